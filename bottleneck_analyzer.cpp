@@ -0,0 +1,75 @@
+#include "bottleneck_analyzer.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+/**
+ * 离线瓶颈分析工具
+ *
+ * 读取 stats_record_path 记录的阶段采样CSV，分析指定窗口并给出线程分配建议。
+ *
+ * 用法：
+ *   BottleneckAnalyzer <stats.csv> [--cores N] [--window N] [--all]
+ *     --cores N   核数预算（默认硬件并发数）
+ *     --window N  只分析最后 N 个采样（默认全部）
+ *     --all       逐个相邻窗口输出，便于观察瓶颈随时间的变化
+ */
+static void print_usage(const char* program) {
+    std::cout << "用法: " << program << " <stats.csv> [--cores N] [--window N] [--all]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string path;
+    int core_budget = 0;
+    size_t window = 0;
+    bool per_interval = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--cores") == 0 && i + 1 < argc) {
+            core_budget = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            window = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--all") == 0) {
+            per_interval = true;
+        } else if (argv[i][0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    std::vector<PipelineSample> samples;
+    if (path.empty() || !BottleneckAnalyzer::load_csv(path, samples)) {
+        std::cerr << "❌ 无法读取采样记录: " << path << std::endl;
+        return 1;
+    }
+    if (samples.size() < 2) {
+        std::cerr << "❌ 采样不足（" << samples.size() << " 个），至少需要2个" << std::endl;
+        return 1;
+    }
+
+    size_t first = 0;
+    if (window >= 2 && window < samples.size()) {
+        first = samples.size() - window;
+    }
+    std::cout << "📂 " << path << ": " << samples.size() << " 个采样，分析第 " << first + 1
+              << " 至 " << samples.size() << " 个" << std::endl;
+
+    if (per_interval) {
+        for (size_t i = first + 1; i < samples.size(); ++i) {
+            BottleneckReport report = BottleneckAnalyzer::analyze(samples[i - 1], samples[i], core_budget);
+            std::cout << "\n[" << i << " -> " << i + 1 << "] " << report.to_string();
+        }
+        std::cout << "\n整体窗口:" << std::endl;
+    }
+
+    BottleneckReport report = BottleneckAnalyzer::analyze(samples[first], samples.back(), core_budget);
+    std::cout << report.to_string();
+    return report.valid ? 0 : 2;
+}
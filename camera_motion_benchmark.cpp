@@ -0,0 +1,222 @@
+#include "camera_motion.h"
+#include "stage_profiler.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * 相机运动估计开销基准
+ *
+ * 用合成的固定机位画面（纹理背景 + 传感器噪声）驱动 CameraMotionEstimator，画面按段交替
+ * 静止与平移（模拟云台转动/抖动），逐帧测量 process() 的线程CPU时间与墙钟时间
+ * （亮度金字塔 + 相位相关，与流水线入口阶段相同的调用），并统计运动判定的命中率与误报率。
+ * 每帧CPU时间中位数不超过 --budget-ms 时退出码为0，否则为2。
+ *
+ * 用法：
+ *   CameraMotionBenchmark [--width N] [--height N] [--format bgr|nv12] [--frames N] [--pan-px P]
+ *                         [--budget-ms MS] [--seed N]
+ *     --width/--height  帧尺寸（默认 1920x1080）
+ *     --format          输入格式（默认 bgr；nv12 时金字塔直接取亮度平面）
+ *     --frames N        帧数（默认 500，每 50 帧切换一次静止/平移）
+ *     --pan-px P        平移段每帧的画面位移（像素，默认 12）
+ *     --budget-ms MS    每帧CPU时间预算（默认 1）
+ */
+
+namespace {
+
+constexpr int kSegmentFrames = 50;
+
+struct Timing {
+    std::vector<double> ms;
+
+    void add(double value) { ms.push_back(value); }
+
+    double percentile(double p) const {
+        if (ms.empty()) return 0.0;
+        std::vector<double> sorted = ms;
+        std::sort(sorted.begin(), sorted.end());
+        size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+        return sorted[std::min(sorted.size(), std::max<size_t>(1, rank)) - 1];
+    }
+
+    double mean() const {
+        double sum = 0.0;
+        for (double value : ms) sum += value;
+        return ms.empty() ? 0.0 : sum / ms.size();
+    }
+};
+
+// 比画面大的纹理背景，平移时从中截取不同位置（低频块 + 高频噪声，相位相关有可用的峰）
+cv::Mat make_world(int width, int height, uint32_t seed) {
+    cv::theRNG().state = seed;
+    cv::Mat coarse(height / 24 + 1, width / 24 + 1, CV_8UC3);
+    cv::randu(coarse, 0, 256);
+    cv::Mat world;
+    cv::resize(coarse, world, cv::Size(width, height), 0, 0, cv::INTER_LINEAR);
+    cv::Mat detail(height, width, CV_8UC3);
+    cv::randu(detail, 0, 32);
+    world += detail;
+    return world;
+}
+
+ImageDataPtr make_frame(const cv::Mat& world, const cv::Rect& view, int noise, bool nv12, uint64_t frame_idx) {
+    cv::Mat bgr = world(view).clone();
+    cv::Mat jitter(bgr.size(), CV_8UC3);
+    cv::randu(jitter, 0, noise + 1);
+    bgr += jitter;
+    ImageDataPtr image;
+    if (nv12) {
+        // BGR -> I420 -> NV12（交织色度），亮度平面与 BGR 输入一致
+        cv::Mat i420;
+        cv::cvtColor(bgr, i420, cv::COLOR_BGR2YUV_I420);
+        const int h = bgr.rows;
+        const int w = bgr.cols;
+        cv::Mat nv(h * 3 / 2, w, CV_8UC1);
+        i420.rowRange(0, h).copyTo(nv.rowRange(0, h));
+        const uchar* u = i420.ptr<uchar>(h);
+        const uchar* v = u + (w / 2) * (h / 2);
+        uchar* uv = nv.ptr<uchar>(h);
+        for (int i = 0; i < (w / 2) * (h / 2); ++i) {
+            uv[2 * i] = u[i];
+            uv[2 * i + 1] = v[i];
+        }
+        image = std::make_shared<ImageData>(YuvImage(std::move(nv), YuvLayout::NV12));
+    } else {
+        image = std::make_shared<ImageData>(std::move(bgr));
+    }
+    image->frame_idx = frame_idx;
+    return image;
+}
+
+void print_usage(const char* program) {
+    std::cerr << "用法: " << program << " [--width N] [--height N] [--format bgr|nv12] [--frames N] [--pan-px P]"
+              << " [--budget-ms MS] [--seed N]" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int width = 1920;
+    int height = 1080;
+    bool nv12 = false;
+    int frames = 500;
+    int pan_px = 12;
+    double budget_ms = 1.0;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            width = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            height = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format != "bgr" && format != "nv12") {
+                print_usage(argv[0]);
+                return 1;
+            }
+            nv12 = format == "nv12";
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = std::max(2, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--pan-px") == 0 && i + 1 < argc) {
+            pan_px = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--budget-ms") == 0 && i + 1 < argc) {
+            budget_ms = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    width &= ~1;
+    height &= ~1;
+    if (width < 64 || height < 64) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // 背景留出整段平移的余量
+    const int margin = pan_px * kSegmentFrames + 2;
+    cv::Mat world = make_world(width + margin, height + margin / 2 + 2, seed);
+    CameraMotionEstimator estimator;
+    Timing cpu;
+    Timing wall;
+    int panning_frames = 0;
+    int panning_detected = 0;
+    int static_frames = 0;
+    int static_false_alarms = 0;
+    double shift_error_sum = 0.0;
+    int shift_error_count = 0;
+
+    cv::Point origin(0, 0);
+    for (int f = 0; f < frames; ++f) {
+        // 偶数段静止，奇数段向右下平移（水平 pan_px、垂直 pan_px/2）
+        const bool panning = (f / kSegmentFrames) % 2 == 1;
+        if (panning && f % kSegmentFrames != 0) {
+            origin.x = std::min(origin.x + pan_px, margin - 1);
+            origin.y = std::min(origin.y + pan_px / 2, margin / 2);
+        }
+        if (!panning && f % kSegmentFrames == 0) {
+            origin = cv::Point(0, 0);   // 段首跳回原点，下一帧才开始计入
+        }
+        ImageDataPtr image = make_frame(world, cv::Rect(origin, cv::Size(width, height)), 3, nv12, f);
+
+        uint64_t cpu_start = StageProfiler::thread_cpu_ns();
+        uint64_t wall_start = StageProfiler::now_ns();
+        estimator.process(image);
+        wall.add((StageProfiler::now_ns() - wall_start) / 1e6);
+        cpu.add((StageProfiler::thread_cpu_ns() - cpu_start) / 1e6);
+
+        // 段首一帧相对上一段末尾有跳变，不计入判定统计
+        if (f % kSegmentFrames == 0 || !image->camera_motion.valid) {
+            continue;
+        }
+        if (panning) {
+            panning_frames++;
+            if (image->camera_motion.moving) {
+                panning_detected++;
+            }
+            // 位移幅度误差（只关心幅度，方向约定由相位相关决定）
+            shift_error_sum += std::abs(std::hypot(image->camera_motion.dx, image->camera_motion.dy) -
+                                        std::hypot(pan_px, pan_px / 2));
+            shift_error_count++;
+        } else {
+            static_frames++;
+            if (image->camera_motion.moving) {
+                static_false_alarms++;
+            }
+        }
+    }
+
+    const double median_cpu = cpu.percentile(0.5);
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "🎥 相机运动估计: " << (nv12 ? "NV12 " : "BGR ") << width << "x" << height << ", " << frames
+              << " 帧（静止/平移每 " << kSegmentFrames << " 帧交替，平移 " << pan_px << " 像素/帧）" << std::endl;
+    std::cout << "  CPU 时间: 中位数 " << median_cpu << " ms, p99 " << cpu.percentile(0.99) << " ms, 平均 "
+              << cpu.mean() << " ms/帧" << std::endl;
+    std::cout << "  墙钟时间: 中位数 " << wall.percentile(0.5) << " ms, p99 " << wall.percentile(0.99) << " ms/帧"
+              << std::endl;
+    std::cout << std::setprecision(1);
+    if (panning_frames > 0) {
+        std::cout << "  平移帧判定为运动: " << panning_detected << "/" << panning_frames << " ("
+                  << 100.0 * panning_detected / panning_frames << "%), 位移幅度平均误差 "
+                  << shift_error_sum / std::max(1, shift_error_count) << " 像素" << std::endl;
+    }
+    if (static_frames > 0) {
+        std::cout << "  静止帧误报: " << static_false_alarms << "/" << static_frames << " ("
+                  << 100.0 * static_false_alarms / static_frames << "%)" << std::endl;
+    }
+    if (median_cpu <= budget_ms) {
+        std::cout << "✅ 每帧CPU时间中位数在预算 " << std::setprecision(2) << budget_ms << " ms 以内" << std::endl;
+        return 0;
+    }
+    std::cout << "❌ 每帧CPU时间中位数超出预算 " << std::setprecision(2) << budget_ms << " ms" << std::endl;
+    return 2;
+}
@@ -0,0 +1,226 @@
+#include "frame_dedup.h"
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * 近重复帧消除测试（合成视频序列）
+ *
+ * 用合成的固定机位画面（渐变背景 + 传感器噪声 + 矩形“车辆”）验证：
+ *   - 静止画面的连续帧被标记为重复，并受 max_consecutive_skips 限制
+ *   - 车辆明显移动、整体亮度变化（开灯/云影）时重新成为关键帧，微小移动仍视为重复
+ *   - 阈值可配置，各视频流的关键帧互不影响
+ *   - 未进入流水线的帧撤销后不影响后续帧的参考状态与计数
+ *   - 参考帧完成对应阶段之前，重复帧不复用其结果
+ * 全部通过时返回0，否则返回失败的检查数。
+ *
+ * 用法：
+ *   FrameDedupTest
+ */
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        ++g_failures;
+        std::cerr << "❌ " << what << std::endl;
+    }
+}
+
+constexpr int kWidth = 640;
+constexpr int kHeight = 360;
+const cv::Rect kVehicle(0, 200, 160, 90);
+
+// 合成一帧：背景渐变 + 均匀噪声（±noise），车辆左上角位于 vehicle_x，brightness 为整体亮度偏移
+cv::Mat make_frame(int vehicle_x, int brightness, int noise, uint32_t seed) {
+    cv::Mat frame(kHeight, kWidth, CV_8UC3);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> jitter(-noise, noise);
+    for (int y = 0; y < kHeight; ++y) {
+        uchar* row = frame.ptr<uchar>(y);
+        for (int x = 0; x < kWidth; ++x) {
+            int base = 60 + x * 100 / kWidth + y * 40 / kHeight + brightness;
+            for (int c = 0; c < 3; ++c) {
+                row[3 * x + c] = cv::saturate_cast<uchar>(base + c * 10 + jitter(rng));
+            }
+        }
+    }
+    if (vehicle_x >= 0) {
+        cv::Rect vehicle(vehicle_x, kVehicle.y, kVehicle.width, kVehicle.height);
+        cv::rectangle(frame, vehicle & cv::Rect(0, 0, kWidth, kHeight), cv::Scalar(20, 20, 200), cv::FILLED);
+    }
+    return frame;
+}
+
+ImageDataPtr make_image(cv::Mat frame, uint64_t frame_idx, int stream_id = 0) {
+    auto image = std::make_shared<ImageData>(std::move(frame));
+    image->frame_idx = frame_idx;
+    image->stream_id = stream_id;
+    return image;
+}
+
+FrameDedupConfig default_config() {
+    FrameDedupConfig config;
+    config.diff_threshold = 2.0;
+    config.max_consecutive_skips = 1000;
+    return config;
+}
+
+void test_static_scene() {
+    FrameDeduplicator dedup(default_config());
+    std::vector<ImageDataPtr> frames;
+    for (int i = 0; i < 30; ++i) {
+        frames.push_back(make_image(make_frame(100, 0, 3, 1000 + i), i));
+        dedup.process(frames.back());
+    }
+    check(!frames[0]->is_duplicate, "静止画面: 首帧应为关键帧");
+    bool all_duplicate = true;
+    for (size_t i = 1; i < frames.size(); ++i) {
+        all_duplicate = all_duplicate && frames[i]->is_duplicate && frames[i]->dedup_reference == frames[0];
+    }
+    check(all_duplicate, "静止画面: 后续帧应全部标记为重复并引用首帧");
+    check(dedup.get_frames_checked() == 30 && dedup.get_frames_marked() == 29, "静止画面: 计数应为 29/30");
+}
+
+void test_max_consecutive_skips() {
+    FrameDedupConfig config = default_config();
+    config.max_consecutive_skips = 4;
+    FrameDeduplicator dedup(config);
+    std::vector<ImageDataPtr> frames;   // 关键帧只以弱引用保存，需保持帧存活（相当于仍在流水线中）
+    std::vector<bool> duplicate;
+    for (int i = 0; i < 12; ++i) {
+        frames.push_back(make_image(make_frame(100, 0, 3, 2000 + i), i));
+        dedup.process(frames.back());
+        duplicate.push_back(frames.back()->is_duplicate);
+    }
+    // 关键帧 + 4 个重复帧为一轮
+    const std::vector<bool> expected = {false, true, true, true, true, false, true, true, true, true, false, true};
+    check(duplicate == expected, "连续重复上限: 每 4 个重复帧后应强制一个关键帧");
+}
+
+void test_motion_and_lighting() {
+    FrameDeduplicator dedup(default_config());
+    ImageDataPtr key = make_image(make_frame(100, 0, 3, 3000), 0);
+    dedup.process(key);
+
+    ImageDataPtr small_move = make_image(make_frame(104, 0, 3, 3001), 1);
+    dedup.process(small_move);
+    check(small_move->is_duplicate, "微小移动(4像素): 应视为重复");
+
+    ImageDataPtr moved = make_image(make_frame(180, 0, 3, 3002), 2);
+    dedup.process(moved);
+    check(!moved->is_duplicate, "车辆移动80像素: 应成为新关键帧");
+
+    ImageDataPtr after_move = make_image(make_frame(180, 0, 3, 3003), 3);
+    dedup.process(after_move);
+    check(after_move->is_duplicate && after_move->dedup_reference == moved, "移动后静止: 应引用新关键帧");
+
+    ImageDataPtr brighter = make_image(make_frame(180, 12, 3, 3004), 4);
+    dedup.process(brighter);
+    check(!brighter->is_duplicate, "整体亮度变化: 应成为新关键帧");
+
+    ImageDataPtr entering = make_image(make_frame(-1, 12, 3, 3005), 5);
+    dedup.process(entering);
+    check(!entering->is_duplicate, "车辆驶离画面: 应成为新关键帧");
+}
+
+void test_threshold_config() {
+    FrameDedupConfig config = default_config();
+    config.diff_threshold = 0.0;
+    FrameDeduplicator dedup(config);
+    ImageDataPtr first = make_image(make_frame(100, 0, 3, 4000), 0);
+    ImageDataPtr second = make_image(make_frame(100, 0, 3, 4001), 1);
+    dedup.process(first);
+    dedup.process(second);
+    check(!second->is_duplicate, "阈值为0: 不应标记任何重复帧");
+
+    // 运行时放宽阈值后，明显移动也视为重复
+    config.diff_threshold = 50.0;
+    dedup.set_config(config);
+    ImageDataPtr moved = make_image(make_frame(180, 0, 3, 4002), 2);
+    dedup.process(moved);
+    check(moved->is_duplicate, "阈值放宽到50: 车辆移动也应视为重复");
+}
+
+void test_streams_isolated() {
+    FrameDeduplicator dedup(default_config());
+    ImageDataPtr a0 = make_image(make_frame(100, 0, 3, 5000), 0, 1);
+    ImageDataPtr b0 = make_image(make_frame(400, 20, 3, 5001), 0, 2);
+    ImageDataPtr a1 = make_image(make_frame(100, 0, 3, 5002), 1, 1);
+    ImageDataPtr b1 = make_image(make_frame(400, 20, 3, 5003), 1, 2);
+    for (const auto& image : {a0, b0, a1, b1}) {
+        dedup.process(image);
+    }
+    check(!a0->is_duplicate && !b0->is_duplicate, "多路流: 各流首帧应为关键帧");
+    check(a1->dedup_reference == a0 && b1->dedup_reference == b0, "多路流: 重复帧应引用本流的关键帧");
+}
+
+void test_revert() {
+    FrameDeduplicator dedup(default_config());
+    ImageDataPtr key = make_image(make_frame(100, 0, 3, 6000), 0);
+    dedup.process(key);
+
+    // 被拒绝的帧本会成为新关键帧：撤销后下一帧仍与原关键帧比较
+    FrameDeduplicator::Checkpoint rejected_checkpoint;
+    ImageDataPtr rejected = make_image(make_frame(300, 0, 3, 6001), 1);
+    dedup.process(rejected, &rejected_checkpoint);
+    check(!rejected->is_duplicate, "撤销: 被拒绝的帧本应成为关键帧");
+
+    FrameDeduplicator::Checkpoint dup_checkpoint;
+    ImageDataPtr rejected_dup = make_image(make_frame(300, 0, 3, 6002), 2);
+    dedup.process(rejected_dup, &dup_checkpoint);
+    check(rejected_dup->is_duplicate, "撤销: 第二个被拒绝的帧本应为重复帧");
+
+    // 按处理的逆序撤销
+    dedup.revert(rejected_dup, dup_checkpoint);
+    dedup.revert(rejected, rejected_checkpoint);
+    check(!rejected_dup->is_duplicate && !rejected_dup->dedup_reference, "撤销: 应清除重复标记与参考帧引用");
+    check(dedup.get_frames_checked() == 1 && dedup.get_frames_marked() == 0, "撤销: 计数应恢复");
+
+    ImageDataPtr next = make_image(make_frame(100, 0, 3, 6003), 3);
+    dedup.process(next);
+    check(next->is_duplicate && next->dedup_reference == key, "撤销: 后续帧应引用原关键帧");
+
+    // 重新提交被拒绝的帧：与当前关键帧正常比较，而不是与自身比较
+    dedup.process(rejected);
+    check(!rejected->is_duplicate, "重新提交: 应与当前关键帧比较并成为新关键帧");
+}
+
+void test_reusable_reference() {
+    FrameDeduplicator dedup(default_config());
+    ImageDataPtr key = make_image(make_frame(100, 0, 3, 7000), 0);
+    ImageDataPtr duplicate = make_image(make_frame(100, 0, 3, 7001), 1);
+    dedup.process(key);
+    dedup.process(duplicate);
+    // 参考帧在同一批次中尚未完成检测：重复帧需自行推理
+    check(!FrameDeduplicator::reusable_reference(duplicate, &ImageData::detection_completed),
+          "参考帧未完成检测: 不应复用");
+    key->detection_completed = true;
+    check(FrameDeduplicator::reusable_reference(duplicate, &ImageData::detection_completed) == key,
+          "参考帧已完成检测: 应复用");
+    check(!FrameDeduplicator::reusable_reference(key, &ImageData::detection_completed), "关键帧: 不应复用");
+}
+
+}  // namespace
+
+int main() {
+    test_static_scene();
+    test_max_consecutive_skips();
+    test_motion_and_lighting();
+    test_threshold_config();
+    test_streams_isolated();
+    test_revert();
+    test_reusable_reference();
+
+    if (g_failures == 0) {
+        std::cout << "✅ 近重复帧消除测试全部通过" << std::endl;
+    } else {
+        std::cout << "❌ 近重复帧消除测试失败 " << g_failures << " 项" << std::endl;
+    }
+    return g_failures;
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "image_data.h"
+#include "buffer_liveness.h"
+#include "stage_profiler.h"
+#include <algorithm>
 #include <vector>
 #include <memory>
 #include <atomic>
@@ -10,6 +13,31 @@
 #include <queue>
 #include <thread>
 
+/**
+ * 批次形状：同一批次内所有图像的分辨率、通道数和流类别相同
+ * 下游阶段可据此复用缩放计划和缓冲区
+ */
+struct BatchShape {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int stream_class = 0;
+
+    static BatchShape of(const ImageData& image) {
+        BatchShape shape;
+        shape.width = image.width;
+        shape.height = image.height;
+        shape.channels = image.channels;
+        shape.stream_class = image.stream_class;
+        return shape;
+    }
+
+    bool operator==(const BatchShape& other) const {
+        return width == other.width && height == other.height && channels == other.channels &&
+               stream_class == other.stream_class;
+    }
+};
+
 /**
  * 批次数据容器 - 包含32个图像数据的批次
  */
@@ -19,6 +47,8 @@ struct ImageBatch {
     std::vector<ImageDataPtr> images;                           // 32个图像数据
     uint64_t batch_id;                                          // 批次ID
     size_t actual_size;                                         // 实际图像数量（可能小于32）
+    size_t capacity;                                            // 满批次图像数（默认 BATCH_SIZE，重组后的批次按下游阶段设定）
+    BatchShape shape;                                           // 批次内图像的公共形状（按形状分桶时有效）
     std::chrono::high_resolution_clock::time_point created_time; // 创建时间
     std::chrono::high_resolution_clock::time_point start_time;   // 开始处理时间
     
@@ -35,19 +65,20 @@ struct ImageBatch {
     std::atomic<bool> event_completed{false};
     
     // 构造函数
-    ImageBatch() : batch_id(0), actual_size(0) {
-        images.reserve(BATCH_SIZE);
+    ImageBatch() : batch_id(0), actual_size(0), capacity(BATCH_SIZE) {
+        images.reserve(capacity);
         created_time = std::chrono::high_resolution_clock::now();
     }
     
-    explicit ImageBatch(uint64_t id) : batch_id(id), actual_size(0) {
-        images.reserve(BATCH_SIZE);
+    explicit ImageBatch(uint64_t id, size_t batch_capacity = BATCH_SIZE)
+        : batch_id(id), actual_size(0), capacity(std::max<size_t>(1, batch_capacity)) {
+        images.reserve(capacity);
         created_time = std::chrono::high_resolution_clock::now();
     }
     
     // 添加图像到批次
     bool add_image(ImageDataPtr image) {
-        if (actual_size >= BATCH_SIZE) {
+        if (actual_size >= capacity) {
             return false;
         }
         images.push_back(image);
@@ -57,7 +88,7 @@ struct ImageBatch {
     
     // 检查批次是否已满
     bool is_full() const {
-        return actual_size >= BATCH_SIZE;
+        return actual_size >= capacity;
     }
     
     // 检查批次是否为空
@@ -92,12 +123,19 @@ using BatchPtr = std::shared_ptr<ImageBatch>;
 /**
  * 批次缓冲区 - 负责收集单个图像并组装成批次
  * 支持背压机制，防止内存无限增长
+ *
+ * 按形状分桶时，每种 (分辨率, 通道数, 流类别) 各有一个收集中的批次和各自的超时刷新期限，
+ * 产出的批次形状一致。公平性：某个桶的未满批次被其他桶的批次越过 max_bypass_batches 次后
+ * 立即刷新，少见分辨率的等待不会随主流分辨率的帧率无限拉长。
  */
 class BatchBuffer {
 public:
     explicit BatchBuffer(
         std::chrono::milliseconds flush_timeout = std::chrono::milliseconds(100),
-        size_t max_ready_batches = 50  // 最大就绪批次数量，实现背压
+        size_t max_ready_batches = 50,  // 最大就绪批次数量，实现背压
+        bool bucket_by_shape = true,    // 按形状分桶收集
+        size_t max_bypass_batches = 4,  // 未满批次最多被其他桶越过的批次数，0 表示不限制
+        size_t batch_size = ImageBatch::BATCH_SIZE  // 满批次图像数（首个阶段的批次大小）
     );
     ~BatchBuffer();
     
@@ -107,35 +145,63 @@ public:
     // 停止批次收集
     void stop();
     
-    // 添加单个图像，自动组装成批次
+    // 添加单个图像，自动组装成批次（就绪队列满时阻塞）
     bool add_image(ImageDataPtr image);
     
+    // 添加单个图像，就绪队列满时最多等待timeout_ms（0表示不等待）
+    bool add_image_with_timeout(ImageDataPtr image, int timeout_ms);
+    
+    /**
+     * 批量添加图像，一次加锁接纳整组
+     * @param timeout_ms 背压等待时间，<0 一直等待，0 不等待
+     * @return 按顺序接纳的图像数量（前缀），可能小于count
+     */
+    size_t add_images(const ImageDataPtr* images, size_t count, int timeout_ms);
+    
     // 获取就绪的批次
     bool get_ready_batch(BatchPtr& batch);
     
     // 非阻塞获取就绪的批次
     bool try_get_ready_batch(BatchPtr& batch);
     
-    // 强制刷新当前收集的批次
+    // 强制刷新所有收集中的批次
     void flush_current_batch();
     
     // 获取统计信息
     size_t get_ready_batch_count() const;
-    size_t get_current_collecting_size() const;
+    size_t get_current_collecting_size() const;     // 所有桶收集中的图像数
+    size_t get_collecting_bucket_count() const;     // 有收集中批次的桶数
+    uint64_t get_fairness_flushes() const { return fairness_flushes_.load(); }
     uint64_t get_total_batches_created() const;
     size_t get_max_ready_batches() const;
+    size_t get_batch_size() const { return batch_size_; }
     bool is_ready_queue_full() const;
+    
+    // 获取收集锁/就绪队列锁的竞争统计
+    std::vector<LockContentionSnapshot> get_lock_stats() const;
 
 private:
+    // 收集桶：每种形状一个收集中的批次
+    struct CollectingBucket {
+        BatchShape shape;
+        BatchPtr batch;                 // 收集中的批次，空表示该桶当前无图像
+        uint64_t opened_at_emit = 0;    // 批次创建时的 batches_emitted_，用于公平性判断
+    };
+    
     // 批次收集相关
-    mutable std::mutex collect_mutex_;
-    BatchPtr current_collecting_batch_;
+    mutable InstrumentedMutex collect_mutex_{"BatchBuffer::collect_mutex_"};
+    std::vector<CollectingBucket> buckets_;   // 形状种类很少，线性查找
     uint64_t next_batch_id_;
+    uint64_t batches_emitted_ = 0;            // 已移入就绪队列的批次数（收集锁内维护）
+    bool bucket_by_shape_;
+    size_t max_bypass_batches_;
+    size_t batch_size_;
+    std::condition_variable_any flush_cv_;    // 刷新线程按最早的刷新期限等待，停止时唤醒
     
     // 就绪批次队列
-    mutable std::mutex ready_mutex_;
+    mutable InstrumentedMutex ready_mutex_{"BatchBuffer::ready_mutex_"};
     std::queue<BatchPtr> ready_batches_;
-    std::condition_variable ready_cv_;
+    std::condition_variable_any ready_cv_;
     size_t max_ready_batches_;  // 就绪批次队列的最大大小
     
     // 自动刷新机制
@@ -147,10 +213,13 @@ private:
     // 统计信息
     std::atomic<uint64_t> total_batches_created_{0};
     std::atomic<uint64_t> total_images_received_{0};
+    std::atomic<uint64_t> fairness_flushes_{0};
     
     // 内部方法
     void flush_thread_func();
     void move_batch_to_ready(BatchPtr batch);
+    CollectingBucket& bucket_for(const ImageData& image);
+    void emit_bucket(CollectingBucket& bucket);   // 需持有收集锁
 };
 
 /**
@@ -166,6 +235,12 @@ public:
     // 获取阶段名称
     virtual std::string get_stage_name() const = 0;
     
+    // 获取阶段耗时分布（计算/等输入/等输出/锁等待）
+    virtual StageProfileSnapshot get_profile() const = 0;
+    
+    // 获取最近的单批次服务时间样本（批次大小 + 墙钟耗时，供流水线仿真器使用）
+    virtual std::vector<ServiceSample> get_service_samples() const = 0;
+    
     // 获取处理的批次数量
     virtual size_t get_processed_count() const = 0;
     
@@ -175,6 +250,9 @@ public:
     // 获取当前队列大小
     virtual size_t get_queue_size() const = 0;
     
+    // 本阶段读取或生成的帧缓冲区，流水线据此在最后一个使用者完成后释放；未声明时视为全部使用
+    virtual FrameBufferSet get_buffer_usage() const { return FRAME_BUFFERS_ALL; }
+    
     // 启动处理阶段
     virtual void start() = 0;
     
@@ -184,22 +262,36 @@ public:
 
 /**
  * 批次连接器 - 连接两个批次处理阶段
+ *
+ * 默认原样转发批次。set_rebatch() 后按下游阶段的批次大小重组：大批次拆分，小批次合并，
+ * 使每个阶段以各自最合适的粒度运行（如分割8、检测32、跟踪逐帧）。
  */
 class BatchConnector {
 public:
     explicit BatchConnector(size_t max_queue_size = 10);
     ~BatchConnector();
     
+    /**
+     * 启用批次重组，必须在 start() 之前调用
+     * 同一形状（BatchShape）的图像按到达顺序拼成 target_batch_size 的批次；某路视频流换了形状时，
+     * 先发出它在其他形状中尚未发出的图像，保证每路流的帧序不变。未凑满的批次最长等待
+     * flush_timeout 后由接收方取走。重组时队列容量按图像数计：
+     * max_queue_size × max(target_batch_size, ImageBatch::BATCH_SIZE)。
+     * @param target_batch_size 下游批次大小，0 表示不重组
+     */
+    void set_rebatch(size_t target_batch_size, std::chrono::milliseconds flush_timeout);
+    size_t get_target_batch_size() const { return target_batch_size_; }
+    
     // 启动连接器
     void start();
     
     // 停止连接器
     void stop();
     
-    // 向连接器发送批次
+    // 向连接器发送批次（队列满时阻塞，等待时间记为调用线程所属阶段的等输出时间）
     bool send_batch(BatchPtr batch);
     
-    // 从连接器接收批次
+    // 从连接器接收批次（队列空时阻塞，等待时间记为调用线程所属阶段的等输入时间）
     bool receive_batch(BatchPtr& batch);
     
     // 非阻塞方式从连接器接收批次
@@ -210,7 +302,30 @@ public:
     size_t get_max_queue_size() const;
     bool is_full() const;
     
+    // 发送/接收方累计阻塞时间（毫秒）
+    double get_send_wait_ms() const { return total_send_wait_ns_.load() / 1e6; }
+    double get_receive_wait_ms() const { return total_receive_wait_ns_.load() / 1e6; }
+    
+    // 接收方取走的批次数/图像数，以及因超时发出的未满批次数
+    uint64_t get_batches_received() const { return total_received_.load(); }
+    uint64_t get_frames_received() const { return total_frames_received_.load(); }
+    uint64_t get_timeout_flushes() const { return timeout_flushes_.load(); }
+    
 private:
+    // 待合并的图像（每种形状一组）
+    struct PendingGroup {
+        BatchShape shape;
+        std::vector<ImageDataPtr> images;
+        std::vector<int> stream_ids;                                // 组内出现过的视频流
+        std::chrono::steady_clock::time_point oldest;               // 组内最早图像的到达时间
+        std::chrono::high_resolution_clock::time_point created_time; // 来源批次中最早的创建时间
+    };
+    
+    // 以下方法需持有 queue_mutex_
+    void enqueue_rebatched(BatchPtr batch);
+    void emit_group(PendingGroup& group);
+    bool flush_expired_group();
+    
     mutable std::mutex queue_mutex_;
     std::queue<BatchPtr> batch_queue_;
     std::condition_variable queue_cv_;
@@ -218,7 +333,18 @@ private:
     size_t max_queue_size_;
     std::atomic<bool> running_;
     
+    // 批次重组（target_batch_size_ 为 0 时不使用）
+    size_t target_batch_size_ = 0;
+    std::chrono::milliseconds rebatch_flush_timeout_{0};
+    std::vector<PendingGroup> pending_groups_;   // 形状种类很少，线性查找
+    size_t queued_frames_ = 0;                   // 队列中与待合并的图像数
+    size_t max_queued_frames_ = 0;
+    
     // 统计信息
     std::atomic<uint64_t> total_sent_{0};
     std::atomic<uint64_t> total_received_{0};
+    std::atomic<uint64_t> total_send_wait_ns_{0};
+    std::atomic<uint64_t> total_receive_wait_ns_{0};
+    std::atomic<uint64_t> total_frames_received_{0};
+    std::atomic<uint64_t> timeout_flushes_{0};
 };
@@ -3,6 +3,8 @@
 #include "batch_data.h"
 #include "event_type.h"
 #include "event_utils.h"
+#include "event_journal.h"
+#include "evidence_recorder.h"
 #include "pipeline_config.h"
 #include <thread>
 #include <atomic>
@@ -22,12 +24,24 @@ public:
     // BatchStage接口实现
     bool process_batch(BatchPtr batch) override;
     std::string get_stage_name() const override;
+    StageProfileSnapshot get_profile() const override;
+    std::vector<ServiceSample> get_service_samples() const override;
     size_t get_processed_count() const override;
     double get_average_processing_time() const override;
     size_t get_queue_size() const override;
+    FrameBufferSet get_buffer_usage() const override;
     void start() override;
     void stop() override;
     
+    // 批次处理锁的竞争统计
+    LockContentionSnapshot get_lock_stats() const { return batch_processing_mutex_.snapshot(); }
+    
+    // 设置事件日志（逐帧提交判定结果，需在 start() 前设置；nullptr 关闭）
+    void set_event_journal(EventJournal* journal) { event_journal_ = journal; }
+    
+    // 设置取证片段采集器（逐帧提交，编码在采集器的后台线程执行；nullptr 关闭）
+    void set_evidence_recorder(EvidenceRecorder* recorder) { evidence_recorder_ = recorder; }
+    
     // 获取输入批次
     bool add_batch(BatchPtr batch);
     
@@ -69,14 +83,17 @@ private:
     float times_car_width_ = 3.0f; // 车宽倍数，用于计算车道线位置
 
     std::string lane_show_image_path_; // 车道线可视化图像保存路径
+    EventJournal* event_journal_ = nullptr; // 事件日志（由流水线管理器持有）
+    EvidenceRecorder* evidence_recorder_ = nullptr; // 取证片段采集器（由流水线管理器持有）
     
     // 性能统计
+    StageProfiler profiler_;                          // 耗时分布（计算/等输入/等输出/锁等待）
     std::atomic<size_t> processed_batch_count_{0};
     std::atomic<uint64_t> total_processing_time_ms_{0};
     std::atomic<uint64_t> total_images_processed_{0};
     std::atomic<uint64_t> total_events_detected_{0};
     
     // 批次处理同步
-    std::mutex batch_processing_mutex_;
+    InstrumentedMutex batch_processing_mutex_{"BatchEventDetermine::batch_processing_mutex_"};
     
 };
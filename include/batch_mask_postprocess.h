@@ -22,9 +22,12 @@ public:
     // BatchStage接口实现
     bool process_batch(BatchPtr batch) override;
     std::string get_stage_name() const override;
+    StageProfileSnapshot get_profile() const override;
+    std::vector<ServiceSample> get_service_samples() const override;
     size_t get_processed_count() const override;
     double get_average_processing_time() const override;
     size_t get_queue_size() const override;
+    FrameBufferSet get_buffer_usage() const override;
     void start() override;
     void stop() override;
     
@@ -61,6 +64,7 @@ private:
     std::unique_ptr<BatchConnector> output_connector_;
     
     // 性能统计
+    StageProfiler profiler_;                          // 耗时分布（计算/等输入/等输出/锁等待）
     std::atomic<size_t> processed_batch_count_{0};
     std::atomic<uint64_t> total_processing_time_ms_{0};
     std::atomic<uint64_t> total_images_processed_{0};
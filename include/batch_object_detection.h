@@ -3,6 +3,9 @@
 #include "batch_data.h"
 #include "detect.h"
 #include "pipeline_config.h"
+#include "motion_gate.h"
+#include "inference_scheduler.h"
+#include "cpu_inference.h"
 #include <thread>
 #include <atomic>
 #include <opencv2/cudaimgproc.hpp>
@@ -21,9 +24,12 @@ public:
     // BatchStage接口实现
     bool process_batch(BatchPtr batch) override;
     std::string get_stage_name() const override;
+    StageProfileSnapshot get_profile() const override;
+    std::vector<ServiceSample> get_service_samples() const override;
     size_t get_processed_count() const override;
     double get_average_processing_time() const override;
     size_t get_queue_size() const override;
+    FrameBufferSet get_buffer_usage() const override;
     void start() override;
     void stop() override;
     
@@ -32,6 +38,24 @@ public:
     
     // 获取处理完成的批次
     bool get_processed_batch(BatchPtr& batch);
+    
+    // 运动门控统计
+    struct MotionGateStats {
+        uint64_t full_frames = 0;      // 有运动，完整检测
+        uint64_t reuse_frames = 0;     // 无运动，复用检测结果
+        uint64_t refresh_frames = 0;   // 无运动，周期刷新检测
+    };
+    MotionGateStats get_motion_gate_stats() const;
+    bool is_motion_gate_enabled() const { return motion_gate_ != nullptr; }
+    
+    // 重复帧继承参考帧检测结果、实际跳过推理的帧数
+    uint64_t get_dedup_reused_frames() const { return dedup_reused_frames_.load(); }
+    
+    // 运行时更新运动门控阈值
+    void update_motion_gate_config(const PipelineConfig& config);
+    
+    // 推理调度器（GPU/CPU 后端分配与实测耗时）
+    const InferenceScheduler& get_scheduler() const { return *scheduler_; }
 
 private:
     // 工作线程函数
@@ -46,6 +70,9 @@ private:
     // 初始化检测模型
     bool initialize_detection_models();
     
+    // 初始化CPU检测模型（OpenCV DNN）
+    bool initialize_cpu_detection_model();
+    
     // 清理检测模型
     void cleanup_detection_models();
 
@@ -63,14 +90,23 @@ private:
     std::vector<std::unique_ptr<xtkj::IDetect>> car_detect_instances_;
     std::vector<std::unique_ptr<xtkj::IDetect>> personal_detect_instances_;
     
+    // 运动门控（未启用时为空）
+    std::unique_ptr<MotionGate> motion_gate_;
+    
     // 批次队列
     std::unique_ptr<BatchConnector> input_connector_;
     std::unique_ptr<BatchConnector> output_connector_;
     
     // 性能统计
+    StageProfiler profiler_;                          // 耗时分布（计算/等输入/等输出/锁等待）
     std::atomic<size_t> processed_batch_count_{0};
     std::atomic<uint64_t> total_processing_time_ms_{0};
     std::atomic<uint64_t> total_images_processed_{0};
+    std::atomic<uint64_t> dedup_reused_frames_{0};
+    
+    // CPU 推理模型（gpu 模式下为空）与后端调度
+    std::unique_ptr<CpuDetectionModel> cpu_det_model_;
+    std::unique_ptr<InferenceScheduler> scheduler_;
     
     // CUDA优化相关
     bool cuda_available_;
@@ -2,10 +2,13 @@
 
 #include "batch_data.h"
 #include "byte_track.h"
+#include "multi_object_tracker.h"
 #include "vehicle_parking_detect.h"
+#include "stillness_detector.h"
 #include "pipeline_config.h"
 #include <thread>
 #include <atomic>
+#include <fstream>
 #include <map>
 #include <mutex>
 
@@ -22,17 +25,38 @@ public:
     // BatchStage接口实现
     bool process_batch(BatchPtr batch) override;
     std::string get_stage_name() const override;
+    StageProfileSnapshot get_profile() const override;
+    std::vector<ServiceSample> get_service_samples() const override;
     size_t get_processed_count() const override;
     double get_average_processing_time() const override;
     size_t get_queue_size() const override;
+    FrameBufferSet get_buffer_usage() const override;
     void start() override;
     void stop() override;
     
+    // 批次处理锁的竞争统计
+    LockContentionSnapshot get_lock_stats() const { return batch_processing_mutex_.snapshot(); }
+    
     // 获取输入批次
     bool add_batch(BatchPtr batch);
     
     // 获取处理完成的批次
     bool get_processed_batch(BatchPtr& batch);
+    
+    // 静止判定统计
+    struct StillnessStats {
+        uint64_t history_frames = 0;        // 由轨迹框历史判定
+        uint64_t feature_frames = 0;        // 相机运动期间由特征点/RANSAC判定
+        uint64_t camera_motion_events = 0;  // 检测到相机运动的次数
+    };
+    StillnessStats get_stillness_stats() const;
+    bool is_track_stillness_enabled() const { return track_stillness_enabled_.load(); }
+    
+    // 内置跟踪器（未启用时为空）
+    const MultiObjectTracker* get_builtin_tracker() const { return builtin_tracker_.get(); }
+    
+    // 运行时切换静止判定方式并更新阈值
+    void update_stillness_config(const PipelineConfig& config);
 
 private:
     // 工作线程函数
@@ -44,6 +68,18 @@ private:
     // 执行目标跟踪算法
     void perform_object_tracking(ImageDataPtr image, int thread_id);
     
+    // 使用内置跟踪器跟踪，结果写回 out（与外部跟踪库的输出格式一致）
+    void track_with_builtin(const ImageDataPtr& image, detect_result_group_t* out);
+    
+    // 运动门控复用检测结果的帧：内置跟踪器只做预测，输出跟踪中轨迹的预测框
+    void coast_with_builtin(const ImageDataPtr& image, detect_result_group_t* out);
+    
+    // 判定各跟踪框是否静止（写入 is_still）
+    void determine_stillness(const ImageDataPtr& image, std::vector<TrackBox>& track_boxes);
+    
+    // 违停检测缩放图尺寸（跟踪框坐标换算用，不需要实际计算缩放图）
+    static cv::Size parking_image_size(const ImageData& image);
+    
     // 初始化跟踪模型
     bool initialize_tracking_models();
     
@@ -60,37 +96,30 @@ private:
     std::atomic<bool> running_;
     std::atomic<bool> stop_requested_;
     
-    // 跟踪模型实例 - 每个线程独立的模型实例
+    // 跟踪模型实例 - 每个线程独立的模型实例（外部 xtkj 跟踪库，所有视频流共用）
     std::vector<std::unique_ptr<xtkj::ITracker>> track_instances_;
+    
+    // 内置多目标跟踪器（use_builtin_tracker 时替代 track_instances_，按视频流隔离轨迹）
+    std::unique_ptr<MultiObjectTracker> builtin_tracker_;
     VehicleParkingDetect* vehicle_parking_instance_;
     
+    // 轨迹历史静止判定（固定机位），相机运动时回退到 vehicle_parking_instance_
+    std::unique_ptr<TrackStillnessDetector> stillness_detector_;
+    std::atomic<bool> track_stillness_enabled_{false};
+    
+    // 跟踪框记录（StillnessBenchmark 回放）
+    std::ofstream track_record_file_;
+    
     // 批次队列
     std::unique_ptr<BatchConnector> input_connector_;
     std::unique_ptr<BatchConnector> output_connector_;
     
     // 性能统计
+    StageProfiler profiler_;                          // 耗时分布（计算/等输入/等输出/锁等待）
     std::atomic<size_t> processed_batch_count_{0};
     std::atomic<uint64_t> total_processing_time_ms_{0};
     std::atomic<uint64_t> total_images_processed_{0};
     
-    // 跟踪参数配置
-    float tracking_confidence_threshold_;
-    int max_disappeared_frames_;
-    float iou_threshold_;
-    
-    // 全局轨迹数据库（跨批次共享）
-    struct TrajectoryInfo {
-        int track_id;
-        cv::Rect last_bbox;
-        uint64_t last_frame_idx;
-        int disappeared_count;
-        bool is_active;
-    };
-    
-    std::map<int, TrajectoryInfo> trajectory_database_;
-    std::mutex trajectory_mutex_;
-    int next_track_id_;
-    
     // 批次处理同步
-    std::mutex batch_processing_mutex_;
+    InstrumentedMutex batch_processing_mutex_{"BatchObjectTracking::batch_processing_mutex_"};
 };
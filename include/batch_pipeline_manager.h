@@ -8,10 +8,18 @@
 #include "batch_event_determine.h"
 #include "pipeline_config.h"
 #include "memory_monitor.h"
+#include "memory_budget.h"
+#include "frame_dedup.h"
+#include "camera_motion.h"
+#include "bottleneck_analyzer.h"
+#include "pipeline_topology.h"
+#include "pipeline_simulator.h"
 #include <memory>
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <deque>
+#include <fstream>
 
 /**
  * 批次流水线管理器
@@ -32,6 +40,12 @@ public:
     // 添加单个图像（自动组装成批次）
     bool add_image(ImageDataPtr image);
     
+    // 添加单个图像，背压时最多等待timeout_ms（0表示不等待）
+    bool add_image_with_timeout(ImageDataPtr image, int timeout_ms);
+    
+    // 批量添加图像，一次加锁接纳整组，返回按顺序接纳的数量
+    size_t add_images(const ImageDataPtr* images, size_t count, int timeout_ms);
+    
     // 获取处理完成的批次结果
     bool get_result_batch(BatchPtr& batch);
     
@@ -41,6 +55,21 @@ public:
     // 打印流水线状态
     void print_status() const;
     
+    // 运行时更新近重复帧消除阈值
+    void update_frame_dedup_config(const PipelineConfig& config);
+    
+    // 运行时更新运动门控阈值
+    void update_motion_gate_config(const PipelineConfig& config);
+    
+    // 运行时更新相机运动估计阈值
+    void update_camera_motion_config(const PipelineConfig& config);
+    
+    // 运行时切换静止判定方式并更新阈值
+    void update_stillness_config(const PipelineConfig& config);
+    
+    // 事件日志（未配置 event_journal_path 时为 nullptr）
+    const EventJournal* get_event_journal() const { return event_journal_.get(); }
+    
     // 获取统计信息
     struct Statistics {
         uint64_t total_images_input;
@@ -50,10 +79,53 @@ public:
         double throughput_images_per_second;
         size_t current_input_buffer_size;
         size_t current_output_buffer_size;
+        uint64_t dedup_frames_checked;     // 经过近重复检测的帧数
+        uint64_t dedup_frames_marked;      // 入口标记为重复的帧数
+        uint64_t dedup_seg_skipped;        // 实际继承参考帧分割结果、跳过分割推理的帧数
+        uint64_t dedup_detect_skipped;     // 实际继承参考帧检测结果、跳过检测推理的帧数
+        uint64_t camera_motion_frames;     // 做过相机运动估计的帧数
+        uint64_t camera_moving_frames;     // 判定相机在运动的帧数
     };
     
     Statistics get_statistics() const;
     
+    // 有界缓冲区占用（长稳测试据此判断是否持续打满或只增不减）
+    struct Occupancy {
+        size_t collecting_images = 0;      // 正在组装的批次中的图像数
+        size_t ready_batches = 0;          // BatchBuffer 就绪队列
+        size_t ready_capacity = 0;
+        size_t connector_batches = 0;      // 阶段间连接器中排队的批次（含结果连接器）
+        size_t connector_capacity = 0;
+        size_t result_images = 0;          // 已完成、等待发布的图像
+        uint64_t images_in_pipeline = 0;   // 已接纳但尚未输出的图像
+    };
+    Occupancy get_occupancy() const;
+    
+    // 各阶段耗时分布（计算/非CPU/等输入/等输出/锁等待）
+    struct StageProfileEntry {
+        std::string stage_name;
+        StageProfileSnapshot profile;
+    };
+    std::vector<StageProfileEntry> get_stage_profiles() const;
+    
+    // 插桩锁的竞争统计
+    std::vector<LockContentionSnapshot> get_lock_stats() const;
+    
+    // 采集当前各阶段累计指标（供瓶颈分析与CSV记录）
+    PipelineSample collect_sample() const;
+    
+    /**
+     * 瓶颈分析：以最早的历史采样与当前采样为窗口，给出限速阶段和线程分配建议
+     * @param core_budget 核数预算，<=0 时使用硬件并发数
+     */
+    BottleneckReport analyze_bottleneck(int core_budget = 0) const;
+    
+    // 流水线拓扑描述（与仿真器共用）
+    const PipelineTopology& get_topology() const { return topology_; }
+    
+    // 采集拓扑与各阶段最近的服务时间样本，供 PipelineSimulator 做容量规划
+    ServiceProfile collect_service_profile() const;
+    
     // 内存监控相关方法
     void start_memory_monitoring();
     void stop_memory_monitoring();
@@ -65,6 +137,7 @@ public:
 private:
     // 配置
     PipelineConfig config_;
+    PipelineTopology topology_;
     
     // 运行状态
     std::atomic<bool> running_;
@@ -72,6 +145,11 @@ private:
     
     // 批次收集器
     std::unique_ptr<BatchBuffer> input_buffer_;
+    std::shared_ptr<MemoryAccount> memory_account_;   // 本流水线在进程级在途内存预算中的账户（帧的占用记录共同持有）
+    
+    // 入口阶段：相机运动估计（同时构建共享亮度金字塔）、近重复帧消除
+    std::unique_ptr<CameraMotionEstimator> camera_motion_;
+    std::unique_ptr<FrameDeduplicator> frame_dedup_;
     
     // 处理阶段
     std::unique_ptr<BatchSemanticSegmentation> semantic_seg_;
@@ -79,6 +157,8 @@ private:
     std::unique_ptr<BatchObjectDetection> object_detection_;
     std::unique_ptr<BatchObjectTracking> object_tracking_;
     std::unique_ptr<BatchEventDetermine> event_determine_;
+    std::unique_ptr<EventJournal> event_journal_;     // 事件判定阶段写入，查询接口读取
+    std::unique_ptr<EvidenceRecorder> evidence_recorder_;  // 事件取证片段（后台编码与写出）
     
     // 阶段连接器
     std::unique_ptr<BatchConnector> seg_to_mask_connector_;
@@ -110,9 +190,20 @@ private:
     std::thread status_monitor_thread_;
     std::chrono::seconds status_print_interval_;
     
+    // 瓶颈分析采样历史（状态监控线程按打印间隔采样）
+    static constexpr size_t MAX_SAMPLE_HISTORY = 12;
+    std::deque<PipelineSample> sample_history_;
+    mutable std::mutex sample_history_mutex_;
+    std::ofstream stats_record_file_;
+    
     // 内存监控器
     std::unique_ptr<MemoryMonitor> memory_monitor_;
     
+    // 帧缓冲区提前释放：各阶段完成后释放的缓冲区集合，释放的分割输入/违停缩放图进入复用池
+    std::vector<std::pair<const BatchStage*, FrameBufferSet>> buffer_release_plan_;
+    std::unique_ptr<FrameBufferPool> buffer_pool_;
+    std::atomic<uint64_t> released_buffer_bytes_{0};
+    
     // 初始化和清理方法
     
     // 协调线程函数
@@ -128,6 +219,25 @@ private:
     
     // 工具函数
     void decompose_batch_to_images(BatchPtr batch);
+    size_t estimate_frame_bytes(const ImageData& image) const;   // 帧在流水线中的估计内存占用
+    void build_buffer_release_plan();                             // 按已启用阶段的缓冲区使用集合计算释放点
+    void release_dead_buffers(const BatchStage* stage, const BatchPtr& batch);   // 阶段完成后释放其后无人使用的缓冲区
+    bool charge_frame(const ImageDataPtr& image, std::chrono::steady_clock::time_point deadline);
+    
+    // 入口阶段的流状态检查点：帧被批次缓冲区拒绝时撤销，未进入流水线的帧不影响后续帧的参考状态
+    struct IngressCheckpoint {
+        CameraMotionEstimator::Checkpoint motion;
+        FrameDeduplicator::Checkpoint dedup;
+    };
+    void run_ingress(const ImageDataPtr& image, IngressCheckpoint& checkpoint);
+    void revert_ingress(const ImageDataPtr& image, const IngressCheckpoint& checkpoint);
     bool initialize_stages();
     void cleanup_stages();
+    
+    // 已创建的阶段及其拓扑描述（按处理顺序）
+    struct StagePlacement {
+        const BatchStage* stage;
+        const StageTopology* topology;
+    };
+    std::vector<StagePlacement> stage_placements() const;
 };
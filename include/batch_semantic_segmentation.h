@@ -4,6 +4,8 @@
 #include "trt_seg_model.h"
 #include "pipeline_config.h"
 #include "thread_pool.h"
+#include "inference_scheduler.h"
+#include "cpu_inference.h"
 #include <thread>
 #include <atomic>
 #include <chrono>
@@ -28,12 +30,27 @@ public:
     // BatchStage接口实现
     bool process_batch(BatchPtr batch) override;
     std::string get_stage_name() const override;
+    StageProfileSnapshot get_profile() const override;
+    std::vector<ServiceSample> get_service_samples() const override;
     size_t get_processed_count() const override;
     double get_average_processing_time() const override;
     size_t get_queue_size() const override;
+    FrameBufferSet get_buffer_usage() const override;
     void start() override;
     void stop() override;
     
+    // GPU缓存锁的竞争统计
+    LockContentionSnapshot get_lock_stats() const { return gpu_mutex_.snapshot(); }
+    
+    // 设置分割输入与违停缩放图的复用池（由流水线管理器持有，需在 start() 前设置；nullptr 关闭）
+    void set_buffer_pool(FrameBufferPool* pool) { buffer_pool_ = pool; }
+    
+    // 推理调度器（GPU/CPU 后端分配与实测耗时）
+    const InferenceScheduler& get_scheduler() const { return *scheduler_; }
+    
+    // 重复帧继承参考帧分割结果、实际跳过推理的帧数
+    uint64_t get_dedup_reused_frames() const { return dedup_reused_frames_.load(); }
+    
     // 获取输入批次
     bool add_batch(BatchPtr batch);
     
@@ -86,15 +103,23 @@ private:
     std::unique_ptr<BatchConnector> output_connector_;
     
     // 性能统计
+    StageProfiler profiler_;                          // 耗时分布（计算/等输入/等输出/锁等待）
     std::atomic<size_t> processed_batch_count_{0};
     std::atomic<uint64_t> total_processing_time_ms_{0};
     std::atomic<uint64_t> total_images_processed_{0};
+    std::atomic<uint64_t> dedup_reused_frames_{0};
+    
+    // CPU 推理模型（gpu 模式下为空）与后端调度
+    std::unique_ptr<CpuSegmentationModel> cpu_seg_model_;
+    std::unique_ptr<InferenceScheduler> scheduler_;
+    
+    FrameBufferPool* buffer_pool_ = nullptr;          // 预处理目标缓冲区复用池
     
     // CUDA优化相关
     bool cuda_available_;
     cv::cuda::GpuMat gpu_src_cache_;
     cv::cuda::GpuMat gpu_dst_cache_;
-    mutable std::mutex gpu_mutex_;
+    mutable InstrumentedMutex gpu_mutex_{"BatchSemanticSegmentation::gpu_mutex_"};
     
     // 分割结果保存配置
     bool enable_seg_show_;
@@ -119,6 +144,7 @@ private:
     
     // 内部工具方法
     bool initialize_seg_models();
+    bool initialize_cpu_seg_model();
     void cleanup_seg_models();
     std::shared_ptr<BatchContext> create_batch_context(BatchPtr batch);
     void process_batch_context(std::shared_ptr<BatchContext> context, int thread_id);
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "stage_profiler.h"
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * 单个阶段的采样（累计值）
+ */
+struct StageSample {
+    std::string config_key;        // 对应 HighwayEventConfig 的线程数字段，如 detection_threads
+    std::string stage_name;        // 阶段名称
+    int threads = 1;               // 当前线程数
+    bool serialized = false;       // 阶段内部按批次串行（如跟踪需持锁保证时序），加线程无效
+    int concurrency = 1;           // 实际可并行处理的批次数（StageTopology::concurrency()）
+    int max_concurrency = 1;       // 加线程可达到的并发上限（模型实例、在途批次上限、串行）
+    uint64_t batches = 0;          // 已处理批次数
+    uint64_t images = 0;           // 已处理图像数
+    size_t input_queue = 0;        // 阶段前等待的批次数
+    StageProfileSnapshot profile;  // 耗时分布
+};
+
+/**
+ * 流水线采样（某一时刻所有阶段的累计值）
+ */
+struct PipelineSample {
+    uint64_t timestamp_ms = 0;     // 采样时刻（单调时钟）
+    uint64_t images_input = 0;
+    uint64_t images_output = 0;
+    std::vector<StageSample> stages;
+};
+
+/**
+ * 阶段分析结果（两次采样之间的增量）
+ */
+struct StageAnalysis {
+    std::string config_key;
+    std::string stage_name;
+    int threads = 1;
+    bool serialized = false;
+    int concurrency = 1;               // 实际可并行处理的批次数
+    int max_concurrency = 1;           // 加线程可达到的并发上限
+    double batches_per_second = 0.0;   // 实际吞吐（批次/秒）
+    double frames_per_batch = 0.0;     // 窗口内平均批次大小（各阶段可按自己的批次大小重组）
+    double frames_per_second = 0.0;    // 实际吞吐（帧/秒）
+    double service_ms = 0.0;           // 单批次处理墙钟时间
+    double cpu_ms_per_batch = 0.0;     // 单批次CPU时间（含线程池）
+    double utilisation = 0.0;          // 并发槽位忙碌占比（0-1）
+    double capacity_bps = 0.0;         // 按当前并发估算的最大吞吐（批次/秒）
+    double capacity_fps = 0.0;         // 按当前并发与平均批次大小估算的最大吞吐（帧/秒），阶段间以此比较
+    double queue_growth_per_second = 0.0; // 输入队列增长速率
+    double input_wait_ratio = 0.0;     // 等输入占比
+    double output_wait_ratio = 0.0;    // 等输出占比
+    double lock_wait_ratio = 0.0;      // 锁等待占比
+    double offcpu_ratio = 0.0;         // 处理期间不在CPU上的占比（GPU/线程池等待）
+    double ipc = 0.0;                  // 每周期指令数（无硬件计数时为0）
+    double cache_mpki = 0.0;           // 每千条指令缓存未命中
+    double branch_mpki = 0.0;          // 每千条指令分支预测失败
+    int recommended_threads = 1;       // 建议线程数
+};
+
+/**
+ * 瓶颈分析报告
+ */
+struct BottleneckReport {
+    bool valid = false;                // 样本不足时为false
+    double interval_seconds = 0.0;     // 分析窗口
+    double throughput_fps = 0.0;       // 窗口内输出帧率
+    int core_budget = 0;               // 分配线程时使用的核数预算
+    int spare_cores = 0;               // 加线程已无收益时剩余的核数
+    std::string limiting_stage;        // 限速阶段名称，输入受限时为空
+    std::string verdict;               // 结论说明
+    std::vector<StageAnalysis> stages;
+
+    // 多行文本报告
+    std::string to_string() const;
+};
+
+/**
+ * 流水线瓶颈分析器
+ *
+ * 对两次累计采样求增量，得到每个阶段的服务时间、利用率、输入队列增长，
+ * 以"并发数 / 单批次服务时间 × 平均批次大小"估算各阶段容量（帧/秒），
+ * 容量最低且利用率高或输入队列持续增长的阶段判定为限速阶段。各阶段批次大小
+ * 可以不同（连接器重组），因此阶段间只按帧/秒比较。并发数取 StageTopology::concurrency()：
+ * 协调线程逐批次投递并等待结果，线程数多于并发上限时多余线程不提高容量。
+ *
+ * 线程分配：每个启用的阶段先分配1个线程，剩余核数逐个分给当前容量最低的阶段
+ * （假设吞吐随并发数线性增长，并发不超过 max_concurrency）；最低容量阶段已达
+ * 并发上限（含串行阶段）时停止分配，剩余核数记为富余。
+ *
+ * 采样可通过 CSV 记录（见 PipelineConfig::stats_record_path），供离线命令行工具分析。
+ */
+class BottleneckAnalyzer {
+public:
+    /**
+     * 分析两次采样之间的窗口
+     * @param core_budget 核数预算，<=0 时使用硬件并发数
+     */
+    static BottleneckReport analyze(const PipelineSample& begin, const PipelineSample& end, int core_budget);
+
+    // CSV 格式：每个阶段一行，同一采样共享 timestamp_ms
+    static void write_csv_header(std::ostream& out);
+    static void append_csv(std::ostream& out, const PipelineSample& sample);
+
+    // 读取 CSV 记录，按时间顺序返回采样
+    static bool load_csv(const std::string& path, std::vector<PipelineSample>& samples);
+};
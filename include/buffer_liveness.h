@@ -0,0 +1,100 @@
+#pragma once
+
+#include "image_data.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/**
+ * 帧上的大块缓冲区（按位组合为集合）
+ */
+enum class FrameBuffer : uint32_t {
+    SOURCE_IMAGE = 1u << 0,    // imageMat / yuvImage 原图
+    SEG_INPUT = 1u << 1,       // segInResizeMat 分割输入（1024x1024）
+    PARKING_INPUT = 1u << 2,   // parkingResizeMat 违停检测缩放图
+    LABEL_MAP = 1u << 3,       // label_map 分割标签
+    MASK = 1u << 4,            // mask 后处理Mask
+};
+
+using FrameBufferSet = uint32_t;
+constexpr FrameBufferSet FRAME_BUFFERS_NONE = 0;
+constexpr FrameBufferSet FRAME_BUFFERS_ALL = 0x1f;
+
+constexpr FrameBufferSet operator|(FrameBuffer a, FrameBuffer b) {
+    return static_cast<FrameBufferSet>(a) | static_cast<FrameBufferSet>(b);
+}
+constexpr FrameBufferSet operator|(FrameBufferSet a, FrameBuffer b) {
+    return a | static_cast<FrameBufferSet>(b);
+}
+constexpr bool has_buffer(FrameBufferSet set, FrameBuffer b) {
+    return (set & static_cast<FrameBufferSet>(b)) != 0;
+}
+
+/**
+ * 帧缓冲区复用池（按 行数/列数/类型 分组）
+ * 只回收独占且连续的缓冲区：仍被其他 Mat 引用（如取证采集、调用方持有）的数据只减引用计数。
+ */
+class FrameBufferPool {
+public:
+    explicit FrameBufferPool(size_t max_per_shape = 64);
+
+    // 取一个指定形状的缓冲区，池中没有时新分配（内容未初始化）
+    cv::Mat acquire(int rows, int cols, int type);
+
+    // 归还缓冲区，调用后 mat 为空
+    void recycle(cv::Mat& mat);
+
+    uint64_t get_hits() const { return hits_.load(); }
+    uint64_t get_misses() const { return misses_.load(); }
+    size_t get_pooled_bytes() const { return pooled_bytes_.load(); }
+
+private:
+    using ShapeKey = std::tuple<int, int, int>;
+
+    size_t max_per_shape_;
+    std::mutex mutex_;
+    std::map<ShapeKey, std::vector<cv::Mat>> free_;
+    std::atomic<size_t> pooled_bytes_{0};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+/**
+ * 帧缓冲区活跃性计划
+ *
+ * 各阶段声明自己读取或生成的缓冲区（BatchStage::get_buffer_usage），按处理顺序排列后，
+ * 每个缓冲区在最后一个使用它的阶段完成后即可释放；交付后调用方仍要读取的缓冲区
+ * （ResultView::source_image / mask）不释放。
+ *
+ * 跨帧读取：近重复帧会在分割/Mask后处理阶段读取参考帧的 label_map 与 Mask，
+ * 而参考帧可能正在被释放，因此启用近重复帧消除时这两项由调用方列入 retained。
+ */
+class BufferLiveness {
+public:
+    BufferLiveness() = default;
+
+    /**
+     * @param stage_usage 已启用阶段按处理顺序的缓冲区使用集合
+     * @param retained 结果交付后仍保留的缓冲区
+     */
+    BufferLiveness(const std::vector<FrameBufferSet>& stage_usage, FrameBufferSet retained);
+
+    // 第 stage_index 个阶段完成后可释放的缓冲区
+    FrameBufferSet release_after(size_t stage_index) const;
+
+    /**
+     * 释放一帧的指定缓冲区，分割输入与违停缩放图归还到复用池（pool 为空时直接释放）
+     * @return 释放的字节数（共享数据也计入，用于预算记账）
+     */
+    static size_t release(ImageData& image, FrameBufferSet buffers, FrameBufferPool* pool);
+
+    // 缓冲区集合的可读描述，如 "分割输入+标签"
+    static std::string describe(FrameBufferSet buffers);
+
+private:
+    std::vector<FrameBufferSet> release_after_;
+};
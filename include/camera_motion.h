@@ -0,0 +1,84 @@
+#pragma once
+
+#include "image_data.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 相机运动估计配置
+ */
+struct CameraMotionConfig {
+    int pyramid_base_width = 480;         // 亮度金字塔第0层宽度（原图按最近邻抽取到该宽度）
+    int pyramid_levels = 3;               // 金字塔层数，逐层 pyrDown 减半
+    int estimate_level = 2;               // 做相位相关的层（1080p 下约 120x68）
+    double motion_ratio = 0.003;          // 全局平移超过原图宽度的该比例视为相机运动（1080p 约6像素）
+    double min_confidence = 0.3;          // 相位相关峰值低于该值时估计不可信，不判定为运动
+};
+
+/**
+ * 全局相机运动估计（流水线入口阶段）
+ *
+ * 每帧构建一次低分辨率亮度金字塔写入 ImageData::luma_pyramid，供近重复帧消除、
+ * 运动门控等需要缩略图的模块直接复用；在 estimate_level 层与同一视频流上一帧做
+ * 相位相关，得到全局平移及其置信度，写入 ImageData::camera_motion，各阶段只读。
+ *
+ * 开销：第0层由最近邻抽取（不对全分辨率图做颜色转换和区域平均），随后的 pyrDown
+ * 负责抗混叠，1080p 单核约0.5ms。估计精度约为估计层的1/4像素（1080p 约4像素），
+ * 用于判断相机是否移动/抖动足够，不用于像素级配准。
+ */
+class CameraMotionEstimator {
+public:
+    // 处理一帧之前的流状态，帧最终未进入流水线时据此撤销
+    struct Checkpoint {
+        int stream_id = 0;
+        const ImageData* frame = nullptr;     // 产生该检查点的帧
+        cv::Mat previous;
+        const ImageData* last_frame = nullptr;
+    };
+
+    explicit CameraMotionEstimator(const CameraMotionConfig& config = CameraMotionConfig());
+
+    // 构建金字塔并估计相对上一帧的全局运动（在 add_image 调用线程、内存预算接纳之后执行，同一流需按帧序号顺序调用）
+    void process(const ImageDataPtr& image, Checkpoint* checkpoint = nullptr);
+
+    // 撤销 process 对上一帧状态的更新（帧被批次缓冲区拒绝时调用，同一流按处理的逆序撤销）
+    void revert(const ImageDataPtr& image, const Checkpoint& checkpoint);
+
+    // 更新阈值配置
+    void set_config(const CameraMotionConfig& config);
+
+    // 清空所有流的上一帧状态
+    void reset();
+
+    // 统计信息
+    uint64_t get_frames_estimated() const { return frames_estimated_.load(); }
+    uint64_t get_frames_moving() const { return frames_moving_.load(); }
+    double get_average_cpu_us() const;    // 每帧平均线程CPU时间（金字塔 + 相位相关）
+
+    // 构建亮度金字塔：[0] 宽 base_width，其后逐层减半
+    static void build_pyramid(const cv::Mat& image, int base_width, int levels, std::vector<cv::Mat>& pyramid);
+
+    /**
+     * 获取指定尺寸的亮度缩略图
+     * 已有金字塔时从不小于目标尺寸的最小层缩放，否则从原图计算
+     */
+    static cv::Mat luma_thumb(const ImageData& image, int thumb_width, int thumb_height);
+
+private:
+    struct StreamState {
+        cv::Mat previous;                 // 上一帧估计层（CV_32F）
+        cv::Mat window;                   // 与 previous 同尺寸的汉宁窗
+        const ImageData* last_frame = nullptr; // 最近处理的帧（撤销时校验）
+    };
+
+    mutable std::mutex state_mutex_;
+    CameraMotionConfig config_;
+    std::unordered_map<int, StreamState> streams_;
+
+    std::atomic<uint64_t> frames_estimated_{0};
+    std::atomic<uint64_t> frames_moving_{0};
+    std::atomic<uint64_t> frames_processed_{0};
+    std::atomic<uint64_t> cpu_ns_{0};
+};
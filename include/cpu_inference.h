@@ -0,0 +1,103 @@
+#pragma once
+
+#include "image_data.h"
+#include <functional>
+#include <opencv2/dnn.hpp>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * CPU推理模型基类（OpenCV DNN 加载 ONNX）
+ *
+ * cv::dnn::Net 不能被多个线程同时 forward，因此每个 OpenMP 线程持有一个 Net 实例，
+ * 一个微批次内的图像用 OpenMP 并行分给各线程逐张推理（导出的 ONNX 常固定 batch=1）。
+ * 未启用 OpenMP 编译时退化为单线程顺序推理。
+ * 同一时刻只应有一个线程调用 infer（推理调度器的 CPU 线程池为单线程）。
+ */
+class CpuDnnModel {
+public:
+    /**
+     * @param model_path ONNX 模型路径
+     * @param threads OpenMP 线程数（Net 实例数），<=0 时取 CPU 核数的一半
+     */
+    CpuDnnModel(const std::string& model_path, int threads);
+    virtual ~CpuDnnModel() = default;
+
+    // 加载模型，失败时返回false
+    bool load();
+    bool is_loaded() const { return !nets_.empty(); }
+    int get_thread_count() const { return static_cast<int>(nets_.size()); }
+    const std::string& get_model_path() const { return model_path_; }
+
+protected:
+    /**
+     * 把 [0, count) 分给各 OpenMP 线程执行 fn(net, i)
+     * @return 全部成功时返回true，fn 抛出的异常在线程内捕获并记为失败
+     */
+    bool parallel_infer(size_t count, const std::function<bool(cv::dnn::Net&, size_t)>& fn);
+
+private:
+    std::string model_path_;
+    int threads_;
+    std::vector<cv::dnn::Net> nets_;
+};
+
+/**
+ * CPU语义分割结果
+ */
+struct CpuSegResult {
+    std::vector<uint8_t> label_map;
+    int height = 0;
+    int width = 0;
+};
+
+/**
+ * CPU语义分割（PP-Seg ONNX）
+ * 输入为已缩放到模型尺寸的 BGR 图（segInResizeMat），
+ * 输出 NCHW 类别分数时逐像素取 argmax，输出 NHW 标签时直接转换为 uint8。
+ */
+class CpuSegmentationModel : public CpuDnnModel {
+public:
+    struct Params {
+        int input_width = 1024;
+        int input_height = 1024;
+        // PP-Seg 默认归一化：(x / 255 - 0.5) / 0.5
+        double scale = 1.0 / 127.5;
+        cv::Scalar mean = cv::Scalar(127.5, 127.5, 127.5);
+        bool swap_rb = true;
+    };
+
+    CpuSegmentationModel(const std::string& model_path, int threads, const Params& params);
+
+    bool infer(const std::vector<cv::Mat>& images, std::vector<CpuSegResult>& results);
+
+private:
+    bool infer_one(cv::dnn::Net& net, const cv::Mat& image, CpuSegResult& result) const;
+
+    Params params_;
+};
+
+/**
+ * CPU车辆检测（YOLO ONNX）
+ * 输入为 ROI 裁剪图，按 letterbox 缩放到 input_size，输出框坐标相对于裁剪图，与 GPU 检测一致。
+ * ultralytics 格式输出为 [1, 4+类别数, 候选数]，否则为 YOLOv5 的 [1, 候选数, 5+类别数]。
+ */
+class CpuDetectionModel : public CpuDnnModel {
+public:
+    struct Params {
+        int input_size = 640;
+        float conf_threshold = 0.25f;
+        float nms_threshold = 0.2f;
+        bool ultralytics = true;
+    };
+
+    CpuDetectionModel(const std::string& model_path, int threads, const Params& params);
+
+    bool infer(const std::vector<cv::Mat>& images, std::vector<std::vector<ImageData::BoundingBox>>& results);
+
+private:
+    bool infer_one(cv::dnn::Net& net, const cv::Mat& image, std::vector<ImageData::BoundingBox>& boxes) const;
+
+    Params params_;
+};
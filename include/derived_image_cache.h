@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include "yuv_image.h"
+
+/**
+ * 派生图像的像素格式
+ */
+enum class DerivedImageFormat {
+    BGR = 0,
+    RGB = 1,
+    GRAY = 2,
+};
+
+/**
+ * 派生图像的键：(尺寸, 格式, 源图裁剪区域)
+ */
+struct DerivedImageKey {
+    cv::Size size;                                        // 目标尺寸
+    DerivedImageFormat format = DerivedImageFormat::BGR;
+    cv::Rect crop;                                        // 源图裁剪区域，空表示整图
+
+    DerivedImageKey() = default;
+    DerivedImageKey(cv::Size target_size, DerivedImageFormat target_format = DerivedImageFormat::BGR,
+                    cv::Rect source_crop = cv::Rect())
+        : size(target_size), format(target_format), crop(source_crop) {}
+
+    bool operator<(const DerivedImageKey& other) const;
+};
+
+/**
+ * 单帧的派生图像缓存（ImageData::derived_images）
+ *
+ * 各阶段按 (尺寸, 格式, 裁剪) 申请派生图，首次申请时计算，多个线程同时申请同一键时
+ * 只计算一次，其余线程等待并共享结果。计算时优先从已缓存的、同一裁剪区域、宽高比与目标
+ * 相同（2%容差内）且两个方向分辨率都不低于目标的最小派生图缩放，没有时才从原图计算。
+ * 原图为 YUV 时用融合内核一次完成 转换+缩放/裁剪，灰度派生图直接取自亮度平面。
+ * 返回的 Mat 与缓存共享数据，调用方不得修改像素内容。
+ */
+class DerivedImageCache {
+public:
+    // 目标缓冲区分配器（如复用池），为空时由 OpenCV 分配
+    using Allocator = std::function<cv::Mat(int rows, int cols, int type)>;
+
+    DerivedImageCache() = default;
+    DerivedImageCache(const DerivedImageCache&) = delete;
+    DerivedImageCache& operator=(const DerivedImageCache&) = delete;
+
+    /**
+     * 取派生图，未缓存时计算
+     * @param source 原图（BGR 或单通道灰度）
+     * @return 派生图，原图为空或计算失败时返回空Mat（失败不缓存，下次重新计算）
+     */
+    cv::Mat get(const cv::Mat& source, const DerivedImageKey& key, const Allocator& allocator = nullptr);
+
+    // 原图为 4:2:0 YUV 时取派生图，只读取裁剪区域内参与采样的样本
+    cv::Mat get(const YuvImage& source, const DerivedImageKey& key, const Allocator& allocator = nullptr);
+
+    // 已计算时返回派生图，否则返回空Mat（不触发计算）
+    cv::Mat peek(const DerivedImageKey& key) const;
+
+    // 移除与 mat 共享数据的缓存项（缓冲区提前释放时调用，使其可归还复用池）
+    void evict(const cv::Mat& mat);
+
+    void clear();
+    size_t size() const;
+
+    // 进程级统计：命中、从原图计算、从已缓存派生图计算
+    static uint64_t get_hits() { return hits_.load(); }
+    static uint64_t get_source_computes() { return source_computes_.load(); }
+    static uint64_t get_derived_computes() { return derived_computes_.load(); }
+
+private:
+    struct Entry {
+        std::once_flag once;
+        std::atomic<bool> ready{false};
+        cv::Mat image;
+    };
+
+    // 从原图计算裁剪区域 crop 的派生图
+    using SourceCompute = std::function<cv::Mat(const cv::Rect& crop)>;
+
+    cv::Mat get_or_compute(cv::Size source_size, const DerivedImageKey& key, const SourceCompute& compute_from_source,
+                           const Allocator& allocator);
+
+    // 找同一裁剪区域、同宽高比下可作为缩放来源的最小已缓存派生图，不超过源图尺寸（需持有 mutex_）
+    std::shared_ptr<Entry> find_base(const DerivedImageKey& key, cv::Size source_size,
+                                     DerivedImageFormat& base_format) const;
+    static cv::Mat compute(const cv::Mat& base, DerivedImageFormat base_format, const DerivedImageKey& key,
+                           const Allocator& allocator);
+    static cv::Mat compute_yuv(const YuvImage& source, const cv::Rect& crop, const DerivedImageKey& key,
+                               const Allocator& allocator);
+
+    mutable std::mutex mutex_;
+    std::map<DerivedImageKey, std::shared_ptr<Entry>> entries_;
+
+    static std::atomic<uint64_t> hits_;
+    static std::atomic<uint64_t> source_computes_;
+    static std::atomic<uint64_t> derived_computes_;
+};
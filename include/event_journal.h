@@ -0,0 +1,185 @@
+#pragma once
+
+#include "image_data.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 事件日志记录（小端序，1字节对齐，每条64字节）
+ *
+ * 文件布局：EventJournalHeader (64字节) + EventJournalRecord × record_count
+ * 一条记录对应一次完整的事件：某视频流中某条轨迹以某事件类型持续的区间。
+ * 记录在事件结束时追加，写入后不再修改，因此文件内记录按 end_ms 非降序排列。
+ */
+namespace event_journal {
+
+constexpr uint32_t kMagic = 0x4a455748;   // "HWEJ"
+constexpr uint16_t kVersion = 1;
+
+#pragma pack(push, 1)
+struct EventJournalHeader {
+    uint32_t magic;             // kMagic
+    uint16_t version;           // kVersion
+    uint16_t record_bytes;      // sizeof(EventJournalRecord)
+    uint64_t record_count;      // 已提交的记录数（先写记录，再更新该字段）
+    uint8_t reserved[48];
+};
+
+struct EventJournalRecord {
+    int32_t stream_id;
+    int32_t track_id;
+    int8_t event_type;          // ObjectStatus（已按静止标志重映射）
+    uint8_t open;               // 1 表示查询时仍在持续的事件（只出现在查询结果中，不落盘）
+    uint16_t reserved;
+    float peak_confidence;      // 事件期间的最高置信度
+    uint64_t start_frame;
+    uint64_t end_frame;         // 最后一次观察到该事件的帧
+    uint64_t start_ms;          // 事件开始时间（Unix毫秒）
+    uint64_t end_ms;
+    int32_t left, top, right, bottom;   // 事件开始时的目标框
+};
+#pragma pack(pop)
+
+static_assert(sizeof(EventJournalHeader) == 64, "EventJournalHeader 布局变化会破坏已有日志");
+static_assert(sizeof(EventJournalRecord) == 64, "EventJournalRecord 布局变化会破坏已有日志");
+
+} // namespace event_journal
+
+/**
+ * 事件日志配置
+ */
+struct EventJournalConfig {
+    int close_gap_frames = 25;            // 轨迹在本流连续该帧数未以同一事件出现时结束事件（同时消除状态抖动）
+    size_t queue_slots = 256;             // 事件阶段 -> 日志线程的观察队列槽位数（2的幂）
+    int64_t time_bucket_ms = 60000;       // 时间桶粒度（毫秒）
+    size_t initial_records = 1 << 16;     // 文件初始容量（记录数），满后按倍数扩展
+};
+
+/**
+ * 事件日志（只追加，mmap）
+ *
+ * 写入路径：事件判定阶段每帧调用 observe()，把该帧处于事件状态的目标写入预分配的
+ * 单生产者/单消费者环形队列，不加锁、稳态不分配内存；队列满时丢弃并计数，不阻塞流水线。
+ * 日志线程按帧消费观察，维护每条轨迹的进行中事件，事件结束时追加记录到映射文件。
+ *
+ * 二级索引（内存，打开时由文件重建）：
+ *   - 轨迹索引：(stream_id, track_id) -> 记录下标
+ *   - 时间桶索引：end_ms 所在时间桶 -> 该桶第一条记录下标（记录按 end_ms 有序）
+ * "最近 N 分钟的事件"只需从 now-N 所在桶开始顺序读，开销与结果数成正比。
+ *
+ * observe() 必须由同一时刻至多一个线程调用（事件判定阶段在批次锁内逐帧调用）：队列只有一个
+ * 写位置，并发写入会覆盖同一槽位。observe() 入口以一次无竞争的原子交换检查该约束，检测到并发
+ * 调用时丢弃该观察、计入 get_concurrent_observes() 并记录错误日志，而不是破坏队列。
+ * 打开时对日志文件加 flock(LOCK_EX)，同一日志文件同时只能由一个 EventJournal 写入。
+ */
+class EventJournal {
+public:
+    explicit EventJournal(const EventJournalConfig& config = EventJournalConfig());
+    ~EventJournal();
+
+    EventJournal(const EventJournal&) = delete;
+    EventJournal& operator=(const EventJournal&) = delete;
+
+    // 打开或创建日志文件并启动日志线程
+    bool open(const std::string& path);
+
+    // 结束所有进行中的事件、落盘并关闭
+    void close();
+
+    // 事件阶段调用：提交一帧的目标状态（无锁，单生产者）
+    void observe(const ImageData& image);
+
+    /**
+     * 与时间区间 [from_ms, to_ms] 有交集的事件
+     * 已结束的事件按结束时间升序在前，进行中的事件（open=1）在后
+     */
+    std::vector<event_journal::EventJournalRecord> query_time_range(uint64_t from_ms, uint64_t to_ms) const;
+
+    // 最近 last_ms 毫秒内发生或持续的事件
+    std::vector<event_journal::EventJournalRecord> query_recent(uint64_t last_ms) const;
+
+    // 指定轨迹的全部事件，已结束的在前、进行中的在后
+    std::vector<event_journal::EventJournalRecord> query_track(int32_t stream_id, int32_t track_id) const;
+
+    // 统计信息
+    uint64_t get_records() const { return record_count_.load(); }
+    uint64_t get_open_events() const { return open_event_count_.load(); }
+    uint64_t get_dropped_observations() const { return dropped_observations_.load(); }
+    uint64_t get_concurrent_observes() const { return concurrent_observes_.load(); }   // 违反单生产者约束的调用
+
+private:
+    struct ObservedBox {
+        int32_t track_id;
+        int8_t event_type;
+        float confidence;
+        int32_t left, top, right, bottom;
+    };
+
+    // 队列槽位：boxes 容量在消费后保留，稳态下生产者只做赋值
+    struct Slot {
+        int32_t stream_id = 0;
+        uint64_t frame_idx = 0;
+        uint64_t timestamp_ms = 0;
+        std::vector<ObservedBox> boxes;
+    };
+
+    struct OpenEvent {
+        event_journal::EventJournalRecord record;
+        uint64_t last_seen_seq = 0;                     // 最近一次出现时的本流帧序号（StreamState::frames_seen）
+    };
+
+    struct StreamState {
+        std::unordered_map<int32_t, OpenEvent> open;    // track_id -> 进行中的事件
+        uint64_t last_frame = 0;
+        uint64_t frames_seen = 0;                       // 本流已观察的帧数（结束间隔按此计数）
+        bool has_frame = false;
+    };
+
+    void journal_thread_func();
+    void consume(const Slot& slot);
+    void close_event(const OpenEvent& event);
+    bool append(const event_journal::EventJournalRecord& record);
+    bool grow(size_t min_records);
+    void index_record(size_t i, const event_journal::EventJournalRecord& record);
+
+    static uint64_t track_key(int32_t stream_id, int32_t track_id) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(stream_id)) << 32) | static_cast<uint32_t>(track_id);
+    }
+
+    EventJournalConfig config_;
+
+    // 单生产者/单消费者队列
+    std::vector<Slot> slots_;
+    size_t slot_mask_ = 0;
+    alignas(64) std::atomic<uint64_t> write_pos_{0};
+    alignas(64) std::atomic<uint64_t> read_pos_{0};
+    std::atomic<uint64_t> dropped_observations_{0};
+    std::atomic<bool> producing_{false};           // observe() 执行中（单生产者检查）
+    std::atomic<uint64_t> concurrent_observes_{0};
+
+    std::thread journal_thread_;
+    std::atomic<bool> running_{false};
+
+    // 日志线程私有：进行中的事件
+    std::unordered_map<int32_t, StreamState> streams_;
+    uint64_t last_end_ms_ = 0;
+
+    // 映射文件与索引（日志线程写，查询线程读）
+    mutable std::shared_mutex map_mutex_;
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    size_t map_records_ = 0;                      // 映射容量（记录数）
+    std::atomic<uint64_t> record_count_{0};
+    std::unordered_map<uint64_t, std::vector<uint32_t>> track_index_;
+    std::vector<uint32_t> bucket_first_;           // 时间桶 -> 第一条 end_ms 落入该桶或之后的记录
+    uint64_t bucket_base_ms_ = 0;
+    std::vector<OpenEvent> open_snapshot_;         // 进行中事件的快照，供查询合并
+    std::atomic<uint64_t> open_event_count_{0};
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "image_data.h"
+#include "memory_budget.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 事件取证片段配置
+ */
+struct EvidenceRecorderConfig {
+    std::string output_dir;               // 片段输出目录（每个片段一个子目录，另有 index.csv）
+    size_t memory_budget_bytes = 64 << 20; // 进程内所有采集器共享的缓存帧（预录环 + 未写出的片段 + 编码中）上限，取各实例配置的最大值
+    int thumb_width = 640;                // 缩小后的帧宽度（高度按比例）
+    int jpeg_quality = 80;                // JPEG质量，0 表示缓存原始缩小帧（写出时存为PNG）
+    int frame_stride = 5;                 // 每隔该帧数缓存一帧
+    int pre_event_frames = 100;           // 事件开始前保留的源帧数
+    int post_event_frames = 100;          // 事件开始后继续采集的源帧数（片段内出现新事件时顺延）
+    int max_clip_frames = 1500;           // 单个片段最多跨越的源帧数
+    int close_gap_frames = 25;            // 轨迹离开事件状态超过该帧数后再次进入视为新事件
+    int encode_threads = 1;               // 后台编码线程数
+};
+
+/**
+ * 事件取证片段采集器
+ *
+ * 每个视频流维护一个按内存预算裁剪的预录环（缩小后的JPEG或原始帧）。事件判定阶段对每帧调用
+ * submit()：只做事件触发判断和预算记账，缩放与编码提交到后台线程池，不在阶段工作线程执行。
+ * 轨迹新进入事件状态时开启片段：预录环中的帧转入片段，之后继续采集 post_event_frames 源帧，
+ * 结束后由写出线程异步写入 <output_dir>/<片段名>/ 并追加一行到 <output_dir>/index.csv。
+ *
+ * 内存预算为进程级：所有采集器实例（每个检测器一个）登记到同一预算，运行中的实例均分保留配额，
+ * 规则与流水线在途内存预算相同（见 MemoryBudget）。超出时先淘汰本实例最旧的预录帧；
+ * 已属于片段的帧不淘汰，仍不足时丢弃新帧并计数。
+ *
+ * 多个实例可共用同一输出目录：片段号进程内唯一，目录名带实例前缀
+ * （r<实例>_s<流>_<片段号>_<触发帧>），目录已存在（其他进程或上次运行遗留）时追加序号；
+ * index.csv 以追加方式打开，每行在 flock 下一次写入，不同实例/进程的行不会交错。
+ * submit() 必须由同一时刻至多一个线程调用（事件判定阶段在批次锁内逐帧调用）。
+ */
+class EvidenceRecorder {
+public:
+    explicit EvidenceRecorder(const EvidenceRecorderConfig& config);
+    ~EvidenceRecorder();
+
+    EvidenceRecorder(const EvidenceRecorder&) = delete;
+    EvidenceRecorder& operator=(const EvidenceRecorder&) = delete;
+
+    // 创建输出目录，启动编码线程池与写出线程
+    bool start();
+
+    // 结束进行中的片段，等待编码与写出完成
+    void stop();
+
+    // 事件判定阶段调用：提交一帧（只引用原图，不拷贝）
+    void submit(const ImageDataPtr& image);
+
+    // 统计信息
+    uint64_t get_frames_captured() const { return frames_captured_.load(); }
+    uint64_t get_frames_dropped() const { return frames_dropped_.load(); }
+    uint64_t get_frames_evicted() const { return frames_evicted_.load(); }
+    uint64_t get_clips_written() const { return clips_written_.load(); }
+    size_t get_memory_bytes() const { return budget_account_->get_used_bytes(); }
+    size_t get_memory_quota_bytes() const { return budget_account_->get_reserved_bytes(); }
+    // 进程内所有采集器的缓存合计
+    size_t get_process_memory_bytes() const { return budget_account_->get_budget().get_used_bytes(); }
+
+private:
+    // 缓存帧：提交时按预估大小记账，编码完成后修正为实际大小
+    struct EvidenceFrame {
+        uint64_t frame_idx = 0;
+        uint64_t timestamp_ms = 0;
+        std::vector<uchar> jpeg;              // jpeg_quality > 0
+        cv::Mat raw;                          // jpeg_quality == 0
+        std::shared_ptr<MemoryCharge> charge; // 预算占用（被淘汰或写出后置空，编码结果直接丢弃）
+        bool ready = false;                   // 编码完成（失败时 ready 且数据为空）
+    };
+    using FramePtr = std::shared_ptr<EvidenceFrame>;
+
+    struct ClipEvent {
+        int track_id;
+        int event_type;
+        uint64_t frame_idx;
+    };
+
+    // 片段窗口按流内源帧计数（seq）计算，输出使用 SDK 帧序号
+    struct Clip {
+        uint64_t clip_id = 0;
+        int stream_id = 0;
+        uint64_t trigger_frame = 0;           // 触发帧的帧序号
+        uint64_t end_seq = 0;                 // 采集到该流内计数（含）为止
+        uint64_t max_end_seq = 0;
+        std::vector<ClipEvent> events;
+        std::vector<FramePtr> frames;
+    };
+
+    struct StreamState {
+        uint64_t frames_seen = 0;
+        std::deque<FramePtr> ring;            // 预录环，按帧序号升序
+        std::unordered_map<uint64_t, uint64_t> event_last_seen;  // (track_id, 事件类型) -> 最后出现的流内计数
+        std::unique_ptr<Clip> clip;           // 进行中的片段
+    };
+
+    FramePtr capture_frame(const ImageDataPtr& image, uint64_t timestamp_ms);
+    // 申请预算，不足时淘汰本实例最旧的预录帧；仍不足时返回空
+    std::shared_ptr<MemoryCharge> reserve_bytes(size_t bytes);
+    // source 为 BGR 原图；以 YUV 输入时 source 为空，缩略图由 yuv 直接转换缩放得到
+    void encode_frame(FramePtr frame, cv::Mat source, YuvImage yuv);
+    void finish_clip(StreamState& state);
+    static bool clip_ready(const Clip& clip);
+    void writer_thread_func();
+    void write_clip(const Clip& clip);
+    void append_index(const std::string& line);
+
+    static uint64_t event_key(int track_id, int event_type) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(track_id)) << 8) | static_cast<uint8_t>(event_type);
+    }
+
+    EvidenceRecorderConfig config_;
+    uint64_t instance_id_ = 0;                // 进程内实例编号，用作片段目录前缀
+    size_t ring_capacity_ = 0;                // 预录环帧数
+    double jpeg_ratio_ = 0.1;                 // JPEG字节数/原始字节数的滑动平均，用于提交时预估
+
+    std::unique_ptr<ThreadPool> encode_pool_;
+    std::shared_ptr<MemoryAccount> budget_account_;   // 进程级采集器预算中的本实例账户
+
+    // 流状态（submit、编码完成回调、写出线程共享）
+    mutable std::mutex mutex_;
+    std::unordered_map<int, StreamState> streams_;
+
+    // 已结束、等待写出的片段
+    std::deque<std::unique_ptr<Clip>> finished_clips_;
+    std::condition_variable writer_cv_;
+    std::thread writer_thread_;
+    int index_fd_ = -1;
+    bool accepting_ = false;                  // submit 是否接收新帧
+    bool running_ = false;                    // 写出线程是否继续等待
+
+    std::atomic<uint64_t> frames_captured_{0};
+    std::atomic<uint64_t> frames_dropped_{0};
+    std::atomic<uint64_t> frames_evicted_{0};
+    std::atomic<uint64_t> clips_written_{0};
+};
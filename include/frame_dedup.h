@@ -0,0 +1,89 @@
+#pragma once
+
+#include "image_data.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * 近重复帧消除配置
+ */
+struct FrameDedupConfig {
+    int thumb_width = 64;                 // 感知签名缩略图宽度
+    int thumb_height = 36;                // 感知签名缩略图高度
+    double diff_threshold = 2.0;          // 平均亮度绝对差阈值（0-255），低于该值视为重复
+    int max_consecutive_skips = 25;       // 连续重复帧上限，超过后强制作为关键帧重新推理
+};
+
+/**
+ * 近重复帧消除器（流水线入口阶段）
+ * 对每帧计算低分辨率亮度签名，与同一视频流最近的关键帧比较。
+ * 近似重复的帧被标记为 is_duplicate，并引用关键帧，
+ * 分割、Mask后处理和检测阶段在参考帧完成后直接继承其结果，
+ * 跟踪和违停判断仍逐帧推进。
+ * 标记只表示可以复用，是否真正跳过推理由各阶段决定并计数
+ * （参考帧尚未完成该阶段时重复帧仍需推理）。
+ */
+class FrameDeduplicator {
+public:
+    // 处理一帧之前的流状态，帧最终未进入流水线时据此撤销
+    struct Checkpoint {
+        int stream_id = 0;
+        const ImageData* frame = nullptr;     // 产生该检查点的帧
+        std::weak_ptr<ImageData> key_frame;
+        cv::Mat key_signature;
+        int consecutive_skips = 0;
+        const ImageData* last_frame = nullptr;
+    };
+
+    explicit FrameDeduplicator(const FrameDedupConfig& config = FrameDedupConfig());
+
+    // 计算签名并判定是否重复（在 add_image 调用线程、内存预算接纳之后执行）
+    void process(const ImageDataPtr& image, Checkpoint* checkpoint = nullptr);
+
+    /**
+     * 撤销 process 对关键帧状态的更新（帧被批次缓冲区拒绝时调用）
+     * 同一流的多帧按处理的逆序撤销；之后该流又处理过其他帧时不撤销
+     */
+    void revert(const ImageDataPtr& image, const Checkpoint& checkpoint);
+
+    // 更新阈值配置
+    void set_config(const FrameDedupConfig& config);
+
+    // 清空所有流的关键帧状态
+    void reset();
+
+    // 统计信息
+    uint64_t get_frames_checked() const { return frames_checked_.load(); }
+    uint64_t get_frames_marked() const { return frames_marked_.load(); }   // 标记为重复的帧数
+
+    /**
+     * 获取可复用结果的参考帧
+     * @param image 当前帧
+     * @param stage_flag 参考帧需已完成的阶段标志（如 &ImageData::detection_completed）
+     * @return 当前帧为重复帧且参考帧已完成该阶段时返回参考帧，否则返回nullptr
+     */
+    static ImageDataPtr reusable_reference(const ImageDataPtr& image,
+                                           std::atomic<bool> ImageData::*stage_flag);
+
+    // 计算亮度缩略图签名
+    static cv::Mat compute_signature(const cv::Mat& image, int thumb_width, int thumb_height);
+
+    // 两个签名的平均亮度绝对差
+    static double signature_distance(const cv::Mat& a, const cv::Mat& b);
+
+private:
+    struct StreamState {
+        std::weak_ptr<ImageData> key_frame;   // 最近的关键帧
+        cv::Mat key_signature;                // 关键帧签名
+        int consecutive_skips = 0;            // 当前连续重复帧数
+        const ImageData* last_frame = nullptr; // 最近处理的帧（撤销时校验）
+    };
+
+    mutable std::mutex state_mutex_;
+    FrameDedupConfig config_;
+    std::unordered_map<int, StreamState> streams_;
+
+    std::atomic<uint64_t> frames_checked_{0};
+    std::atomic<uint64_t> frames_marked_{0};
+};
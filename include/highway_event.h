@@ -6,12 +6,14 @@
 #include "box_event.h"
 #include "image_data.h"
 #include "batch_pipeline_manager.h"
+#include "result_delta.h"
 #include <string>
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <unordered_map>
 #include <thread>
+#include <iterator>
 
 /**
  * 高速公路事件检测配置参数
@@ -40,6 +42,13 @@ struct HighwayEventConfig {
     int det_max_opt = 64;                                   // 最大优化尺寸
     int det_is_ultralytics = 1;                             // 是否使用Ultralytics格式
     int det_gpu_id = 0;                                     // GPU设备ID
+
+    // === 推理后端配置 ===
+    std::string inference_mode = "gpu";                     // gpu / cpu（纯CPU部署，不加载TensorRT模型）/ hybrid（GPU饱和时溢出到CPU）
+    std::string cpu_seg_model_path;                         // CPU语义分割ONNX模型，空时使用 seg_model_path
+    std::string cpu_det_model_path;                         // CPU车辆检测ONNX模型，空时使用 car_det_model_path
+    int cpu_infer_threads = 0;                              // 每个推理阶段的CPU推理线程数，0 取核数一半
+    int infer_micro_batch = 4;                              // 每个微批次的图像数
     
     // === 筛选配置 ===
     float box_filter_top_fraction = 4.0f / 7.0f;           // 筛选区域上边界比例
@@ -49,6 +58,81 @@ struct HighwayEventConfig {
     // === 队列配置 ===
     int result_queue_capacity = 500;                        // 结果队列容量
 
+    // === 组批配置 ===
+    bool batch_by_shape = true;                             // 不同分辨率/流类别的帧分别组批（流类别由 FrameSource::stream_class 指定）
+    int batch_max_bypass = 4;                               // 未满批次最多被其他分辨率的批次越过的次数，0 不限制
+    int seg_batch_size = 32;                                // 语义分割批次大小（即组批大小）
+    int mask_batch_size = 0;                                // Mask后处理批次大小，0 沿用上游批次
+    int detection_batch_size = 0;                           // 目标检测批次大小，0 沿用上游批次
+    int tracking_batch_size = 0;                            // 目标跟踪批次大小，1 逐帧，0 沿用上游批次
+    int event_batch_size = 0;                               // 事件判定批次大小，0 沿用上游批次
+    int rebatch_flush_ms = 50;                              // 合并批次时未凑满批次的最长等待时间
+    int memory_budget_mb = 0;                               // 进程级在途内存预算（MB，取各实例的最大值），0 不限制
+    bool enable_buffer_release = true;                      // 帧缓冲区在最后一个使用阶段完成后提前释放
+    bool result_keep_source_image = true;                   // 结果保留原图，关闭后 ResultView::source_image 为空
+    bool result_keep_mask = true;                           // 结果保留Mask，关闭后 ResultView::mask 为空
+
+    // === 近重复帧消除配置 ===
+    bool enable_frame_dedup = false;                        // 启用近重复帧消除
+    int dedup_thumb_width = 64;                             // 感知签名缩略图宽度
+    int dedup_thumb_height = 36;                            // 感知签名缩略图高度
+    float dedup_diff_threshold = 2.0f;                      // 平均亮度绝对差阈值（0-255）
+    int dedup_max_consecutive_skips = 25;                   // 连续重复帧上限
+
+    // === 运动门控配置 ===
+    bool enable_motion_gate = false;                        // 启用运动门控（无运动帧复用检测结果）
+    int motion_gate_thumb_width = 160;                      // 帧差缩略图宽度
+    int motion_gate_thumb_height = 90;                      // 帧差缩略图高度
+    int motion_pixel_threshold = 15;                        // 像素亮度差阈值（0-255）
+    float motion_area_ratio = 0.002f;                       // ROI内变化像素占比阈值
+    int motion_refresh_interval = 25;                       // 无运动时的周期刷新间隔（帧）
+
+    // === 相机运动估计配置 ===
+    bool enable_camera_motion = false;                      // 每帧估计全局相机运动（云台转动、风吹抖动）
+    float camera_motion_ratio = 0.003f;                     // 全局平移超过图像宽度的该比例视为相机运动
+    float camera_motion_min_confidence = 0.3f;              // 相位相关峰值下限
+
+    // === 目标跟踪配置 ===
+    bool use_builtin_tracker = false;                       // 使用内置多目标跟踪器（否则使用外部 xtkj 跟踪库）
+    int tracker_frame_rate = 30;                            // 视频帧率
+    int tracker_buffer_frames = 30;                         // 丢失轨迹保留帧数（按30fps计）
+    float tracker_track_thresh = 0.5f;                      // 高分检测阈值
+    float tracker_high_thresh = 0.6f;                       // 新建轨迹所需的最低置信度
+    float tracker_match_thresh = 0.8f;                      // 关联代价阈值（1 - IoU）
+
+    // === 静止判定配置 ===
+    bool enable_track_stillness = false;                    // 固定机位用轨迹框历史判定静止（相机运动时回退特征点路径），可由 FrameSource::track_stillness 按流覆盖
+    int stillness_history_frames = 25;                      // 每条轨迹保留的历史帧数
+    float stillness_displacement_ratio = 0.15f;             // 窗口内位移低于框高的该倍数视为静止
+    int stillness_camera_hold_frames = 50;                  // 检测到相机运动后使用特征点路径的帧数
+    std::string track_record_path;                          // 非空时记录跟踪框CSV（StillnessBenchmark 回放）
+
+    // === 增量输出配置 ===
+    bool enable_delta_output = false;                       // 结果附带相对上一帧的增量（ResultView::delta）
+    int delta_keyframe_interval = 50;                       // 关键帧间隔（帧），关键帧携带完整目标集合
+    int delta_move_threshold_px = 8;                        // 目标框移动超过该像素数才作为变化下发
+    float delta_move_threshold_ratio = 0.1f;                // 同上，按框高比例计，两者取较大值
+
+    // === 结果归档配置 ===
+    std::string result_archive_path;                        // 非空时逐帧追加结果到二进制归档（ResultArchiveReader 读取）
+    int result_archive_fsync_ms = 1000;                     // 归档批量 fsync 间隔（毫秒）
+
+    // === 事件日志配置 ===
+    std::string event_journal_path;                         // 非空时记录事件区间（开始/结束帧、峰值置信度、起始框）
+    int event_close_gap_frames = 25;                        // 轨迹连续该帧数不再处于同一事件时结束事件
+
+    // === 事件取证片段配置 ===
+    std::string evidence_output_dir;                        // 非空时为每次事件保存前后片段（子目录 + index.csv）
+    int evidence_memory_budget_mb = 64;                     // 进程内所有检测器的取证缓存帧共享上限（MB，取各实例的最大值）
+    int evidence_thumb_width = 640;                         // 缓存帧宽度（像素）
+    int evidence_jpeg_quality = 80;                         // JPEG质量，0 表示缓存原始缩小帧
+    int evidence_frame_stride = 5;                          // 每隔该帧数缓存一帧
+    int evidence_pre_frames = 100;                          // 事件前保留的源帧数
+    int evidence_post_frames = 100;                         // 事件后采集的源帧数
+
+    // === 瓶颈分析配置 ===
+    std::string stats_record_path;                          // 非空时记录阶段采样CSV（bottleneck_analyzer 离线分析）
+    bool enable_perf_counters = false;                      // 按阶段统计硬件计数（IPC、缓存/分支未命中），内核不允许时自动降级
     
     // === 模块开关配置 ===
     bool enable_segmentation = true;       // 启用语义分割模块
@@ -73,7 +157,7 @@ struct HighwayEventConfig {
     std::string log_level = "INFO";                         // 日志级别 (DEBUG, INFO, WARN, ERROR)
     
     // === 超时配置 ===
-    int add_timeout_ms = 5000;                              // 添加帧超时时间（毫秒）
+    int add_timeout_ms = 5000;                              // 添加帧超时时间（毫秒），<0 表示背压时一直阻塞
     int get_timeout_ms = 30000;                             // 获取结果超时时间（毫秒）
 };
 
@@ -106,6 +190,26 @@ enum class ResultStatus {
     ERROR = 4           // 错误
 };
 
+/**
+ * 添加帧状态
+ */
+enum class AddFrameStatus {
+    OK = 0,             // 已全部接纳
+    BUSY = 1,           // 流水线背压，超时前未能接纳（批量提交时可能已接纳部分帧）
+    NOT_RUNNING = 2,    // 流水线未运行
+    INVALID_INPUT = 3,  // 输入图像为空
+    ERROR = 4           // 内部错误
+};
+
+/**
+ * 帧来源信息，随帧进入流水线
+ */
+struct FrameSource {
+    int stream_id = 0;      // 视频流ID，去重、运动门控、跟踪等跨帧状态按流隔离
+    int stream_class = 0;   // 流类别（同型号/同用途相机），batch_by_shape 时与分辨率一起决定批次分桶
+    int track_stillness = -1;   // 本流的轨迹历史静止判定：-1 沿用 enable_track_stillness，0 关闭（特征点路径），1 开启
+};
+
 /**
  * 处理结果
  */
@@ -119,10 +223,134 @@ struct ProcessResult {
     cv::Mat srcImage;                   // 源图像（可选）
     cv::Rect roi;                          // 感兴趣区域
     
-    ProcessResult() : status(ResultStatus::PENDING), frame_id(0), 
+    ProcessResult() : status(ResultStatus::PENDING), frame_id(0),
                      has_filtered_box(false) {}
 };
 
+/**
+ * 结果视图 - 直接引用流水线内部的帧数据，不做拷贝
+ *
+ * 生命周期：视图持有该帧 ImageData 的引用，最后一个视图（及其拷贝）
+ * 析构或 reset() 时帧数据才被释放。持有视图期间帧图像、掩码一直占用内存
+ * （共享内存输入时还会占用帧槽位），取完所需数据后应尽快释放。
+ * 流水线在结果交付后不再修改帧数据，视图可在多线程间只读共享。
+ *
+ * 目标框通过迭代器访问，状态重映射（静止目标 -> 违停类事件）在解引用时进行。
+ */
+class ResultView {
+public:
+    /**
+     * 目标框只读迭代器，解引用时按需转换为 DetectionBox
+     */
+    class BoxIterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = DetectionBox;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = DetectionBox;
+
+        BoxIterator() : box_(nullptr) {}
+        explicit BoxIterator(const ImageData::BoundingBox* box) : box_(box) {}
+
+        DetectionBox operator*() const { return ResultView::to_detection_box(*box_); }
+        DetectionBox operator[](difference_type n) const { return ResultView::to_detection_box(box_[n]); }
+        BoxIterator& operator++() { ++box_; return *this; }
+        BoxIterator operator++(int) { BoxIterator tmp(*this); ++box_; return tmp; }
+        BoxIterator& operator--() { --box_; return *this; }
+        BoxIterator operator--(int) { BoxIterator tmp(*this); --box_; return tmp; }
+        BoxIterator& operator+=(difference_type n) { box_ += n; return *this; }
+        BoxIterator& operator-=(difference_type n) { box_ -= n; return *this; }
+        BoxIterator operator+(difference_type n) const { return BoxIterator(box_ + n); }
+        BoxIterator operator-(difference_type n) const { return BoxIterator(box_ - n); }
+        difference_type operator-(const BoxIterator& other) const { return box_ - other.box_; }
+        bool operator==(const BoxIterator& other) const { return box_ == other.box_; }
+        bool operator!=(const BoxIterator& other) const { return box_ != other.box_; }
+        bool operator<(const BoxIterator& other) const { return box_ < other.box_; }
+
+        // 未重映射的原始目标框
+        const ImageData::BoundingBox& raw() const { return *box_; }
+
+    private:
+        const ImageData::BoundingBox* box_;
+    };
+
+    // 空视图，状态为 PENDING
+    ResultView();
+
+    // 无数据的视图（超时、未找到、错误等）
+    ResultView(ResultStatus status, uint64_t frame_id);
+
+    // 引用已完成的帧数据，状态为 SUCCESS
+    explicit ResultView(ImageDataPtr image_data);
+
+    ResultStatus status() const { return status_; }
+    uint64_t frame_id() const { return frame_id_; }
+    bool has_data() const { return static_cast<bool>(image_data_); }
+
+    // 目标框访问（状态已重映射）
+    size_t box_count() const;
+    bool empty() const { return box_count() == 0; }
+    DetectionBox box(size_t index) const;
+    BoxIterator begin() const;
+    BoxIterator end() const;
+
+    // 筛选出的最佳目标框
+    bool has_filtered_box() const;
+    DetectionBox filtered_box() const;
+
+    // 感兴趣区域
+    cv::Rect roi() const;
+
+    /**
+     * 源图像（共享数据，不拷贝），无数据或 result_keep_source_image 关闭时返回空Mat
+     * 以 YUV 输入的帧在首次调用时整帧转换为 BGR 并缓存
+     * 调用方不得修改像素内容，需要修改时请自行 clone()
+     */
+    cv::Mat source_image() const;
+
+    /**
+     * Mask后处理结果（共享数据，不拷贝），未启用分割、无数据或 result_keep_mask 关闭时返回空Mat
+     */
+    cv::Mat mask() const;
+
+    /**
+     * 相对同一流上一帧的增量结果（见 ResultDelta），未启用增量输出或无数据时返回nullptr
+     * 关键帧的完整目标集合即本视图的目标框
+     */
+    const ResultDelta* delta() const;
+
+    // 释放对帧数据的引用
+    void reset();
+
+    /**
+     * 生成独立的 ProcessResult 拷贝（不含 mask/srcImage）
+     */
+    ProcessResult to_process_result() const;
+
+    /**
+     * 上报状态重映射：静止的正常目标视为违停，静止的占道目标视为应急车道停车
+     */
+    static ObjectStatus remap_status(ObjectStatus status, bool is_still);
+
+    // 流水线内部目标框转换为对外的 DetectionBox（含状态重映射）
+    static DetectionBox to_detection_box(const ImageData::BoundingBox& box);
+
+private:
+    ResultStatus status_;
+    uint64_t frame_id_;
+    ImageDataPtr image_data_;
+};
+
+/**
+ * 流水线缓冲区占用快照
+ */
+struct PipelineOccupancy {
+    BatchPipelineManager::Occupancy pipeline;  // 批次缓冲区、连接器和结果队列
+    size_t result_cache = 0;                   // 已发布、等待 get_result 取走的结果数
+    size_t result_cache_capacity = 0;
+};
+
 /**
  * 高速公路事件检测器 - 纯虚接口
  * 
@@ -162,18 +390,79 @@ public:
 
     
     /**
-     * 添加图像数据到流水线
+     * 添加图像数据到流水线，背压时最多等待配置的 add_timeout_ms
      * @param image 输入图像
-     * @return 成功返回帧序号（>=0），失败返回-1
+     * @param source 帧来源（视频流ID等）
+     * @return 成功返回帧序号（>=0），失败或超时返回-1
      */
-    virtual int64_t add_frame(const cv::Mat& image) = 0;
+    virtual int64_t add_frame(const cv::Mat& image, const FrameSource& source = FrameSource()) = 0;
     
     /**
-     * 添加图像数据到流水线（移动语义）
+     * 添加图像数据到流水线（移动语义），背压时最多等待配置的 add_timeout_ms
      * @param image 输入图像（移动）
-     * @return 成功返回帧序号（>=0），失败返回-1
+     * @param source 帧来源（视频流ID等）
+     * @return 成功返回帧序号（>=0），失败或超时返回-1
+     */
+    virtual int64_t add_frame(cv::Mat&& image, const FrameSource& source = FrameSource()) = 0;
+    
+    /**
+     * 非阻塞添加图像，流水线背压时立即返回 BUSY
+     * @param image 输入图像
+     * @param frame_id 成功时返回帧序号
+     * @param source 帧来源（视频流ID等）
+     * @return 添加状态
      */
-    virtual int64_t add_frame(cv::Mat&& image) = 0;
+    virtual AddFrameStatus try_add_frame(const cv::Mat& image, uint64_t& frame_id,
+                                         const FrameSource& source = FrameSource()) = 0;
+    
+    /**
+     * 添加图像，背压时最多等待 timeout_ms 毫秒
+     * @param image 输入图像
+     * @param timeout_ms 超时时间（毫秒），0表示不等待，<0表示一直等待
+     * @param frame_id 成功时返回帧序号
+     * @param source 帧来源（视频流ID等）
+     * @return 添加状态
+     */
+    virtual AddFrameStatus add_frame_with_timeout(const cv::Mat& image, int timeout_ms, uint64_t& frame_id,
+                                                  const FrameSource& source = FrameSource()) = 0;
+    
+    /**
+     * 批量添加图像，整组在一次加锁中接纳，帧序号连续
+     * 背压时按顺序接纳尽可能多的帧，未接纳的帧序号为-1
+     * @param images 图像数组
+     * @param count 图像数量
+     * @param frame_ids 输出每帧的帧序号（大小为count）
+     * @param timeout_ms 超时时间（毫秒），默认使用配置中的 add_timeout_ms
+     * @param sources 每帧的来源（大小为count），为空时均使用默认来源
+     * @return 全部接纳返回 OK，部分或全部未接纳返回 BUSY
+     */
+    virtual AddFrameStatus add_frames(const cv::Mat* images, size_t count,
+                                      std::vector<int64_t>& frame_ids, int timeout_ms = USE_CONFIG_TIMEOUT,
+                                      const FrameSource* sources = nullptr) = 0;
+    
+    AddFrameStatus add_frames(const std::vector<cv::Mat>& images, std::vector<int64_t>& frame_ids,
+                              int timeout_ms = USE_CONFIG_TIMEOUT, const FrameSource* sources = nullptr) {
+        return add_frames(images.data(), images.size(), frame_ids, timeout_ms, sources);
+    }
+    
+    /**
+     * 添加 4:2:0 YUV 图像（如解码器输出的 NV12，拷贝），背压时最多等待配置的 add_timeout_ms
+     * 流水线不做整帧色彩转换，各阶段只转换自己需要的尺寸与区域
+     * @param image YUV 图像，宽高须为偶数
+     * @param source 帧来源（视频流ID等）
+     * @return 成功返回帧序号（>=0），失败或超时返回-1
+     */
+    virtual int64_t add_frame(const YuvImage& image, const FrameSource& source = FrameSource()) = 0;
+    
+    /**
+     * 批量添加 YUV 图像，语义同 add_frames(const cv::Mat*, ...)
+     */
+    virtual AddFrameStatus add_frames(const YuvImage* images, size_t count,
+                                      std::vector<int64_t>& frame_ids, int timeout_ms = USE_CONFIG_TIMEOUT,
+                                      const FrameSource* sources = nullptr) = 0;
+    
+    // 使用配置中 add_timeout_ms 的超时标记
+    static constexpr int USE_CONFIG_TIMEOUT = INT32_MIN;
     
     /**
      * 获取指定帧序号的处理结果
@@ -190,6 +479,22 @@ public:
      */
     virtual ProcessResult get_result_with_timeout(uint64_t frame_id, int timeout_ms) = 0;
     
+    /**
+     * 获取指定帧序号的结果视图（不拷贝目标框、掩码和源图像）
+     * 视图持有帧数据直到其析构，见 ResultView
+     * @param frame_id 帧序号
+     * @return 结果视图，失败时 status() 不为 SUCCESS 且无数据
+     */
+    virtual ResultView get_result_view(uint64_t frame_id) = 0;
+    
+    /**
+     * 获取指定帧序号的结果视图（带超时）
+     * @param frame_id 帧序号
+     * @param timeout_ms 超时时间（毫秒）
+     * @return 结果视图
+     */
+    virtual ResultView get_result_view_with_timeout(uint64_t frame_id, int timeout_ms) = 0;
+    
     /**
      * 停止流水线
      */
@@ -218,6 +523,59 @@ public:
      * @return 状态信息字符串
      */
     virtual std::string get_pipeline_status() const = 0;
+    
+    /**
+     * 开始时间线追踪抓取（批次组装、各阶段预处理/推理/后处理、连接器等待、结果发布）
+     * 追踪数据为进程级，多个检测器实例共享同一次抓取；未抓取时埋点只有一次分支开销
+     * @param events_per_thread 每个线程最多记录的事件数，超出部分丢弃
+     * @return 已在抓取中返回false
+     */
+    virtual bool start_trace_capture(size_t events_per_thread = 1 << 16) = 0;
+    
+    /**
+     * 停止追踪抓取并导出 Chrome trace-event JSON（chrome://tracing 或 Perfetto UI 打开）
+     * @param output_path 输出文件路径
+     * @return 导出成功返回true
+     */
+    virtual bool stop_trace_capture(const std::string& output_path) = 0;
+    
+    /**
+     * 分析流水线瓶颈：结合各阶段利用率、输入队列增长和服务时间判定限速阶段，
+     * 并按核数预算给出各阶段线程数建议（对应本配置的 *_threads 字段）
+     * 分析窗口为最近约一分钟（状态监控线程每5秒采样一次）
+     * @param core_budget 核数预算，<=0 时使用硬件并发数
+     * @return 分析报告，report.to_string() 可直接打印
+     */
+    virtual BottleneckReport analyze_bottleneck(int core_budget = 0) const = 0;
+    
+    /**
+     * 保存服务时间画像（流水线拓扑 + 各阶段最近的单批次服务时间样本）
+     * 供 PipelineSimulator 离线预测不同路数下的吞吐、延迟和内存
+     * @param output_path 输出CSV路径
+     * @return 保存成功返回true；尚无样本的阶段仍会写入拓扑，仿真前需补齐
+     */
+    virtual bool save_service_profile(const std::string& output_path) const = 0;
+    
+    /**
+     * 获取各有界缓冲区的当前占用（批次缓冲区、连接器、结果队列、结果缓存）
+     * @return 占用快照，未初始化时全为0
+     */
+    virtual PipelineOccupancy get_occupancy() const = 0;
+    
+    /**
+     * 查询最近发生或仍在持续的事件（需配置 event_journal_path）
+     * @param last_ms 时间窗口（毫秒），如最近5分钟传 300000
+     * @return 事件列表，已结束的按结束时间升序在前，进行中的（open=1）在后；未启用日志时为空
+     */
+    virtual std::vector<event_journal::EventJournalRecord> query_recent_events(uint64_t last_ms) const = 0;
+    
+    /**
+     * 查询某条轨迹的全部事件（需配置 event_journal_path）
+     * @param stream_id 视频流ID
+     * @param track_id 跟踪ID
+     * @return 事件列表，未启用日志时为空
+     */
+    virtual std::vector<event_journal::EventJournalRecord> query_track_events(int stream_id, int track_id) const = 0;
 
 protected:
     /**
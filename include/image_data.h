@@ -1,23 +1,62 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <vector>
 #include <mutex>
 #include "event_type.h"
+#include "derived_image_cache.h"
+
+/**
+ * 运动门控对检测阶段的调度决策
+ */
+enum class DetectSchedule {
+  FULL,     // 画面有运动，需要完整检测
+  REUSE,    // 无运动，复用锚点帧检测结果，由跟踪器预测推进
+  REFRESH   // 无运动但达到周期刷新间隔，重新检测
+};
+
+/**
+ * 相对同一视频流上一帧的全局相机运动（入口阶段写入，各阶段只读）
+ */
+struct CameraMotion {
+  bool valid = false;       // 是否有估计（流的第一帧或未启用时为false）
+  float dx = 0.0f;          // 画面内容的全局平移（原图像素）
+  float dy = 0.0f;
+  float confidence = 0.0f;  // 相位相关峰值（0-1），越大越可信
+  bool moving = false;      // 可信且平移超过阈值，视为相机运动
+};
+
+struct ResultDelta;
+class MemoryCharge;
 
 /**
  * 图像数据结构，用于在流水线各阶段之间传递数据
  */
 struct ImageData {
-  cv::Mat imageMat;
-  cv::Mat segInResizeMat;
-  cv::Mat parkingResizeMat; // 用于车辆违停检测的缩放图像
+  cv::Mat imageMat;         // BGR 原图（以 YUV 输入时为空）
+  YuvImage yuvImage;        // 4:2:0 YUV 原图（以 BGR 输入时为空），各阶段按需转换所需区域
+  cv::Mat segInResizeMat;   // 分割输入（1024x1024，取自 derived_images）
+  cv::Mat parkingResizeMat; // 用于车辆违停检测的缩放图像（跟踪阶段按需取自 derived_images）
+  DerivedImageCache derived_images; // 按 (尺寸, 格式, 裁剪) 缓存的派生图，首次申请时计算
   int width;
   int height;
   int channels;
   uint64_t frame_idx; // 添加帧序号，用于保证处理顺序
+  int stream_id;      // 视频流ID，按流维护跨帧状态（去重、跟踪等）
+  int stream_class;   // 流类别（同型号/同用途相机），与分辨率一起决定批次分桶
+  int track_stillness; // 本流的轨迹历史静止判定：-1 沿用检测器配置，0 关闭，1 开启
+
+  // 近重复帧消除（入口阶段写入）
+  cv::Mat luma_thumb;   // 低分辨率亮度缩略图（如64x36），用于感知签名比较
+  bool is_duplicate;    // 是否与参考帧近似重复
+  std::shared_ptr<ImageData> dedup_reference; // 重复帧继承结果的参考关键帧
+
+  // 全局相机运动（入口阶段写入）
+  std::vector<cv::Mat> luma_pyramid; // 低分辨率亮度金字塔，[0]宽约480，逐层减半，各模块复用
+  CameraMotion camera_motion;
 
   // 语义分割结果
   int mask_height;
@@ -28,6 +67,10 @@ struct ImageData {
   // 裁剪后的ROI
   cv::Rect roi;
 
+  // 运动门控（检测阶段写入）
+  DetectSchedule detect_schedule;
+  std::shared_ptr<ImageData> detect_anchor; // REUSE帧复用检测结果的锚点帧
+
   // 目标检测结果
   struct BoundingBox {
     int left, top, right, bottom;
@@ -44,22 +87,32 @@ struct ImageData {
   BoundingBox filtered_box;  // 筛选出的宽度最小的目标框
   bool has_filtered_box;     // 是否有筛选结果
 
+  // 相对同一流上一帧的增量结果（结果发布时写入，未启用增量输出时为空）
+  std::shared_ptr<const ResultDelta> result_delta;
+
+  // 全局内存预算的占用（入口接纳时登记，帧析构时释放；未启用或未接纳时为空）
+  std::shared_ptr<MemoryCharge> memory_charge;
+
   // 线程安全保护（用于跟踪结果的访问）
   std::mutex track_results_mutex;
 
   // 处理完成标志（替代promise/future机制）
-  bool segmentation_completed;
-  bool mask_postprocess_completed;
-  bool detection_completed;
-  bool track_completed; // 跟踪是否完成
+  // 重复帧会跨线程读取参考帧的完成标志，因此使用原子变量
+  std::atomic<bool> segmentation_completed;
+  std::atomic<bool> mask_postprocess_completed;
+  std::atomic<bool> detection_completed;
+  std::atomic<bool> track_completed; // 跟踪是否完成
   
 
     // 默认构造函数
   ImageData()
       : width(0), height(0),
-        channels(0), frame_idx(0), mask_height(0), mask_width(0), 
+        channels(0), frame_idx(0), stream_id(0), stream_class(0), track_stillness(-1), is_duplicate(false),
+        mask_height(0), mask_width(0), 
+        detect_schedule(DetectSchedule::FULL),
         has_filtered_box(false),
-        segmentation_completed(false), mask_postprocess_completed(false), detection_completed(false) {
+        segmentation_completed(false), mask_postprocess_completed(false), detection_completed(false),
+        track_completed(false) {
   }
 
   // 带图像的构造函数
@@ -88,9 +141,43 @@ struct ImageData {
     track_results.reserve(100);      // 预留跟踪结果空间
   }
 
+  // YUV 原图构造函数（拷贝）
+  ImageData(const YuvImage& img) : ImageData(img.clone()) {}
+
+  // YUV 原图移动构造函数，不做整帧色彩转换
+  ImageData(YuvImage&& img) : ImageData() {
+    yuvImage = std::move(img);
+    width = yuvImage.width();
+    height = yuvImage.height();
+    channels = 3; // 按需转换出的派生图为 BGR
+
+    // 内存优化：预分配常用缓冲区
+    label_map.reserve(1024 * 1024); // 预留分割结果空间
+    detection_results.reserve(100);  // 预留检测结果空间
+    track_results.reserve(100);      // 预留跟踪结果空间
+  }
+
   // 析构函数
   ~ImageData();
 
+  // 是否有原图像素（BGR 或 YUV）
+  bool has_source() const { return !imageMat.empty() || !yuvImage.empty(); }
+
+  // 原图字节数（预算记账与缓冲区释放统计用）
+  size_t source_bytes() const { return imageMat.total() * imageMat.elemSize() + yuvImage.bytes(); }
+
+  // 取派生图（见 DerivedImageCache），原图为 YUV 时由融合内核一次完成 转换+缩放/裁剪
+  cv::Mat derived(const DerivedImageKey& key, const DerivedImageCache::Allocator& allocator = nullptr);
+
+  // 原图区域的 BGR 像素：BGR 原图返回零拷贝视图，YUV 原图只转换该区域（不缓存，由调用方持有）
+  cv::Mat source_region(const cv::Rect& region) const;
+
+  // 整帧 BGR：YUV 原图时首次调用整帧转换并缓存在 derived_images，仅供确实需要整帧彩色图的调用方
+  cv::Mat source_bgr();
+
+  // 亮度计算用的原图：BGR 原图，或 YUV 原图的 Y 平面（单通道视图，无需色彩转换）
+  cv::Mat luma_source() const { return imageMat.empty() ? yuvImage.luma() : imageMat; }
+
   // 检查是否完全处理完成
   bool is_fully_processed() const;
 };
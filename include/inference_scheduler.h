@@ -0,0 +1,119 @@
+#pragma once
+
+#include "stage_profiler.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * 推理后端
+ */
+enum class InferenceBackend {
+    GPU = 0,    // TensorRT 模型
+    CPU = 1,    // OpenCV DNN 模型（见 cpu_inference.h）
+};
+
+/**
+ * 推理模式
+ */
+enum class InferenceMode {
+    GPU_ONLY,   // 只用 TensorRT（默认，与原行为一致）
+    CPU_ONLY,   // 只用 CPU，不初始化 TensorRT 模型（无GPU的站点）
+    HYBRID,     // 按在途量与实测耗时把微批次分配给 GPU 或 CPU
+};
+
+/**
+ * 单个后端的调度统计
+ */
+struct InferenceBackendStats {
+    bool available = false;
+    uint64_t items = 0;             // 累计推理的图像数
+    uint64_t micro_batches = 0;     // 累计分配的微批次数
+    uint64_t failures = 0;          // 失败的调用次数
+    size_t in_flight = 0;           // 当前已分配未完成的图像数
+    double ms_per_item = 0.0;       // 每张图像耗时的滑动平均（未实测时为先验值）
+};
+
+/**
+ * 推理调度器（每个推理阶段一个）
+ *
+ * 把一个批次中待推理的图像按 micro_batch 切分，逐个微批次选择预计完成最早的后端：
+ *   预计耗时 = (该后端在途图像数 + 微批次图像数) × 该后端每张图像耗时
+ * 在途图像数跨本阶段所有工作线程统计，每张图像耗时是实测值的滑动平均。GPU 排队较深时
+ * 溢出的微批次落到 CPU，利用空闲核心；CPU 更慢时只在 GPU 积压足够多时才被选中。
+ *
+ * 执行方式：分到 CPU 的微批次提交到调度器自己的 CPU 线程池异步执行；分到 GPU 的微批次
+ * 合并为一次调用在当前线程执行（保持 TensorRT 的大批次效率），两者并行，最后等待全部完成。
+ */
+class InferenceScheduler {
+public:
+    /**
+     * @param name 日志中的阶段名
+     * @param mode 推理模式
+     * @param gpu_ms_hint GPU 每张图像耗时先验（毫秒），实测前使用
+     * @param cpu_ms_hint CPU 每张图像耗时先验（毫秒），实测前使用
+     * @param profiler 所属阶段的剖析器，CPU 微批次的CPU时间记入该阶段
+     */
+    InferenceScheduler(const std::string& name, InferenceMode mode, double gpu_ms_hint, double cpu_ms_hint,
+                       StageProfiler* profiler = nullptr);
+    ~InferenceScheduler();
+
+    InferenceScheduler(const InferenceScheduler&) = delete;
+    InferenceScheduler& operator=(const InferenceScheduler&) = delete;
+
+    // "gpu" / "cpu" / "hybrid"，无法识别时按 gpu 处理
+    static InferenceMode parse_mode(const std::string& name);
+    static const char* mode_name(InferenceMode mode);
+
+    // 模型加载结果：不可用的后端不会被分配
+    void set_backend_available(InferenceBackend backend, bool available);
+    bool any_available() const;
+    InferenceMode get_mode() const { return mode_; }
+
+    /**
+     * 调度并执行 item_count 张图像的推理
+     * @param run_gpu 对给定下标（升序）执行一次 GPU 推理，返回是否成功
+     * @param run_cpu 对下标区间 [begin, end) 执行 CPU 推理，返回是否成功（在 CPU 线程池中调用）
+     * @return 所有微批次都成功时返回true；任一失败或没有可用后端时返回false
+     */
+    bool run(size_t item_count, size_t micro_batch,
+             const std::function<bool(const std::vector<size_t>&)>& run_gpu,
+             const std::function<bool(size_t, size_t)>& run_cpu);
+
+    InferenceBackendStats get_stats(InferenceBackend backend) const;
+
+    // 状态行，如 "GPU 1520张 3.1ms/张 在途0 | CPU 96张 41.7ms/张 在途4"
+    std::string format_stats() const;
+
+private:
+    struct BackendState {
+        bool available = false;
+        uint64_t items = 0;
+        uint64_t micro_batches = 0;
+        uint64_t failures = 0;
+        size_t in_flight = 0;
+        double ms_per_item = 0.0;
+        bool measured = false;
+    };
+
+    // 选择预计完成最早的后端并登记在途，没有可用后端时返回false
+    bool acquire(size_t items, InferenceBackend& backend);
+
+    // 登记完成并更新耗时滑动平均
+    void release(InferenceBackend backend, size_t items, double elapsed_ms, bool success);
+
+    std::string name_;
+    InferenceMode mode_;
+    mutable std::mutex mutex_;
+    BackendState backends_[2];
+
+    std::unique_ptr<ThreadPool> cpu_pool_;    // CPU 微批次执行线程（单线程，批内并行由 OpenMP 完成）
+    StageProfiler* profiler_;
+
+    static constexpr double kCostAlpha = 0.2;  // 耗时滑动平均系数
+};
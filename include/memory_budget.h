@@ -0,0 +1,195 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * 预算占用类别（决定是否会阻塞新帧接纳）
+ */
+enum class MemoryClass {
+    PIPELINE = 0,   // 流水线内的帧：接纳时登记，处理完成前计入接纳判断
+    RESULT = 1,     // 已处理完成、等待调用方取走的帧：计入用量，但不会让接纳无限等待
+};
+
+class MemoryBudget;
+class MemoryAccount;
+
+/**
+ * 一帧的预算占用，随帧（ImageData::memory_charge）析构自动释放
+ * 帧在任一队列、阶段或结果视图中存活期间都保持登记，无需各队列分别记账。
+ * 占用记录持有所属账户，调用方在流水线销毁后仍持有结果帧时账户不会先于帧析构。
+ */
+class MemoryCharge {
+public:
+    MemoryCharge(std::shared_ptr<MemoryAccount> account, size_t bytes);
+    ~MemoryCharge();
+
+    MemoryCharge(const MemoryCharge&) = delete;
+    MemoryCharge& operator=(const MemoryCharge&) = delete;
+
+    // 转为结果类占用（结果交付时调用，重复调用无效果）
+    void move_to_result();
+
+    // 帧的部分缓冲区提前释放后归还相应预算（不超过剩余占用）
+    void release_partial(size_t bytes);
+
+    size_t get_bytes() const { return bytes_.load(); }
+
+private:
+    friend class MemoryBudget;
+
+    std::shared_ptr<MemoryAccount> account_;
+    std::atomic<size_t> bytes_;
+    std::atomic<bool> is_result_{false};
+};
+
+/**
+ * 进程级预算中的一个账户（每个 BatchPipelineManager 一个）
+ *
+ * 账户启用（流水线运行）期间在进程限额中保留均分的配额：限额 / 启用账户数。
+ * 配额内的申请只与本账户用量比较，其他检测器未取走的结果不会挤占；超出配额的部分
+ * 只能借用尚未被任何账户保留的余量。停用（流水线停止）后配额归还给其余账户，
+ * 本账户已登记的占用（如未取走的结果）仍计入进程用量，直到帧析构。
+ * 账户须由 std::shared_ptr 持有（见 MemoryCharge），通过 MemoryBudget::open_account 创建。
+ */
+class MemoryAccount : public std::enable_shared_from_this<MemoryAccount> {
+public:
+    ~MemoryAccount();
+
+    MemoryAccount(const MemoryAccount&) = delete;
+    MemoryAccount& operator=(const MemoryAccount&) = delete;
+
+    /**
+     * 为一帧申请预算
+     * @param deadline 等待截止时间；time_point::max() 表示一直等待
+     * @param running 非空时该标志变为false即放弃等待（流水线停止）
+     * @return 成功时返回占用记录（析构时释放），超时或放弃时返回空
+     */
+    std::shared_ptr<MemoryCharge> acquire(size_t bytes, std::chrono::steady_clock::time_point deadline,
+                                          const std::atomic<bool>* running = nullptr);
+
+    // 不等待：预算允许时登记并返回占用记录，否则返回空（调用方自行腾出空间后重试）
+    std::shared_ptr<MemoryCharge> try_acquire(size_t bytes);
+
+    // 不做接纳判断直接登记（已分配的数据，如编码后的实际大小超出预估）
+    std::shared_ptr<MemoryCharge> charge(size_t bytes);
+
+    // 参与 / 退出配额分配（流水线启动 / 停止时调用），停用时唤醒本账户的等待者
+    void activate();
+    void deactivate();
+
+    // 清零接纳/等待/拒绝计数，峰值重置为当前用量（流水线重新启动时调用）
+    void reset_stats();
+
+    const std::string& get_name() const { return name_; }
+    MemoryBudget& get_budget() const { return *budget_; }
+
+    // 本账户当前的保留配额（未启用或不限额时为0）
+    size_t get_reserved_bytes() const;
+
+    // 统计信息
+    size_t get_pipeline_bytes() const { return pipeline_bytes_.load(); }
+    size_t get_result_bytes() const { return result_bytes_.load(); }
+    size_t get_used_bytes() const { return pipeline_bytes_.load() + result_bytes_.load(); }
+    size_t get_peak_bytes() const { return peak_bytes_.load(); }
+    uint64_t get_admitted() const { return admitted_.load(); }
+    uint64_t get_waited() const { return waited_.load(); }
+    uint64_t get_rejected() const { return rejected_.load(); }
+    double get_wait_ms() const { return wait_ns_.load() / 1e6; }
+
+private:
+    friend class MemoryBudget;
+
+    MemoryAccount(std::shared_ptr<MemoryBudget> budget, std::string name);
+
+    std::shared_ptr<MemoryBudget> budget_;
+    std::string name_;
+    bool active_ = false;                     // 受 budget_->mutex_ 保护
+
+    std::atomic<size_t> pipeline_bytes_{0};
+    std::atomic<size_t> result_bytes_{0};
+    std::atomic<size_t> peak_bytes_{0};
+
+    std::atomic<uint64_t> admitted_{0};
+    std::atomic<uint64_t> waited_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> wait_ns_{0};
+};
+
+/**
+ * 进程级在途内存预算（按字节）
+ *
+ * 进程内所有检测器实例的帧都登记到同一预算，总在途内存不随实例数增长。各实例通过自己的
+ * 账户（MemoryAccount）申请，账户按启用数均分限额作为保留配额，见 MemoryAccount。
+ *
+ * 新帧在入口按估计占用申请预算，超出时等待其他帧释放（超时语义与 add_frame 一致），
+ * 这是流水线中唯一会因预算阻塞的位置；阶段内部和结果交付只登记、不等待，因此预算
+ * 不会造成阶段之间的死锁。
+ *
+ * 接纳条件（任一满足）：
+ *   1. 账户内没有在途帧（PIPELINE 用量为0）：总是接纳。结果（RESULT）优先于新帧——调用方在
+ *      同一线程先阻塞在 add_frame、后取结果时，预算被未取走的结果占满会永远等不到释放。
+ *      结果存储本身按条数有上限，每个账户超出部分因此有界（至多一帧在途 + 结果上限）。
+ *   2. 账户用量加本帧不超过其保留配额。
+ *   3. 各账户 max(用量, 配额) 之和加本帧不超过限额（借用无人保留的余量）。
+ * 启用账户数变化后配额随之调整，借用超出新配额的账户在释放前不能再借用。
+ *
+ * 限额为0时不限制，只统计用量。
+ */
+class MemoryBudget : public std::enable_shared_from_this<MemoryBudget> {
+public:
+    // 进程内共享的预算实例
+    static const std::shared_ptr<MemoryBudget>& global();
+
+    explicit MemoryBudget(size_t limit_bytes = 0);
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    // 设置限额（字节），0 表示不限制；调小后已登记的占用不受影响
+    void set_limit(size_t limit_bytes);
+    // 限额提高到不低于 limit_bytes（各实例按各自配置调用，进程限额取其中最大值）
+    void raise_limit(size_t limit_bytes);
+    size_t get_limit() const { return limit_bytes_.load(); }
+
+    // 创建账户（初始未启用）
+    std::shared_ptr<MemoryAccount> open_account(const std::string& name);
+
+    // 统计信息（所有账户合计）
+    size_t get_pipeline_bytes() const { return pipeline_bytes_.load(); }
+    size_t get_result_bytes() const { return result_bytes_.load(); }
+    size_t get_used_bytes() const { return pipeline_bytes_.load() + result_bytes_.load(); }
+    size_t get_peak_bytes() const { return peak_bytes_.load(); }
+    size_t get_active_accounts() const;
+
+private:
+    friend class MemoryAccount;
+    friend class MemoryCharge;
+
+    void release(MemoryAccount& account, size_t bytes, bool is_result);
+    void move_to_result(MemoryCharge& charge);
+    void release_partial(MemoryCharge& charge, size_t bytes);
+    void remove_account(MemoryAccount* account);
+
+    // 以下需持有 mutex_
+    size_t reserved_locked(const MemoryAccount& account) const;
+    bool fits(const MemoryAccount& account, size_t bytes) const;
+    void update_peaks(MemoryAccount& account);
+
+    std::atomic<size_t> limit_bytes_;
+    std::atomic<size_t> pipeline_bytes_{0};
+    std::atomic<size_t> result_bytes_{0};
+    std::atomic<size_t> peak_bytes_{0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<MemoryAccount*> accounts_;    // 所有存活账户（账户析构时移除）
+    size_t active_accounts_ = 0;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "image_data.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * 运动门控配置
+ */
+struct MotionGateConfig {
+    int thumb_width = 160;                // 帧差缩略图宽度
+    int thumb_height = 90;                // 帧差缩略图高度
+    int pixel_threshold = 15;             // 像素亮度差阈值（0-255），超过视为变化像素
+    double motion_area_ratio = 0.002;     // ROI内变化像素占比阈值，超过视为有运动
+    int refresh_interval = 25;            // 无运动时的周期刷新间隔（帧）
+};
+
+/**
+ * 运动门控（检测阶段调度）
+ * 在ROI范围内对低分辨率亮度图与同一视频流最近一次完整检测的锚点帧做帧差，
+ * 为每帧给出 FULL / REUSE / REFRESH 决策：
+ *   - FULL：ROI内有运动或ROI发生变化，需要完整检测
+ *   - REUSE：无运动，复用锚点帧检测结果；跟踪阶段不把它作为观测，而由跟踪器预测推进
+ *   - REFRESH：无运动但距离锚点已达刷新间隔，重新检测以更新静止车辆
+ * 与锚点而不是上一帧比较，缓慢移动的目标会累积差异并最终触发检测。
+ */
+class MotionGate {
+public:
+    // 单帧的调度决策（未提交前不影响锚点状态）
+    struct Decision {
+        DetectSchedule schedule = DetectSchedule::FULL;
+        ImageDataPtr anchor;                  // REUSE 时复用检测结果的锚点帧
+        cv::Mat thumb;                        // 当前帧缩略图，成为锚点时保存
+    };
+
+    explicit MotionGate(const MotionGateConfig& config = MotionGateConfig());
+
+    /**
+     * 为单帧计算调度决策，只读锚点状态
+     * 同一流的帧需按帧序号顺序 decide/commit
+     */
+    Decision decide(const ImageDataPtr& image) const;
+
+    /**
+     * 提交检测阶段的最终决策（REUSE 可能因锚点检测未完成而回退为 FULL）
+     * 写入 image->detect_schedule 和 image->detect_anchor，更新锚点与计数：
+     * 完整检测（FULL/REFRESH）的帧成为新锚点，只有真正复用的帧计入 REUSE
+     */
+    void commit(const ImageDataPtr& image, const Decision& decision);
+
+    // 更新阈值配置
+    void set_config(const MotionGateConfig& config);
+
+    // 清空所有流的锚点状态
+    void reset();
+
+    // 统计信息
+    uint64_t get_full_count() const { return full_count_.load(); }
+    uint64_t get_reuse_count() const { return reuse_count_.load(); }
+    uint64_t get_refresh_count() const { return refresh_count_.load(); }
+
+    // ROI内变化像素占比（ROI为原图坐标）
+    static double motion_ratio(const cv::Mat& current, const cv::Mat& anchor, const cv::Rect& roi,
+                               int image_width, int image_height, int pixel_threshold);
+
+private:
+    struct StreamState {
+        std::weak_ptr<ImageData> anchor;      // 最近一次完整检测的帧
+        cv::Mat anchor_thumb;                 // 锚点帧缩略图
+        cv::Rect anchor_roi;                  // 锚点帧ROI
+        int frames_since_anchor = 0;          // 距离锚点的帧数
+    };
+
+    // ROI是否与锚点一致（检测框坐标相对于ROI）
+    static bool roi_compatible(const cv::Rect& a, const cv::Rect& b);
+
+    mutable std::mutex state_mutex_;
+    MotionGateConfig config_;
+    std::unordered_map<int, StreamState> streams_;
+
+    std::atomic<uint64_t> full_count_{0};
+    std::atomic<uint64_t> reuse_count_{0};
+    std::atomic<uint64_t> refresh_count_{0};
+};
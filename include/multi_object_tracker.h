@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 多目标跟踪配置（参数含义与 ByteTrack 一致）
+ */
+struct TrackerConfig {
+    int frame_rate = 30;                  // 视频帧率
+    int track_buffer = 30;                // 丢失轨迹保留时长（按30fps计的帧数），实际保留 track_buffer * frame_rate / 30 帧
+    float track_thresh = 0.5f;            // 高分检测阈值，高于该值参与第一轮关联
+    float high_thresh = 0.6f;             // 新建轨迹所需的最低置信度
+    float match_thresh = 0.8f;            // 第一轮关联代价阈值（1 - IoU），即 IoU >= 0.2
+    float match_buffer = 0.3f;            // 第一轮 IoU 前两框各边外扩的比例（相对各自宽高），0 表示不外扩
+    float low_thresh = 0.1f;              // 低分检测下限，介于两者之间的检测参与第二轮关联
+    float low_match_iou = 0.5f;           // 第二轮（低分检测）关联的最小 IoU
+    float unconfirmed_match_iou = 0.3f;   // 待确认轨迹关联的最小 IoU
+    bool class_aware = true;              // 只关联同类别目标
+    bool use_spatial_hash = true;         // 用网格哈希筛选候选对（关闭时两两计算 IoU，用于对比）
+};
+
+/**
+ * 参与跟踪的目标框（坐标系由调用方决定，同一流需保持一致）
+ */
+struct TrackedObject {
+    float left = 0.0f;
+    float top = 0.0f;
+    float right = 0.0f;
+    float bottom = 0.0f;
+    float score = 0.0f;
+    int cls_id = 0;
+    int track_id = -1;                    // update() 写入，-1 表示未输出
+    int index = -1;                       // 调用方自定义（如原检测下标），原样返回
+};
+
+/**
+ * 内置 CPU 多目标跟踪器（ByteTrack/SORT 风格）
+ *
+ * 每条轨迹用匀速卡尔曼滤波预测 (cx, cy, 宽高比, h)，关联分三轮：
+ *   1. 高分检测 ↔ 跟踪中/丢失的轨迹
+ *   2. 低分检测 ↔ 第一轮未匹配的跟踪中轨迹（找回被遮挡、置信度下降的目标）
+ *   3. 剩余高分检测 ↔ 待确认轨迹（新轨迹需连续两帧匹配才输出，流的第一帧除外）
+ * 候选对由空间网格哈希产生：轨迹预测框按覆盖的网格单元分组（计数排序），检测框只与
+ * 共享单元的轨迹计算 IoU，关联开销随目标数近似线性增长。匹配在稀疏的 IoU 边上按 IoU 从大到小贪心完成，
+ * 不构建完整代价矩阵。
+ *
+ * 小目标每帧位移接近自身宽度时（远景、目标密集），预测框与检测框的原始 IoU 常低于门限，
+ * 轨迹丢失后以新ID重建。第一轮因此用外扩后的框（match_buffer，C-BIoU 做法）判定候选，
+ * 排序仍以原始 IoU 为先、外扩 IoU 次之，避免外扩后相邻目标的 IoU 拉平导致错配。
+ * 剩余的ID切换主要来自同类目标交错：TrackerBenchmark 在每帧1000个小目标时仍约每千个
+ * 轨迹帧2-3次（50个目标时接近0），对同一组稀疏边改用逐连通分量的最优指派只减少约15%，
+ * CPU时间却翻倍，因此保留贪心匹配。
+ *
+ * 状态按 stream_id 隔离，同一流的帧需按帧序号顺序调用，不同流可由多个线程并行调用。
+ */
+class MultiObjectTracker {
+public:
+    explicit MultiObjectTracker(const TrackerConfig& config = TrackerConfig());
+
+    /**
+     * 跟踪一帧
+     * @param objects 当前帧检测框；返回时只保留输出的目标，并写入 track_id
+     */
+    void update(int stream_id, std::vector<TrackedObject>& objects);
+
+    /**
+     * 无新检测的帧（运动门控复用锚点检测结果）：只做卡尔曼预测推进轨迹，不关联、不计为丢失
+     * @param objects 输出跟踪中轨迹的预测框（score 为轨迹最近一次匹配的置信度，index 为 -1）
+     */
+    void coast(int stream_id, std::vector<TrackedObject>& objects);
+
+    // 更新阈值配置
+    void set_config(const TrackerConfig& config);
+
+    // 清空指定流 / 所有流的轨迹
+    void reset_stream(int stream_id);
+    void reset();
+
+    // 统计信息
+    uint64_t get_frames_tracked() const { return frames_tracked_.load(); }
+    uint64_t get_frames_coasted() const { return frames_coasted_.load(); }   // 只做预测的帧数
+    uint64_t get_candidate_pairs() const { return candidate_pairs_.load(); }   // 计算过 IoU 的候选对数
+    size_t get_active_tracks() const;
+
+private:
+    // 单一维度的位置/速度卡尔曼滤波（ByteTrack 的8维滤波在各维度间解耦）
+    struct KalmanDim {
+        float x = 0.0f, v = 0.0f;
+        float p00 = 0.0f, p01 = 0.0f, p11 = 0.0f;
+    };
+
+    enum class TrackState { TENTATIVE, TRACKED, LOST };
+
+    struct Track {
+        int id = 0;
+        int cls_id = 0;
+        float score = 0.0f;
+        KalmanDim dims[4];                // cx, cy, 宽高比, h
+        TrackState state = TrackState::TENTATIVE;
+        int frames_since_update = 0;
+        float box[4] = {0, 0, 0, 0};      // 预测框 left, top, right, bottom
+    };
+
+    struct Edge {
+        float iou;
+        float buffered_iou;               // 外扩框 IoU（未外扩时与 iou 相同）
+        int track;
+        int object;
+    };
+
+    struct StreamState {
+        std::mutex mutex;                 // 同一流的帧串行处理，不同流互不阻塞
+        std::vector<Track> tracks;
+        int next_id = 1;
+        uint64_t frame_count = 0;
+
+        // 关联过程的临时缓冲区（持锁使用，避免每帧分配）
+        std::vector<int> cell_start;      // 网格单元在 cell_tracks 中的起始位置
+        std::vector<int> cell_tracks;
+        std::vector<Edge> edges;
+        std::vector<int> visit_stamp;
+    };
+
+    // 取流的状态（不存在时创建）并复制当前配置
+    std::shared_ptr<StreamState> acquire_stream(int stream_id, TrackerConfig& config);
+
+    // 卡尔曼滤波
+    static void initiate(Track& track, const TrackedObject& object);
+    static void predict(Track& track);
+    static void correct(Track& track, const TrackedObject& object);
+
+    /**
+     * 贪心关联
+     * @param track_ids 参与关联的轨迹下标
+     * @param object_ids 参与关联的检测下标
+     * @param buffer 框外扩比例，min_iou 按外扩后的 IoU 判定
+     * @param matches 输出 (轨迹下标, 检测下标)
+     * @return 计算过 IoU 的候选对数
+     * 未匹配的下标留在 track_ids / object_ids 中
+     */
+    static uint64_t associate(StreamState& state, const std::vector<TrackedObject>& objects,
+                              std::vector<int>& track_ids, std::vector<int>& object_ids, float min_iou,
+                              float buffer, const TrackerConfig& config, std::vector<std::pair<int, int>>& matches);
+
+    mutable std::mutex state_mutex_;
+    TrackerConfig config_;
+    std::unordered_map<int, std::shared_ptr<StreamState>> streams_;
+
+    std::atomic<uint64_t> frames_tracked_{0};
+    std::atomic<uint64_t> frames_coasted_{0};
+    std::atomic<uint64_t> candidate_pairs_{0};
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * 硬件性能计数器读数（当前线程，仅用户态，累计值）
+ * 计数器组被多路复用时已按 time_enabled/time_running 折算
+ */
+struct HwCounterValues {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cache_misses = 0;      // 末级缓存未命中（PERF_COUNT_HW_CACHE_MISSES）
+    uint64_t branch_misses = 0;
+
+    HwCounterValues operator-(const HwCounterValues& other) const {
+        HwCounterValues diff;
+        diff.cycles = cycles > other.cycles ? cycles - other.cycles : 0;
+        diff.instructions = instructions > other.instructions ? instructions - other.instructions : 0;
+        diff.cache_misses = cache_misses > other.cache_misses ? cache_misses - other.cache_misses : 0;
+        diff.branch_misses = branch_misses > other.branch_misses ? branch_misses - other.branch_misses : 0;
+        return diff;
+    }
+};
+
+/**
+ * 每线程硬件性能计数器（Linux perf_event_open）
+ *
+ * 每个线程首次 read() 时打开一个计数器组（cycles 为组长，另含 instructions、
+ * cache-misses、branch-misses），一次 read 系统调用同时取得全部计数，线程退出时关闭。
+ * 组内只放4个事件，避免在通用计数器较少的CPU上被多路复用。
+ *
+ * 内核禁止访问（perf_event_paranoid、容器seccomp、虚拟机未透传PMU）时记录一次告警并全局
+ * 标记为不可用，之后 read() 直接返回false，不再重复尝试；调用方按"无硬件计数"处理。
+ * 个别事件不被支持时该项保持为0，其余事件照常计数。
+ */
+class HwPerfCounters {
+public:
+    // 全局开关（默认关闭），关闭时 read() 不打开计数器
+    static void set_enabled(bool enabled);
+    static bool enabled();
+
+    // 最近一次打开尝试后是否可用（未尝试过时为true）
+    static bool available();
+
+    // 不可用原因（可用时为空）
+    static std::string unavailable_reason();
+
+    /**
+     * 读取当前线程的计数器
+     * @return 未启用、不可用或计数器组本周期未被调度时返回false
+     */
+    static bool read(HwCounterValues& values);
+};
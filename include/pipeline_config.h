@@ -15,6 +15,7 @@ struct PipelineConfig {
     bool enable_detection = true;          // 启用目标检测模块
     bool enable_tracking = true;           // 启用目标跟踪模块
     bool enable_event_determine = true;    // 启用事件判定模块
+    bool enable_parking_detection = true;  // 启用违停检测（跟踪阶段特征点静止判定），关闭时不生成违停缩放图
     
     // 语义分割模型配置
     std::string seg_model_path = "seg_model";               // 语义分割模型路径
@@ -35,6 +36,13 @@ struct PipelineConfig {
     int det_gpu_id = 0;                                     // GPU设备ID
     bool enable_pedestrian_detect = false;                  // 是否启用行人检测
     std::string pedestrian_det_model_path = "person_detect.onnx"; // 行人检测模型路径
+
+    // 推理后端配置（语义分割与车辆检测）
+    std::string inference_mode = "gpu";    // gpu 只用TensorRT；cpu 只用OpenCV DNN（不初始化TensorRT）；hybrid 按在途量与实测耗时分配微批次
+    std::string cpu_seg_model_path;        // CPU语义分割ONNX模型，空时使用 seg_model_path
+    std::string cpu_det_model_path;        // CPU车辆检测ONNX模型，空时使用 car_det_model_path
+    int cpu_infer_threads = 0;             // 每个推理阶段的OpenMP线程数（每线程一个Net实例），0 取核数一半
+    int infer_micro_batch = 4;             // 调度粒度：每个微批次的图像数
     
     // 事件判定配置
     float event_determine_top_fraction = 4.0f / 7.0f;           // 筛选区域上边界比例
@@ -46,5 +54,77 @@ struct PipelineConfig {
     
     // 队列配置
     int final_result_queue_capacity = 500; // 最终结果队列容量
+
+    // 组批配置
+    bool batch_by_shape = true;            // 按 (分辨率, 通道数, 流类别) 分桶组批，每个批次形状一致
+    int batch_max_bypass = 4;              // 未满批次被其他桶越过该批次数后立即刷新（少见分辨率的公平性），0 不限制
+
+    // 各阶段批次大小（阶段前连接器拆分/合并批次，保持每路流帧序）
+    int seg_batch_size = 32;               // 语义分割批次大小，即 BatchBuffer 组批大小
+    int mask_batch_size = 0;               // Mask后处理批次大小，0 沿用上游批次
+    int detection_batch_size = 0;          // 目标检测批次大小（可对齐 det_mid_opt/det_max_opt），0 沿用上游批次
+    int tracking_batch_size = 0;           // 目标跟踪批次大小，1 表示逐帧，0 沿用上游批次
+    int event_batch_size = 0;              // 事件判定批次大小，0 沿用上游批次
+    int rebatch_flush_ms = 50;             // 合并批次时未凑满的批次最长等待时间
+
+    // 在途内存预算（进程内所有流水线共享，运行中的流水线均分保留配额）
+    int memory_budget_mb = 0;              // 入口按帧估计占用接纳新帧，超出时按 add_frame 超时等待；0 不限制（仍统计用量）
+
+    // 帧缓冲区提前释放（按各阶段声明的使用集合，在最后一个使用者完成后释放）
+    bool enable_buffer_release = true;     // 关闭时所有缓冲区保留到结果被取走
+    bool result_keep_source_image = true;  // 结果保留原图（ResultView::source_image），关闭后原图在最后一个读取阶段后释放
+    bool result_keep_mask = true;          // 结果保留Mask（ResultView::mask）
+
+    // 近重复帧消除配置
+    bool enable_frame_dedup = false;       // 启用近重复帧消除（重复帧继承上一关键帧的分割/检测结果）
+    int dedup_thumb_width = 64;            // 感知签名缩略图宽度
+    int dedup_thumb_height = 36;           // 感知签名缩略图高度
+    float dedup_diff_threshold = 2.0f;     // 平均亮度绝对差阈值，低于该值视为重复帧
+    int dedup_max_consecutive_skips = 25;  // 连续重复帧上限，超过后强制重新推理
+
+    // 运动门控配置（检测阶段）
+    bool enable_motion_gate = false;       // 启用运动门控（ROI内无运动的帧复用锚点帧检测结果，内置跟踪器以预测推进）
+    int motion_gate_thumb_width = 160;     // 帧差缩略图宽度
+    int motion_gate_thumb_height = 90;     // 帧差缩略图高度
+    int motion_pixel_threshold = 15;       // 像素亮度差阈值，超过视为变化像素
+    float motion_area_ratio = 0.002f;      // ROI内变化像素占比阈值，超过视为有运动
+    int motion_refresh_interval = 25;      // 无运动时的周期刷新间隔（帧），用于更新静止车辆
+
+    // 相机运动估计配置（入口阶段）
+    bool enable_camera_motion = false;     // 每帧构建亮度金字塔并估计全局相机运动，写入 ImageData::camera_motion
+    float camera_motion_ratio = 0.003f;    // 全局平移超过原图宽度的该比例视为相机运动
+    float camera_motion_min_confidence = 0.3f; // 相位相关峰值低于该值时不判定为运动
+
+    // 目标跟踪配置（参数含义与 ByteTrack 一致，内置与外部跟踪器共用）
+    bool use_builtin_tracker = false;      // 使用内置多目标跟踪器（按视频流隔离轨迹），否则使用外部 xtkj 跟踪库
+    int tracker_frame_rate = 30;           // 视频帧率
+    int tracker_buffer_frames = 30;        // 丢失轨迹保留帧数（按30fps计）
+    float tracker_track_thresh = 0.5f;     // 高分检测阈值
+    float tracker_high_thresh = 0.6f;      // 新建轨迹所需的最低置信度
+    float tracker_match_thresh = 0.8f;     // 关联代价阈值（1 - IoU）
+
+    // 静止判定配置（跟踪阶段）
+    bool enable_track_stillness = false;   // 用轨迹框历史判定静止，仅在检测到相机运动时调用特征点/RANSAC路径
+    int stillness_history_frames = 25;     // 每条轨迹保留的历史帧数
+    float stillness_displacement_ratio = 0.15f; // 窗口内位移低于框高的该倍数视为静止
+    int stillness_camera_hold_frames = 50; // 检测到相机运动后使用特征点路径的帧数
+    std::string track_record_path;         // 非空时把每帧跟踪框与静止判定写入该CSV，供 StillnessBenchmark 回放
+
+    // 事件日志配置（事件判定阶段）
+    std::string event_journal_path;        // 非空时把事件区间追加到该 mmap 日志（EventJournal），可按轨迹/时间查询
+    int event_close_gap_frames = 25;       // 轨迹连续该帧数不再处于同一事件时结束事件
+
+    // 事件取证片段配置（事件判定阶段）
+    std::string evidence_output_dir;       // 非空时为每次事件保存事件前后的缩小帧片段（EvidenceRecorder）
+    int evidence_memory_budget_mb = 64;    // 进程内所有检测器的取证缓存帧共享上限（取各实例的最大值）
+    int evidence_thumb_width = 640;        // 缓存帧宽度
+    int evidence_jpeg_quality = 80;        // JPEG质量，0 表示缓存原始缩小帧
+    int evidence_frame_stride = 5;         // 每隔该帧数缓存一帧
+    int evidence_pre_frames = 100;         // 事件前保留的源帧数
+    int evidence_post_frames = 100;        // 事件后采集的源帧数
+
+    // 瓶颈分析配置
+    std::string stats_record_path;         // 非空时按状态打印间隔把各阶段累计指标追加到该CSV，供离线分析
+    bool enable_perf_counters = false;     // 各阶段工作线程打开 perf_event_open 计数器组，统计 IPC/缓存/分支未命中
 };
 #endif // PIPELINE_CONFIG_H
\ No newline at end of file
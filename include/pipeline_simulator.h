@@ -0,0 +1,145 @@
+#pragma once
+
+#include "pipeline_topology.h"
+#include "stage_profiler.h"
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * 服务时间画像：流水线拓扑 + 各阶段实测的单批次服务时间样本
+ *
+ * 由 BatchPipelineManager::collect_service_profile() 从运行中的流水线采集，
+ * 保存为 CSV 后供仿真器离线使用。
+ */
+struct ServiceProfile {
+    PipelineTopology topology;
+    std::map<std::string, std::vector<ServiceSample>> samples;  // 键为阶段 config_key
+
+    // 缺少样本的阶段名称，为空表示可以仿真
+    std::vector<std::string> missing_stages() const;
+
+    // CSV：topology/stage 行描述拓扑，sample 行为 config_key,batch_size,wall_ns
+    bool save(const std::string& path) const;
+    static bool load(const std::string& path, ServiceProfile& profile);
+};
+
+/**
+ * 单阶段服务时间分布（经验分布，按批次大小分桶）
+ */
+struct ServiceDistribution {
+    std::map<size_t, std::vector<double>> by_batch_size;  // 批次大小 -> 服务时间样本（毫秒）
+    double intercept_ms = 0.0;          // 线性模型 a + b*n 的 a
+    double per_image_ms = 0.0;          // 线性模型 a + b*n 的 b
+
+    static ServiceDistribution fit(const std::vector<ServiceSample>& samples);
+
+    bool empty() const { return by_batch_size.empty(); }
+
+    // 抽取一个服务时间（毫秒）
+    // 没有该批次大小的样本时，从最接近的批次大小中抽取并按线性模型缩放
+    double draw(size_t batch_size, std::mt19937& rng) const;
+
+    // 线性模型给出的平均服务时间（毫秒）
+    double mean(size_t batch_size) const;
+};
+
+/**
+ * 仿真参数
+ */
+struct SimulationOptions {
+    int streams = 1;                    // 视频流数量
+    double fps_per_stream = 25.0;       // 每路帧率
+    double duration_s = 120.0;          // 仿真时长（秒）
+    double warmup_s = 20.0;             // 预热时长，此前到达的帧不计入延迟与吞吐
+    int add_timeout_ms = -1;            // 背压等待时间，<0 一直等待，0 不等待（与 add_timeout_ms 配置一致）
+    double frame_bytes = 1920.0 * 1080 * 3 * 2;  // 单帧在流水线中占用的内存（原图 + 缩放图/掩码等派生数据）
+    uint32_t seed = 1;                  // 随机数种子（服务时间抽样、各路相位）
+};
+
+/**
+ * 阶段仿真结果
+ */
+struct StageSimulation {
+    std::string name;
+    std::string config_key;
+    int concurrency = 1;
+    double utilisation = 0.0;           // 服务中时间占比（不含阻塞在下游的时间）
+    double blocked_ratio = 0.0;         // 处理完成但下游连接器已满的时间占比
+    double mean_queue = 0.0;            // 输入队列平均长度（批次）
+    size_t max_queue = 0;
+    double mean_batch_size = 0.0;
+    double throughput_fps = 0.0;        // 预热后进入服务的帧率
+    double capacity_fps = 0.0;          // 按平均批次大小与并发估算的最大帧率（各阶段批次大小不同，按帧比较）
+    uint64_t timeout_flushes = 0;       // 重组时未凑满、等待超时发出的批次数
+};
+
+/**
+ * 仿真结果
+ */
+struct SimulationResult {
+    bool valid = false;
+    std::string error;
+    int streams = 0;
+    double offered_fps = 0.0;           // 摄像头产生的帧率
+    double throughput_fps = 0.0;        // 预热后的输出帧率
+    double latency_p50_ms = 0.0;        // 帧从采集到输出的延迟
+    double latency_p95_ms = 0.0;
+    double latency_p99_ms = 0.0;
+    double latency_max_ms = 0.0;
+    uint64_t frames_offered = 0;
+    uint64_t frames_completed = 0;
+    uint64_t frames_overrun = 0;        // 上一帧仍阻塞在背压中时到达、被采集端丢弃的帧
+    uint64_t frames_rejected = 0;       // 背压等待超过 add_timeout_ms 被拒绝的帧
+    uint64_t frames_flush_dropped = 0;  // 超时刷新时就绪队列已满，随批次被丢弃的帧
+    double mean_frames_in_flight = 0.0;
+    size_t peak_frames_in_flight = 0;
+    double mean_memory_mb = 0.0;
+    double peak_memory_mb = 0.0;
+    std::vector<StageSimulation> stages;
+
+    // 所有帧都被处理且吞吐跟得上输入
+    bool sustainable() const;
+
+    std::string to_string() const;
+};
+
+/**
+ * 批次流水线离散事件仿真器
+ *
+ * 按 PipelineTopology 建模与 BatchPipelineManager 相同的结构：
+ *   - 每路摄像头按固定帧率产生帧，提交时遵循 BatchBuffer 的背压规则
+ *     （就绪队列满时等待空位；每路同一时刻最多一帧在等待，期间到达的新帧被采集端丢弃）
+ *   - BatchBuffer 满批次立即就绪，未满批次由刷新线程每 flush_timeout_ms 检查一次，
+ *     超时刷新时就绪队列已满则整批丢弃（与实际实现一致）
+ *   - 每个阶段 concurrency() 个服务者从输入队列取批次，服务时间从实测样本中抽取，
+ *     下游连接器满时服务者持有批次阻塞（背压逐级向上传递）
+ *   - 阶段设置了 batch_size 时，前置连接器与 BatchConnector::set_rebatch 一致地重组批次：
+ *     按到达顺序拆分/合并为 batch_size 帧，容量按图像数计，未凑满的批次在服务者空闲且
+ *     等待超过 rebatch_flush_ms 后发出（仿真不区分形状，所有帧视为同一组）
+ *   - 最后一个阶段完成即视为结果输出
+ * 帧内存按 SimulationOptions::frame_bytes × 在途帧数估算（含等待提交的帧）。
+ */
+class PipelineSimulator {
+public:
+    explicit PipelineSimulator(ServiceProfile profile);
+
+    SimulationResult run(const SimulationOptions& options) const;
+
+    /**
+     * 在满足吞吐、无丢帧以及延迟预算的前提下，求最多可接入的视频流数量
+     * @param latency_budget_ms p99 延迟上限，<=0 表示不限制
+     * @param max_streams 搜索上限
+     * @param best 最大可接入流数对应的仿真结果（返回0时为单路结果）
+     */
+    int find_max_streams(const SimulationOptions& options, double latency_budget_ms, int max_streams,
+                         SimulationResult* best = nullptr) const;
+
+    const ServiceProfile& profile() const { return profile_; }
+
+private:
+    ServiceProfile profile_;
+    std::vector<ServiceDistribution> distributions_;  // 与 profile_.topology.stages 一一对应
+};
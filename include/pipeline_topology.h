@@ -0,0 +1,57 @@
+#pragma once
+
+#include "pipeline_config.h"
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * 单个处理阶段的拓扑描述
+ */
+struct StageTopology {
+    std::string name;            // 阶段名称，与 BatchStage::get_stage_name() 一致
+    std::string config_key;      // 对应 HighwayEventConfig 的线程数字段
+    int threads = 1;             // 配置的线程数
+    int model_instances = 0;     // 模型实例数（同一时刻可并行推理的批次数），0 表示不受模型限制
+    int max_in_flight = 1;       // 同时在处理中的批次数上限（协调线程逐批次投递并等待结果，故为1）
+    bool serialized = false;     // 阶段内部按批次串行（持锁保证时序）
+    size_t input_capacity = 10;  // 阶段前队列容量（首阶段为 BatchBuffer 就绪队列）
+    size_t batch_size = 0;       // 阶段前连接器重组的批次大小，0 表示沿用上游批次（首阶段见 PipelineTopology::batch_size）
+
+    // 实际可并行处理的批次数
+    int concurrency() const;
+
+    // 配置 threads 个线程时可并行处理的批次数（线程数之外还受模型实例、在途批次上限和串行限制）
+    int concurrency_with(int threads) const;
+};
+
+/**
+ * 批次流水线拓扑描述
+ *
+ * BatchPipelineManager 按该描述创建批次收集器和连接器，
+ * 流水线仿真器（PipelineSimulator）用同一份描述建模，保证两者结构一致。
+ */
+struct PipelineTopology {
+    size_t batch_size = 32;              // BatchBuffer 满批次图像数（首阶段批次大小，默认 ImageBatch::BATCH_SIZE）
+    int flush_timeout_ms = 10000;        // 未满批次的超时刷新时间
+    int rebatch_flush_ms = 50;           // 连接器重组批次时未凑满的批次最长等待时间
+    size_t max_ready_batches = 1;        // BatchBuffer 就绪队列容量（背压）
+    size_t connector_capacity = 10;      // 阶段间连接器容量
+    size_t result_capacity = 20;         // 结果连接器容量
+    std::vector<StageTopology> stages;   // 按处理顺序排列的启用阶段
+
+    // 按流水线配置生成拓扑（只包含启用的阶段）
+    static PipelineTopology from_config(const PipelineConfig& config);
+
+    // 按阶段名称查找，不存在返回nullptr
+    const StageTopology* find(const std::string& name) const;
+    StageTopology* find(const std::string& name);
+
+    // 文本格式读写（与服务时间样本保存在同一个CSV文件中，见 ServiceProfile）
+    void save(std::ostream& out) const;
+    bool parse_line(const std::vector<std::string>& fields);
+
+    // 多行描述
+    std::string to_string() const;
+};
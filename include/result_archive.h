@@ -0,0 +1,198 @@
+#pragma once
+
+#include "result_record.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 结果归档文件（只追加）
+ *
+ * 数据文件 <path>：
+ *   ArchiveFileHeader (64字节)
+ *   result_record 记录 × N（与共享内存结果环相同的紧凑二进制格式，逐条首尾相接）
+ * 索引文件 <path>.idx：
+ *   ArchiveIndexEntry × N（每条32字节，与数据文件中的记录一一对应）
+ *
+ * 写入顺序为先数据后索引，fsync 也先数据后索引，因此索引不会指向未落盘的数据。
+ * 进程崩溃后数据文件尾部可能有半条记录、索引可能短于数据：写入方重新打开时截掉
+ * 半条记录并补齐索引，读取方按数据文件中的完整记录为准。
+ */
+namespace result_archive {
+
+constexpr uint32_t kFileMagic = 0x41525748;   // "HWRA"
+constexpr uint16_t kFileVersion = 1;
+
+#pragma pack(push, 1)
+struct ArchiveFileHeader {
+    uint32_t magic;             // kFileMagic
+    uint16_t version;           // kFileVersion
+    uint16_t record_version;    // result_record::kVersion
+    uint64_t created_ms;        // 文件创建时间（Unix毫秒）
+    uint8_t reserved[48];
+};
+
+struct ArchiveIndexEntry {
+    uint64_t frame_id;          // SDK内部帧序号
+    uint64_t timestamp_ms;      // 记录时间戳
+    uint64_t offset;            // 记录在数据文件中的偏移
+    int32_t stream_id;
+    uint32_t record_bytes;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(ArchiveFileHeader) == 64, "ArchiveFileHeader 布局变化会破坏已有归档");
+static_assert(sizeof(ArchiveIndexEntry) == 32, "ArchiveIndexEntry 布局变化会破坏已有归档");
+
+} // namespace result_archive
+
+/**
+ * 归档写入配置
+ */
+struct ResultArchiveConfig {
+    size_t buffer_bytes = 256 << 10;      // 用户态写缓冲，满后一次 write
+    int fsync_interval_records = 500;     // 每追加该数量的记录 fsync 一次，<=0 不按记录数
+    int fsync_interval_ms = 1000;         // 距上次 fsync 超过该时间时 fsync，<=0 不按时间
+};
+
+/**
+ * 归档写入器（单线程使用）
+ *
+ * 记录先进入用户态缓冲，按记录数或时间批量 write，单条追加只有一次内存拷贝。
+ * fdatasync 由后台线程执行，追加线程（结果回调）不等待磁盘；后台线程落盘期间到达的
+ * 请求合并为下一次落盘。崩溃最多丢失最近一个 fsync 周期（加一次进行中的落盘）内的记录。
+ * 打开时对数据文件加 flock(LOCK_EX)，同一归档同时只能有一个写入方（跨进程、同进程均适用）。
+ */
+class ResultArchiveWriter {
+public:
+    explicit ResultArchiveWriter(const ResultArchiveConfig& config = ResultArchiveConfig());
+    ~ResultArchiveWriter();
+
+    ResultArchiveWriter(const ResultArchiveWriter&) = delete;
+    ResultArchiveWriter& operator=(const ResultArchiveWriter&) = delete;
+
+    /**
+     * 打开归档，不存在时创建，存在时校验文件头、修复尾部后继续追加
+     * @return 成功返回true
+     */
+    bool open(const std::string& path);
+
+    /**
+     * 追加一条结果记录
+     * @return 写入失败（磁盘满等）返回false，此后的追加全部失败
+     */
+    bool append(const ProcessResult& result, const result_record::RecordMeta& meta);
+
+    // 写出缓冲并请求后台 fdatasync（不等待落盘完成）
+    bool flush();
+
+    // 写出缓冲并等待 fdatasync 完成
+    bool sync();
+
+    // sync 后停止后台线程并关闭
+    void close();
+
+    bool is_open() const { return data_fd_ >= 0; }
+    uint64_t get_records_written() const { return records_written_; }
+    uint64_t get_fsync_count() const { return fsync_count_.load(); }
+
+private:
+    bool write_buffers();
+    bool recover(uint64_t data_size);
+
+    // 请求一次落盘，返回请求序号
+    uint64_t request_sync();
+    void sync_thread_func();
+
+    ResultArchiveConfig config_;
+    int data_fd_ = -1;
+    int index_fd_ = -1;
+    std::atomic<bool> failed_{false};
+
+    // 后台落盘：请求序号与已完成序号（完成序号之前写出的数据均已落盘）
+    std::thread sync_thread_;
+    std::mutex sync_mutex_;
+    std::condition_variable sync_cv_;
+    uint64_t sync_requested_ = 0;
+    uint64_t sync_done_ = 0;
+    bool sync_stop_ = false;
+
+    uint64_t data_offset_ = 0;                    // 下一条记录在数据文件中的偏移（含缓冲中的记录）
+    std::vector<uint8_t> data_buffer_;
+    std::vector<result_archive::ArchiveIndexEntry> index_buffer_;
+
+    int records_since_sync_ = 0;
+    std::chrono::steady_clock::time_point last_sync_;
+    uint64_t records_written_ = 0;
+    std::atomic<uint64_t> fsync_count_{0};
+};
+
+/**
+ * 归档只读视图（mmap，零拷贝）
+ *
+ * 记录按下标访问，RecordRef 直接指向映射内存；按帧序号/时间查找走索引二分，
+ * 索引非单调（多次运行追加到同一文件，帧序号从0重新开始）时在内存中建排序表。
+ * 打开后对文件的后续追加不可见，需重新 open。
+ */
+class ResultArchiveReader {
+public:
+    /**
+     * 单条记录的零拷贝引用，生命周期不超过所属 reader
+     */
+    struct RecordRef {
+        const result_record::ResultRecordHeader* header = nullptr;
+        const result_record::ResultRecordBox* boxes = nullptr;      // header->box_count 个
+        const result_record::ResultRecordBox* filtered_box = nullptr; // 无筛选框时为 nullptr
+    };
+
+    ResultArchiveReader() = default;
+    ~ResultArchiveReader();
+
+    ResultArchiveReader(const ResultArchiveReader&) = delete;
+    ResultArchiveReader& operator=(const ResultArchiveReader&) = delete;
+
+    /**
+     * 映射归档文件；索引缺失或短于数据时扫描数据文件补全（只在内存中）
+     * @return 文件头无效时返回false
+     */
+    bool open(const std::string& path);
+    void close();
+
+    size_t size() const { return index_count_; }
+    const result_archive::ArchiveIndexEntry& entry(size_t i) const { return index_[i]; }
+    RecordRef record(size_t i) const;
+
+    // 解码为 ProcessResult（有拷贝）
+    bool decode(size_t i, result_record::DecodedRecord& record) const;
+
+    /**
+     * 按帧序号查找
+     * @return 记录下标，不存在返回 size()；同一帧序号有多条时返回最早的一条
+     */
+    size_t find_frame(uint64_t frame_id, int32_t stream_id) const;
+
+    /**
+     * 时间范围 [from_ms, to_ms) 内的记录下标（按时间升序）
+     */
+    std::vector<size_t> time_range(uint64_t from_ms, uint64_t to_ms) const;
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t data_size_ = 0;
+    const result_archive::ArchiveIndexEntry* index_ = nullptr;
+    size_t index_count_ = 0;
+    void* index_map_ = nullptr;                   // 映射的索引文件
+    size_t index_map_size_ = 0;
+    std::vector<result_archive::ArchiveIndexEntry> rebuilt_index_;  // 索引缺失部分由扫描补全
+
+    // 非单调时的排序表（记录下标）
+    std::vector<uint32_t> by_frame_;
+    std::vector<uint32_t> by_time_;
+    bool frame_sorted_ = true;
+    bool time_sorted_ = true;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "box_event.h"
+#include "image_data.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 增量输出配置
+ */
+struct ResultDeltaConfig {
+    int keyframe_interval = 50;           // 关键帧间隔（帧），关键帧携带完整目标集合
+    int move_threshold_px = 8;            // 目标框任一边相对上次下发位置的移动超过该像素数时下发
+    float move_threshold_ratio = 0.1f;    // 同上，按框高的比例计，两者取较大值
+};
+
+/**
+ * 单个目标的变化类型（位标志，可组合）
+ */
+enum ResultChangeFlag : uint8_t {
+    CHANGE_APPEARED = 1 << 0,             // 新出现的轨迹
+    CHANGE_DISAPPEARED = 1 << 1,          // 轨迹消失，box 为最后一次下发的位置
+    CHANGE_STATUS = 1 << 2,               // 事件状态或静止标志变化
+    CHANGE_MOVED = 1 << 3,                // 位置移动超过阈值
+    CHANGE_UNTRACKED = 1 << 4             // 无跟踪ID的目标，无法跨帧比对，每帧照常下发
+};
+
+struct BoxChange {
+    uint8_t flags = 0;                    // ResultChangeFlag 组合
+    DetectionBox box;
+};
+
+/**
+ * 一帧的增量结果
+ *
+ * 关键帧：changes 为空，接收方以该帧完整目标集合（ResultView 的目标框）替换本地状态。
+ * 非关键帧：changes 只含相对 base_frame_id 那一帧发生变化的目标，接收方需按帧序号
+ * 顺序应用；发现 base_frame_id 与本地最后应用的帧不一致（漏取、超时）时丢弃本地状态，
+ * 等待下一个关键帧。
+ */
+struct ResultDelta {
+    bool keyframe = true;
+    uint64_t base_frame_id = 0;           // 增量相对的上一帧（同一视频流），关键帧无意义
+    std::vector<BoxChange> changes;
+};
+
+/**
+ * 结果增量编码器（结果发布线程调用）
+ *
+ * 按视频流记住每条轨迹上次下发的目标框，逐帧比较当前目标集合，只输出出现、消失、
+ * 状态变化和移动超过阈值的目标。移动阈值与"上次下发"而非"上一帧"比较，缓慢漂移
+ * 累积到阈值后同样会下发，接收方状态与真实位置的偏差不超过阈值。
+ * 同一流的帧必须按帧序号顺序编码（结果发布线程天然满足）。
+ */
+class ResultDeltaEncoder {
+public:
+    explicit ResultDeltaEncoder(const ResultDeltaConfig& config = ResultDeltaConfig());
+
+    // 编码一帧，结果写入 image.result_delta
+    void encode(ImageData& image);
+
+    // 更新配置，所有流在下一帧输出关键帧
+    void set_config(const ResultDeltaConfig& config);
+
+    // 清空所有流的状态
+    void reset();
+
+    // 统计信息
+    uint64_t get_frames_encoded() const { return frames_encoded_.load(); }
+    uint64_t get_keyframes() const { return keyframes_.load(); }
+    uint64_t get_full_boxes() const { return full_boxes_.load(); }       // 全量输出时应下发的目标数
+    uint64_t get_sent_boxes() const { return sent_boxes_.load(); }       // 实际下发的目标数（关键帧计全量）
+
+private:
+    struct StreamState {
+        std::unordered_map<int, DetectionBox> sent;   // track_id -> 上次下发的目标框
+        uint64_t last_frame_id = 0;
+        int frames_since_keyframe = 0;
+        bool has_base = false;
+    };
+
+    bool moved(const DetectionBox& sent, const DetectionBox& current, const ResultDeltaConfig& config) const;
+
+    std::mutex state_mutex_;
+    ResultDeltaConfig config_;
+    std::unordered_map<int, StreamState> streams_;
+
+    std::atomic<uint64_t> frames_encoded_{0};
+    std::atomic<uint64_t> keyframes_{0};
+    std::atomic<uint64_t> full_boxes_{0};
+    std::atomic<uint64_t> sent_boxes_{0};
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "highway_event.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * 紧凑二进制结果记录格式（小端序，1字节对齐）
+ * 用于共享内存结果环和结果归档，跨进程/跨语言读取时按以下布局解析：
+ *
+ *   ResultRecordHeader (64字节)
+ *   ResultRecordBox × box_count   (每个28字节)
+ *   ResultRecordBox × 1           (仅当 has_filtered_box != 0)
+ */
+namespace result_record {
+
+constexpr uint32_t kMagic = 0x52455748;   // "HWER"
+constexpr uint16_t kVersion = 1;
+
+#pragma pack(push, 1)
+struct ResultRecordHeader {
+    uint32_t magic;             // kMagic
+    uint16_t version;           // kVersion
+    uint16_t box_count;         // 检测框数量
+    uint32_t record_bytes;      // 整条记录字节数（含头）
+    uint8_t status;             // ResultStatus
+    uint8_t has_filtered_box;   // 是否附带筛选框
+    uint16_t reserved;
+    uint64_t frame_id;          // SDK内部帧序号
+    uint64_t source_frame_id;   // 生产者侧帧序号
+    uint64_t timestamp_ms;      // 生产者侧时间戳
+    int32_t stream_id;          // 生产者侧视频流ID
+    int32_t roi_x, roi_y, roi_width, roi_height;
+    uint32_t reserved2;
+};
+
+struct ResultRecordBox {
+    int32_t left, top, right, bottom;
+    uint16_t confidence;        // 置信度 × 10000
+    int16_t class_id;
+    int32_t track_id;
+    int8_t status;              // ObjectStatus
+    uint8_t is_still;
+    uint16_t reserved;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(ResultRecordHeader) == 64, "ResultRecordHeader 布局变化会破坏跨进程兼容性");
+static_assert(sizeof(ResultRecordBox) == 28, "ResultRecordBox 布局变化会破坏跨进程兼容性");
+
+/**
+ * 结果记录附带的生产者侧元数据
+ */
+struct RecordMeta {
+    uint64_t source_frame_id = 0;
+    uint64_t timestamp_ms = 0;
+    int32_t stream_id = 0;
+};
+
+/**
+ * 解码后的结果记录
+ */
+struct DecodedRecord {
+    RecordMeta meta;
+    ProcessResult result;
+};
+
+// 记录编码后的字节数
+size_t encoded_size(const ProcessResult& result);
+
+/**
+ * 编码结果记录，追加到out末尾
+ * @return 本条记录的字节数
+ */
+size_t encode(const ProcessResult& result, const RecordMeta& meta, std::vector<uint8_t>& out);
+
+/**
+ * 编码结果记录到调用方提供的缓冲区
+ * @return 写入字节数，缓冲区不足时返回0
+ */
+size_t encode_to(const ProcessResult& result, const RecordMeta& meta, uint8_t* buffer, size_t capacity);
+
+/**
+ * 解码一条结果记录
+ * @return 成功返回记录字节数，数据不完整或格式错误返回0
+ */
+size_t decode(const uint8_t* data, size_t size, DecodedRecord& record);
+
+} // namespace result_record
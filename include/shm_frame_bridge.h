@@ -0,0 +1,105 @@
+#pragma once
+
+#include "highway_event.h"
+#include "shm_transport.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * 共享内存桥接配置
+ */
+struct ShmBridgeConfig {
+    std::string name = "highway_event";            // 共享内存名前缀：/<name>_frames、/<name>_results
+    uint32_t slot_count = 64;                      // 帧槽位数量，需覆盖流水线在途帧数
+    uint64_t slot_bytes = 1920ull * 1080ull * 3;   // 每个槽位最大图像字节数
+    uint64_t result_ring_bytes = 4ull << 20;       // 结果环容量
+    std::string control_socket_path;               // 控制通道Unix socket路径，空则为 /tmp/<name>.sock
+    int result_timeout_ms = 30000;                 // 等待单帧结果的超时时间
+    int result_write_timeout_ms = 1000;            // 结果环满时的等待时间，超时丢弃
+};
+
+/**
+ * 共享内存桥接器
+ * 把独立进程中的解码器和结果消费方接到 HighwayEventDetector：
+ *   - 接收线程从帧环按顺序取帧，以零拷贝Mat调用 add_frame(cv::Mat&&)，
+ *     帧数据留在共享内存中，流水线释放最后一个引用时槽位自动归还；
+ *   - 结果线程按提交顺序获取结果，编码为 result_record 写入结果环；
+ *     停止时已提交的帧同样各写入一条记录（等待缩短，检测器已停止时为ERROR），
+ *     生产者不会因桥接停止而漏收结果；
+ *   - 控制线程在Unix socket上响应文本命令（PING/INFO/STATS/STATUS），
+ *     生产者通过 INFO 获取共享内存名和槽位规格。
+ * 生产者进程崩溃只影响其正在写入的槽位，由帧环自动回收。
+ */
+class ShmFrameBridge {
+public:
+    ShmFrameBridge(HighwayEventDetector* detector, const ShmBridgeConfig& config = ShmBridgeConfig());
+    ~ShmFrameBridge();
+
+    ShmFrameBridge(const ShmFrameBridge&) = delete;
+    ShmFrameBridge& operator=(const ShmFrameBridge&) = delete;
+
+    // 创建共享内存和控制通道并启动线程，检测器需已启动
+    bool start();
+
+    // 停止线程（先为已提交的帧写完结果记录），等待流水线释放所有槽位后删除共享内存
+    void stop();
+
+    bool is_running() const { return running_.load(); }
+
+    std::string get_frame_ring_name() const { return "/" + config_.name + "_frames"; }
+    std::string get_result_ring_name() const { return "/" + config_.name + "_results"; }
+    std::string get_control_socket_path() const;
+
+    // 统计信息
+    struct Statistics {
+        uint64_t frames_received = 0;       // 从帧环取出的帧数
+        uint64_t frames_rejected = 0;       // add_frame 失败的帧数
+        uint64_t results_written = 0;       // 写入结果环的记录数
+        uint64_t results_dropped = 0;       // 结果环满被丢弃的记录数
+        uint64_t slots_recovered = 0;       // 生产者崩溃后回收的槽位数
+        uint32_t slots_in_use = 0;          // 当前被流水线引用的槽位数
+    };
+    Statistics get_statistics() const;
+
+private:
+    struct PendingFrame {
+        uint64_t frame_id;
+        ShmFrameMeta meta;
+        bool rejected;      // add_frame 失败，结果环中写入ERROR记录
+    };
+
+    void ingest_thread_func();
+    void result_thread_func();
+    void control_thread_func();
+
+    // 处理一条控制命令，返回应答文本（以换行结尾）
+    std::string handle_command(const std::string& command);
+
+    HighwayEventDetector* detector_;
+    ShmBridgeConfig config_;
+
+    // 停止时若流水线仍引用槽位，帧环映射保持有效（不释放），避免悬空访问
+    std::unique_ptr<ShmFrameRing> frame_ring_;
+    ShmResultRing result_ring_;
+    int listen_fd_;
+
+    std::atomic<bool> running_;
+    std::thread ingest_thread_;
+    std::thread result_thread_;
+    std::thread control_thread_;
+
+    // 已提交、等待结果的帧（按提交顺序）
+    std::mutex pending_mutex_;
+    std::condition_variable pending_cv_;
+    std::deque<PendingFrame> pending_frames_;
+    bool ingest_done_ = false;      // 接收线程已退出，不会再有新的待处理帧
+
+    std::atomic<uint64_t> frames_received_{0};
+    std::atomic<uint64_t> frames_rejected_{0};
+    std::atomic<uint64_t> results_written_{0};
+};
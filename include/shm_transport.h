@@ -0,0 +1,231 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 基于POSIX共享内存的跨进程帧/结果传输
+ *
+ * 帧环（多生产者 → 单消费者）：
+ *   固定大小的帧槽位，每个槽位头包含状态机和seqlock序号。
+ *   生产者（解码进程）按票号顺序占用空闲槽位，直接把图像写入共享内存；
+ *   消费者（SDK进程）按票号顺序取出就绪槽位，以零拷贝方式包装为cv::Mat，
+ *   最后一个引用该Mat的对象析构时槽位自动归还。
+ *   生产者写入过程中崩溃时，消费者判定写入方已退出（见下）后回收该槽位，不会卡死；
+ *   占用槽位后、推进票号前崩溃时，由后续生产者回收。
+ *
+ * 生产者存活判定：生产者首次写入时在环头的生产者表中登记，后台线程定期递增表项的心跳计数，
+ *   槽位状态字记录占用者的登记号。观察方（消费者或其他生产者）按本地时钟计时，心跳计数在
+ *   owner_timeout_ms 内没有变化、或登记号已注销/被复用时视为占用者已退出。不使用 pid：
+ *   不同 pid 命名空间（容器）中的进程互相看不到对方的 pid，kill(pid, 0) 会把存活的生产者
+ *   误判为已退出；也不比较双方的时间戳（时间命名空间可能不同）。
+ *   生产者被暂停超过超时（如调试器）后其槽位可能已被回收，commit_write_slot 返回false，该帧丢弃。
+ *
+ * 结果环（单生产者 → 单消费者）：
+ *   变长字节环，每条记录为 result_record 紧凑二进制格式，记录不跨越环尾。
+ */
+
+/**
+ * 帧槽位元数据（受seqlock保护）
+ */
+struct ShmFrameMeta {
+    uint64_t source_frame_id = 0;   // 生产者侧帧序号
+    uint64_t timestamp_ms = 0;      // 生产者侧时间戳
+    int32_t stream_id = 0;          // 视频流ID
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t type = 0;               // OpenCV类型，如 CV_8UC3
+    uint64_t step = 0;              // 行字节数
+    uint64_t data_bytes = 0;        // 有效数据字节数
+};
+
+/**
+ * 多生产者帧环
+ */
+class ShmFrameRing {
+public:
+    enum SlotState : uint32_t {
+        SLOT_FREE = 0,        // 空闲，可被生产者占用
+        SLOT_WRITING = 1,     // 生产者写入中
+        SLOT_READY = 2,       // 写入完成，等待消费
+        SLOT_CONSUMING = 3    // 消费者处理中（被流水线引用）
+    };
+
+    /**
+     * 生产者占用的槽位句柄
+     */
+    struct SlotHandle {
+        uint32_t index = 0;
+        uint64_t ticket = 0;
+        uint8_t* data = nullptr;
+        uint64_t capacity = 0;
+        uint64_t claimed_state = 0;   // 占用时写入的状态字，提交时据此确认槽位未被回收
+    };
+
+    ShmFrameRing();
+    ~ShmFrameRing();
+
+    ShmFrameRing(const ShmFrameRing&) = delete;
+    ShmFrameRing& operator=(const ShmFrameRing&) = delete;
+
+    /**
+     * 创建共享内存帧环（消费者侧调用，已存在则重建）
+     * @param name 共享内存名（如 "/highway_event_frames"）
+     * @param slot_count 槽位数量，需覆盖流水线中同时在途的帧数
+     * @param slot_bytes 每个槽位的最大图像字节数
+     */
+    bool create(const std::string& name, uint32_t slot_count, uint64_t slot_bytes);
+
+    // 打开已存在的帧环（生产者侧调用）
+    bool open(const std::string& name);
+
+    // 解除映射；创建者同时删除共享内存对象
+    void close();
+
+    bool is_open() const { return header_ != nullptr; }
+    uint32_t get_slot_count() const;
+    uint64_t get_slot_bytes() const;
+
+    // ===== 生产者接口 =====
+
+    /**
+     * 占用下一个槽位，可直接把解码结果写入 handle.data
+     * @param timeout_ms 环满时的最长等待时间，0表示不等待
+     */
+    bool acquire_write_slot(SlotHandle& handle, int timeout_ms);
+
+    // 提交写入完成的槽位；槽位已被当作崩溃回收时返回false（该帧丢弃）
+    bool commit_write_slot(const SlotHandle& handle, const ShmFrameMeta& meta);
+
+    // 拷贝一帧图像到环中（便捷接口）
+    bool write_frame(const cv::Mat& image, uint64_t source_frame_id, uint64_t timestamp_ms,
+                     int32_t stream_id, int timeout_ms);
+
+    // ===== 消费者接口 =====
+
+    /**
+     * 按票号顺序取出下一个就绪帧，包装为零拷贝cv::Mat
+     * Mat及其所有副本析构后槽位自动归还给生产者
+     * @param timeout_ms 无就绪帧时的最长等待时间
+     */
+    bool read_frame(cv::Mat& image, ShmFrameMeta& meta, int timeout_ms);
+
+    // 归还槽位（由零拷贝Mat的分配器调用）
+    void release_slot(uint32_t index);
+
+    // 占用者心跳无变化多久视为已退出（观察方本地设置，默认2000毫秒）
+    void set_owner_timeout_ms(int timeout_ms) { owner_timeout_ms_.store(std::max(1, timeout_ms)); }
+
+    // 统计信息
+    uint64_t get_frames_written() const;
+    uint64_t get_frames_read() const;
+    uint64_t get_slots_recovered() const;
+    uint32_t get_slots_in_use() const;
+
+private:
+    struct RingHeader;
+    struct SlotHeader;
+    struct ProducerEntry;
+
+    // 观察到的某个生产者表项心跳（按本地时钟判断是否停止）
+    struct BeatObservation {
+        uint32_t owner = 0;
+        uint64_t beat = 0;
+        int64_t since_ms = 0;
+    };
+
+    bool map_region(int fd, size_t size);
+    ProducerEntry* producer_at(uint32_t index) const;
+
+    // 在生产者表中登记（首次写入时）并启动心跳线程，返回登记号，失败返回0
+    uint32_t register_producer();
+    void unregister_producer();
+    void heartbeat_thread_func();
+    SlotHeader* slot_at(uint32_t index) const;
+    uint8_t* slot_data(uint32_t index) const;
+
+    // 读取受seqlock保护的元数据，写入中返回false
+    bool read_meta(const SlotHeader* slot, ShmFrameMeta& meta) const;
+
+    // 状态字记录的占用者是否已退出（已注销，或心跳超时无变化）
+    bool owner_exited(uint64_t state);
+
+    // 消费者侧：票号已推进、占用者已退出的槽位回收
+    bool try_recover_slot(SlotHeader* slot, uint64_t ticket);
+
+    // 生产者侧：占用槽位后、推进票号前占用者已退出的槽位回收
+    bool try_recover_claim(SlotHeader* slot, uint64_t ticket, uint64_t state);
+
+    std::string name_;
+    bool owner_;
+    void* region_;
+    size_t region_size_;
+    RingHeader* header_;
+
+    // 生产者侧：本进程的登记号与心跳线程
+    std::mutex producer_mutex_;
+    std::condition_variable heartbeat_cv_;
+    std::thread heartbeat_thread_;
+    std::atomic<uint32_t> producer_id_{0};
+    bool heartbeat_stop_ = false;
+
+    // 观察侧：各生产者表项最近一次看到的心跳
+    std::mutex observe_mutex_;
+    std::vector<BeatObservation> observed_;
+    std::atomic<int> owner_timeout_ms_{2000};
+};
+
+/**
+ * 单生产者/单消费者结果字节环
+ */
+class ShmResultRing {
+public:
+    ShmResultRing();
+    ~ShmResultRing();
+
+    ShmResultRing(const ShmResultRing&) = delete;
+    ShmResultRing& operator=(const ShmResultRing&) = delete;
+
+    // 创建结果环（SDK侧调用）
+    bool create(const std::string& name, uint64_t capacity_bytes);
+
+    // 打开已存在的结果环（结果消费进程调用）
+    bool open(const std::string& name);
+
+    void close();
+    bool is_open() const { return header_ != nullptr; }
+
+    /**
+     * 写入一条记录
+     * @param timeout_ms 空间不足时的最长等待时间，超时后丢弃该记录
+     */
+    bool write(const uint8_t* record, uint32_t size, int timeout_ms);
+
+    /**
+     * 读取一条记录
+     * @param timeout_ms 无记录时的最长等待时间
+     */
+    bool read(std::vector<uint8_t>& record, int timeout_ms);
+
+    uint64_t get_records_dropped() const;
+
+private:
+    struct RingHeader;
+
+    bool try_write(const uint8_t* record, uint32_t size);
+    bool try_read(std::vector<uint8_t>& record);
+
+    std::string name_;
+    bool owner_;
+    void* region_;
+    size_t region_size_;
+    RingHeader* header_;
+    uint8_t* data_;
+};
@@ -0,0 +1,259 @@
+#pragma once
+
+#include "perf_counters.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * 阶段耗时分布快照（各工作线程累计值，单位纳秒）
+ *   busy_cpu_ns     : process_batch 期间工作线程实际占用的CPU时间
+ *   busy_wall_ns    : process_batch 的墙钟时间（含锁等待、GPU/线程池future等待）
+ *   input_wait_ns   : 阻塞在输入连接器上的时间
+ *   output_wait_ns  : 阻塞在输出连接器上的时间
+ *   lock_wait_ns    : 工作线程在插桩锁上等待的时间（竞争时才计时，属于 busy_wall_ns 的一部分）
+ *   pool_cpu_ns     : 阶段线程池任务消耗的CPU时间
+ *   pool_lock_wait_ns : 线程池任务在插桩锁上等待的时间；不在工作线程时间内，只作为绝对值报告
+ *   hw_*            : process_batch 与线程池任务期间的硬件计数（启用 HwPerfCounters 且内核允许时）
+ */
+struct StageProfileSnapshot {
+    uint64_t batches = 0;
+    uint64_t images = 0;           // 已处理图像数（各阶段批次大小不同，按帧比较吞吐）
+    uint64_t busy_cpu_ns = 0;
+    uint64_t busy_wall_ns = 0;
+    uint64_t input_wait_ns = 0;
+    uint64_t output_wait_ns = 0;
+    uint64_t lock_wait_ns = 0;
+    uint64_t pool_tasks = 0;
+    uint64_t pool_cpu_ns = 0;
+    uint64_t pool_lock_wait_ns = 0;
+    uint64_t hw_intervals = 0;     // 取得硬件计数的区间数
+    uint64_t hw_cycles = 0;
+    uint64_t hw_instructions = 0;
+    uint64_t hw_cache_misses = 0;
+    uint64_t hw_branch_misses = 0;
+
+    // 每周期指令数，无硬件计数时为0
+    double ipc() const {
+        return hw_cycles > 0 ? static_cast<double>(hw_instructions) / hw_cycles : 0.0;
+    }
+
+    // 每千条指令的未命中数
+    double cache_mpki() const {
+        return hw_instructions > 0 ? hw_cache_misses * 1000.0 / hw_instructions : 0.0;
+    }
+    double branch_mpki() const {
+        return hw_instructions > 0 ? hw_branch_misses * 1000.0 / hw_instructions : 0.0;
+    }
+
+    // process_batch 中既不在CPU上、也不在等锁的时间（GPU推理、等待线程池future等）
+    uint64_t offcpu_ns() const {
+        uint64_t accounted = busy_cpu_ns + lock_wait_ns;
+        return busy_wall_ns > accounted ? busy_wall_ns - accounted : 0;
+    }
+
+    // 工作线程总的已记录时间
+    uint64_t total_ns() const {
+        return busy_wall_ns + input_wait_ns + output_wait_ns;
+    }
+};
+
+/**
+ * 单批次服务时间样本（供流水线仿真器拟合服务时间分布）
+ */
+struct ServiceSample {
+    uint32_t batch_size = 0;
+    uint64_t wall_ns = 0;
+};
+
+/**
+ * 阶段性能剖析器
+ * 每个处理阶段持有一个实例，阶段工作线程通过 ThreadBinding 绑定到该实例。
+ * 绑定后线程内的连接器等待、插桩锁等待会自动记入对应阶段，
+ * 不需要把剖析器指针逐层传递。线程池线程以 pool_task 绑定，其锁等待单独累计，
+ * 不计入工作线程的耗时分布（否则各项占比之和可能超过100%）。
+ */
+class StageProfiler {
+public:
+    StageProfiler() = default;
+    StageProfiler(const StageProfiler&) = delete;
+    StageProfiler& operator=(const StageProfiler&) = delete;
+
+    // 当前线程的CPU时间（CLOCK_THREAD_CPUTIME_ID）
+    static uint64_t thread_cpu_ns();
+
+    // 单调时钟
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // 当前线程绑定的剖析器（可能为空）
+    static StageProfiler* current();
+
+    // 记录到当前线程绑定的剖析器，未绑定时忽略
+    static void record_input_wait(uint64_t ns);
+    static void record_output_wait(uint64_t ns);
+    static void record_lock_wait(uint64_t ns);
+
+    /**
+     * 线程绑定（RAII），析构时恢复之前的绑定
+     * pool_task 为 true 表示线程池线程（锁等待记入 pool_lock_wait_ns）
+     */
+    class ThreadBinding {
+    public:
+        explicit ThreadBinding(StageProfiler* profiler, bool pool_task = false);
+        ~ThreadBinding();
+        ThreadBinding(const ThreadBinding&) = delete;
+        ThreadBinding& operator=(const ThreadBinding&) = delete;
+    private:
+        StageProfiler* previous_;
+        bool previous_pool_task_;
+    };
+
+    /**
+     * 处理区间计时（RAII），同时记录墙钟时间和线程CPU时间
+     * 给出批次大小时额外保存一个服务时间样本；启用硬件计数器时在区间边界各读一次
+     */
+    class BusyScope {
+    public:
+        explicit BusyScope(StageProfiler& profiler, size_t batch_size = 0)
+            : profiler_(profiler), batch_size_(batch_size), wall_start_(now_ns()), cpu_start_(thread_cpu_ns()),
+              hw_valid_(HwPerfCounters::read(hw_start_)) {}
+        ~BusyScope() {
+            HwCounterValues hw_end;
+            if (hw_valid_ && HwPerfCounters::read(hw_end)) {
+                profiler_.add_hw(hw_end - hw_start_);
+            }
+            uint64_t wall_ns = now_ns() - wall_start_;
+            profiler_.add_busy(wall_ns, thread_cpu_ns() - cpu_start_);
+            if (batch_size_ > 0) {
+                profiler_.add_images(batch_size_);
+                profiler_.add_service_sample(batch_size_, wall_ns);
+            }
+        }
+        BusyScope(const BusyScope&) = delete;
+        BusyScope& operator=(const BusyScope&) = delete;
+    private:
+        StageProfiler& profiler_;
+        size_t batch_size_;
+        uint64_t wall_start_;
+        uint64_t cpu_start_;
+        HwCounterValues hw_start_;
+        bool hw_valid_;
+    };
+
+    void add_busy(uint64_t wall_ns, uint64_t cpu_ns) {
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        busy_wall_ns_.fetch_add(wall_ns, std::memory_order_relaxed);
+        busy_cpu_ns_.fetch_add(cpu_ns, std::memory_order_relaxed);
+    }
+    void add_images(size_t count) { images_.fetch_add(count, std::memory_order_relaxed); }
+    void add_input_wait(uint64_t ns) { input_wait_ns_.fetch_add(ns, std::memory_order_relaxed); }
+    void add_output_wait(uint64_t ns) { output_wait_ns_.fetch_add(ns, std::memory_order_relaxed); }
+    void add_lock_wait(uint64_t ns) { lock_wait_ns_.fetch_add(ns, std::memory_order_relaxed); }
+    void add_pool_lock_wait(uint64_t ns) { pool_lock_wait_ns_.fetch_add(ns, std::memory_order_relaxed); }
+    void add_pool_task(uint64_t cpu_ns) {
+        pool_tasks_.fetch_add(1, std::memory_order_relaxed);
+        pool_cpu_ns_.fetch_add(cpu_ns, std::memory_order_relaxed);
+    }
+    void add_hw(const HwCounterValues& values) {
+        hw_intervals_.fetch_add(1, std::memory_order_relaxed);
+        hw_cycles_.fetch_add(values.cycles, std::memory_order_relaxed);
+        hw_instructions_.fetch_add(values.instructions, std::memory_order_relaxed);
+        hw_cache_misses_.fetch_add(values.cache_misses, std::memory_order_relaxed);
+        hw_branch_misses_.fetch_add(values.branch_misses, std::memory_order_relaxed);
+    }
+
+    // 服务时间样本环（保留最近 SERVICE_SAMPLE_CAPACITY 个，每批次一次加锁）
+    static constexpr size_t SERVICE_SAMPLE_CAPACITY = 4096;
+    void add_service_sample(size_t batch_size, uint64_t wall_ns);
+    std::vector<ServiceSample> service_samples() const;
+
+    StageProfileSnapshot snapshot() const;
+
+    // 格式化为一行耗时分布，如 "计算 62.1% | 非CPU 20.3% | 等输入 10.0% | 等输出 0.0% | 锁等待 7.6%"
+    // 百分比均相对工作线程总时间（total_ns），线程池CPU与锁等待以毫秒附在后面
+    static std::string format(const StageProfileSnapshot& profile);
+
+private:
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> images_{0};
+    std::atomic<uint64_t> busy_cpu_ns_{0};
+    std::atomic<uint64_t> busy_wall_ns_{0};
+    std::atomic<uint64_t> input_wait_ns_{0};
+    std::atomic<uint64_t> output_wait_ns_{0};
+    std::atomic<uint64_t> lock_wait_ns_{0};
+    std::atomic<uint64_t> pool_tasks_{0};
+    std::atomic<uint64_t> pool_cpu_ns_{0};
+    std::atomic<uint64_t> pool_lock_wait_ns_{0};
+    std::atomic<uint64_t> hw_intervals_{0};
+    std::atomic<uint64_t> hw_cycles_{0};
+    std::atomic<uint64_t> hw_instructions_{0};
+    std::atomic<uint64_t> hw_cache_misses_{0};
+    std::atomic<uint64_t> hw_branch_misses_{0};
+
+    mutable std::mutex samples_mutex_;
+    std::vector<ServiceSample> service_samples_;
+    size_t next_sample_ = 0;
+};
+
+/**
+ * 锁竞争统计快照
+ */
+struct LockContentionSnapshot {
+    std::string name;
+    uint64_t acquisitions = 0;   // 加锁次数
+    uint64_t contended = 0;      // 需要等待的次数
+    uint64_t wait_ns = 0;        // 累计等待时间
+    uint64_t max_wait_ns = 0;    // 最长单次等待
+};
+
+/**
+ * 插桩互斥锁
+ * 满足 Lockable 要求，可直接用于 std::lock_guard / std::unique_lock，
+ * 与条件变量配合时需使用 std::condition_variable_any。
+ * 先 try_lock，只有发生竞争时才读时钟，无竞争路径只多一次原子加。
+ * 等待时间同时记入锁自身统计和当前线程绑定的阶段。
+ */
+class InstrumentedMutex {
+public:
+    explicit InstrumentedMutex(const char* name = "mutex") : name_(name) {}
+    InstrumentedMutex(const InstrumentedMutex&) = delete;
+    InstrumentedMutex& operator=(const InstrumentedMutex&) = delete;
+
+    void lock() {
+        acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        if (mutex_.try_lock()) {
+            return;
+        }
+        uint64_t start = StageProfiler::now_ns();
+        mutex_.lock();
+        record_wait(StageProfiler::now_ns() - start);
+    }
+
+    bool try_lock() {
+        if (!mutex_.try_lock()) {
+            return false;
+        }
+        acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void unlock() { mutex_.unlock(); }
+
+    LockContentionSnapshot snapshot() const;
+
+private:
+    void record_wait(uint64_t ns);
+
+    std::mutex mutex_;
+    const char* name_;
+    std::atomic<uint64_t> acquisitions_{0};
+    std::atomic<uint64_t> contended_{0};
+    std::atomic<uint64_t> wait_ns_{0};
+    std::atomic<uint64_t> max_wait_ns_{0};
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "vehicle_parking_detect.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 轨迹静止判定配置
+ * 位移与步长均以目标框高度为单位，与目标远近无关
+ */
+struct StillnessConfig {
+    int history_frames = 25;                  // 每条轨迹保留的历史帧数
+    int min_history_frames = 10;              // 历史帧数达到该值才给出静止判定
+    float still_displacement_ratio = 0.15f;   // 窗口首尾位置位移（框高倍数）低于该值视为静止
+    float camera_step_ratio = 0.08f;          // 静止目标单帧步长（框高倍数）超过该值视为被带动
+    float camera_motion_track_ratio = 0.6f;   // 被带动的静止目标占比超过该值判定为相机运动
+    float camera_zoom_ratio = 0.05f;          // 静止目标框高整体变化比例超过该值判定为变焦
+    int min_reference_tracks = 2;             // 判定相机运动所需的最少静止参考目标数
+    int camera_confirm_frames = 2;            // 连续多少帧出现整体偏移才判定为相机运动
+    int camera_motion_hold_frames = 50;       // 检测到相机运动后交给特征点路径的帧数
+    int max_missing_frames = 25;              // 轨迹消失超过该帧数后清除历史
+};
+
+/**
+ * 基于轨迹框历史的静止判定（固定机位）
+ *
+ * 固定相机下目标是否静止可以直接由检测框在时间上的位移判断，无需每帧做特征点
+ * 提取 + RANSAC 的自运动估计。每条轨迹维护最近 history_frames 帧的框底部中心点，
+ * 取窗口首尾各三分之一的分量中位数之差作为位移，检测框抖动和个别错检不影响结果。
+ *
+ * 相机运动检测：上一帧判定为静止的目标相对各自最近位置整体同向移动（或整体缩放），
+ * 且连续 camera_confirm_frames 帧如此时，说明是相机在动而不是目标在动。此时 update()
+ * 返回 true，由调用方对该帧及随后 camera_motion_hold_frames 帧调用特征点/RANSAC 路径
+ * （VehicleParkingDetect），同时清空轨迹历史，待相机稳定后用新位置重新累积。
+ * 画面中少于 min_reference_tracks 个静止参考目标时无法检测相机运动。
+ *
+ * 同一流的帧需按帧序号顺序调用；不同流的状态按 stream_id 隔离。配置中的帧数（历史窗口、
+ * 相机运动保持、轨迹消失）都按该流自己的帧计数，与同一检测器上的流数无关。
+ */
+class TrackStillnessDetector {
+public:
+    explicit TrackStillnessDetector(const StillnessConfig& config = StillnessConfig());
+
+    /**
+     * 更新轨迹历史并写入 boxes 的 is_still
+     * @param boxes 当前帧跟踪框（违停检测图坐标）
+     * @param camera_moving 入口阶段的全局运动估计已判定相机运动（ImageData::camera_motion）
+     * @return true 表示相机处于运动中，调用方应使用特征点路径重新判定该帧
+     */
+    bool update(int stream_id, std::vector<TrackBox>& boxes, bool camera_moving = false);
+
+    // 更新阈值配置
+    void set_config(const StillnessConfig& config);
+
+    // 清空所有流 / 指定流的轨迹历史
+    void reset();
+    void reset_stream(int stream_id);
+
+    // 统计信息
+    uint64_t get_history_frames() const { return history_frames_.load(); }
+    uint64_t get_feature_frames() const { return feature_frames_.load(); }
+    uint64_t get_camera_motion_events() const { return camera_motion_events_.load(); }
+
+private:
+    struct Sample {
+        uint64_t seq;   // 本流帧序号（StreamState::frames_seen）
+        float x;        // 框底部中心
+        float y;
+        float height;
+    };
+
+    struct TrackHistory {
+        std::deque<Sample> samples;
+        bool still = false;                   // 最近一次判定结果
+    };
+
+    struct StreamState {
+        std::unordered_map<int, TrackHistory> tracks;
+        uint64_t frames_seen = 0;             // 本流已处理的帧数，即下一帧的序号
+        uint64_t hold_until = 0;              // 本流帧序号小于该值时使用特征点路径
+        int suspect_frames = 0;               // 连续出现整体偏移的帧数
+    };
+
+    // 上一帧静止的目标是否被整体带动
+    bool detect_camera_motion(const StreamState& state, const std::vector<TrackBox>& boxes,
+                              const StillnessConfig& config) const;
+
+    // 窗口首尾位置差（框高倍数）
+    static float displacement_ratio(const std::deque<Sample>& samples);
+
+    mutable std::mutex state_mutex_;
+    StillnessConfig config_;
+    std::unordered_map<int, StreamState> streams_;
+
+    std::atomic<uint64_t> history_frames_{0};
+    std::atomic<uint64_t> feature_frames_{0};
+    std::atomic<uint64_t> camera_motion_events_{0};
+};
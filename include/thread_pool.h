@@ -10,6 +10,7 @@
 #include <functional>
 #include <stdexcept>
 #include <atomic>
+#include "stage_profiler.h"
 
 /**
  * 高速公路事件检测专用线程池类
@@ -18,7 +19,12 @@
  */
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+    /**
+     * @param threads 线程数
+     * @param profiler 所属阶段的剖析器，非空时统计每个任务的CPU时间，任务内的锁等待也记入该阶段
+     */
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency(),
+                        StageProfiler* profiler = nullptr);
     ~ThreadPool();
 
     // 提交任务到线程池
@@ -48,6 +54,9 @@ private:
     // 控制标志
     std::atomic<bool> running_;
     
+    // 所属阶段剖析器（可为空）
+    StageProfiler* profiler_;
+    
     // 最大队列大小
     static constexpr size_t MAX_QUEUE_SIZE = 64;
 };
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * 时间线追踪记录器
+ *
+ * 用于短时抓取批次/帧在流水线中的时间线，导出为 Chrome trace-event JSON，
+ * 可直接用 chrome://tracing 或 Perfetto UI (ui.perfetto.dev) 打开。
+ *
+ * - 关闭时每个埋点只有一次全局原子读 + 一个可预测分支；
+ * - 开启时事件写入各线程私有的定长缓冲区（单写者，无锁），
+ *   线程首次记录时注册缓冲区（每次抓取每线程一次加锁），缓冲区满后丢弃并计数；
+ * - 事件名和类别必须是字符串字面量（只保存指针）。
+ *
+ * 用法：
+ *   TraceRecorder::start();              // 开始抓取
+ *   ...
+ *   TraceRecorder::stop();               // 停止抓取
+ *   TraceRecorder::dump_chrome_json("trace.json");
+ */
+class TraceRecorder {
+public:
+    // 默认每线程缓冲事件数
+    static constexpr size_t DEFAULT_EVENTS_PER_THREAD = 1 << 16;
+
+    // 是否正在抓取（热路径只调用这一个函数）
+    static bool is_enabled() {
+        return __builtin_expect(enabled_.load(std::memory_order_relaxed), 0);
+    }
+
+    /**
+     * 开始一次抓取，清空上一次的数据
+     * @param events_per_thread 每个线程最多记录的事件数
+     * @return 已在抓取中时返回false
+     */
+    static bool start(size_t events_per_thread = DEFAULT_EVENTS_PER_THREAD);
+
+    // 停止抓取，已记录的数据保留到下一次 start()
+    static void stop();
+
+    // 导出最近一次抓取的数据（建议先 stop()）
+    static std::string to_chrome_json();
+    static bool dump_chrome_json(const std::string& path);
+
+    // 记录一个区间事件 / 瞬时事件（调用方需先检查 is_enabled()）
+    static void complete(const char* category, const char* name, uint64_t start_ns, uint64_t end_ns,
+                         int64_t batch_id = -1, int64_t frame_idx = -1);
+    static void instant(const char* category, const char* name,
+                        int64_t batch_id = -1, int64_t frame_idx = -1);
+
+    // 设置当前线程在时间线中显示的名称（在线程启动时调用）
+    static void set_thread_name(const std::string& name);
+
+    // 单调时钟（纳秒），与 StageProfiler::now_ns 同源
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // 抓取统计
+    struct CaptureStats {
+        uint64_t events = 0;     // 已记录事件数
+        uint64_t dropped = 0;    // 缓冲区满丢弃的事件数
+        size_t threads = 0;      // 参与记录的线程数
+    };
+    static CaptureStats get_stats();
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+/**
+ * 区间埋点（RAII）
+ * 构造时读取一次抓取状态并缓存，析构时只检查缓存值：内联后构造与析构是同一个条件，
+ * 编译器合并为一个分支，关闭时不读时钟也不访问线程缓冲区。
+ * 区间跨越 stop() 时事件被丢弃，不会为未记录过的线程创建缓冲区。
+ */
+class TraceScope {
+public:
+    TraceScope(const char* category, const char* name, int64_t batch_id = -1, int64_t frame_idx = -1)
+        : category_(category), name_(name), batch_id_(batch_id), frame_idx_(frame_idx),
+          enabled_(TraceRecorder::is_enabled()), start_ns_(enabled_ ? TraceRecorder::now_ns() : 0) {}
+
+    ~TraceScope() {
+        if (enabled_) {
+            TraceRecorder::complete(category_, name_, start_ns_, TraceRecorder::now_ns(), batch_id_, frame_idx_);
+        }
+    }
+
+    // 批次/帧号在区间结束时才确定的场景（如接收等待）
+    void set_batch_id(int64_t batch_id) { batch_id_ = batch_id; }
+    void set_frame_idx(int64_t frame_idx) { frame_idx_ = frame_idx; }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* category_;
+    const char* name_;
+    int64_t batch_id_;
+    int64_t frame_idx_;
+    bool enabled_;          // 构造时的抓取状态（须在 start_ns_ 之前声明）
+    uint64_t start_ns_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+// 区间埋点：TRACE_SCOPE("stage", "seg.inference", batch->batch_id, -1);
+#define TRACE_SCOPE(category, name, batch_id, frame_idx) \
+    TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(category, name, batch_id, frame_idx)
+
+// 瞬时埋点
+#define TRACE_INSTANT(category, name, batch_id, frame_idx)                 \
+    do {                                                                  \
+        if (TraceRecorder::is_enabled()) {                                \
+            TraceRecorder::instant(category, name, batch_id, frame_idx);  \
+        }                                                                 \
+    } while (0)
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+/**
+ * 4:2:0 YUV 的色度排列
+ */
+enum class YuvLayout {
+    NV12 = 0,   // Y 平面 + UV 交织半平面（硬件解码器常见输出）
+    NV21 = 1,   // Y 平面 + VU 交织半平面
+    I420 = 2,   // Y 平面 + U 平面 + V 平面
+};
+
+/**
+ * 4:2:0 YUV 原始帧（BT.601 有限范围）
+ *
+ * data 为单通道 (height*3/2) x width 的 CV_8UC1，亮度平面在前，色度平面紧随其后，
+ * 与 cv::cvtColor(COLOR_YUV2BGR_NV12/NV21/I420) 的输入排列一致。宽高须为偶数；
+ * I420 的色度平面按 width/2 紧密排列，因此要求 data 连续。
+ */
+struct YuvImage {
+    cv::Mat data;
+    YuvLayout layout = YuvLayout::NV12;
+
+    YuvImage() = default;
+    YuvImage(const cv::Mat& yuv_data, YuvLayout yuv_layout) : data(yuv_data), layout(yuv_layout) {}
+
+    // 包装外部缓冲区（不拷贝），step 为亮度行字节数
+    YuvImage(int width, int height, void* buffer, YuvLayout yuv_layout, size_t step = cv::Mat::AUTO_STEP)
+        : data(height * 3 / 2, width, CV_8UC1, buffer, step), layout(yuv_layout) {}
+
+    bool empty() const { return data.empty(); }
+    int width() const { return data.cols; }
+    int height() const { return data.rows * 2 / 3; }
+    cv::Size size() const { return cv::Size(width(), height()); }
+    size_t bytes() const { return data.total() * data.elemSize(); }
+
+    // 尺寸与排列是否合法（非空、宽高为偶数、I420 连续）
+    bool valid() const;
+
+    // 亮度平面视图（零拷贝单通道图，可直接用作灰度图）
+    cv::Mat luma() const { return data.rowRange(0, height()); }
+
+    YuvImage clone() const { return YuvImage(data.clone(), layout); }
+};
+
+/**
+ * YUV 4:2:0 到 BGR 的融合转换内核
+ *
+ * 解码器输出 NV12 时，先整帧转 BGR 再缩放/裁剪会写出并反复读取整帧三通道数据；这里把色彩转换
+ * 与缩放或裁剪合并：缩放先在 Y/UV 平面上进行（只读取目标区域），再以目标尺寸做一次色彩转换；
+ * 裁剪只转换区域内的像素。各阶段只生成自己需要的派生图。
+ * 系数与 OpenCV 的 BT.601 定点实现一致（20 位定点），偶数对齐的 NV12/NV21 裁剪直接使用
+ * cv::cvtColorTwoPlane；其余情况的色彩转换用 OpenCV 通用向量指令（CV_SIMD）实现，结果与标量定点实现一致。
+ */
+namespace yuv {
+
+// cv::cvtColor 整帧转换 BGR 使用的转换码
+int bgr_conversion_code(YuvLayout layout);
+
+// 整帧转 BGR（OpenCV SIMD 实现，供确实需要整帧彩色图的调用方）
+void to_bgr(const YuvImage& src, cv::Mat& dst);
+
+/**
+ * 融合 转换+缩放：crop 区域双线性缩放后输出 dst_size 的 BGR（rgb 为 true 时输出 RGB）
+ * dst 已是目标尺寸与类型时原地写入（可由调用方从复用池分配）。
+ * dst_size 与 crop 尺寸相同时退化为 convert_crop。
+ */
+void convert_resize(const YuvImage& src, const cv::Rect& crop, cv::Size dst_size, cv::Mat& dst, bool rgb = false);
+
+// 融合 转换+裁剪：只转换 crop 区域，输出 crop 尺寸的 BGR
+void convert_crop(const YuvImage& src, const cv::Rect& crop, cv::Mat& dst, bool rgb = false);
+
+// 亮度平面的裁剪缩放（灰度派生图无需色彩转换）
+void luma_resize(const YuvImage& src, const cv::Rect& crop, cv::Size dst_size, cv::Mat& dst,
+                 int interpolation = cv::INTER_LINEAR);
+
+// 进程级统计：融合内核输出的像素数、整帧转换输出的像素数
+uint64_t get_fused_pixels();
+uint64_t get_full_frame_pixels();
+
+}  // namespace yuv
@@ -10,6 +10,7 @@ package cn.xtkj.jni.algor.helper;
 public class EventYoloCoor extends YoloCoor {
     private int eventId;//事件ID，算法给出; 参考HighwayEventType枚举定义的eventTypeId
     private HighwayEventType eventType;//高速事件类型，引擎层解析
+    private int changeFlags;//增量输出时的变化类型（位标志）：1出现 2消失 4状态变化 8移动 16无跟踪ID；全量输出时为0
 
     public int getEventId() {
         return eventId;
@@ -26,4 +27,12 @@ public class EventYoloCoor extends YoloCoor {
     public void setEventType(HighwayEventType eventType) {
         this.eventType = eventType;
     }
+
+    public int getChangeFlags() {
+        return changeFlags;
+    }
+
+    public void setChangeFlags(int changeFlags) {
+        this.changeFlags = changeFlags;
+    }
 }
\ No newline at end of file
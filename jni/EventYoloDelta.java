@@ -0,0 +1,37 @@
+package cn.xtkj.jni.algor.helper;
+
+/**
+ * 一帧的增量结果
+ * 关键帧：coors为完整目标集合，接收方以此替换本地状态
+ * 非关键帧：coors只含相对baseMatId那一帧发生变化的目标（见EventYoloCoor.changeFlags），
+ * 需按数据id顺序应用；baseMatId与本地最后应用的数据id不一致时丢弃本地状态，等待下一个关键帧
+ */
+public class EventYoloDelta {
+    private boolean keyframe;//是否为关键帧
+    private long baseMatId;//增量相对的上一帧数据id，关键帧无意义
+    private EventYoloCoor[] coors;//关键帧为全部目标，否则为变化的目标
+
+    public boolean isKeyframe() {
+        return keyframe;
+    }
+
+    public void setKeyframe(boolean keyframe) {
+        this.keyframe = keyframe;
+    }
+
+    public long getBaseMatId() {
+        return baseMatId;
+    }
+
+    public void setBaseMatId(long baseMatId) {
+        this.baseMatId = baseMatId;
+    }
+
+    public EventYoloCoor[] getCoors() {
+        return coors;
+    }
+
+    public void setCoors(EventYoloCoor[] coors) {
+        this.coors = coors;
+    }
+}
\ No newline at end of file
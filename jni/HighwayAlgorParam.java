@@ -29,6 +29,10 @@ public class HighwayAlgorParam {
     private String segShowImagePathString = ""; // 分割可视化图片路径
     private String laneShowImagePathString = ""; // 车道线可视化图片路径
 
+    // 增量输出参数（takeResDelta）
+    private boolean enableDeltaOutput = false;     // 是否生成增量结果
+    private int deltaKeyframeInterval = 50;        // 关键帧间隔（帧）
+
 
     public boolean getEnableEmergencyLaneDetection() {
         return enableEmergencyLaneDetection;
@@ -133,4 +137,20 @@ public class HighwayAlgorParam {
     public void setLaneShowImagePathString(String laneShowImagePathString) {
         this.laneShowImagePathString = laneShowImagePathString;
     }
+
+    public boolean getEnableDeltaOutput() {
+        return enableDeltaOutput;
+    }
+
+    public void setEnableDeltaOutput(boolean enableDeltaOutput) {
+        this.enableDeltaOutput = enableDeltaOutput;
+    }
+
+    public int getDeltaKeyframeInterval() {
+        return deltaKeyframeInterval;
+    }
+
+    public void setDeltaKeyframeInterval(int deltaKeyframeInterval) {
+        this.deltaKeyframeInterval = deltaKeyframeInterval;
+    }
 }
\ No newline at end of file
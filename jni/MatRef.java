@@ -1,58 +1,104 @@
-package cn.xtkj.jni.algor.data;
-
-import java.io.Serializable;
-
-/**
- * @author htchen
- * @version 1.0
- * @ClassName: MatRef
- * @date 2022年10月29日 10:28:16
- */
-public class MatRef implements Serializable {
-    private long matDataAddr;//底层数据地址
-    private int matCols;
-    private int matRows;
-    private long nativeObjAddr;//底层对象地址
-
-    public MatRef() {
-    }
-
-    public MatRef(long matDataAddr, int matCols, int matRows, long nativeObjAddr) {
-        this.matDataAddr = matDataAddr;
-        this.matCols = matCols;
-        this.matRows = matRows;
-        this.nativeObjAddr = nativeObjAddr;
-    }
-
-    public long getMatDataAddr() {
-        return matDataAddr;
-    }
-
-    public void setMatDataAddr(long matDataAddr) {
-        this.matDataAddr = matDataAddr;
-    }
-
-    public int getMatCols() {
-        return matCols;
-    }
-
-    public void setMatCols(int matCols) {
-        this.matCols = matCols;
-    }
-
-    public int getMatRows() {
-        return matRows;
-    }
-
-    public void setMatRows(int matRows) {
-        this.matRows = matRows;
-    }
-
-    public long getNativeObjAddr() {
-        return nativeObjAddr;
-    }
-
-    public void setNativeObjAddr(long nativeObjAddr) {
-        this.nativeObjAddr = nativeObjAddr;
-    }
+package cn.xtkj.jni.algor.data;
+
+import java.io.Serializable;
+
+/**
+ * @author htchen
+ * @version 1.0
+ * @ClassName: MatRef
+ * @date 2022年10月29日 10:28:16
+ */
+public class MatRef implements Serializable {
+    public static final int PIXEL_FORMAT_BGR = 0;//BGR 三通道
+    public static final int PIXEL_FORMAT_NV12 = 1;//YUV420 半平面 UV 交织（硬件解码器常见输出）
+    public static final int PIXEL_FORMAT_NV21 = 2;//YUV420 半平面 VU 交织
+    public static final int PIXEL_FORMAT_I420 = 3;//YUV420 三平面
+
+    private long matDataAddr;//底层数据地址
+    private int matCols;
+    private int matRows;//图像高度，YUV 格式时为亮度平面行数（数据共 matRows*3/2 行）
+    private long nativeObjAddr;//底层对象地址
+    private int pixelFormat = PIXEL_FORMAT_BGR;//像素格式，YUV 格式宽高须为偶数
+    private int streamId;//视频流ID，同一实例接入多路视频时用于隔离跨帧状态（去重、跟踪等）
+    private int streamClass;//流类别（同型号/同用途相机），与分辨率一起决定批次分组
+    private int trackStillness = -1;//本路视频的轨迹历史静止判定：-1 沿用实例配置，0 关闭，1 开启（固定机位）
+
+    public MatRef() {
+    }
+
+    public MatRef(long matDataAddr, int matCols, int matRows, long nativeObjAddr) {
+        this.matDataAddr = matDataAddr;
+        this.matCols = matCols;
+        this.matRows = matRows;
+        this.nativeObjAddr = nativeObjAddr;
+    }
+
+    public MatRef(long matDataAddr, int matCols, int matRows, long nativeObjAddr, int pixelFormat) {
+        this(matDataAddr, matCols, matRows, nativeObjAddr);
+        this.pixelFormat = pixelFormat;
+    }
+
+    public long getMatDataAddr() {
+        return matDataAddr;
+    }
+
+    public void setMatDataAddr(long matDataAddr) {
+        this.matDataAddr = matDataAddr;
+    }
+
+    public int getMatCols() {
+        return matCols;
+    }
+
+    public void setMatCols(int matCols) {
+        this.matCols = matCols;
+    }
+
+    public int getMatRows() {
+        return matRows;
+    }
+
+    public void setMatRows(int matRows) {
+        this.matRows = matRows;
+    }
+
+    public long getNativeObjAddr() {
+        return nativeObjAddr;
+    }
+
+    public void setNativeObjAddr(long nativeObjAddr) {
+        this.nativeObjAddr = nativeObjAddr;
+    }
+
+    public int getPixelFormat() {
+        return pixelFormat;
+    }
+
+    public void setPixelFormat(int pixelFormat) {
+        this.pixelFormat = pixelFormat;
+    }
+
+    public int getStreamId() {
+        return streamId;
+    }
+
+    public void setStreamId(int streamId) {
+        this.streamId = streamId;
+    }
+
+    public int getStreamClass() {
+        return streamClass;
+    }
+
+    public void setStreamClass(int streamClass) {
+        this.streamClass = streamClass;
+    }
+
+    public int getTrackStillness() {
+        return trackStillness;
+    }
+
+    public void setTrackStillness(int trackStillness) {
+        this.trackStillness = trackStillness;
+    }
 }
\ No newline at end of file
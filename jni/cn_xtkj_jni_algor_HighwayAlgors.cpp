@@ -39,11 +39,31 @@ bool check_and_clear_exception(JNIEnv* env, const char* context) {
     return false;
 }
 
-// 辅助函数：从MatRef获取OpenCV Mat
-cv::Mat get_mat_from_matref(JNIEnv* env, jobject matRef) {
+// MatRef.pixelFormat 取值，与 MatRef.java 中 PIXEL_FORMAT_* 常量一致
+enum MatRefPixelFormat {
+    PIXEL_FORMAT_BGR = 0,
+    PIXEL_FORMAT_NV12 = 1,
+    PIXEL_FORMAT_NV21 = 2,
+    PIXEL_FORMAT_I420 = 3,
+};
+
+// MatRef 指向的帧：BGR 或 4:2:0 YUV（均引用Java侧缓冲区，不拷贝）
+struct MatRefFrame {
+    cv::Mat bgr;
+    YuvImage yuv;
+    FrameSource source;
+
+    bool is_yuv() const { return !yuv.empty(); }
+    bool empty() const { return bgr.empty() && yuv.empty(); }
+};
+
+// 辅助函数：从MatRef获取图像，pixelFormat/streamId/streamClass/trackStillness 字段缺失时（旧版MatRef）
+// 按BGR、视频流0、类别0、沿用检测器的静止判定配置处理
+MatRefFrame get_frame_from_matref(JNIEnv* env, jobject matRef) {
+    MatRefFrame frame;
     jclass matRefClass = env->GetObjectClass(matRef);
-    if (check_and_clear_exception(env, "get_mat_from_matref - GetObjectClass")) {
-        return cv::Mat();
+    if (check_and_clear_exception(env, "get_frame_from_matref - GetObjectClass")) {
+        return frame;
     }
     
     // 获取宽度和高度
@@ -51,25 +71,78 @@ cv::Mat get_mat_from_matref(JNIEnv* env, jobject matRef) {
     jfieldID rowsField = env->GetFieldID(matRefClass, "matRows", "I");
     jfieldID dataAddrField = env->GetFieldID(matRefClass, "matDataAddr", "J");
     
-    if (check_and_clear_exception(env, "get_mat_from_matref - GetFieldID")) {
+    if (check_and_clear_exception(env, "get_frame_from_matref - GetFieldID")) {
         env->DeleteLocalRef(matRefClass);
-        return cv::Mat();
+        return frame;
+    }
+    
+    jint pixelFormat = PIXEL_FORMAT_BGR;
+    jfieldID formatField = env->GetFieldID(matRefClass, "pixelFormat", "I");
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        formatField = nullptr;
+    }
+    jfieldID streamField = env->GetFieldID(matRefClass, "streamId", "I");
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        streamField = nullptr;
+    }
+    jfieldID streamClassField = env->GetFieldID(matRefClass, "streamClass", "I");
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        streamClassField = nullptr;
+    }
+    jfieldID trackStillnessField = env->GetFieldID(matRefClass, "trackStillness", "I");
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        trackStillnessField = nullptr;
     }
     
     jint cols = env->GetIntField(matRef, colsField);
     jint rows = env->GetIntField(matRef, rowsField);
     jlong dataAddr = env->GetLongField(matRef, dataAddrField);
+    if (formatField) {
+        pixelFormat = env->GetIntField(matRef, formatField);
+    }
+    if (streamField) {
+        frame.source.stream_id = env->GetIntField(matRef, streamField);
+    }
+    if (streamClassField) {
+        frame.source.stream_class = env->GetIntField(matRef, streamClassField);
+    }
+    if (trackStillnessField) {
+        frame.source.track_stillness = env->GetIntField(matRef, trackStillnessField);
+    }
     
-    if (check_and_clear_exception(env, "get_mat_from_matref - Get*Field")) {
+    if (check_and_clear_exception(env, "get_frame_from_matref - Get*Field")) {
         env->DeleteLocalRef(matRefClass);
-        return cv::Mat();
+        return frame;
     }
-    
-    // 从数据地址创建OpenCV Mat
-    cv::Mat mat(rows, cols, CV_8UC3, reinterpret_cast<void*>(dataAddr));
-    
     env->DeleteLocalRef(matRefClass);
-    return mat; // 克隆以确保数据安全
+    if (rows <= 0 || cols <= 0 || dataAddr == 0) {
+        return frame;
+    }
+    
+    // 从数据地址创建OpenCV Mat，YUV 时 matRows 为亮度平面行数
+    void* data = reinterpret_cast<void*>(dataAddr);
+    switch (pixelFormat) {
+    case PIXEL_FORMAT_BGR:
+        frame.bgr = cv::Mat(rows, cols, CV_8UC3, data);
+        break;
+    case PIXEL_FORMAT_NV12:
+        frame.yuv = YuvImage(cols, rows, data, YuvLayout::NV12);
+        break;
+    case PIXEL_FORMAT_NV21:
+        frame.yuv = YuvImage(cols, rows, data, YuvLayout::NV21);
+        break;
+    case PIXEL_FORMAT_I420:
+        frame.yuv = YuvImage(cols, rows, data, YuvLayout::I420);
+        break;
+    default:
+        std::cerr << "❌ 不支持的像素格式: " << pixelFormat << std::endl;
+        break;
+    }
+    return frame;
 }
 
 // 辅助函数：从HighwayAlgorParam获取配置
@@ -143,6 +216,18 @@ HighwayEventConfig get_config_from_param(JNIEnv* env, jobject param) {
         config.times_car_width = emergencyWidth;
     }
     
+    // 获取增量输出参数
+    jfieldID enableDeltaField = env->GetFieldID(paramClass, "enableDeltaOutput", "Z");
+    jfieldID deltaKeyframeField = env->GetFieldID(paramClass, "deltaKeyframeInterval", "I");
+    if (!check_and_clear_exception(env, "get_config_from_param - GetFieldID for delta")) {
+        if (enableDeltaField) {
+            config.enable_delta_output = env->GetBooleanField(param, enableDeltaField);
+        }
+        if (deltaKeyframeField) {
+            config.delta_keyframe_interval = env->GetIntField(param, deltaKeyframeField);
+        }
+    }
+    
     // 设置默认线程配置（可以根据需要调整）
     config.semantic_threads = 1;
     config.mask_threads = 8;
@@ -169,6 +254,7 @@ HighwayEventConfig get_config_from_param(JNIEnv* env, jobject param) {
     config.enable_lane_show = true; // 关闭车道线可视化
     config.lane_show_image_path = "./lane_results/"; // 车道线结果
     config.enable_pedestrian_detect = false;
+    config.result_keep_source_image = false; // Java 侧只取检测/事件结果，不读 ResultView 原图，原图在最后一个读取阶段后释放
     env->DeleteLocalRef(paramClass);
     return config;
 }
@@ -484,7 +570,7 @@ JNIEXPORT jlong JNICALL Java_cn_xtkj_jni_algor_HighwayAlgors_putMat
     }
     
     // 先获取图像数据，避免在持锁时进行JNI操作
-    cv::Mat image = get_mat_from_matref(env, matRef);
+    MatRefFrame image = get_frame_from_matref(env, matRef);
     
     if (image.empty()) {
         std::cerr << "❌ 获取图像数据失败" << std::endl;
@@ -507,8 +593,9 @@ JNIEXPORT jlong JNICALL Java_cn_xtkj_jni_algor_HighwayAlgors_putMat
             return -1;
         }
         
-        // 添加图像到检测器
-        int64_t frame_id = detector->add_frame(std::move(image));
+        // 添加图像到检测器，YUV 图像拷贝后按需转换
+        int64_t frame_id = image.is_yuv() ? detector->add_frame(image.yuv, image.source)
+                                          : detector->add_frame(std::move(image.bgr), image.source);
        
         
         if (frame_id < 0) {
@@ -523,6 +610,92 @@ JNIEXPORT jlong JNICALL Java_cn_xtkj_jni_algor_HighwayAlgors_putMat
     }
 }
 
+/*
+ * Class:     cn_xtkj_jni_algor_HighwayAlgors
+ * Method:    putMats
+ * Signature: (I[Lcn/xtkj/jni/algor/data/MatRef;)[J
+ */
+JNIEXPORT jlongArray JNICALL Java_cn_xtkj_jni_algor_HighwayAlgors_putMats
+  (JNIEnv *env, jobject, jint instanceId, jobjectArray matRefs) {
+    
+    if (!matRefs) {
+        std::cerr << "❌ MatRef数组参数为null" << std::endl;
+        return nullptr;
+    }
+    
+    // 先获取所有图像数据，避免在持锁时进行JNI操作
+    jsize count = env->GetArrayLength(matRefs);
+    std::vector<cv::Mat> images;
+    std::vector<YuvImage> yuv_images;
+    std::vector<FrameSource> sources;
+    images.reserve(count);
+    sources.reserve(count);
+    for (jsize i = 0; i < count; ++i) {
+        jobject matRef = env->GetObjectArrayElement(matRefs, i);
+        MatRefFrame image = matRef ? get_frame_from_matref(env, matRef) : MatRefFrame();
+        if (matRef) {
+            env->DeleteLocalRef(matRef);
+        }
+        if (image.empty()) {
+            std::cerr << "❌ 获取图像数据失败，索引: " << i << std::endl;
+            return nullptr;
+        }
+        if (image.is_yuv()) {
+            yuv_images.push_back(image.yuv);
+        } else {
+            images.push_back(image.bgr);
+        }
+        sources.push_back(image.source);
+    }
+    if (!images.empty() && !yuv_images.empty()) {
+        std::cerr << "❌ 同一批图像的像素格式需一致" << std::endl;
+        return nullptr;
+    }
+    
+    std::vector<int64_t> frame_ids;
+    {
+        std::lock_guard<std::mutex> lock(g_instance_mutex);
+        
+        try {
+            // 查找检测器实例
+            auto it = g_detectors.find(instanceId);
+            if (it == g_detectors.end()) {
+                std::cerr << "❌ 找不到实例 " << instanceId << std::endl;
+                return nullptr;
+            }
+            
+            auto& detector = it->second;
+            if (!detector) {
+                std::cerr << "❌ 检测器实例 " << instanceId << " 为空" << std::endl;
+                return nullptr;
+            }
+            
+            // 整组提交（内部拷贝图像），繁忙时未接纳的帧ID为-1
+            AddFrameStatus status = yuv_images.empty()
+                                        ? detector->add_frames(images, frame_ids, HighwayEventDetector::USE_CONFIG_TIMEOUT,
+                                                               sources.data())
+                                        : detector->add_frames(yuv_images.data(), yuv_images.size(), frame_ids,
+                                                               HighwayEventDetector::USE_CONFIG_TIMEOUT, sources.data());
+            if (status == AddFrameStatus::BUSY) {
+                std::cerr << "⚠️ 流水线繁忙，部分图像未被接纳" << std::endl;
+            } else if (status != AddFrameStatus::OK) {
+                std::cerr << "❌ 批量添加图像失败，状态: " << static_cast<int>(status) << std::endl;
+                return nullptr;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "❌ 批量添加图像时发生异常: " << e.what() << std::endl;
+            return nullptr;
+        }
+    }
+    
+    jlongArray result = env->NewLongArray(count);
+    if (result) {
+        std::vector<jlong> ids(frame_ids.begin(), frame_ids.end());
+        env->SetLongArrayRegion(result, 0, count, ids.data());
+    }
+    return result;
+}
+
 /*
  * Class:     cn_xtkj_jni_algor_HighwayAlgors
  * Method:    takeRes
@@ -548,7 +721,8 @@ JNIEXPORT jobjectArray JNICALL Java_cn_xtkj_jni_algor_HighwayAlgors_takeRes
         }
         
         // 获取处理结果
-        auto result = detector->get_result(static_cast<uint64_t>(frameId));
+        // 使用结果视图直接读取流水线帧数据，避免中间拷贝
+        ResultView result = detector->get_result_view(static_cast<uint64_t>(frameId));
         // cv::Mat image = result.srcImage;
         // for(auto & box : result.detections) {
         //     // 确保每个检测框的track_id唯一
@@ -560,14 +734,11 @@ JNIEXPORT jobjectArray JNICALL Java_cn_xtkj_jni_algor_HighwayAlgors_takeRes
         // int image_id = static_cast<int>(frameId);
         // cv::imwrite("output_" + std::to_string(image_id) + ".jpg", image);
         
-        if (result.status != ResultStatus::SUCCESS) {
-            std::cerr << "❌ 获取帧 " << frameId << " 结果失败，状态: " << static_cast<int>(result.status) << std::endl;
+        if (result.status() != ResultStatus::SUCCESS) {
+            std::cerr << "❌ 获取帧 " << frameId << " 结果失败，状态: " << static_cast<int>(result.status()) << std::endl;
             return nullptr;
         }
         
-        // 使用ProcessResult中的detections
-        const auto& boxes = result.detections;
-        
         // 创建Java数组
         jclass coorClass = env->FindClass("cn/xtkj/jni/algor/helper/EventYoloCoor");
         if (!coorClass) {
@@ -575,7 +746,7 @@ JNIEXPORT jobjectArray JNICALL Java_cn_xtkj_jni_algor_HighwayAlgors_takeRes
             return nullptr;
         }
         
-        jobjectArray resultArray = env->NewObjectArray(boxes.size(), coorClass, nullptr);
+        jobjectArray resultArray = env->NewObjectArray(result.box_count(), coorClass, nullptr);
         
         if (!resultArray) {
             std::cerr << "❌ 创建结果数组失败" << std::endl;
@@ -584,8 +755,8 @@ JNIEXPORT jobjectArray JNICALL Java_cn_xtkj_jni_algor_HighwayAlgors_takeRes
         }
         
         // 填充结果数组
-        for (size_t i = 0; i < boxes.size(); i++) {
-            jobject coorObj = create_event_yolo_coor(env, boxes[i]);
+        for (size_t i = 0; i < result.box_count(); i++) {
+            jobject coorObj = create_event_yolo_coor(env, result.box(i));
             if (coorObj) {
                 env->SetObjectArrayElement(resultArray, i, coorObj);
                 if (check_and_clear_exception(env, "takeRes - SetObjectArrayElement")) {
@@ -609,6 +780,124 @@ JNIEXPORT jobjectArray JNICALL Java_cn_xtkj_jni_algor_HighwayAlgors_takeRes
     }
 }
 
+// 辅助函数：创建EventYoloCoor数组，changes非空时写入每个目标的变化类型
+static jobjectArray create_event_yolo_coor_array(JNIEnv* env, const std::vector<DetectionBox>& boxes,
+                                                 const std::vector<uint8_t>* changes) {
+    jclass coorClass = env->FindClass("cn/xtkj/jni/algor/helper/EventYoloCoor");
+    if (!coorClass) {
+        std::cerr << "❌ 找不到EventYoloCoor类" << std::endl;
+        return nullptr;
+    }
+    jfieldID changeFlagsField = changes ? env->GetFieldID(coorClass, "changeFlags", "I") : nullptr;
+    if (check_and_clear_exception(env, "create_event_yolo_coor_array - GetFieldID")) {
+        changeFlagsField = nullptr;
+    }
+    
+    jobjectArray resultArray = env->NewObjectArray(boxes.size(), coorClass, nullptr);
+    if (!resultArray) {
+        std::cerr << "❌ 创建结果数组失败" << std::endl;
+        env->DeleteLocalRef(coorClass);
+        return nullptr;
+    }
+    
+    for (size_t i = 0; i < boxes.size(); i++) {
+        jobject coorObj = create_event_yolo_coor(env, boxes[i]);
+        if (!coorObj) {
+            std::cerr << "⚠️ 创建EventYoloCoor对象失败，索引: " << i << std::endl;
+            continue;
+        }
+        if (changeFlagsField) {
+            env->SetIntField(coorObj, changeFlagsField, static_cast<jint>((*changes)[i]));
+        }
+        env->SetObjectArrayElement(resultArray, i, coorObj);
+        env->DeleteLocalRef(coorObj);
+        if (check_and_clear_exception(env, "create_event_yolo_coor_array - SetObjectArrayElement")) {
+            env->DeleteLocalRef(resultArray);
+            env->DeleteLocalRef(coorClass);
+            return nullptr;
+        }
+    }
+    
+    env->DeleteLocalRef(coorClass);
+    return resultArray;
+}
+
+/*
+ * Class:     cn_xtkj_jni_algor_HighwayAlgors
+ * Method:    takeResDelta
+ * Signature: (IJ)Lcn/xtkj/jni/algor/helper/EventYoloDelta;
+ */
+JNIEXPORT jobject JNICALL Java_cn_xtkj_jni_algor_HighwayAlgors_takeResDelta
+  (JNIEnv *env, jobject, jint instanceId, jlong frameId) {
+    
+    std::lock_guard<std::mutex> lock(g_instance_mutex);
+    
+    try {
+        auto it = g_detectors.find(instanceId);
+        if (it == g_detectors.end() || !it->second) {
+            std::cerr << "❌ 找不到实例 " << instanceId << std::endl;
+            return nullptr;
+        }
+        
+        ResultView result = it->second->get_result_view(static_cast<uint64_t>(frameId));
+        if (result.status() != ResultStatus::SUCCESS) {
+            std::cerr << "❌ 获取帧 " << frameId << " 结果失败，状态: " << static_cast<int>(result.status()) << std::endl;
+            return nullptr;
+        }
+        
+        // 未启用增量输出时每帧都按关键帧返回完整目标集合
+        const ResultDelta* delta = result.delta();
+        bool keyframe = !delta || delta->keyframe;
+        std::vector<DetectionBox> boxes;
+        std::vector<uint8_t> changes;
+        if (keyframe) {
+            boxes.assign(result.begin(), result.end());
+        } else {
+            boxes.reserve(delta->changes.size());
+            changes.reserve(delta->changes.size());
+            for (const auto& change : delta->changes) {
+                boxes.push_back(change.box);
+                changes.push_back(change.flags);
+            }
+        }
+        
+        jobjectArray coors = create_event_yolo_coor_array(env, boxes, keyframe ? nullptr : &changes);
+        if (!coors) {
+            return nullptr;
+        }
+        
+        jclass deltaClass = env->FindClass("cn/xtkj/jni/algor/helper/EventYoloDelta");
+        if (!deltaClass) {
+            std::cerr << "❌ 找不到EventYoloDelta类" << std::endl;
+            env->DeleteLocalRef(coors);
+            return nullptr;
+        }
+        jmethodID constructor = env->GetMethodID(deltaClass, "<init>", "()V");
+        jfieldID keyframeField = env->GetFieldID(deltaClass, "keyframe", "Z");
+        jfieldID baseField = env->GetFieldID(deltaClass, "baseMatId", "J");
+        jfieldID coorsField = env->GetFieldID(deltaClass, "coors", "[Lcn/xtkj/jni/algor/helper/EventYoloCoor;");
+        if (check_and_clear_exception(env, "takeResDelta - GetFieldID") || !constructor) {
+            env->DeleteLocalRef(coors);
+            env->DeleteLocalRef(deltaClass);
+            return nullptr;
+        }
+        
+        jobject deltaObj = env->NewObject(deltaClass, constructor);
+        if (deltaObj) {
+            env->SetBooleanField(deltaObj, keyframeField, keyframe ? JNI_TRUE : JNI_FALSE);
+            env->SetLongField(deltaObj, baseField, keyframe ? -1 : static_cast<jlong>(delta->base_frame_id));
+            env->SetObjectField(deltaObj, coorsField, coors);
+        }
+        env->DeleteLocalRef(coors);
+        env->DeleteLocalRef(deltaClass);
+        return deltaObj;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "❌ 获取增量结果时发生异常: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
 /*
  * Class:     cn_xtkj_jni_algor_HighwayAlgors
  * Method:    releaseInstanceCollection
@@ -0,0 +1,428 @@
+#include "pipeline_simulator.h"
+#include "batch_data.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * 流水线容量规划工具
+ *
+ * 读取 HighwayEventDetector::save_service_profile() 保存的服务时间画像，
+ * 仿真给定路数下的吞吐、延迟分位数和帧数据内存，或搜索最多可接入的路数。
+ *
+ * 用法：
+ *   PipelineSimulator <profile.csv> [选项]
+ *     --streams N          视频流数量（默认1）
+ *     --fps F              每路帧率（默认25）
+ *     --duration S         仿真时长秒数（默认120）
+ *     --warmup S           预热秒数（默认20）
+ *     --timeout-ms N       提交背压等待时间，<0 一直等待（默认-1）
+ *     --frame-mb M         单帧在流水线中占用的内存MB（默认按1080p原图+派生数据估算）
+ *     --threads key=N      覆盖某阶段线程数，如 --threads detection_threads=8
+ *     --max-streams N      搜索满足吞吐、无丢帧的最大路数（上限N）
+ *     --latency-budget MS  搜索时的 p99 延迟上限
+ *     --validate           用替身模型（按样本睡眠的阶段线程）搭建真实的 BatchBuffer/BatchConnector
+ *                          流水线，以相同路数实际运行 --duration 秒并与仿真结果对比
+ *     --stand-in key=A:B   不读取画像，按 A + B*批次大小 毫秒（±20%抖动）生成该阶段的替身样本，
+ *                          阶段和线程数取默认 PipelineConfig
+ */
+static void print_usage(const char* program) {
+    std::cout << "用法: " << program << " <profile.csv> [--streams N] [--fps F] [--duration S] [--warmup S]"
+              << " [--timeout-ms N] [--frame-mb M] [--threads key=N] [--max-streams N] [--latency-budget MS]"
+              << " [--validate] [--stand-in key=A:B]" << std::endl;
+}
+
+namespace {
+
+bool split_assignment(const std::string& arg, std::string& key, std::string& value) {
+    size_t pos = arg.find('=');
+    if (pos == std::string::npos || pos == 0) {
+        return false;
+    }
+    key = arg.substr(0, pos);
+    value = arg.substr(pos + 1);
+    return true;
+}
+
+// 按 A + B*n 毫秒生成替身服务时间样本，覆盖 1..batch_size 的所有批次大小
+std::vector<ServiceSample> make_stand_in_samples(double base_ms, double per_image_ms, size_t batch_size) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> jitter(0.8, 1.2);
+    std::vector<ServiceSample> samples;
+    for (size_t n = 1; n <= batch_size; ++n) {
+        for (int i = 0; i < 32; ++i) {
+            ServiceSample sample;
+            sample.batch_size = static_cast<uint32_t>(n);
+            sample.wall_ns = static_cast<uint64_t>((base_ms + per_image_ms * n) * jitter(rng) * 1e6);
+            samples.push_back(sample);
+        }
+    }
+    return samples;
+}
+
+/**
+ * 替身流水线：真实的 BatchBuffer、BatchConnector 和阶段线程，
+ * 阶段处理用按服务时间样本睡眠代替模型推理
+ */
+class StandInPipeline {
+public:
+    StandInPipeline(const ServiceProfile& profile, const SimulationOptions& options)
+        : profile_(profile), options_(options) {
+        for (const auto& stage : profile.topology.stages) {
+            auto it = profile.samples.find(stage.config_key);
+            distributions_.push_back(ServiceDistribution::fit(it != profile.samples.end()
+                                                              ? it->second : std::vector<ServiceSample>()));
+        }
+    }
+
+    SimulationResult run() {
+        const PipelineTopology& topology = profile_.topology;
+        BatchBuffer buffer(std::chrono::milliseconds(topology.flush_timeout_ms), topology.max_ready_batches);
+        std::vector<std::unique_ptr<BatchConnector>> connectors;
+        for (size_t i = 1; i < topology.stages.size(); ++i) {
+            connectors.push_back(std::make_unique<BatchConnector>(topology.stages[i].input_capacity));
+            if (topology.stages[i].batch_size > 0) {
+                connectors.back()->set_rebatch(topology.stages[i].batch_size,
+                                               std::chrono::milliseconds(std::max(1, topology.rebatch_flush_ms)));
+            }
+        }
+        BatchConnector results(topology.result_capacity);
+
+        size_t max_frames = static_cast<size_t>(options_.streams * options_.fps_per_stream *
+                                                (options_.duration_s + 1.0)) + 1;
+        capture_ms_.assign(max_frames, 0.0);
+        start_ = std::chrono::steady_clock::now();
+
+        buffer.start();
+        for (auto& connector : connectors) {
+            connector->start();
+        }
+        results.start();
+
+        std::atomic<bool> running{true};
+        std::vector<std::thread> threads;
+
+        // 阶段线程：concurrency() 个协调者各自逐批次 取批次 -> 睡眠服务时间 -> 送往下游
+        for (size_t i = 0; i < topology.stages.size(); ++i) {
+            BatchConnector* input = i == 0 ? nullptr : connectors[i - 1].get();
+            BatchConnector* output = i + 1 < topology.stages.size() ? connectors[i].get() : &results;
+            for (int k = 0; k < topology.stages[i].concurrency(); ++k) {
+                uint32_t seed = options_.seed + static_cast<uint32_t>(i * 131 + k);
+                threads.emplace_back([this, i, input, output, seed, &buffer, &running]() {
+                    std::mt19937 rng(seed);
+                    while (running.load()) {
+                        BatchPtr batch;
+                        bool got = input ? input->receive_batch(batch) : buffer.get_ready_batch(batch);
+                        if (!got || !batch) {
+                            continue;
+                        }
+                        double service_ms = distributions_[i].draw(batch->actual_size, rng);
+                        std::this_thread::sleep_for(std::chrono::microseconds(
+                            static_cast<int64_t>(service_ms * 1000.0)));
+                        output->send_batch(batch);
+                    }
+                });
+            }
+        }
+
+        // 结果收集：按帧序号回查采集时刻
+        std::thread collector([this, &results, &running]() {
+            while (running.load()) {
+                BatchPtr batch;
+                if (!results.receive_batch(batch) || !batch) {
+                    continue;
+                }
+                double now = elapsed_ms();
+                for (size_t j = 0; j < batch->actual_size; ++j) {
+                    on_complete(batch->images[j]->frame_idx, now);
+                }
+            }
+        });
+
+        // 在途帧数采样
+        std::thread sampler([this, &running]() {
+            while (running.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                double now = elapsed_ms();
+                if (now >= options_.warmup_s * 1000.0) {
+                    size_t in_flight = in_flight_.load();
+                    in_flight_sum_ += in_flight;
+                    in_flight_samples_++;
+                    peak_in_flight_ = std::max(peak_in_flight_, in_flight);
+                }
+            }
+        });
+
+        // 每路一个提交线程，按固定帧率产生帧；提交阻塞期间错过的帧记为采集端丢弃
+        std::vector<std::thread> producers;
+        std::mt19937 phase_rng(options_.seed);
+        std::uniform_real_distribution<double> phase(0.0, 1000.0 / options_.fps_per_stream);
+        for (int s = 0; s < options_.streams; ++s) {
+            double offset = phase(phase_rng);
+            producers.emplace_back([this, s, offset, &buffer]() { produce(s, offset, buffer); });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+
+        // 等待在途帧排空后停止
+        auto drain_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (in_flight_.load() > 0 && std::chrono::steady_clock::now() < drain_deadline) {
+            buffer.flush_current_batch();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        running.store(false);
+        buffer.stop();
+        for (auto& connector : connectors) {
+            connector->stop();
+        }
+        results.stop();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        collector.join();
+        sampler.join();
+
+        return build_result();
+    }
+
+private:
+    const ServiceProfile& profile_;
+    SimulationOptions options_;
+    std::vector<ServiceDistribution> distributions_;
+    std::chrono::steady_clock::time_point start_;
+
+    std::atomic<uint64_t> next_frame_{0};
+    std::vector<double> capture_ms_;
+    std::atomic<size_t> in_flight_{0};
+    std::atomic<uint64_t> offered_{0};
+    std::atomic<uint64_t> overrun_{0};
+    std::atomic<uint64_t> rejected_{0};
+    double in_flight_sum_ = 0.0;
+    uint64_t in_flight_samples_ = 0;
+    size_t peak_in_flight_ = 0;
+
+    std::mutex latency_mutex_;
+    std::vector<double> latencies_;
+    uint64_t completed_in_window_ = 0;
+
+    double elapsed_ms() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    void produce(int stream, double offset_ms, BatchBuffer& buffer) {
+        double interval_ms = 1000.0 / options_.fps_per_stream;
+        double end_ms = options_.duration_s * 1000.0;
+        for (double due = offset_ms; due <= end_ms; due += interval_ms) {
+            double now = elapsed_ms();
+            if (now < due) {
+                std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>((due - now) * 1000.0)));
+            } else if (now - due >= interval_ms) {
+                // 上一帧提交阻塞超过一个帧间隔，这一帧在采集端已被覆盖
+                offered_++;
+                overrun_++;
+                continue;
+            }
+            offered_++;
+            uint64_t index = next_frame_.fetch_add(1);
+            if (index >= capture_ms_.size()) {
+                break;
+            }
+            auto image = std::make_shared<ImageData>();
+            image->frame_idx = index;
+            image->stream_id = stream;
+            capture_ms_[index] = due;
+            in_flight_++;
+            if (!buffer.add_image_with_timeout(image, options_.add_timeout_ms)) {
+                in_flight_--;
+                rejected_++;
+            }
+        }
+    }
+
+    void on_complete(uint64_t frame_idx, double now) {
+        in_flight_--;
+        double warmup_ms = options_.warmup_s * 1000.0;
+        if (now < warmup_ms || now > options_.duration_s * 1000.0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(latency_mutex_);
+        completed_in_window_++;
+        if (capture_ms_[frame_idx] >= warmup_ms) {
+            latencies_.push_back(now - capture_ms_[frame_idx]);
+        }
+    }
+
+    SimulationResult build_result() {
+        SimulationResult r;
+        r.valid = true;
+        r.streams = options_.streams;
+        r.offered_fps = options_.streams * options_.fps_per_stream;
+        double window_s = options_.duration_s - options_.warmup_s;
+        r.throughput_fps = completed_in_window_ / window_s;
+        r.frames_offered = offered_.load();
+        r.frames_completed = completed_in_window_;
+        r.frames_overrun = overrun_.load();
+        r.frames_rejected = rejected_.load();
+        if (in_flight_samples_ > 0) {
+            r.mean_frames_in_flight = in_flight_sum_ / in_flight_samples_;
+        }
+        r.peak_frames_in_flight = peak_in_flight_;
+        r.mean_memory_mb = r.mean_frames_in_flight * options_.frame_bytes / (1024.0 * 1024.0);
+        r.peak_memory_mb = r.peak_frames_in_flight * options_.frame_bytes / (1024.0 * 1024.0);
+
+        std::sort(latencies_.begin(), latencies_.end());
+        auto pct = [this](double p) {
+            if (latencies_.empty()) {
+                return 0.0;
+            }
+            size_t rank = static_cast<size_t>(std::ceil(p * latencies_.size()));
+            return latencies_[std::min(latencies_.size(), std::max<size_t>(1, rank)) - 1];
+        };
+        r.latency_p50_ms = pct(0.50);
+        r.latency_p95_ms = pct(0.95);
+        r.latency_p99_ms = pct(0.99);
+        r.latency_max_ms = latencies_.empty() ? 0.0 : latencies_.back();
+        return r;
+    }
+};
+
+double relative_error(double predicted, double measured) {
+    if (measured == 0.0) {
+        return predicted == 0.0 ? 0.0 : 1.0;
+    }
+    return std::fabs(predicted - measured) / measured;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string path;
+    SimulationOptions options;
+    int max_streams = 0;
+    double latency_budget_ms = 0.0;
+    bool validate = false;
+    std::vector<std::pair<std::string, int>> thread_overrides;
+    std::vector<std::pair<std::string, std::pair<double, double>>> stand_ins;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string key, value;
+        if (std::strcmp(argv[i], "--streams") == 0 && i + 1 < argc) {
+            options.streams = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            options.fps_per_stream = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            options.duration_s = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            options.warmup_s = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--timeout-ms") == 0 && i + 1 < argc) {
+            options.add_timeout_ms = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--frame-mb") == 0 && i + 1 < argc) {
+            options.frame_bytes = std::atof(argv[++i]) * 1024.0 * 1024.0;
+        } else if (std::strcmp(argv[i], "--max-streams") == 0 && i + 1 < argc) {
+            max_streams = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--latency-budget") == 0 && i + 1 < argc) {
+            latency_budget_ms = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--validate") == 0) {
+            validate = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc && split_assignment(argv[++i], key, value)) {
+            thread_overrides.emplace_back(key, std::atoi(value.c_str()));
+        } else if (std::strcmp(argv[i], "--stand-in") == 0 && i + 1 < argc && split_assignment(argv[++i], key, value)) {
+            size_t colon = value.find(':');
+            double base = std::atof(value.substr(0, colon).c_str());
+            double per_image = colon == std::string::npos ? 0.0 : std::atof(value.substr(colon + 1).c_str());
+            stand_ins.emplace_back(key, std::make_pair(base, per_image));
+        } else if (argv[i][0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    ServiceProfile profile;
+    if (!path.empty()) {
+        if (!ServiceProfile::load(path, profile)) {
+            std::cerr << "❌ 无法读取服务时间画像: " << path << std::endl;
+            return 1;
+        }
+    } else if (!stand_ins.empty()) {
+        profile.topology = PipelineTopology::from_config(PipelineConfig());
+    } else {
+        print_usage(argv[0]);
+        return 1;
+    }
+    for (const auto& stand_in : stand_ins) {
+        const StageTopology* stage = profile.topology.find(stand_in.first);
+        if (!stage) {
+            std::cerr << "❌ 未知阶段: " << stand_in.first << std::endl;
+            return 1;
+        }
+        profile.samples[stage->config_key] = make_stand_in_samples(stand_in.second.first, stand_in.second.second,
+                                                                   profile.topology.batch_size);
+    }
+    for (const auto& override_entry : thread_overrides) {
+        StageTopology* stage = profile.topology.find(override_entry.first);
+        if (!stage) {
+            std::cerr << "❌ 未知阶段: " << override_entry.first << std::endl;
+            return 1;
+        }
+        stage->threads = std::max(1, override_entry.second);
+    }
+
+    std::cout << "🧭 流水线拓扑:\n" << profile.topology.to_string();
+    PipelineSimulator simulator(profile);
+
+    if (max_streams > 0) {
+        SimulationResult best;
+        int streams = simulator.find_max_streams(options, latency_budget_ms, max_streams, &best);
+        std::cout << "\n🔎 最多可接入 " << streams << " 路（上限 " << max_streams << "）";
+        if (latency_budget_ms > 0.0) {
+            std::cout << "，p99 延迟预算 " << latency_budget_ms << " ms";
+        }
+        std::cout << "\n" << best.to_string();
+        return streams > 0 ? 0 : 2;
+    }
+
+    SimulationResult predicted = simulator.run(options);
+    std::cout << "\n" << predicted.to_string();
+    if (!predicted.valid) {
+        return 1;
+    }
+    if (!validate) {
+        return 0;
+    }
+
+    std::cout << "\n🏃 替身模型实测 " << options.duration_s << " 秒..." << std::endl;
+    StandInPipeline stand_in(profile, options);
+    SimulationResult measured = stand_in.run();
+    std::cout << measured.to_string();
+
+    // 吞吐误差10%、延迟分位数误差25%以内视为仿真有效
+    const std::pair<const char*, std::pair<double, double>> metrics[] = {
+        {"吞吐", {predicted.throughput_fps, measured.throughput_fps}},
+        {"p50 延迟", {predicted.latency_p50_ms, measured.latency_p50_ms}},
+        {"p95 延迟", {predicted.latency_p95_ms, measured.latency_p95_ms}},
+        {"p99 延迟", {predicted.latency_p99_ms, measured.latency_p99_ms}},
+        {"平均在途帧", {predicted.mean_frames_in_flight, measured.mean_frames_in_flight}},
+    };
+    bool passed = true;
+    std::cout << "\n📏 仿真 vs 实测:" << std::fixed << std::setprecision(2) << std::endl;
+    for (const auto& metric : metrics) {
+        double error = relative_error(metric.second.first, metric.second.second);
+        double tolerance = std::strcmp(metric.first, "吞吐") == 0 ? 0.10 : 0.25;
+        bool ok = error <= tolerance;
+        passed = passed && ok;
+        std::cout << "  " << metric.first << ": 仿真 " << metric.second.first << " / 实测 " << metric.second.second
+                  << "，误差 " << error * 100.0 << "% " << (ok ? "✅" : "❌") << std::endl;
+    }
+    return passed ? 0 : 3;
+}
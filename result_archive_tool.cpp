@@ -0,0 +1,165 @@
+#include "result_archive.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+/**
+ * 结果归档查询与扫描工具
+ *
+ * 用法：
+ *   ResultArchiveTool <archive> [--frame N] [--stream N] [--from MS] [--to MS] [--scan] [--generate N]
+ *     --frame N     打印指定帧序号的记录（配合 --stream，默认流0）
+ *     --from/--to   打印时间范围 [from, to) 内记录的摘要（Unix毫秒）
+ *     --scan        顺序扫描全部记录，统计目标数并报告扫描带宽
+ *     --generate N  向归档追加 N 条合成记录（每条约100个目标），报告写入速率，用于基准测试
+ */
+namespace {
+
+void print_usage(const char* program) {
+    std::cout << "用法: " << program
+              << " <archive> [--frame N] [--stream N] [--from MS] [--to MS] [--scan] [--generate N]" << std::endl;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool generate(const std::string& path, uint64_t count) {
+    ResultArchiveWriter writer;
+    if (!writer.open(path)) {
+        return false;
+    }
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> coord(0, 1800);
+    ProcessResult result;
+    result.status = ResultStatus::SUCCESS;
+    result.roi = cv::Rect(0, 0, 1920, 1080);
+    for (int i = 0; i < 100; ++i) {
+        int x = coord(rng), y = coord(rng) / 2;
+        result.detections.emplace_back(x, y, x + 80, y + 60, 0.9f, i % 3, i + 1, ObjectStatus::NORMAL);
+    }
+
+    uint64_t now_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < count; ++i) {
+        result.frame_id = i;
+        result_record::RecordMeta meta;
+        meta.source_frame_id = i;
+        meta.timestamp_ms = now_ms + i * 40;   // 25fps
+        if (!writer.append(result, meta)) {
+            std::cerr << "❌ 追加记录失败" << std::endl;
+            return false;
+        }
+    }
+    writer.close();
+    double elapsed = seconds_since(start);
+    std::cout << "写入 " << count << " 条记录, " << std::fixed << std::setprecision(2) << elapsed << " s, "
+              << std::setprecision(0) << count / std::max(elapsed, 1e-9) << " 条/s, fsync " << writer.get_fsync_count()
+              << " 次" << std::endl;
+    return true;
+}
+
+void print_record(const ResultArchiveReader& reader, size_t i) {
+    result_record::DecodedRecord record;
+    if (!reader.decode(i, record)) {
+        std::cout << "  [" << i << "] 解码失败" << std::endl;
+        return;
+    }
+    const ProcessResult& result = record.result;
+    std::cout << "  [" << i << "] 帧 " << result.frame_id << " 流 " << record.meta.stream_id << " 时间 "
+              << record.meta.timestamp_ms << " ROI " << result.roi << " 目标 " << result.detections.size()
+              << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string path;
+    long long frame = -1;
+    int stream = 0;
+    uint64_t from_ms = 0, to_ms = 0;
+    bool scan = false;
+    uint64_t generate_count = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--frame") == 0 && i + 1 < argc) {
+            frame = std::atoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+            stream = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+            from_ms = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--to") == 0 && i + 1 < argc) {
+            to_ms = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--scan") == 0) {
+            scan = true;
+        } else if (std::strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+            generate_count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argv[i][0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    if (generate_count > 0 && !generate(path, generate_count)) {
+        std::cerr << "❌ 无法写入归档: " << path << std::endl;
+        return 1;
+    }
+
+    ResultArchiveReader reader;
+    if (path.empty() || !reader.open(path)) {
+        std::cerr << "❌ 无法打开归档: " << path << std::endl;
+        return 1;
+    }
+    std::cout << "📦 " << path << ": " << reader.size() << " 条记录";
+    if (reader.size() > 0) {
+        std::cout << ", 时间 " << reader.entry(0).timestamp_ms << " ~ " << reader.entry(reader.size() - 1).timestamp_ms;
+    }
+    std::cout << std::endl;
+
+    if (frame >= 0) {
+        size_t i = reader.find_frame(static_cast<uint64_t>(frame), stream);
+        if (i == reader.size()) {
+            std::cout << "未找到帧 " << frame << "（流 " << stream << "）" << std::endl;
+        } else {
+            print_record(reader, i);
+        }
+    }
+
+    if (to_ms > from_ms) {
+        std::vector<size_t> hits = reader.time_range(from_ms, to_ms);
+        std::cout << "时间范围内 " << hits.size() << " 条记录" << std::endl;
+        for (size_t k = 0; k < hits.size() && k < 20; ++k) {
+            print_record(reader, hits[k]);
+        }
+    }
+
+    if (scan) {
+        // 零拷贝扫描：只读取记录头和目标框，不解码为 ProcessResult
+        auto start = std::chrono::steady_clock::now();
+        uint64_t boxes = 0, still = 0, bytes = 0;
+        for (size_t i = 0; i < reader.size(); ++i) {
+            ResultArchiveReader::RecordRef ref = reader.record(i);
+            boxes += ref.header->box_count;
+            for (uint16_t b = 0; b < ref.header->box_count; ++b) {
+                still += ref.boxes[b].is_still;
+            }
+            bytes += ref.header->record_bytes;
+        }
+        double elapsed = seconds_since(start);
+        std::cout << "扫描 " << reader.size() << " 条记录, 目标 " << boxes << " (静止 " << still << "), "
+                  << std::fixed << std::setprecision(1) << bytes / 1048576.0 << " MB, "
+                  << bytes / 1048576.0 / std::max(elapsed, 1e-9) << " MB/s" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,297 @@
+#include "shm_transport.h"
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * 共享内存帧环/结果环测试（多进程生产者 + 单消费者）
+ *
+ * 生产者用 fork 出的子进程模拟，验证：
+ *   - 生产者占用槽位后、提交前崩溃：消费者在心跳超时前等待，超时后回收槽位，后续帧正常送达
+ *   - 存活的生产者占用槽位超过心跳超时仍不会被回收（心跳持续递增）
+ *   - 多个生产者并发写入：各生产者的帧按写入顺序送达，不丢帧，内容完整，零拷贝帧释放后槽位归还
+ *   - 结果环写满后丢弃并计数，已写入的记录按顺序读出；跨越环尾（填充标记）后内容正确；
+ *     超过半个环的记录直接拒绝
+ * 全部通过时返回0，否则返回失败的检查数。
+ *
+ * 用法：
+ *   ShmTransportTest
+ */
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        ++g_failures;
+        std::cerr << "❌ " << what << std::endl;
+    }
+}
+
+constexpr int kOwnerTimeoutMs = 300;
+constexpr int kWidth = 64;
+constexpr int kHeight = 32;
+
+std::string ring_name(const std::string& suffix) {
+    return "/shm_transport_test_" + std::to_string(getpid()) + "_" + suffix;
+}
+
+// 帧内容由生产者编号和序号决定，消费者据此校验
+cv::Mat make_frame(int producer, uint32_t seq) {
+    cv::Mat frame(kHeight, kWidth, CV_8UC1);
+    for (int y = 0; y < kHeight; ++y) {
+        uchar* row = frame.ptr<uchar>(y);
+        for (int x = 0; x < kWidth; ++x) {
+            row[x] = static_cast<uchar>(producer * 31 + seq * 7 + y + x);
+        }
+    }
+    return frame;
+}
+
+bool frame_matches(const cv::Mat& frame, int producer, uint32_t seq) {
+    if (frame.rows != kHeight || frame.cols != kWidth) {
+        return false;
+    }
+    for (int y = 0; y < kHeight; ++y) {
+        const uchar* row = frame.ptr<uchar>(y);
+        for (int x = 0; x < kWidth; ++x) {
+            if (row[x] != static_cast<uchar>(producer * 31 + seq * 7 + y + x)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 子进程中运行 body，返回值作为退出码；父进程返回子进程pid
+template <typename Body>
+pid_t spawn(Body body) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        _exit(body());
+    }
+    return pid;
+}
+
+int wait_exit_code(pid_t pid) {
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+        return -1;
+    }
+    return WEXITSTATUS(status);
+}
+
+void test_producer_crash_mid_claim() {
+    ShmFrameRing ring;
+    std::string name = ring_name("crash");
+    check(ring.create(name, 4, kWidth * kHeight), "创建帧环失败");
+    ring.set_owner_timeout_ms(kOwnerTimeoutMs);
+
+    // 占用槽位并写入一半数据后直接退出：不提交、不注销
+    pid_t crashed = spawn([&]() {
+        ShmFrameRing producer;
+        ShmFrameRing::SlotHandle handle;
+        if (!producer.open(name) || !producer.acquire_write_slot(handle, 1000)) {
+            return 1;
+        }
+        std::memset(handle.data, 0xAB, handle.capacity / 2);
+        _exit(0);
+    });
+    check(wait_exit_code(crashed) == 0, "崩溃生产者未能占用槽位");
+    check(ring.get_slots_in_use() == 1, "崩溃生产者应占用1个槽位");
+
+    // 心跳超时前消费者等待，不回收
+    cv::Mat image;
+    ShmFrameMeta meta;
+    check(!ring.read_frame(image, meta, kOwnerTimeoutMs / 3), "未提交的槽位不应被读出");
+    check(ring.get_slots_recovered() == 0, "心跳超时前不应回收槽位");
+
+    // 超时后回收，后续生产者的帧正常送达
+    check(!ring.read_frame(image, meta, kOwnerTimeoutMs * 3), "回收的槽位不应作为帧读出");
+    check(ring.get_slots_recovered() == 1, "心跳超时后应回收崩溃生产者的槽位");
+    check(ring.get_slots_in_use() == 0, "回收后槽位应空闲");
+
+    pid_t next = spawn([&]() {
+        ShmFrameRing producer;
+        return producer.open(name) && producer.write_frame(make_frame(1, 7), 7, 0, 1, 1000) ? 0 : 1;
+    });
+    check(wait_exit_code(next) == 0, "回收后生产者写入失败");
+    check(ring.read_frame(image, meta, 1000), "回收后应能读出后续帧");
+    check(meta.source_frame_id == 7 && meta.stream_id == 1, "回收后读出的帧元数据错误");
+    check(frame_matches(image, 1, 7), "回收后读出的帧内容错误");
+    image.release();
+    check(ring.get_slots_in_use() == 0, "零拷贝帧释放后槽位应归还");
+}
+
+void test_live_producer_not_reclaimed() {
+    ShmFrameRing ring;
+    std::string name = ring_name("live");
+    check(ring.create(name, 4, kWidth * kHeight), "创建帧环失败");
+    ring.set_owner_timeout_ms(kOwnerTimeoutMs);
+
+    // 占用槽位后停留超过心跳超时再提交，心跳线程期间持续递增
+    pid_t slow = spawn([&]() {
+        ShmFrameRing producer;
+        ShmFrameRing::SlotHandle handle;
+        if (!producer.open(name) || !producer.acquire_write_slot(handle, 1000)) {
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(kOwnerTimeoutMs * 3));
+        cv::Mat frame = make_frame(2, 3);
+        std::memcpy(handle.data, frame.data, kWidth * kHeight);
+        ShmFrameMeta meta;
+        meta.source_frame_id = 3;
+        meta.stream_id = 2;
+        meta.width = kWidth;
+        meta.height = kHeight;
+        meta.type = CV_8UC1;
+        meta.step = kWidth;
+        meta.data_bytes = kWidth * kHeight;
+        return producer.commit_write_slot(handle, meta) ? 0 : 2;
+    });
+
+    cv::Mat image;
+    ShmFrameMeta meta;
+    bool received = ring.read_frame(image, meta, kOwnerTimeoutMs * 10);
+    check(wait_exit_code(slow) == 0, "存活生产者的提交被拒绝（槽位被误回收）");
+    check(received && meta.source_frame_id == 3 && frame_matches(image, 2, 3), "存活生产者的帧未完整送达");
+    check(ring.get_slots_recovered() == 0, "存活生产者的槽位不应被回收");
+}
+
+void test_ticket_ordering() {
+    constexpr int kProducers = 4;
+    constexpr uint32_t kFramesPerProducer = 300;
+
+    ShmFrameRing ring;
+    std::string name = ring_name("order");
+    check(ring.create(name, 8, kWidth * kHeight), "创建帧环失败");
+
+    std::vector<pid_t> children;
+    for (int p = 0; p < kProducers; ++p) {
+        children.push_back(spawn([&, p]() {
+            ShmFrameRing producer;
+            if (!producer.open(name)) {
+                return 1;
+            }
+            for (uint32_t seq = 0; seq < kFramesPerProducer; ++seq) {
+                if (!producer.write_frame(make_frame(p, seq), seq, 0, p, 5000)) {
+                    return 2;
+                }
+            }
+            return 0;
+        }));
+    }
+
+    // 消费者持有少量帧再释放，模拟流水线中的在途帧
+    std::map<int, uint32_t> next_seq;
+    std::vector<cv::Mat> in_flight;
+    int received = 0;
+    bool ordered = true;
+    bool intact = true;
+    cv::Mat image;
+    ShmFrameMeta meta;
+    while (received < kProducers * static_cast<int>(kFramesPerProducer) && ring.read_frame(image, meta, 5000)) {
+        int producer = meta.stream_id;
+        uint32_t seq = static_cast<uint32_t>(meta.source_frame_id);
+        ordered = ordered && seq == next_seq[producer];
+        intact = intact && frame_matches(image, producer, seq);
+        next_seq[producer] = seq + 1;
+        in_flight.push_back(image);
+        image.release();
+        if (in_flight.size() >= 3) {
+            in_flight.clear();
+        }
+        ++received;
+    }
+    in_flight.clear();
+
+    for (pid_t child : children) {
+        check(wait_exit_code(child) == 0, "生产者写入失败");
+    }
+    check(received == kProducers * static_cast<int>(kFramesPerProducer), "多生产者写入有丢帧");
+    check(ordered, "同一生产者的帧未按写入顺序送达");
+    check(intact, "多生产者写入的帧内容被破坏");
+    check(ring.get_frames_written() == ring.get_frames_read(), "写入与读出帧数不一致");
+    check(ring.get_slots_recovered() == 0, "正常退出的生产者不应触发回收");
+    check(ring.get_slots_in_use() == 0, "全部帧释放后槽位应空闲");
+}
+
+std::vector<uint8_t> make_record(uint32_t seq, uint32_t size) {
+    std::vector<uint8_t> record(size);
+    std::memcpy(record.data(), &seq, sizeof(seq));
+    for (uint32_t i = sizeof(seq); i < size; ++i) {
+        record[i] = static_cast<uint8_t>(seq + i);
+    }
+    return record;
+}
+
+void test_result_ring_overflow() {
+    constexpr uint64_t kCapacity = 4096;
+    ShmResultRing writer;
+    ShmResultRing reader;
+    std::string name = ring_name("results");
+    check(writer.create(name, kCapacity), "创建结果环失败");
+    check(reader.open(name), "打开结果环失败");
+
+    // 写满：超时为0时立即丢弃并计数
+    uint32_t written = 0;
+    while (written < 1000) {
+        std::vector<uint8_t> record = make_record(written, 100);
+        if (!writer.write(record.data(), static_cast<uint32_t>(record.size()), 0)) {
+            break;
+        }
+        ++written;
+    }
+    check(written > 0 && written < 1000, "结果环应在写满后拒绝写入");
+    check(writer.get_records_dropped() == 1, "写满时丢弃的记录应计数");
+
+    std::vector<uint8_t> record;
+    bool in_order = true;
+    for (uint32_t seq = 0; seq < written; ++seq) {
+        in_order = in_order && reader.read(record, 0) && record == make_record(seq, 100);
+    }
+    check(in_order, "写满前的记录未按顺序完整读出");
+    check(!reader.read(record, 0), "读空后不应再有记录");
+
+    // 变长记录多次跨越环尾
+    bool wrapped_ok = true;
+    for (uint32_t seq = 0; seq < 500; ++seq) {
+        uint32_t size = 37 + (seq * 53) % 700;
+        std::vector<uint8_t> expected = make_record(seq, size);
+        wrapped_ok = wrapped_ok && writer.write(expected.data(), size, 0) &&
+                     reader.read(record, 0) && record == expected;
+    }
+    check(wrapped_ok, "跨越环尾的记录内容错误");
+
+    // 超过半个环的记录不等待、直接拒绝
+    std::vector<uint8_t> oversize = make_record(0, kCapacity / 2);
+    auto start = std::chrono::steady_clock::now();
+    check(!writer.write(oversize.data(), static_cast<uint32_t>(oversize.size()), 1000), "超大记录应被拒绝");
+    check(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500), "超大记录不应等待超时");
+    check(writer.get_records_dropped() == 2, "超大记录应计入丢弃数");
+}
+
+} // namespace
+
+int main() {
+    test_producer_crash_mid_claim();
+    test_live_producer_not_reclaimed();
+    test_ticket_ordering();
+    test_result_ring_overflow();
+
+    if (g_failures == 0) {
+        std::cout << "✅ 共享内存传输测试全部通过" << std::endl;
+    } else {
+        std::cout << "❌ 共享内存传输测试失败 " << g_failures << " 项" << std::endl;
+    }
+    return g_failures;
+}
@@ -0,0 +1,916 @@
+#include "highway_event.h"
+#include "memory_monitor.h"
+#include <opencv2/opencv.hpp>
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+/**
+ * 长稳（soak）测试
+ *
+ * 用合成视频流长时间驱动流水线，每路一个检测器实例（与 JNI 的多实例用法一致），
+ * 随机启停视频流并随机调用 change_params，周期性检查：
+ *   - 进程 RSS 增长斜率（滑动窗口线性回归，MB/小时）
+ *   - 堆空闲内存增长斜率（malloc 已向系统申请但未使用的部分，反映碎片化）
+ *   - 有界缓冲区占用：连接器和结果缓存连续多次打满视为异常
+ *     （BatchBuffer 就绪队列是设计上的背压点，打满属正常，不检查）
+ *   - 在途帧数：已提交但未取到结果的帧
+ *   - 每个检查间隔的 p99 延迟相对基线的漂移
+ *   - 取结果超时/失败比例
+ * 任一检查失败即停止并输出报告，退出码 2；到达测试时长且全部通过退出码 0。
+ * 报告给出进程峰值 RSS（VmHWM）。--compare-buffer-release 在两个子进程中分别以
+ * enable_buffer_release 开/关各运行一次（各 --hours 小时），最后并列输出两者的峰值 RSS；
+ * 峰值是进程级的，两种模式不能在同一进程内先后测量。
+ *
+ * 用法：
+ *   SoakTest [选项]
+ *     --hours H               测试时长（默认8）
+ *     --streams N             最多同时运行的视频流（默认4）
+ *     --min-streams N         最少同时运行的视频流（默认1）
+ *     --fps F                 每路帧率（默认25）
+ *     --width W --height H    合成帧尺寸（默认1920x1080）
+ *     --stream-toggle-s S     平均每 S 秒随机启停一路（默认300，0 关闭）
+ *     --change-params-s S     平均每 S 秒对随机一路调用 change_params（默认120，0 关闭）
+ *     --check-interval-s S    检查间隔（默认10）
+ *     --warmup-min M          预热分钟数，此后才开始检查（默认10）
+ *     --baseline-min M        预热后用于建立 p99 基线的分钟数（默认10）
+ *     --slope-window-min M    RSS/堆斜率的回归窗口（默认60）
+ *     --max-rss-slope MB      RSS 增长上限，MB/小时（默认20）
+ *     --max-heap-free-slope MB 堆空闲内存增长上限，MB/小时（默认20）
+ *     --max-in-flight N       每路在途帧上限（默认256）
+ *     --max-saturated-checks N 缓冲区连续打满的检查次数上限（默认6）
+ *     --max-p99-drift R       p99 相对基线的漂移上限（默认0.5，即+50%）
+ *     --drift-checks N        p99 连续超限的检查次数（默认3）
+ *     --max-error-rate R      取结果超时/失败比例上限（默认0.01）
+ *     --buffer-release on|off 帧缓冲区提前释放（默认on）
+ *     --compare-buffer-release 开/关各运行一次并对比峰值 RSS（报告/CSV 文件名加 .release_on/.release_off）
+ *     --seg-model PATH --det-model PATH  模型路径
+ *     --csv PATH              每次检查追加一行指标
+ *     --report PATH           报告同时写入文件
+ */
+static void print_usage(const char* program) {
+    std::cout << "用法: " << program << " [--hours H] [--streams N] [--min-streams N] [--fps F]"
+              << " [--width W] [--height H] [--stream-toggle-s S] [--change-params-s S] [--check-interval-s S]"
+              << " [--warmup-min M] [--baseline-min M] [--slope-window-min M] [--max-rss-slope MB]"
+              << " [--max-heap-free-slope MB] [--max-in-flight N] [--max-saturated-checks N]"
+              << " [--max-p99-drift R] [--drift-checks N] [--max-error-rate R]"
+              << " [--buffer-release on|off] [--compare-buffer-release]"
+              << " [--seg-model PATH] [--det-model PATH] [--csv PATH] [--report PATH]" << std::endl;
+}
+
+namespace {
+
+struct SoakOptions {
+    double hours = 8.0;
+    int max_streams = 4;
+    int min_streams = 1;
+    double fps = 25.0;
+    int width = 1920;
+    int height = 1080;
+    double stream_toggle_s = 300.0;
+    double change_params_s = 120.0;
+    double check_interval_s = 10.0;
+    double warmup_min = 10.0;
+    double baseline_min = 10.0;
+    double slope_window_min = 60.0;
+    double max_rss_slope_mb_per_hour = 20.0;
+    double max_heap_free_slope_mb_per_hour = 20.0;
+    uint64_t max_in_flight_per_stream = 256;
+    int max_saturated_checks = 6;
+    double max_p99_drift = 0.5;
+    int drift_checks = 3;
+    double max_error_rate = 0.01;
+    bool buffer_release = true;
+    bool compare_buffer_release = false;
+    std::string seg_model_path = "seg_model";
+    std::string det_model_path = "car_detect.onnx";
+    std::string csv_path;
+    std::string report_path;
+};
+
+std::atomic<bool> g_interrupted{false};
+
+void handle_signal(int) {
+    g_interrupted.store(true);
+}
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 堆统计：已向系统申请的字节数与其中空闲的字节数
+struct HeapStats {
+    double arena_mb = 0.0;
+    double free_mb = 0.0;
+};
+
+HeapStats read_heap_stats() {
+    HeapStats stats;
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    stats.arena_mb = (info.arena + info.hblkhd) / (1024.0 * 1024.0);
+    stats.free_mb = info.fordblks / (1024.0 * 1024.0);
+#elif defined(__GLIBC__)
+    struct mallinfo info = mallinfo();
+    stats.arena_mb = (static_cast<size_t>(info.arena) + static_cast<size_t>(info.hblkhd)) / (1024.0 * 1024.0);
+    stats.free_mb = static_cast<size_t>(info.fordblks) / (1024.0 * 1024.0);
+#endif
+    return stats;
+}
+
+// 最小二乘斜率（y 对 x）
+double linear_slope(const std::vector<std::pair<double, double>>& points) {
+    if (points.size() < 2) {
+        return 0.0;
+    }
+    double n = static_cast<double>(points.size());
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (const auto& p : points) {
+        sx += p.first;
+        sy += p.second;
+        sxx += p.first * p.first;
+        sxy += p.first * p.second;
+    }
+    double denom = n * sxx - sx * sx;
+    return denom > 0.0 ? (n * sxy - sx * sy) / denom : 0.0;
+}
+
+// 进程峰值 RSS（/proc/self/status 的 VmHWM），读取失败返回0
+double read_peak_rss_mb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::atof(line.c_str() + 6) / 1024.0;
+        }
+    }
+    return 0.0;
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(std::ceil(p * values.size()));
+    return values[std::min(values.size(), std::max<size_t>(1, rank)) - 1];
+}
+
+/**
+ * 延迟样本收集（各路共享，每个检查间隔取走一次）
+ */
+class LatencyWindow {
+public:
+    void add(double ms) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        samples_.push_back(ms);
+    }
+    std::vector<double> take() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<double> out;
+        out.swap(samples_);
+        return out;
+    }
+private:
+    std::mutex mutex_;
+    std::vector<double> samples_;
+};
+
+/**
+ * 合成视频帧：固定路面背景 + 匀速移动的车辆矩形 + 少量噪声，
+ * 各路使用不同的随机种子，画面内容不同
+ */
+class SyntheticScene {
+public:
+    SyntheticScene(int width, int height, uint32_t seed) : rng_(seed) {
+        background_ = cv::Mat(height, width, CV_8UC3, cv::Scalar(90, 90, 90));
+        for (int lane = 1; lane < 4; ++lane) {
+            int x = width * lane / 4;
+            for (int y = 0; y < height; y += 80) {
+                cv::line(background_, cv::Point(x, y), cv::Point(x, y + 40), cv::Scalar(230, 230, 230), 6);
+            }
+        }
+        std::uniform_real_distribution<double> pos(0.0, 1.0);
+        std::uniform_real_distribution<double> speed(2.0, 12.0);
+        for (int i = 0; i < 8; ++i) {
+            Vehicle v;
+            v.x = pos(rng_) * (width - 160);
+            v.y = pos(rng_) * height;
+            v.speed = i % 3 == 0 ? 0.0 : speed(rng_);  // 部分车辆静止，覆盖违停路径
+            v.color = cv::Scalar(40 + 25 * i, 200 - 20 * i, 120);
+            vehicles_.push_back(v);
+        }
+        noise_ = cv::Mat(height, width, CV_8UC3);
+        cv::randn(noise_, cv::Scalar::all(0), cv::Scalar::all(4));
+    }
+
+    cv::Mat next_frame() {
+        cv::Mat frame = background_.clone();
+        for (auto& v : vehicles_) {
+            v.y += v.speed;
+            if (v.y > frame.rows) {
+                v.y = -120.0;
+            }
+            cv::rectangle(frame, cv::Rect(static_cast<int>(v.x), static_cast<int>(v.y), 160, 120), v.color, cv::FILLED);
+        }
+        // 噪声按帧滚动，避免相邻帧完全相同
+        int shift = static_cast<int>(frame_index_++ % 16);
+        cv::Mat rows = noise_.rowRange(shift, noise_.rows);
+        cv::add(frame.rowRange(0, rows.rows), rows, frame.rowRange(0, rows.rows));
+        return frame;
+    }
+
+private:
+    struct Vehicle {
+        double x, y, speed;
+        cv::Scalar color;
+    };
+    std::mt19937 rng_;
+    cv::Mat background_;
+    cv::Mat noise_;
+    std::vector<Vehicle> vehicles_;
+    uint64_t frame_index_ = 0;
+};
+
+/**
+ * 单路视频流：独立检测器 + 提交线程 + 取结果线程
+ */
+class SoakStream {
+public:
+    SoakStream(int id, const SoakOptions& options, const HighwayEventConfig& config, LatencyWindow& latencies)
+        : id_(id), options_(options), config_(config), latencies_(latencies),
+          scene_(options.width, options.height, 1000u + static_cast<uint32_t>(id)) {}
+
+    ~SoakStream() {
+        stop();
+    }
+
+    bool start() {
+        detector_ = create_highway_event_detector();
+        if (!detector_->initialize(config_) || !detector_->start()) {
+            detector_.reset();
+            return false;
+        }
+        running_.store(true);
+        producer_ = std::thread(&SoakStream::produce, this);
+        consumer_ = std::thread(&SoakStream::consume, this);
+        return true;
+    }
+
+    void stop() {
+        if (!running_.exchange(false)) {
+            return;
+        }
+        pending_cv_.notify_all();
+        if (producer_.joinable()) {
+            producer_.join();
+        }
+        if (consumer_.joinable()) {
+            consumer_.join();
+        }
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            abandoned_ += pending_.size();
+            pending_.clear();
+        }
+        detector_->stop();
+        detector_.reset();
+    }
+
+    // 随机扰动运行时可调的阈值
+    bool change_params(std::mt19937& rng) {
+        if (!running_.load()) {
+            return false;
+        }
+        std::uniform_real_distribution<float> conf(0.2f, 0.4f);
+        std::uniform_real_distribution<float> diff(1.0f, 4.0f);
+        std::uniform_int_distribution<int> refresh(10, 50);
+        HighwayEventConfig config = detector_->get_config();
+        config.det_conf_thresh = conf(rng);
+        config.dedup_diff_threshold = diff(rng);
+        config.motion_refresh_interval = refresh(rng);
+        return detector_->change_params(config);
+    }
+
+    int id() const { return id_; }
+    uint64_t submitted() const { return submitted_.load(); }
+    uint64_t busy() const { return busy_.load(); }
+    uint64_t completed() const { return completed_.load(); }
+    uint64_t failed() const { return failed_.load(); }
+    uint64_t abandoned() const { return abandoned_.load(); }
+
+    uint64_t in_flight() const {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        return pending_.size();
+    }
+
+    PipelineOccupancy occupancy() const {
+        return running_.load() && detector_ ? detector_->get_occupancy() : PipelineOccupancy();
+    }
+
+private:
+    struct PendingFrame {
+        uint64_t frame_id;
+        Clock::time_point submitted;
+    };
+
+    int id_;
+    const SoakOptions& options_;
+    HighwayEventConfig config_;
+    LatencyWindow& latencies_;
+    SyntheticScene scene_;
+    std::unique_ptr<HighwayEventDetector> detector_;
+
+    std::atomic<bool> running_{false};
+    std::thread producer_;
+    std::thread consumer_;
+
+    mutable std::mutex pending_mutex_;
+    std::condition_variable pending_cv_;
+    std::deque<PendingFrame> pending_;
+
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> busy_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> abandoned_{0};
+
+    void produce() {
+        auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options_.fps));
+        auto due = Clock::now();
+        while (running_.load()) {
+            std::this_thread::sleep_until(due);
+            due += interval;
+            cv::Mat frame = scene_.next_frame();
+            auto submitted_at = Clock::now();
+            uint64_t frame_id = 0;
+            AddFrameStatus status = detector_->add_frame_with_timeout(frame, config_.add_timeout_ms, frame_id);
+            if (status != AddFrameStatus::OK) {
+                busy_++;
+                continue;
+            }
+            submitted_++;
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                pending_.push_back({frame_id, submitted_at});
+            }
+            pending_cv_.notify_one();
+            // 提交阻塞超过一个帧间隔时不补发，保持实时采集语义
+            auto now = Clock::now();
+            if (now > due) {
+                due = now;
+            }
+        }
+    }
+
+    void consume() {
+        while (true) {
+            PendingFrame frame;
+            {
+                std::unique_lock<std::mutex> lock(pending_mutex_);
+                pending_cv_.wait(lock, [this]() { return !pending_.empty() || !running_.load(); });
+                if (pending_.empty()) {
+                    return;
+                }
+                frame = pending_.front();
+            }
+            // 分段等待，停流时不必等满 get_timeout_ms
+            ResultView view(ResultStatus::TIMEOUT, frame.frame_id);
+            auto deadline = frame.submitted + std::chrono::milliseconds(config_.get_timeout_ms);
+            while (running_.load() && Clock::now() < deadline) {
+                view = detector_->get_result_view_with_timeout(frame.frame_id, 500);
+                if (view.status() != ResultStatus::TIMEOUT) {
+                    break;
+                }
+            }
+            if (!running_.load() && view.status() != ResultStatus::SUCCESS) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                pending_.pop_front();
+            }
+            if (view.status() == ResultStatus::SUCCESS) {
+                completed_++;
+                latencies_.add(std::chrono::duration<double, std::milli>(Clock::now() - frame.submitted).count());
+            } else {
+                failed_++;
+            }
+        }
+    }
+};
+
+/**
+ * 单次检查的指标
+ */
+struct SoakSample {
+    double elapsed_s = 0.0;
+    int active_streams = 0;
+    double rss_mb = 0.0;
+    HeapStats heap;
+    uint64_t in_flight = 0;
+    uint64_t max_stream_in_flight = 0;
+    size_t saturated_pools = 0;          // 本次检查中处于打满状态的缓冲区数
+    std::string saturated_detail;
+    double p99_ms = 0.0;
+    size_t latency_samples = 0;
+    uint64_t completed = 0;
+    uint64_t failed = 0;
+};
+
+class SoakSupervisor {
+public:
+    SoakSupervisor(const SoakOptions& options, const HighwayEventConfig& config)
+        : options_(options), config_(config), rng_(20250501u) {}
+
+    int run() {
+        start_ = Clock::now();
+        if (!options_.csv_path.empty()) {
+            csv_.open(options_.csv_path, std::ios::out | std::ios::trunc);
+            csv_ << "elapsed_s,streams,rss_mb,heap_arena_mb,heap_free_mb,in_flight,saturated_pools,p99_ms,"
+                    "latency_samples,completed,failed\n";
+        }
+
+        for (int i = 0; i < options_.max_streams; ++i) {
+            start_stream();
+        }
+        if (active_count() < options_.min_streams) {
+            failures_.push_back("启动失败：可用视频流少于 --min-streams");
+            return finish();
+        }
+
+        double duration_s = options_.hours * 3600.0;
+        double next_check = options_.check_interval_s;
+        while (!g_interrupted.load() && seconds_since(start_) < duration_s && failures_.empty()) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            chaos_tick();
+            if (seconds_since(start_) >= next_check) {
+                next_check += options_.check_interval_s;
+                check();
+            }
+        }
+        if (g_interrupted.load()) {
+            notes_.push_back("收到中断信号，提前结束");
+        }
+        return finish();
+    }
+
+    // 峰值 RSS：取 VmHWM 与检查时采样峰值中的较大者（读不到 VmHWM 时只有采样值）
+    double peak_rss_mb() const {
+        return std::max(peak_rss_mb_, read_peak_rss_mb());
+    }
+
+private:
+    const SoakOptions& options_;
+    HighwayEventConfig config_;
+    std::mt19937 rng_;
+    Clock::time_point start_;
+    LatencyWindow latencies_;
+    std::vector<std::unique_ptr<SoakStream>> streams_;
+    int next_stream_id_ = 0;
+    uint64_t stream_starts_ = 0;
+    uint64_t stream_stops_ = 0;
+    uint64_t param_changes_ = 0;
+
+    std::vector<SoakSample> samples_;
+    std::vector<double> baseline_p99_;
+    double baseline_ = 0.0;
+    int drift_streak_ = 0;
+    int saturated_streak_ = 0;
+    double rss_slope_ = 0.0;
+    double heap_free_slope_ = 0.0;
+    double peak_rss_mb_ = 0.0;
+    std::vector<std::string> failures_;
+    std::vector<std::string> notes_;
+    std::ofstream csv_;
+
+    int active_count() const {
+        return static_cast<int>(streams_.size());
+    }
+
+    void start_stream() {
+        auto stream = std::make_unique<SoakStream>(next_stream_id_++, options_, config_, latencies_);
+        if (stream->start()) {
+            streams_.push_back(std::move(stream));
+            stream_starts_++;
+        } else {
+            notes_.push_back("第 " + std::to_string(stream->id()) + " 路启动失败");
+        }
+    }
+
+    // 每秒按平均间隔的概率触发启停和参数修改
+    void chaos_tick() {
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        if (options_.stream_toggle_s > 0.0 && coin(rng_) < 1.0 / options_.stream_toggle_s) {
+            bool can_stop = active_count() > options_.min_streams;
+            bool can_start = active_count() < options_.max_streams;
+            if (can_stop && (!can_start || coin(rng_) < 0.5)) {
+                std::uniform_int_distribution<size_t> pick(0, streams_.size() - 1);
+                size_t index = pick(rng_);
+                std::cout << "🔻 停止第 " << streams_[index]->id() << " 路" << std::endl;
+                retire(index);
+            } else if (can_start) {
+                std::cout << "🔺 启动第 " << next_stream_id_ << " 路" << std::endl;
+                start_stream();
+            }
+        }
+        if (options_.change_params_s > 0.0 && !streams_.empty() && coin(rng_) < 1.0 / options_.change_params_s) {
+            std::uniform_int_distribution<size_t> pick(0, streams_.size() - 1);
+            if (streams_[pick(rng_)]->change_params(rng_)) {
+                param_changes_++;
+            }
+        }
+    }
+
+    // 停止并销毁一路，累计计数保留到退役统计
+    uint64_t retired_completed_ = 0;
+    uint64_t retired_failed_ = 0;
+    uint64_t retired_busy_ = 0;
+    uint64_t retired_abandoned_ = 0;
+
+    void retire(size_t index) {
+        streams_[index]->stop();
+        retired_completed_ += streams_[index]->completed();
+        retired_failed_ += streams_[index]->failed();
+        retired_busy_ += streams_[index]->busy();
+        retired_abandoned_ += streams_[index]->abandoned();
+        streams_.erase(streams_.begin() + static_cast<std::ptrdiff_t>(index));
+        stream_stops_++;
+    }
+
+    uint64_t total_completed() const {
+        uint64_t total = retired_completed_;
+        for (const auto& s : streams_) {
+            total += s->completed();
+        }
+        return total;
+    }
+
+    uint64_t total_failed() const {
+        uint64_t total = retired_failed_;
+        for (const auto& s : streams_) {
+            total += s->failed();
+        }
+        return total;
+    }
+
+    void check() {
+        SoakSample sample;
+        sample.elapsed_s = seconds_since(start_);
+        sample.active_streams = active_count();
+        sample.rss_mb = static_cast<double>(MemoryUtils::get_process_memory_mb());
+        sample.heap = read_heap_stats();
+        sample.completed = total_completed();
+        sample.failed = total_failed();
+        peak_rss_mb_ = std::max(peak_rss_mb_, sample.rss_mb);
+
+        std::ostringstream saturated;
+        for (const auto& stream : streams_) {
+            uint64_t in_flight = stream->in_flight();
+            sample.in_flight += in_flight;
+            sample.max_stream_in_flight = std::max(sample.max_stream_in_flight, in_flight);
+
+            PipelineOccupancy occupancy = stream->occupancy();
+            if (occupancy.pipeline.connector_capacity > 0 &&
+                occupancy.pipeline.connector_batches >= occupancy.pipeline.connector_capacity) {
+                sample.saturated_pools++;
+                saturated << " 第" << stream->id() << "路连接器 " << occupancy.pipeline.connector_batches << "/"
+                          << occupancy.pipeline.connector_capacity;
+            }
+            if (occupancy.result_cache_capacity > 0 && occupancy.result_cache >= occupancy.result_cache_capacity) {
+                sample.saturated_pools++;
+                saturated << " 第" << stream->id() << "路结果缓存 " << occupancy.result_cache << "/"
+                          << occupancy.result_cache_capacity;
+            }
+        }
+        sample.saturated_detail = saturated.str();
+
+        std::vector<double> latencies = latencies_.take();
+        sample.latency_samples = latencies.size();
+        sample.p99_ms = percentile(std::move(latencies), 0.99);
+        samples_.push_back(sample);
+
+        if (csv_.is_open()) {
+            csv_ << std::fixed << std::setprecision(2) << sample.elapsed_s << ',' << sample.active_streams << ','
+                 << sample.rss_mb << ',' << sample.heap.arena_mb << ',' << sample.heap.free_mb << ','
+                 << sample.in_flight << ',' << sample.saturated_pools << ',' << sample.p99_ms << ','
+                 << sample.latency_samples << ',' << sample.completed << ',' << sample.failed << '\n';
+            csv_.flush();
+        }
+
+        std::cout << std::fixed << std::setprecision(1) << "🩺 [" << sample.elapsed_s / 60.0 << " min] "
+                  << sample.active_streams << " 路, RSS " << sample.rss_mb << " MB, 堆空闲 " << sample.heap.free_mb
+                  << " MB, 在途 " << sample.in_flight << " 帧, p99 " << sample.p99_ms << " ms" << std::endl;
+
+        evaluate(sample);
+    }
+
+    void evaluate(const SoakSample& sample) {
+        double warmup_s = options_.warmup_min * 60.0;
+        if (sample.elapsed_s < warmup_s) {
+            return;
+        }
+        std::ostringstream msg;
+        msg << std::fixed << std::setprecision(2);
+
+        // 在途帧
+        if (sample.max_stream_in_flight > options_.max_in_flight_per_stream) {
+            msg << "在途帧超限: 单路最多 " << sample.max_stream_in_flight << " 帧 > " << options_.max_in_flight_per_stream;
+            failures_.push_back(msg.str());
+            return;
+        }
+
+        // 缓冲区持续打满
+        saturated_streak_ = sample.saturated_pools > 0 ? saturated_streak_ + 1 : 0;
+        if (saturated_streak_ > options_.max_saturated_checks) {
+            msg << "缓冲区连续 " << saturated_streak_ << " 次检查打满:" << sample.saturated_detail;
+            failures_.push_back(msg.str());
+            return;
+        }
+
+        // 取结果失败比例
+        uint64_t finished = sample.completed + sample.failed;
+        if (finished > 0 && static_cast<double>(sample.failed) / finished > options_.max_error_rate) {
+            msg << "取结果失败比例 " << 100.0 * sample.failed / finished << "% > " << options_.max_error_rate * 100.0 << "%";
+            failures_.push_back(msg.str());
+            return;
+        }
+
+        // p99 基线与漂移
+        if (sample.elapsed_s < warmup_s + options_.baseline_min * 60.0) {
+            if (sample.latency_samples > 0) {
+                baseline_p99_.push_back(sample.p99_ms);
+            }
+            return;
+        }
+        if (baseline_ == 0.0 && !baseline_p99_.empty()) {
+            baseline_ = percentile(baseline_p99_, 0.5);
+            std::cout << "📌 p99 基线: " << baseline_ << " ms" << std::endl;
+        }
+        if (baseline_ > 0.0 && sample.latency_samples > 0) {
+            drift_streak_ = sample.p99_ms > baseline_ * (1.0 + options_.max_p99_drift) ? drift_streak_ + 1 : 0;
+            if (drift_streak_ >= options_.drift_checks) {
+                msg << "p99 延迟漂移: " << sample.p99_ms << " ms，基线 " << baseline_ << " ms，连续 " << drift_streak_
+                    << " 次超过 +" << options_.max_p99_drift * 100.0 << "%";
+                failures_.push_back(msg.str());
+                return;
+            }
+        }
+
+        // 内存斜率：窗口需覆盖满才判定，避免初期分配被误判为泄漏
+        double window_s = options_.slope_window_min * 60.0;
+        if (sample.elapsed_s - warmup_s < window_s) {
+            return;
+        }
+        std::vector<std::pair<double, double>> rss_points, free_points;
+        for (const auto& s : samples_) {
+            if (s.elapsed_s >= sample.elapsed_s - window_s) {
+                rss_points.emplace_back(s.elapsed_s / 3600.0, s.rss_mb);
+                free_points.emplace_back(s.elapsed_s / 3600.0, s.heap.free_mb);
+            }
+        }
+        rss_slope_ = linear_slope(rss_points);
+        heap_free_slope_ = linear_slope(free_points);
+        if (rss_slope_ > options_.max_rss_slope_mb_per_hour) {
+            msg << "RSS 持续增长: " << rss_slope_ << " MB/小时 > " << options_.max_rss_slope_mb_per_hour;
+            failures_.push_back(msg.str());
+        } else if (heap_free_slope_ > options_.max_heap_free_slope_mb_per_hour) {
+            msg << "堆碎片增长: 空闲堆内存 " << heap_free_slope_ << " MB/小时 > "
+                << options_.max_heap_free_slope_mb_per_hour;
+            failures_.push_back(msg.str());
+        }
+    }
+
+    int finish() {
+        while (!streams_.empty()) {
+            retire(streams_.size() - 1);
+        }
+
+        std::ostringstream report;
+        report << std::fixed << std::setprecision(2);
+        report << "\n" << std::string(80, '=') << "\n";
+        report << "🧪 长稳测试报告 (运行 " << seconds_since(start_) / 3600.0 << " 小时)\n";
+        report << std::string(80, '=') << "\n";
+        report << "  视频流: 启动 " << stream_starts_ << " 次, 停止 " << stream_stops_ << " 次, change_params "
+               << param_changes_ << " 次\n";
+        report << "  帧: 完成 " << retired_completed_ << ", 取结果失败 " << retired_failed_ << ", 提交繁忙 "
+               << retired_busy_ << ", 停流时丢弃 " << retired_abandoned_ << "\n";
+        if (!samples_.empty()) {
+            const SoakSample& first = samples_.front();
+            const SoakSample& last = samples_.back();
+            report << "  缓冲区提前释放: " << (config_.enable_buffer_release ? "开" : "关") << ", 峰值 RSS (VmHWM) "
+                   << peak_rss_mb() << " MB\n";
+            report << "  RSS: " << first.rss_mb << " -> " << last.rss_mb << " MB, 峰值 " << peak_rss_mb_
+                   << " MB, 窗口斜率 " << rss_slope_ << " MB/小时\n";
+            report << "  堆: 已申请 " << first.heap.arena_mb << " -> " << last.heap.arena_mb << " MB, 空闲 "
+                   << first.heap.free_mb << " -> " << last.heap.free_mb << " MB, 空闲斜率 " << heap_free_slope_
+                   << " MB/小时\n";
+            double worst_p99 = 0.0;
+            for (const auto& s : samples_) {
+                worst_p99 = std::max(worst_p99, s.p99_ms);
+            }
+            report << "  p99 延迟: 基线 " << baseline_ << " ms, 最近 " << last.p99_ms << " ms, 最差 " << worst_p99
+                   << " ms\n";
+        }
+        for (const auto& note : notes_) {
+            report << "  ℹ️ " << note << "\n";
+        }
+        if (failures_.empty()) {
+            report << "✅ 全部检查通过\n";
+        } else {
+            for (const auto& failure : failures_) {
+                report << "❌ " << failure << "\n";
+            }
+        }
+        report << std::string(80, '=') << "\n";
+
+        std::cout << report.str();
+        if (!options_.report_path.empty()) {
+            std::ofstream out(options_.report_path, std::ios::out | std::ios::trunc);
+            out << report.str();
+        }
+        return failures_.empty() ? 0 : 2;
+    }
+};
+
+// 运行一次长稳测试
+int run_soak(const SoakOptions& options, double* peak_rss_mb) {
+    HighwayEventConfig config;
+    config.seg_model_path = options.seg_model_path;
+    config.car_det_model_path = options.det_model_path;
+    config.enable_console_log = false;
+    config.add_timeout_ms = 1000;
+    config.get_timeout_ms = 30000;
+    config.enable_buffer_release = options.buffer_release;
+    // 与 JNI 一致：只取检测结果，不通过 ResultView 读原图，原图可在最后一个读取阶段后释放
+    config.result_keep_source_image = false;
+
+    std::cout << "🧪 长稳测试: " << options.hours << " 小时, " << options.min_streams << "-" << options.max_streams
+              << " 路 @ " << options.fps << " fps, " << options.width << "x" << options.height << ", 缓冲区提前释放 "
+              << (options.buffer_release ? "开" : "关") << std::endl;
+    SoakSupervisor supervisor(options, config);
+    int code = supervisor.run();
+    if (peak_rss_mb) {
+        *peak_rss_mb = supervisor.peak_rss_mb();
+    }
+    return code;
+}
+
+std::string with_suffix(const std::string& path, const std::string& suffix) {
+    return path.empty() ? path : path + suffix;
+}
+
+// enable_buffer_release 开/关各在一个子进程中运行，对比峰值 RSS
+int compare_buffer_release(const SoakOptions& options) {
+    struct Run {
+        bool buffer_release;
+        const char* suffix;
+        double peak_rss_mb = 0.0;
+        int code = 1;
+    };
+    Run runs[] = {{true, ".release_on"}, {false, ".release_off"}};
+    for (Run& run : runs) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            std::cerr << "❌ 创建管道失败: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "❌ 创建子进程失败: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        if (pid == 0) {
+            ::close(fds[0]);
+            SoakOptions child = options;
+            child.buffer_release = run.buffer_release;
+            child.report_path = with_suffix(options.report_path, run.suffix);
+            child.csv_path = with_suffix(options.csv_path, run.suffix);
+            double peak = 0.0;
+            int code = run_soak(child, &peak);
+            ssize_t written = write(fds[1], &peak, sizeof(peak));
+            (void)written;
+            ::close(fds[1]);
+            std::cout.flush();
+            _exit(code);
+        }
+        ::close(fds[1]);
+        if (read(fds[0], &run.peak_rss_mb, sizeof(run.peak_rss_mb)) != sizeof(run.peak_rss_mb)) {
+            run.peak_rss_mb = 0.0;
+        }
+        ::close(fds[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        run.code = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+        if (g_interrupted.load()) {
+            break;
+        }
+    }
+
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(2);
+    report << "\n" << std::string(80, '=') << "\n";
+    report << "🧪 缓冲区提前释放对比 (各 " << options.hours << " 小时)\n";
+    report << std::string(80, '=') << "\n";
+    for (const Run& run : runs) {
+        report << "  enable_buffer_release=" << (run.buffer_release ? "on " : "off") << ": 峰值 RSS "
+               << run.peak_rss_mb << " MB, " << (run.code == 0 ? "检查通过" : "检查失败") << "\n";
+    }
+    if (runs[0].peak_rss_mb > 0.0 && runs[1].peak_rss_mb > 0.0) {
+        double saved = runs[1].peak_rss_mb - runs[0].peak_rss_mb;
+        report << "  提前释放降低峰值 RSS " << saved << " MB (" << 100.0 * saved / runs[1].peak_rss_mb << "%)\n";
+    }
+    report << std::string(80, '=') << "\n";
+    std::cout << report.str();
+    if (!options.report_path.empty()) {
+        std::ofstream out(options.report_path, std::ios::out | std::ios::trunc);
+        out << report.str();
+    }
+    return std::max(runs[0].code, runs[1].code);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SoakOptions options;
+    for (int i = 1; i < argc; ++i) {
+        auto next = [&](double& value) {
+            if (i + 1 >= argc) {
+                return false;
+            }
+            value = std::atof(argv[++i]);
+            return true;
+        };
+        double value = 0.0;
+        std::string arg = argv[i];
+        bool ok = true;
+        if (arg == "--hours") { ok = next(options.hours); }
+        else if (arg == "--streams") { ok = next(value); options.max_streams = static_cast<int>(value); }
+        else if (arg == "--min-streams") { ok = next(value); options.min_streams = static_cast<int>(value); }
+        else if (arg == "--fps") { ok = next(options.fps); }
+        else if (arg == "--width") { ok = next(value); options.width = static_cast<int>(value); }
+        else if (arg == "--height") { ok = next(value); options.height = static_cast<int>(value); }
+        else if (arg == "--stream-toggle-s") { ok = next(options.stream_toggle_s); }
+        else if (arg == "--change-params-s") { ok = next(options.change_params_s); }
+        else if (arg == "--check-interval-s") { ok = next(options.check_interval_s); }
+        else if (arg == "--warmup-min") { ok = next(options.warmup_min); }
+        else if (arg == "--baseline-min") { ok = next(options.baseline_min); }
+        else if (arg == "--slope-window-min") { ok = next(options.slope_window_min); }
+        else if (arg == "--max-rss-slope") { ok = next(options.max_rss_slope_mb_per_hour); }
+        else if (arg == "--max-heap-free-slope") { ok = next(options.max_heap_free_slope_mb_per_hour); }
+        else if (arg == "--max-in-flight") { ok = next(value); options.max_in_flight_per_stream = static_cast<uint64_t>(value); }
+        else if (arg == "--max-saturated-checks") { ok = next(value); options.max_saturated_checks = static_cast<int>(value); }
+        else if (arg == "--max-p99-drift") { ok = next(options.max_p99_drift); }
+        else if (arg == "--drift-checks") { ok = next(value); options.drift_checks = static_cast<int>(value); }
+        else if (arg == "--max-error-rate") { ok = next(options.max_error_rate); }
+        else if (arg == "--buffer-release" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            ok = mode == "on" || mode == "off";
+            options.buffer_release = mode == "on";
+        }
+        else if (arg == "--compare-buffer-release") { options.compare_buffer_release = true; }
+        else if (arg == "--seg-model" && i + 1 < argc) { options.seg_model_path = argv[++i]; }
+        else if (arg == "--det-model" && i + 1 < argc) { options.det_model_path = argv[++i]; }
+        else if (arg == "--csv" && i + 1 < argc) { options.csv_path = argv[++i]; }
+        else if (arg == "--report" && i + 1 < argc) { options.report_path = argv[++i]; }
+        else { ok = false; }
+        if (!ok) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.max_streams <= 0 || options.min_streams < 0 || options.min_streams > options.max_streams ||
+        options.fps <= 0.0 || options.check_interval_s <= 0.0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+
+    if (options.compare_buffer_release) {
+        return compare_buffer_release(options);
+    }
+    return run_soak(options, nullptr);
+}
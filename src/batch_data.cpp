@@ -1,14 +1,17 @@
 #include "batch_data.h"
 #include "logger_manager.h"
+#include "trace_recorder.h"
 #include <iostream>
 #include <algorithm>
 
 // BatchBuffer implementation
 
-BatchBuffer::BatchBuffer(std::chrono::milliseconds flush_timeout, size_t max_ready_batches)
-    : next_batch_id_(1), flush_timeout_(flush_timeout), max_ready_batches_(max_ready_batches),
+BatchBuffer::BatchBuffer(std::chrono::milliseconds flush_timeout, size_t max_ready_batches,
+                         bool bucket_by_shape, size_t max_bypass_batches, size_t batch_size)
+    : next_batch_id_(1), bucket_by_shape_(bucket_by_shape), max_bypass_batches_(max_bypass_batches),
+      batch_size_(std::max<size_t>(1, batch_size)),
+      max_ready_batches_(max_ready_batches), flush_timeout_(flush_timeout),
       running_(false), stop_requested_(false) {
-    current_collecting_batch_ = nullptr;
 }
 
 BatchBuffer::~BatchBuffer() {
@@ -40,6 +43,10 @@ void BatchBuffer::stop() {
     // 刷新当前批次
     flush_current_batch();
     
+    // 唤醒刷新线程和因背压等待的提交线程
+    flush_cv_.notify_all();
+    ready_cv_.notify_all();
+    
     // 等待刷新线程结束
     if (flush_thread_.joinable()) {
         flush_thread_.join();
@@ -49,49 +56,99 @@ void BatchBuffer::stop() {
 }
 
 bool BatchBuffer::add_image(ImageDataPtr image) {
-    if (!running_.load() || !image) {
+    if (!image) {
         return false;
     }
+    return add_images(&image, 1, -1) == 1;
+}
 
-    // 背压检查：如果就绪队列已满，则阻塞等待
-    {
-        std::unique_lock<std::mutex> ready_lock(ready_mutex_);
-        ready_cv_.wait(ready_lock, [this]() {
-            return ready_batches_.size() < max_ready_batches_ || !running_.load();
-        });
-        
-        if (!running_.load()) {
-            return false;
-        }
-    }
-    
-    std::lock_guard<std::mutex> lock(collect_mutex_);
-    
-    // 如果当前没有收集批次，创建新的
-    if (!current_collecting_batch_) {
-        current_collecting_batch_ = std::make_shared<ImageBatch>(next_batch_id_++);
-    }
-    
-    // 添加图像到当前批次
-    bool added = current_collecting_batch_->add_image(image);
-    if (!added) {
-        LOG_ERROR("❌ 无法添加图像到批次，批次可能已满");
+bool BatchBuffer::add_image_with_timeout(ImageDataPtr image, int timeout_ms) {
+    if (!image) {
         return false;
     }
+    return add_images(&image, 1, timeout_ms) == 1;
+}
+
+size_t BatchBuffer::add_images(const ImageDataPtr* images, size_t count, int timeout_ms) {
+    if (!running_.load() || !images || count == 0) {
+        return 0;
+    }
     
-    total_images_received_.fetch_add(1);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, timeout_ms));
+    size_t admitted = 0;
     
-    // 如果批次已满，移动到就绪队列
-    if (current_collecting_batch_->is_full()) {
-        move_batch_to_ready(current_collecting_batch_);
-        current_collecting_batch_ = nullptr;
+    while (admitted < count) {
+        // 背压检查：就绪队列已满时按超时策略等待（timeout_ms < 0 一直等待，0 不等待）
+        {
+            std::unique_lock<InstrumentedMutex> ready_lock(ready_mutex_);
+            auto has_space = [this]() {
+                return ready_batches_.size() < max_ready_batches_ || !running_.load();
+            };
+            if (timeout_ms < 0) {
+                ready_cv_.wait(ready_lock, has_space);
+            } else if (!ready_cv_.wait_until(ready_lock, deadline, has_space)) {
+                break;
+            }
+            if (!running_.load()) {
+                break;
+            }
+        }
+        
+        // 一次加锁接纳尽可能多的图像
+        std::lock_guard<InstrumentedMutex> lock(collect_mutex_);
+        size_t free_ready;
+        {
+            std::lock_guard<InstrumentedMutex> ready_lock(ready_mutex_);
+            free_ready = max_ready_batches_ > ready_batches_.size() ? max_ready_batches_ - ready_batches_.size() : 0;
+        }
+        
+        while (admitted < count) {
+            CollectingBucket& bucket = bucket_for(*images[admitted]);
+            if (!bucket.batch) {
+                bucket.batch = std::make_shared<ImageBatch>(next_batch_id_++, batch_size_);
+                bucket.batch->shape = bucket.shape;
+                bucket.opened_at_emit = batches_emitted_;
+            }
+            // 填满当前批次需要一个就绪队列空位，没有空位时停止接纳，避免满批次被丢弃
+            bool completes_batch = bucket.batch->actual_size + 1 >= batch_size_;
+            if (completes_batch && free_ready == 0) {
+                break;
+            }
+            if (!bucket.batch->add_image(images[admitted])) {
+                LOG_ERROR("❌ 无法添加图像到批次，批次可能已满");
+                break;
+            }
+            admitted++;
+            
+            if (bucket.batch->is_full()) {
+                emit_bucket(bucket);
+                free_ready--;
+                
+                // 公平性：被越过 max_bypass_batches 次的未满批次立即刷新
+                for (auto& other : buckets_) {
+                    if (max_bypass_batches_ == 0 || free_ready == 0) {
+                        break;
+                    }
+                    if (other.batch && batches_emitted_ - other.opened_at_emit >= max_bypass_batches_) {
+                        emit_bucket(other);
+                        free_ready--;
+                        fairness_flushes_.fetch_add(1);
+                    }
+                }
+            }
+        }
+        
+        if (timeout_ms == 0) {
+            break;
+        }
     }
     
-    return true;
+    total_images_received_.fetch_add(admitted);
+    return admitted;
 }
 
 bool BatchBuffer::get_ready_batch(BatchPtr& batch) {
-    std::unique_lock<std::mutex> lock(ready_mutex_);
+    std::unique_lock<InstrumentedMutex> lock(ready_mutex_);
     
     // 等待就绪批次
     ready_cv_.wait(lock, [this]() {
@@ -106,9 +163,9 @@ bool BatchBuffer::get_ready_batch(BatchPtr& batch) {
         batch = ready_batches_.front();
         ready_batches_.pop();
         
-        // 通知等待的add_image线程
+        // 通知等待的add_image线程（与消费者共用条件变量，需全部唤醒）
         lock.unlock();
-        ready_cv_.notify_one();
+        ready_cv_.notify_all();
         
         return true;
     }
@@ -117,15 +174,15 @@ bool BatchBuffer::get_ready_batch(BatchPtr& batch) {
 }
 
 bool BatchBuffer::try_get_ready_batch(BatchPtr& batch) {
-    std::unique_lock<std::mutex> lock(ready_mutex_);
+    std::unique_lock<InstrumentedMutex> lock(ready_mutex_);
     
     if (!ready_batches_.empty()) {
         batch = ready_batches_.front();
         ready_batches_.pop();
         
-        // 通知等待的add_image线程
+        // 通知等待的add_image线程（与消费者共用条件变量，需全部唤醒）
         lock.unlock();
-        ready_cv_.notify_one();
+        ready_cv_.notify_all();
         
         return true;
     }
@@ -134,24 +191,35 @@ bool BatchBuffer::try_get_ready_batch(BatchPtr& batch) {
 }
 
 void BatchBuffer::flush_current_batch() {
-    std::lock_guard<std::mutex> lock(collect_mutex_);
+    std::lock_guard<InstrumentedMutex> lock(collect_mutex_);
     
-    if (current_collecting_batch_ && !current_collecting_batch_->is_empty()) {
-        std::cout << "🚿 强制刷新批次 " << current_collecting_batch_->batch_id 
-                  << "，包含 " << current_collecting_batch_->actual_size << " 个图像" << std::endl;
-        move_batch_to_ready(current_collecting_batch_);
-        current_collecting_batch_ = nullptr;
+    for (auto& bucket : buckets_) {
+        if (bucket.batch && !bucket.batch->is_empty()) {
+            std::cout << "🚿 强制刷新批次 " << bucket.batch->batch_id 
+                      << "，包含 " << bucket.batch->actual_size << " 个图像" << std::endl;
+            emit_bucket(bucket);
+        }
     }
 }
 
 size_t BatchBuffer::get_ready_batch_count() const {
-    std::lock_guard<std::mutex> lock(ready_mutex_);
+    std::lock_guard<InstrumentedMutex> lock(ready_mutex_);
     return ready_batches_.size();
 }
 
 size_t BatchBuffer::get_current_collecting_size() const {
-    std::lock_guard<std::mutex> lock(collect_mutex_);
-    return current_collecting_batch_ ? current_collecting_batch_->actual_size : 0;
+    std::lock_guard<InstrumentedMutex> lock(collect_mutex_);
+    size_t size = 0;
+    for (const auto& bucket : buckets_) {
+        size += bucket.batch ? bucket.batch->actual_size : 0;
+    }
+    return size;
+}
+
+size_t BatchBuffer::get_collecting_bucket_count() const {
+    std::lock_guard<InstrumentedMutex> lock(collect_mutex_);
+    return std::count_if(buckets_.begin(), buckets_.end(),
+                         [](const CollectingBucket& bucket) { return bucket.batch != nullptr; });
 }
 
 uint64_t BatchBuffer::get_total_batches_created() const {
@@ -163,36 +231,71 @@ size_t BatchBuffer::get_max_ready_batches() const {
 }
 
 bool BatchBuffer::is_ready_queue_full() const {
-    std::lock_guard<std::mutex> lock(ready_mutex_);
+    std::lock_guard<InstrumentedMutex> lock(ready_mutex_);
     return ready_batches_.size() >= max_ready_batches_;
 }
 
+std::vector<LockContentionSnapshot> BatchBuffer::get_lock_stats() const {
+    return {collect_mutex_.snapshot(), ready_mutex_.snapshot()};
+}
+
 void BatchBuffer::flush_thread_func() {
+    std::unique_lock<InstrumentedMutex> lock(collect_mutex_);
     while (running_.load()) {
-        std::this_thread::sleep_for(flush_timeout_);
-        
-        if (!running_.load()) {
-            break;
-        }
-        // 检查是否需要刷新当前批次
-        {
-            std::lock_guard<std::mutex> lock(collect_mutex_);
-            if (current_collecting_batch_ && !current_collecting_batch_->is_empty()) {
-                auto now = std::chrono::high_resolution_clock::now();
-                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    now - current_collecting_batch_->created_time);
-                
-                if (elapsed >= flush_timeout_) {
-                    std::cout << "⏰ 超时刷新批次 " << current_collecting_batch_->batch_id 
-                              << "，包含 " << current_collecting_batch_->actual_size 
-                              << " 个图像，等待时间: " << elapsed.count() << "ms" << std::endl;
-                    std::cout << "规定超时时间是 " << flush_timeout_.count() << " ms" << std::endl;
-                    move_batch_to_ready(current_collecting_batch_);
-                    current_collecting_batch_ = nullptr;
-                }
+        // 各桶独立的刷新期限；之后新建的批次期限更晚，因此等到当前最早期限即可
+        auto now = std::chrono::high_resolution_clock::now();
+        auto next_deadline = now + flush_timeout_;
+        for (auto& bucket : buckets_) {
+            if (!bucket.batch || bucket.batch->is_empty()) {
+                continue;
             }
+            auto deadline = bucket.batch->created_time + flush_timeout_;
+            if (deadline <= now) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - bucket.batch->created_time);
+                std::cout << "⏰ 超时刷新批次 " << bucket.batch->batch_id 
+                          << "，包含 " << bucket.batch->actual_size 
+                          << " 个图像，等待时间: " << elapsed.count() << "ms" << std::endl;
+                std::cout << "规定超时时间是 " << flush_timeout_.count() << " ms" << std::endl;
+                emit_bucket(bucket);
+            } else {
+                next_deadline = std::min(next_deadline, deadline);
+            }
+        }
+        flush_cv_.wait_until(lock, next_deadline);
+    }
+}
+
+BatchBuffer::CollectingBucket& BatchBuffer::bucket_for(const ImageData& image) {
+    if (!bucket_by_shape_) {
+        if (buckets_.empty()) {
+            buckets_.emplace_back();
+        }
+        return buckets_.front();
+    }
+    BatchShape shape = BatchShape::of(image);
+    for (auto& bucket : buckets_) {
+        if (bucket.shape == shape) {
+            return bucket;
         }
     }
+    // 形状种类变化（相机切换分辨率）后回收空闲的桶
+    if (buckets_.size() >= 16) {
+        buckets_.erase(std::remove_if(buckets_.begin(), buckets_.end(),
+                                      [](const CollectingBucket& bucket) { return !bucket.batch; }),
+                       buckets_.end());
+    }
+    buckets_.emplace_back();
+    buckets_.back().shape = shape;
+    return buckets_.back();
+}
+
+void BatchBuffer::emit_bucket(CollectingBucket& bucket) {
+    if (!bucket.batch) {
+        return;
+    }
+    move_batch_to_ready(bucket.batch);
+    bucket.batch = nullptr;
+    batches_emitted_++;
 }
 
 void BatchBuffer::move_batch_to_ready(BatchPtr batch) {
@@ -201,7 +304,7 @@ void BatchBuffer::move_batch_to_ready(BatchPtr batch) {
     }
     
     {
-        std::lock_guard<std::mutex> lock(ready_mutex_);
+        std::lock_guard<InstrumentedMutex> lock(ready_mutex_);
         
         // 检查是否会超过限制
         if (ready_batches_.size() >= max_ready_batches_) {
@@ -214,7 +317,15 @@ void BatchBuffer::move_batch_to_ready(BatchPtr batch) {
         ready_batches_.push(batch);
         total_batches_created_.fetch_add(1);
     }
-    ready_cv_.notify_one();
+    if (TraceRecorder::is_enabled()) {
+        // 组批区间：批次创建到进入就绪队列
+        auto age = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::high_resolution_clock::now() - batch->created_time).count();
+        uint64_t end_ns = TraceRecorder::now_ns();
+        uint64_t start_ns = age > 0 && static_cast<uint64_t>(age) < end_ns ? end_ns - age : end_ns;
+        TraceRecorder::complete("batch", "batch.formation", start_ns, end_ns, batch->batch_id);
+    }
+    ready_cv_.notify_all();
     
     // std::cout << "📦 批次 " << batch->batch_id << " 已就绪，包含 " 
     //           << batch->actual_size << " 个图像，队列大小: " 
@@ -223,6 +334,11 @@ void BatchBuffer::move_batch_to_ready(BatchPtr batch) {
 
 // BatchConnector implementation
 
+namespace {
+// 重组产生的批次ID从 2^40 开始，与 BatchBuffer 分配的批次ID区分
+std::atomic<uint64_t> g_next_rebatch_id{1ULL << 40};
+}
+
 BatchConnector::BatchConnector(size_t max_queue_size)
     : max_queue_size_(max_queue_size), running_(false) {
 }
@@ -231,9 +347,21 @@ BatchConnector::~BatchConnector() {
     stop();
 }
 
+void BatchConnector::set_rebatch(size_t target_batch_size, std::chrono::milliseconds flush_timeout) {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    target_batch_size_ = target_batch_size;
+    rebatch_flush_timeout_ = flush_timeout;
+    max_queued_frames_ = max_queue_size_ * std::max(target_batch_size, ImageBatch::BATCH_SIZE);
+}
+
 void BatchConnector::start() {
     running_.store(true);
-    std::cout << "✅ BatchConnector 已启动，最大队列大小: " << max_queue_size_ << std::endl;
+    if (target_batch_size_ > 0) {
+        std::cout << "✅ BatchConnector 已启动，重组为 " << target_batch_size_ << " 帧/批，最多缓存 "
+                  << max_queued_frames_ << " 帧" << std::endl;
+    } else {
+        std::cout << "✅ BatchConnector 已启动，最大队列大小: " << max_queue_size_ << std::endl;
+    }
 }
 
 void BatchConnector::stop() {
@@ -249,31 +377,148 @@ bool BatchConnector::send_batch(BatchPtr batch) {
     
     std::unique_lock<std::mutex> lock(queue_mutex_);
     
-    // 等待队列有空间
-    queue_cv_.wait(lock, [this]() {
-        return batch_queue_.size() < max_queue_size_ || !running_.load();
-    });
+    // 等待队列有空间，只有真正阻塞时才计时（重组时按图像数计容量）
+    auto has_space = [this]() {
+        if (!running_.load()) {
+            return true;
+        }
+        return target_batch_size_ > 0 ? queued_frames_ < max_queued_frames_
+                                      : batch_queue_.size() < max_queue_size_;
+    };
+    if (!has_space()) {
+        uint64_t wait_start = StageProfiler::now_ns();
+        queue_cv_.wait(lock, has_space);
+        uint64_t wait_end = StageProfiler::now_ns();
+        uint64_t waited = wait_end - wait_start;
+        total_send_wait_ns_.fetch_add(waited);
+        StageProfiler::record_output_wait(waited);
+        if (TraceRecorder::is_enabled()) {
+            TraceRecorder::complete("connector", "connector.send_wait", wait_start, wait_end, batch->batch_id);
+        }
+    }
     
     if (!running_.load()) {
         return false;
     }
     
-    batch_queue_.push(batch);
+    if (target_batch_size_ > 0) {
+        enqueue_rebatched(batch);
+    } else {
+        batch_queue_.push(batch);
+    }
     total_sent_.fetch_add(1);
     
     lock.unlock();
-    queue_cv_.notify_one();
+    // 重组可能一次产生多个批次，也可能只是新开了待合并组（接收方需重新计算等待期限）
+    queue_cv_.notify_all();
+    
+    return true;
+}
+
+void BatchConnector::enqueue_rebatched(BatchPtr batch) {
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < batch->actual_size; ++i) {
+        const ImageDataPtr& image = batch->images[i];
+        if (!image) {
+            continue;
+        }
+        BatchShape shape = BatchShape::of(*image);
+        
+        // 该路流换了形状：先发出它在其他组中的图像，保证帧序
+        for (auto& group : pending_groups_) {
+            if (!(group.shape == shape) &&
+                std::find(group.stream_ids.begin(), group.stream_ids.end(), image->stream_id) != group.stream_ids.end()) {
+                emit_group(group);
+            }
+        }
+        
+        auto it = std::find_if(pending_groups_.begin(), pending_groups_.end(),
+                               [&shape](const PendingGroup& group) { return group.shape == shape; });
+        if (it == pending_groups_.end()) {
+            pending_groups_.emplace_back();
+            it = std::prev(pending_groups_.end());
+            it->shape = shape;
+        }
+        PendingGroup& group = *it;
+        if (group.images.empty()) {
+            group.oldest = now;
+            group.created_time = batch->created_time;
+        } else {
+            group.created_time = std::min(group.created_time, batch->created_time);
+        }
+        group.images.push_back(image);
+        if (std::find(group.stream_ids.begin(), group.stream_ids.end(), image->stream_id) == group.stream_ids.end()) {
+            group.stream_ids.push_back(image->stream_id);
+        }
+        queued_frames_++;
+        
+        if (group.images.size() >= target_batch_size_) {
+            emit_group(group);
+        }
+    }
     
+    pending_groups_.erase(std::remove_if(pending_groups_.begin(), pending_groups_.end(),
+                                         [](const PendingGroup& group) { return group.images.empty(); }),
+                          pending_groups_.end());
+}
+
+void BatchConnector::emit_group(PendingGroup& group) {
+    if (group.images.empty()) {
+        return;
+    }
+    auto out = std::make_shared<ImageBatch>(g_next_rebatch_id.fetch_add(1), target_batch_size_);
+    out->shape = group.shape;
+    out->created_time = group.created_time;
+    out->images = std::move(group.images);
+    out->actual_size = out->images.size();
+    batch_queue_.push(out);
+    
+    group.images.clear();
+    group.stream_ids.clear();
+}
+
+bool BatchConnector::flush_expired_group() {
+    if (pending_groups_.empty()) {
+        return false;
+    }
+    auto oldest = std::min_element(pending_groups_.begin(), pending_groups_.end(),
+                                   [](const PendingGroup& a, const PendingGroup& b) { return a.oldest < b.oldest; });
+    if (std::chrono::steady_clock::now() < oldest->oldest + rebatch_flush_timeout_) {
+        return false;
+    }
+    emit_group(*oldest);
+    pending_groups_.erase(oldest);
+    timeout_flushes_.fetch_add(1);
     return true;
 }
 
 bool BatchConnector::receive_batch(BatchPtr& batch) {
     std::unique_lock<std::mutex> lock(queue_mutex_);
     
-    // 等待有批次可用
-    queue_cv_.wait(lock, [this]() {
-        return !batch_queue_.empty() || !running_.load();
-    });
+    // 等待有批次可用（重组时待合并的图像超时也可发出），只有真正阻塞时才计时
+    uint64_t wait_start = 0;
+    while (batch_queue_.empty() && running_.load() && !flush_expired_group()) {
+        if (wait_start == 0) {
+            wait_start = StageProfiler::now_ns();
+        }
+        if (pending_groups_.empty()) {
+            queue_cv_.wait(lock);
+        } else {
+            auto oldest = std::min_element(pending_groups_.begin(), pending_groups_.end(),
+                                           [](const PendingGroup& a, const PendingGroup& b) { return a.oldest < b.oldest; });
+            queue_cv_.wait_until(lock, oldest->oldest + rebatch_flush_timeout_);
+        }
+    }
+    if (wait_start != 0) {
+        uint64_t wait_end = StageProfiler::now_ns();
+        uint64_t waited = wait_end - wait_start;
+        total_receive_wait_ns_.fetch_add(waited);
+        StageProfiler::record_input_wait(waited);
+        if (TraceRecorder::is_enabled()) {
+            int64_t batch_id = batch_queue_.empty() ? -1 : static_cast<int64_t>(batch_queue_.front()->batch_id);
+            TraceRecorder::complete("connector", "connector.receive_wait", wait_start, wait_end, batch_id);
+        }
+    }
     
     if (!running_.load() && batch_queue_.empty()) {
         return false;
@@ -283,9 +528,11 @@ bool BatchConnector::receive_batch(BatchPtr& batch) {
         batch = batch_queue_.front();
         batch_queue_.pop();
         total_received_.fetch_add(1);
+        total_frames_received_.fetch_add(batch->actual_size);
+        queued_frames_ -= std::min(queued_frames_, batch->actual_size);
         
         lock.unlock();
-        queue_cv_.notify_one(); // 通知可能等待发送的线程
+        queue_cv_.notify_all(); // 通知可能等待发送的线程
         
         return true;
     }
@@ -296,13 +543,18 @@ bool BatchConnector::receive_batch(BatchPtr& batch) {
 bool BatchConnector::try_receive_batch(BatchPtr& batch) {
     std::unique_lock<std::mutex> lock(queue_mutex_);
     
+    if (batch_queue_.empty()) {
+        flush_expired_group();
+    }
     if (!batch_queue_.empty()) {
         batch = batch_queue_.front();
         batch_queue_.pop();
         total_received_.fetch_add(1);
+        total_frames_received_.fetch_add(batch->actual_size);
+        queued_frames_ -= std::min(queued_frames_, batch->actual_size);
         
         lock.unlock();
-        queue_cv_.notify_one(); // 通知可能等待发送的线程
+        queue_cv_.notify_all(); // 通知可能等待发送的线程
         
         return true;
     }
@@ -1,4 +1,5 @@
 #include "batch_event_determine.h"
+#include "trace_recorder.h"
 #include "logger_manager.h"
 #include <iostream>
 #include <algorithm>
@@ -103,7 +104,7 @@ bool BatchEventDetermine::process_batch(BatchPtr batch) {
                   });
         
         // 使用批次处理锁确保事件数据一致性
-        std::lock_guard<std::mutex> batch_lock(batch_processing_mutex_);
+        std::lock_guard<InstrumentedMutex> batch_lock(batch_processing_mutex_);
         
         for(auto & image : batch->images) {
             if (!image) {
@@ -111,7 +112,13 @@ bool BatchEventDetermine::process_batch(BatchPtr batch) {
             }
             // 执行事件判定
             perform_event_determination(image);
-            
+            if (event_journal_) {
+                // 批次锁保证 observe() 只有一个调用方（事件日志队列为单生产者）
+                event_journal_->observe(*image);
+            }
+            if (evidence_recorder_) {
+                evidence_recorder_->submit(image);
+            }
         }
         
         // 标记批次完成
@@ -145,6 +152,10 @@ bool BatchEventDetermine::process_batch(BatchPtr batch) {
 }
 
 void BatchEventDetermine::worker_thread_func() {
+    // 绑定剖析器，连接器等待与锁等待自动记入本阶段
+    StageProfiler::ThreadBinding binding(&profiler_);
+    TraceRecorder::set_thread_name(get_stage_name());
+    
     while (running_.load()) {
         BatchPtr batch;
         
@@ -152,7 +163,12 @@ void BatchEventDetermine::worker_thread_func() {
         if (input_connector_->receive_batch(batch)) {
             if (batch) {
                 // 处理批次
-                bool success = process_batch(batch);
+                bool success;
+                {
+                    StageProfiler::BusyScope busy(profiler_, batch->actual_size);
+                    TRACE_SCOPE("stage", "event.process", batch->batch_id, -1);
+                    success = process_batch(batch);
+                }
                 
                 if (success) {
                     // 发送到输出连接器
@@ -174,6 +190,23 @@ std::string BatchEventDetermine::get_stage_name() const {
     return "批次事件判定";
 }
 
+StageProfileSnapshot BatchEventDetermine::get_profile() const {
+    return profiler_.snapshot();
+}
+
+std::vector<ServiceSample> BatchEventDetermine::get_service_samples() const {
+    return profiler_.service_samples();
+}
+
+FrameBufferSet BatchEventDetermine::get_buffer_usage() const {
+    // 应急车道判定读Mask；车道线可视化与取证片段读原图
+    FrameBufferSet usage = static_cast<FrameBufferSet>(FrameBuffer::MASK);
+    if (!lane_show_image_path_.empty() || evidence_recorder_) {
+        usage = usage | FrameBuffer::SOURCE_IMAGE;
+    }
+    return usage;
+}
+
 size_t BatchEventDetermine::get_processed_count() const {
     return processed_batch_count_.load();
 }
@@ -249,7 +282,7 @@ void BatchEventDetermine::perform_event_determination(ImageDataPtr image) {
     // lane_show_image_path_ = "lane_results";
     if(image->frame_idx % 200 == 0 && !lane_show_image_path_.empty()) {
       // 绘制车道线结果
-      cv::Mat show_mat = image->imageMat.clone();
+      cv::Mat show_mat = image->source_bgr().clone();
       drawEmergencyLaneQuarterPoints(show_mat, eRes);
       // 保存车道线结果图像
       std::string filename = lane_show_image_path_ + "/" + std::to_string(image->frame_idx) + ".jpg";
@@ -1,4 +1,6 @@
 #include "batch_mask_postprocess.h"
+#include "trace_recorder.h"
+#include "frame_dedup.h"
 #include "logger_manager.h"
 #include <iostream>
 #include <algorithm>
@@ -13,7 +15,7 @@ BatchMaskPostProcess::BatchMaskPostProcess(int num_threads)
       min_area_threshold_(1000), morphology_kernel_size_(5), roi_expansion_ratio_(0.1) {
     
     // 创建线程池
-    thread_pool_ = std::make_unique<ThreadPool>(num_threads_);
+    thread_pool_ = std::make_unique<ThreadPool>(num_threads_, &profiler_);
     
     // 创建输入输出连接器
     input_connector_ = std::make_unique<BatchConnector>(10);
@@ -174,6 +176,10 @@ bool BatchMaskPostProcess::process_batch_with_threadpool(BatchPtr batch) {
 }
 
 void BatchMaskPostProcess::worker_thread_func() {
+    // 绑定剖析器，连接器等待与锁等待自动记入本阶段
+    StageProfiler::ThreadBinding binding(&profiler_);
+    TraceRecorder::set_thread_name(get_stage_name());
+    
     while (running_.load()) {
         BatchPtr batch;
         
@@ -181,7 +187,12 @@ void BatchMaskPostProcess::worker_thread_func() {
         if (input_connector_->receive_batch(batch)) {
             if (batch) {
                 // 处理批次
-                bool success = process_batch(batch);
+                bool success;
+                {
+                    StageProfiler::BusyScope busy(profiler_, batch->actual_size);
+                    TRACE_SCOPE("stage", "mask.process", batch->batch_id, -1);
+                    success = process_batch(batch);
+                }
                 
                 if (success) {
                     // 发送到输出连接器
@@ -199,6 +210,17 @@ void BatchMaskPostProcess::worker_thread_func() {
 }
 
 void BatchMaskPostProcess::process_image_mask(ImageDataPtr image) {
+    // 重复帧：直接共享参考帧的Mask与ROI（下游只读）
+    if (ImageDataPtr reference = FrameDeduplicator::reusable_reference(
+            image, &ImageData::mask_postprocess_completed)) {
+        if (!reference->mask.empty()) {
+            image->mask = reference->mask;
+            image->roi = reference->roi;
+            image->mask_postprocess_completed = true;
+            return;
+        }
+    }
+    
     if (!image || image->label_map.empty()) {
         LOG_ERROR("⚠️ 图像或label_map为空，跳过Mask后处理");
         image->roi = cv::Rect(0, 0, image->width, image->height);
@@ -244,6 +266,18 @@ std::string BatchMaskPostProcess::get_stage_name() const {
     return "批次Mask后处理";
 }
 
+StageProfileSnapshot BatchMaskPostProcess::get_profile() const {
+    return profiler_.snapshot();
+}
+
+std::vector<ServiceSample> BatchMaskPostProcess::get_service_samples() const {
+    return profiler_.service_samples();
+}
+
+FrameBufferSet BatchMaskPostProcess::get_buffer_usage() const {
+    return FrameBuffer::LABEL_MAP | FrameBuffer::MASK;
+}
+
 size_t BatchMaskPostProcess::get_processed_count() const {
     return processed_batch_count_.load();
 }
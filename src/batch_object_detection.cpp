@@ -1,4 +1,7 @@
 #include "batch_object_detection.h"
+#include "trace_recorder.h"
+#include "frame_dedup.h"
+#include "motion_gate.h"
 #include "logger_manager.h"
 #include <iostream>
 #include <algorithm>
@@ -23,6 +26,13 @@ BatchObjectDetection::BatchObjectDetection(int num_threads, const PipelineConfig
     input_connector_ = std::make_unique<BatchConnector>(10);
     output_connector_ = std::make_unique<BatchConnector>(10);
     
+    // 创建运动门控
+    if (config_.enable_motion_gate) {
+        motion_gate_ = std::make_unique<MotionGate>();
+        update_motion_gate_config(config_);
+        LOG_INFO("✅ 运动门控已启用，无运动帧将复用检测结果");
+    }
+    
     // 初始化CUDA
     try {
         cv::cuda::getCudaEnabledDeviceCount();
@@ -35,9 +45,17 @@ BatchObjectDetection::BatchObjectDetection(int num_threads, const PipelineConfig
         LOG_INFO("⚠️ 未检测到CUDA设备，批次目标检测将使用CPU");
     }
     
-    // 初始化检测模型
-    if (!initialize_detection_models()) {
-        LOG_ERROR("❌ 批次目标检测模型初始化失败");
+    // 初始化检测模型：cpu 模式不加载 TensorRT 模型
+    InferenceMode mode = InferenceScheduler::parse_mode(config_.inference_mode);
+    scheduler_ = std::make_unique<InferenceScheduler>(get_stage_name(), mode, 2.0, 40.0, &profiler_);
+    if (mode != InferenceMode::CPU_ONLY) {
+        if (!initialize_detection_models()) {
+            LOG_ERROR("❌ 批次目标检测模型初始化失败");
+        }
+        scheduler_->set_backend_available(InferenceBackend::GPU, !car_detect_instances_.empty());
+    }
+    if (mode != InferenceMode::GPU_ONLY) {
+        scheduler_->set_backend_available(InferenceBackend::CPU, initialize_cpu_detection_model());
     }
 }
 
@@ -116,38 +134,86 @@ bool BatchObjectDetection::process_batch(BatchPtr batch) {
     try {
         // 将图像分配给不同线程处理
         std::vector<cv::Mat> crop_images;
+        std::vector<ImageDataPtr> infer_images;
+        std::vector<ImageDataPtr> reuse_images;
         crop_images.reserve(batch->actual_size);
-        for(int i = 0;i<batch->actual_size; ++i) {
+        infer_images.reserve(batch->actual_size);
+        
+        // 运动门控需按帧序号顺序决策
+        std::vector<size_t> order(batch->actual_size);
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        if (motion_gate_) {
+            std::sort(order.begin(), order.end(), [&batch](size_t a, size_t b) {
+                const auto& ia = batch->images[a];
+                const auto& ib = batch->images[b];
+                if (!ia || !ib) return static_cast<bool>(ia);
+                return ia->frame_idx < ib->frame_idx;
+            });
+        }
+        
+        for (size_t i : order) {
             if (batch->images[i]) {
                 auto& image = batch->images[i];
-                if (image->imageMat.empty()) {
+                // 重复帧：参考帧检测已完成时直接继承检测结果，不进入推理批次
+                if (ImageDataPtr reference = FrameDeduplicator::reusable_reference(
+                        image, &ImageData::detection_completed)) {
+                    // 检测框坐标相对于ROI，ROI需与参考帧保持一致
+                    image->roi = reference->roi;
+                    image->detection_results = reference->detection_results;
+                    image->detection_completed = true;
+                    dedup_reused_frames_.fetch_add(1);
+                    continue;
+                }
+                if (!image->has_source()) {
                     std::cerr << "❌ 图像 " << image->frame_idx << " 为空，跳过处理" << std::endl;
                     continue;
                 }
-                // 进行裁剪
-                cv::Mat crop_image = image->imageMat(image->roi);
+                if (motion_gate_) {
+                    MotionGate::Decision decision = motion_gate_->decide(image);
+                    if (decision.schedule == DetectSchedule::REUSE) {
+                        // 锚点帧不在本批次且检测未完成（如所在批次失败）时回退为完整检测
+                        const ImageDataPtr& anchor = decision.anchor;
+                        bool anchor_pending = std::find(infer_images.begin(), infer_images.end(), anchor) != infer_images.end();
+                        if (!anchor_pending && !anchor->detection_completed.load(std::memory_order_acquire)) {
+                            decision.schedule = DetectSchedule::FULL;
+                            decision.anchor.reset();
+                        }
+                    }
+                    // 按最终决策更新锚点：回退为完整检测的帧成为新锚点，不计入复用
+                    motion_gate_->commit(image, decision);
+                    if (decision.schedule == DetectSchedule::REUSE) {
+                        reuse_images.push_back(image);
+                        continue;
+                    }
+                }
+                // 进行裁剪（YUV 原图只转换ROI区域）
+                cv::Mat crop_image = image->source_region(image->roi);
                 crop_images.push_back(crop_image);
+                infer_images.push_back(image);
             }
         }
-        std::vector<detect_result_group_t> car_outs(crop_images.size());
-        std::vector<detect_result_group_t*> car_out_ptrs;
-        car_out_ptrs.reserve(crop_images.size());
-        for (auto& out : car_outs) {
-            car_out_ptrs.push_back(&out);
-        }
-        auto start_time1 = std::chrono::high_resolution_clock::now();
-        car_detect_instances_[0]->forward(crop_images, car_out_ptrs.data());
-        auto end_time1 = std::chrono::high_resolution_clock::now();
-        auto duration1 = std::chrono::duration_cast<std::chrono::milliseconds>(end_time1 - start_time1);
-        std::cout << "目标检测耗时: " 
-                  << duration1.count() << " ms，实际图像数量: " 
-                  << batch->actual_size << std::endl;
-        for(size_t i = 0; i < batch->images.size(); ++i) {
-            auto& image = batch->images[i];
-            cv::Mat crop_image = crop_images[i];
-            if (image && car_out_ptrs[i]) {
-                for (int j = 0; j < car_out_ptrs[i]->count; ++j) {
-                    auto& result = car_out_ptrs[i]->results[j];
+        TRACE_INSTANT("stage", "detect.scheduled", batch->batch_id, static_cast<int64_t>(crop_images.size()));
+        // 按微批次分配到 GPU / CPU 后端，检测框统一写入 boxes（坐标相对于ROI）
+        std::vector<std::vector<ImageData::BoundingBox>> boxes(crop_images.size());
+        auto run_gpu = [&](const std::vector<size_t>& items) -> bool {
+            std::vector<cv::Mat> gpu_crops;
+            gpu_crops.reserve(items.size());
+            for (size_t k : items) {
+                gpu_crops.push_back(crop_images[k]);
+            }
+            std::vector<detect_result_group_t> car_outs(gpu_crops.size());
+            std::vector<detect_result_group_t*> car_out_ptrs;
+            car_out_ptrs.reserve(gpu_crops.size());
+            for (auto& out : car_outs) {
+                car_out_ptrs.push_back(&out);
+            }
+            car_detect_instances_[0]->forward(gpu_crops, car_out_ptrs.data());
+            for (size_t j = 0; j < items.size(); ++j) {
+                auto& image_boxes = boxes[items[j]];
+                for (int r = 0; r < car_out_ptrs[j]->count; ++r) {
+                    auto& result = car_out_ptrs[j]->results[r];
                     ImageData::BoundingBox box;
                     // box.left = result.box.left + image->roi.x;
                     // box.top = result.box.top + image->roi.y;
@@ -161,24 +227,69 @@ bool BatchObjectDetection::process_batch(BatchPtr batch) {
                     box.confidence = result.prop;
                     box.class_id = result.cls_id;
                     box.track_id = result.track_id;
-                    // std::cout << "检测到目标: "
-                    //           << "类ID: " << result.cls_id
-                    //           << ", 置信度: " << result.prop
-                    //           << ", 位置: (" << box.left << ", " << box.top 
-                    //           << ") - (" << box.right << ", " << box.bottom << ")" 
-                    //           << std::endl;
                     // box.is_still = result.is_still;
                     // box.status = static_cast<ObjectStatus>(result.status);
-                    image->detection_results.push_back(box);
-                    // cv::rectangle(image->imageMat,
-                    //             cv::Point(box.left, box.top), 
-                    //             cv::Point(box.right, box.bottom), 
-                    //             cv::Scalar(255, 0, 0), 2);
+                    image_boxes.push_back(box);
                 }
+            }
+            return true;
+        };
+        auto run_cpu = [&](size_t begin, size_t end) -> bool {
+            std::vector<cv::Mat> cpu_crops(crop_images.begin() + begin, crop_images.begin() + end);
+            std::vector<std::vector<ImageData::BoundingBox>> cpu_boxes;
+            if (!cpu_det_model_->infer(cpu_crops, cpu_boxes)) {
+                return false;
+            }
+            for (size_t j = 0; j < cpu_boxes.size(); ++j) {
+                boxes[begin + j] = std::move(cpu_boxes[j]);
+            }
+            return true;
+        };
+        if (!crop_images.empty()) {
+            TRACE_SCOPE("stage", "detect.inference", batch->batch_id, -1);
+            auto start_time1 = std::chrono::high_resolution_clock::now();
+            bool inference_success = scheduler_->run(crop_images.size(), static_cast<size_t>(config_.infer_micro_batch),
+                                                     run_gpu, run_cpu);
+            auto end_time1 = std::chrono::high_resolution_clock::now();
+            auto duration1 = std::chrono::duration_cast<std::chrono::milliseconds>(end_time1 - start_time1);
+            std::cout << "目标检测耗时: " 
+                      << duration1.count() << " ms，推理图像数量: " 
+                      << crop_images.size() << "/" << batch->actual_size << std::endl;
+            if (!inference_success) {
+                std::cerr << "❌ 批次 " << batch->batch_id << " 目标检测推理失败" << std::endl;
+                return false;
+            }
+        }
+        TRACE_SCOPE("stage", "detect.postprocess", batch->batch_id, -1);
+        for(size_t i = 0; i < infer_images.size(); ++i) {
+            auto& image = infer_images[i];
+            if (image) {
+                image->detection_results.insert(image->detection_results.end(), boxes[i].begin(), boxes[i].end());
                 // 标记检测完成
                 image->detection_completed = true;
             }
-            // cv::imwrite("batch_outs/batch_" + std::to_string(batch->batch_id) + "_img_" + std::to_string(i) + ".jpg", image->imageMat);
+        }
+        // 无运动帧：复用锚点帧检测结果（ROI平移时同步平移检测框）；
+        // 内置跟踪器在跟踪阶段以卡尔曼预测推进这些帧，不把复用的检测框当作新观测
+        for (auto& image : reuse_images) {
+            const ImageDataPtr& anchor = image->detect_anchor;
+            int dx = anchor->roi.x - image->roi.x;
+            int dy = anchor->roi.y - image->roi.y;
+            image->detection_results = anchor->detection_results;
+            for (auto& box : image->detection_results) {
+                box.left += dx;
+                box.right += dx;
+                box.top += dy;
+                box.bottom += dy;
+            }
+            image->detection_completed = true;
+        }
+        // 检测阶段之后不再需要参考帧，及时释放引用以免延长参考帧图像的生命周期
+        for (size_t i = 0; i < batch->actual_size; ++i) {
+            if (batch->images[i]) {
+                batch->images[i]->detect_anchor.reset();
+                batch->images[i]->dedup_reference.reset();
+            }
         }
         // 标记批次完成
         batch->detection_completed.store(true);
@@ -204,6 +315,10 @@ bool BatchObjectDetection::process_batch(BatchPtr batch) {
 }
 
 void BatchObjectDetection::worker_thread_func() {
+    // 绑定剖析器，连接器等待与锁等待自动记入本阶段
+    StageProfiler::ThreadBinding binding(&profiler_);
+    TraceRecorder::set_thread_name(get_stage_name());
+    
     while (running_.load()) {
         BatchPtr batch;
         
@@ -211,7 +326,12 @@ void BatchObjectDetection::worker_thread_func() {
         if (input_connector_->receive_batch(batch)) {
             if (batch) {
                 // 处理批次
-                bool success = process_batch(batch);
+                bool success;
+                {
+                    StageProfiler::BusyScope busy(profiler_, batch->actual_size);
+                    TRACE_SCOPE("stage", "detect.process", batch->batch_id, -1);
+                    success = process_batch(batch);
+                }
                 
                 if (success) {
                     // 发送到输出连接器
@@ -247,7 +367,7 @@ void BatchObjectDetection::process_image_detection(ImageDataPtr image, int threa
 }
 
 void BatchObjectDetection::perform_object_detection(ImageDataPtr image, int thread_id) {
-    if (!image || image->imageMat.empty()) {
+    if (!image || !image->has_source()) {
         return;
     }
     
@@ -307,14 +427,67 @@ bool BatchObjectDetection::initialize_detection_models() {
     return true;
 }
 
+bool BatchObjectDetection::initialize_cpu_detection_model() {
+    CpuDetectionModel::Params params;
+    params.input_size = config_.det_img_size;
+    params.conf_threshold = config_.det_conf_thresh;
+    params.nms_threshold = config_.det_iou_thresh;
+    params.ultralytics = config_.det_is_ultralytics != 0;
+    std::string model_path = config_.cpu_det_model_path.empty() ? config_.car_det_model_path : config_.cpu_det_model_path;
+    cpu_det_model_ = std::make_unique<CpuDetectionModel>(model_path, config_.cpu_infer_threads, params);
+    if (!cpu_det_model_->load()) {
+        std::cerr << "❌ CPU车辆检测模型初始化失败: " << model_path << std::endl;
+        cpu_det_model_.reset();
+        return false;
+    }
+    std::cout << "✅ CPU车辆检测模型初始化成功，推理线程 " << cpu_det_model_->get_thread_count() << std::endl;
+    return true;
+}
+
 void BatchObjectDetection::cleanup_detection_models() {
 }
 
+void BatchObjectDetection::update_motion_gate_config(const PipelineConfig& config) {
+    if (!motion_gate_) {
+        return;
+    }
+    MotionGateConfig gate_config;
+    gate_config.thumb_width = std::max(16, config.motion_gate_thumb_width);
+    gate_config.thumb_height = std::max(9, config.motion_gate_thumb_height);
+    gate_config.pixel_threshold = config.motion_pixel_threshold;
+    gate_config.motion_area_ratio = config.motion_area_ratio;
+    gate_config.refresh_interval = std::max(1, config.motion_refresh_interval);
+    motion_gate_->set_config(gate_config);
+}
+
+BatchObjectDetection::MotionGateStats BatchObjectDetection::get_motion_gate_stats() const {
+    MotionGateStats stats;
+    if (motion_gate_) {
+        stats.full_frames = motion_gate_->get_full_count();
+        stats.reuse_frames = motion_gate_->get_reuse_count();
+        stats.refresh_frames = motion_gate_->get_refresh_count();
+    }
+    return stats;
+}
+
 // BatchStage接口实现
 std::string BatchObjectDetection::get_stage_name() const {
     return "批次目标检测";
 }
 
+StageProfileSnapshot BatchObjectDetection::get_profile() const {
+    return profiler_.snapshot();
+}
+
+std::vector<ServiceSample> BatchObjectDetection::get_service_samples() const {
+    return profiler_.service_samples();
+}
+
+FrameBufferSet BatchObjectDetection::get_buffer_usage() const {
+    // 按ROI裁剪原图（运动门控同样读原图）
+    return static_cast<FrameBufferSet>(FrameBuffer::SOURCE_IMAGE);
+}
+
 size_t BatchObjectDetection::get_processed_count() const {
     return processed_batch_count_.load();
 }
@@ -1,28 +1,40 @@
 #include "batch_object_tracking.h"
+#include "trace_recorder.h"
 #include "logger_manager.h"
 #include <iostream>
 #include <algorithm>
+#include <cmath>
 // #include <execution>
 #include <opencv2/imgproc.hpp>
 #include <future>
 
 
 BatchObjectTracking::BatchObjectTracking(int num_threads, const PipelineConfig* config)
-    : num_threads_(num_threads), running_(false), stop_requested_(false),
-      tracking_confidence_threshold_(0.3f), max_disappeared_frames_(10), 
-      iou_threshold_(0.3f), next_track_id_(1) {
+    : num_threads_(num_threads), running_(false), stop_requested_(false) {
     
     // 初始化配置
     if (config) {
         config_ = *config;
-        // tracking_confidence_threshold_ = config->tracking_confidence_threshold;
-        // max_disappeared_frames_ = config->max_disappeared_frames;
-        // iou_threshold_ = config->tracking_iou_threshold;
     }
-    track_instances_.reserve(num_threads_);
-    auto track_instance = xtkj::createTracker(30, 30, 0.5, 0.6, 0.8);
-    track_instance->init(30, 30, 0.5, 0.6, 0.8);
-    track_instances_.push_back(std::unique_ptr<xtkj::ITracker>(track_instance));
+    if (config_.use_builtin_tracker) {
+        TrackerConfig tracker_config;
+        tracker_config.frame_rate = config_.tracker_frame_rate;
+        tracker_config.track_buffer = config_.tracker_buffer_frames;
+        tracker_config.track_thresh = config_.tracker_track_thresh;
+        tracker_config.high_thresh = config_.tracker_high_thresh;
+        tracker_config.match_thresh = config_.tracker_match_thresh;
+        builtin_tracker_ = std::make_unique<MultiObjectTracker>(tracker_config);
+        LOG_INFO("✅ 使用内置多目标跟踪器");
+    } else {
+        track_instances_.reserve(num_threads_);
+        auto track_instance = xtkj::createTracker(config_.tracker_frame_rate, config_.tracker_buffer_frames,
+                                                  config_.tracker_track_thresh, config_.tracker_high_thresh,
+                                                  config_.tracker_match_thresh);
+        track_instance->init(config_.tracker_frame_rate, config_.tracker_buffer_frames,
+                             config_.tracker_track_thresh, config_.tracker_high_thresh,
+                             config_.tracker_match_thresh);
+        track_instances_.push_back(std::unique_ptr<xtkj::ITracker>(track_instance));
+    }
     vehicle_parking_instance_ = createVehicleParkingDetectOptimized();
     // 初始化车辆停车检测参数
     VehicleParkingInitParams parkingParams;
@@ -37,6 +49,18 @@ BatchObjectTracking::BatchObjectTracking(int num_threads, const PipelineConfig*
     parkingParams.RANSAC_THRESHOLD = 3.0;
     parkingParams.MIN_INLIERS = 80;
     vehicle_parking_instance_->init(parkingParams);
+    stillness_detector_ = std::make_unique<TrackStillnessDetector>();
+    update_stillness_config(config_);
+    if (!config_.track_record_path.empty()) {
+        track_record_file_.open(config_.track_record_path, std::ios::out | std::ios::trunc);
+        if (track_record_file_.is_open()) {
+            track_record_file_ << "frame_idx,stream_id,parking_width,parking_height,method,"
+                                  "track_id,cls_id,confidence,x,y,w,h,is_still\n";
+            LOG_INFO_F("📝 跟踪框记录到: %s", config_.track_record_path.c_str());
+        } else {
+            LOG_WARN_F("⚠️ 无法打开跟踪框记录文件: %s", config_.track_record_path.c_str());
+        }
+    }
     // 创建输入输出连接器
     input_connector_ = std::make_unique<BatchConnector>(10);
     output_connector_ = std::make_unique<BatchConnector>(10);
@@ -128,11 +152,12 @@ bool BatchObjectTracking::process_batch(BatchPtr batch) {
                   });
         
         // 使用批次处理锁确保轨迹数据一致性
-        std::lock_guard<std::mutex> batch_lock(batch_processing_mutex_);
+        std::lock_guard<InstrumentedMutex> batch_lock(batch_processing_mutex_);
         
         // 逐帧处理跟踪（保持时序）
         for (size_t i = 0; i < batch->actual_size; ++i) {
             int thread_id = i % num_threads_;
+            TRACE_SCOPE("stage", "track.frame", batch->batch_id, static_cast<int64_t>(batch->images[i]->frame_idx));
             process_image_tracking(batch->images[i], thread_id);
         }
         
@@ -161,6 +186,10 @@ bool BatchObjectTracking::process_batch(BatchPtr batch) {
 }
 
 void BatchObjectTracking::worker_thread_func() {
+    // 绑定剖析器，连接器等待与锁等待自动记入本阶段
+    StageProfiler::ThreadBinding binding(&profiler_);
+    TraceRecorder::set_thread_name(get_stage_name());
+    
     while (running_.load()) {
         BatchPtr batch;
         
@@ -168,7 +197,12 @@ void BatchObjectTracking::worker_thread_func() {
         if (input_connector_->receive_batch(batch)) {
             if (batch) {
                 // 处理批次
-                bool success = process_batch(batch);
+                bool success;
+                {
+                    StageProfiler::BusyScope busy(profiler_, batch->actual_size);
+                    TRACE_SCOPE("stage", "track.process", batch->batch_id, -1);
+                    success = process_batch(batch);
+                }
                 
                 if (success) {
                     // 发送到输出连接器
@@ -204,12 +238,13 @@ void BatchObjectTracking::process_image_tracking(ImageDataPtr image, int thread_
 }
 
 void BatchObjectTracking::perform_object_tracking(ImageDataPtr image, int thread_id) {
-    if (!image || image->imageMat.empty()) {
+    // 原图可能已在检测后释放，按尺寸判断
+    if (!image || image->width <= 0 || image->height <= 0) {
         return;
     }
     
     // 检查线程ID是否有效
-    if (thread_id < 0 || thread_id >= track_instances_.size()) {
+    if (!builtin_tracker_ && (thread_id < 0 || thread_id >= static_cast<int>(track_instances_.size()))) {
         std::cerr << "❌ 无效的跟踪线程ID: " << thread_id << std::endl;
         return;
     }
@@ -239,21 +274,29 @@ void BatchObjectTracking::perform_object_tracking(ImageDataPtr image, int thread
             out->results[out->count++] = result;
         }
         // auto start_time = std::chrono::high_resolution_clock::now();
-        track_instances_[0]->track(out, image->roi.width,
-                                            image->roi.height);
+        if (builtin_tracker_ && image->detect_schedule == DetectSchedule::REUSE) {
+            // 复用的检测框来自锚点帧，不是本帧的观测；外部跟踪库没有预测接口，仍以复用框跟踪
+            coast_with_builtin(image, out);
+        } else if (builtin_tracker_) {
+            track_with_builtin(image, out);
+        } else {
+            track_instances_[0]->track(out, image->roi.width,
+                                                image->roi.height);
+        }
         // auto end_time = std::chrono::high_resolution_clock::now();
         // auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
         // std::cout << "🎯 目标跟踪耗时: " << duration.count() << " ms" << std::endl;
         image->track_results.clear();
         std::vector<TrackBox> track_boxes;
+        const cv::Size parking_size = parking_image_size(*image);
         for (int i = 0; i < out->count; ++i) {
             detect_result_t &result = out->results[i];
             // 这里的box是resize后的坐标，需要转换回原图像坐标系
             TrackBox box = TrackBox(result.track_id, 
-                                        cv::Rect((result.box.left + image->roi.x) * image->parkingResizeMat.cols / image->width, 
-                                        (result.box.top + image->roi.y) * image->parkingResizeMat.rows / image->height,
-                                        (result.box.right - result.box.left) * image->parkingResizeMat.cols / image->width,
-                                        (result.box.bottom - result.box.top) * image->parkingResizeMat.rows / image->height),
+                                        cv::Rect((result.box.left + image->roi.x) * parking_size.width / image->width, 
+                                        (result.box.top + image->roi.y) * parking_size.height / image->height,
+                                        (result.box.right - result.box.left) * parking_size.width / image->width,
+                                        (result.box.bottom - result.box.top) * parking_size.height / image->height),
                                         result.cls_id, 
                                         result.prop, 
                                         false, 0.0);
@@ -289,7 +332,7 @@ void BatchObjectTracking::perform_object_tracking(ImageDataPtr image, int thread
         // cv::imwrite("imageMat.png", image->imageMat);
         // exit(0);
         // start_time = std::chrono::high_resolution_clock::now();
-        vehicle_parking_instance_->detect(image->parkingResizeMat, track_boxes);
+        determine_stillness(image, track_boxes);
         
         // end_time = std::chrono::high_resolution_clock::now();
         // duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
@@ -309,10 +352,10 @@ void BatchObjectTracking::perform_object_tracking(ImageDataPtr image, int thread
         for(const auto &track_box : track_boxes) {
           ImageData::BoundingBox box;
           box.track_id = track_box.track_id;
-          box.left = track_box.box.x * image->width / image->parkingResizeMat.cols;
-          box.top = track_box.box.y * image->height / image->parkingResizeMat.rows;
-          box.right = (track_box.box.x + track_box.box.width) * image->width / image->parkingResizeMat.cols;
-          box.bottom = (track_box.box.y + track_box.box.height) * image->height / image->parkingResizeMat.rows;
+          box.left = track_box.box.x * image->width / parking_size.width;
+          box.top = track_box.box.y * image->height / parking_size.height;
+          box.right = (track_box.box.x + track_box.box.width) * image->width / parking_size.width;
+          box.bottom = (track_box.box.y + track_box.box.height) * image->height / parking_size.height;
           box.confidence = track_box.confidence;
           box.class_id = track_box.cls_id;
           box.is_still = track_box.is_still;
@@ -326,6 +369,110 @@ void BatchObjectTracking::perform_object_tracking(ImageDataPtr image, int thread
 }
 
 
+void BatchObjectTracking::track_with_builtin(const ImageDataPtr& image, detect_result_group_t* out) {
+    std::vector<TrackedObject> objects;
+    objects.reserve(out->count);
+    for (int i = 0; i < out->count; ++i) {
+        const detect_result_t& result = out->results[i];
+        TrackedObject object;
+        object.left = static_cast<float>(result.box.left);
+        object.top = static_cast<float>(result.box.top);
+        object.right = static_cast<float>(result.box.right);
+        object.bottom = static_cast<float>(result.box.bottom);
+        object.score = result.prop;
+        object.cls_id = result.cls_id;
+        object.index = i;
+        objects.push_back(object);
+    }
+    builtin_tracker_->update(image->stream_id, objects);
+
+    // 输出目标保持原检测顺序，原地压缩即可
+    int count = 0;
+    for (const auto& object : objects) {
+        detect_result_t result = out->results[object.index];
+        result.track_id = object.track_id;
+        out->results[count++] = result;
+    }
+    out->count = count;
+}
+
+void BatchObjectTracking::coast_with_builtin(const ImageDataPtr& image, detect_result_group_t* out) {
+    std::vector<TrackedObject> objects;
+    builtin_tracker_->coast(image->stream_id, objects);
+
+    const int capacity = static_cast<int>(sizeof(out->results) / sizeof(out->results[0]));
+    out->count = 0;
+    for (const auto& object : objects) {
+        if (out->count >= capacity) {
+            break;
+        }
+        detect_result_t result;
+        result.cls_id = object.cls_id;
+        result.box.left = static_cast<int>(std::lround(object.left));
+        result.box.top = static_cast<int>(std::lround(object.top));
+        result.box.right = static_cast<int>(std::lround(object.right));
+        result.box.bottom = static_cast<int>(std::lround(object.bottom));
+        result.prop = object.score;
+        result.track_id = object.track_id;
+        out->results[out->count++] = result;
+    }
+}
+
+void BatchObjectTracking::determine_stillness(const ImageDataPtr& image, std::vector<TrackBox>& track_boxes) {
+    // 固定机位直接由轨迹框位移判定；检测到相机运动时才需要特征点自运动估计
+    // 帧来源可按流覆盖检测器的配置（同一实例中固定机位与云台相机混接）
+    bool use_feature = true;
+    bool enabled = image->track_stillness < 0 ? track_stillness_enabled_.load() : image->track_stillness > 0;
+    if (enabled) {
+        use_feature = stillness_detector_->update(image->stream_id, track_boxes, image->camera_motion.moving);
+    } else {
+        // 关闭期间的轨迹历史已过期，重新开启时重新累积
+        stillness_detector_->reset_stream(image->stream_id);
+    }
+    // 违停缩放图只在需要特征点判定时计算
+    const cv::Size parking_size = parking_image_size(*image);
+    if (use_feature && config_.enable_parking_detection) {
+        if (image->parkingResizeMat.empty()) {
+            image->parkingResizeMat = image->derived(DerivedImageKey(parking_size));
+        }
+        if (!image->parkingResizeMat.empty()) {
+            vehicle_parking_instance_->detect(image->parkingResizeMat, track_boxes);
+        }
+    }
+
+    if (track_record_file_.is_open()) {
+        for (const auto& track_box : track_boxes) {
+            track_record_file_ << image->frame_idx << ',' << image->stream_id << ','
+                               << parking_size.width << ',' << parking_size.height << ','
+                               << (use_feature ? "feature" : "history") << ','
+                               << track_box.track_id << ',' << track_box.cls_id << ',' << track_box.confidence << ','
+                               << track_box.box.x << ',' << track_box.box.y << ','
+                               << track_box.box.width << ',' << track_box.box.height << ','
+                               << (track_box.is_still ? 1 : 0) << '\n';
+        }
+    }
+}
+
+void BatchObjectTracking::update_stillness_config(const PipelineConfig& config) {
+    StillnessConfig stillness_config;
+    stillness_config.history_frames = std::max(3, config.stillness_history_frames);
+    stillness_config.min_history_frames = std::max(3, stillness_config.history_frames * 2 / 5);
+    stillness_config.still_displacement_ratio = config.stillness_displacement_ratio;
+    stillness_config.camera_motion_hold_frames = std::max(1, config.stillness_camera_hold_frames);
+    stillness_detector_->set_config(stillness_config);
+
+    // 关闭期间各流的轨迹历史由 determine_stillness 逐流清除
+    track_stillness_enabled_.store(config.enable_track_stillness);
+}
+
+BatchObjectTracking::StillnessStats BatchObjectTracking::get_stillness_stats() const {
+    StillnessStats stats;
+    stats.history_frames = stillness_detector_->get_history_frames();
+    stats.feature_frames = stillness_detector_->get_feature_frames();
+    stats.camera_motion_events = stillness_detector_->get_camera_motion_events();
+    return stats;
+}
+
 bool BatchObjectTracking::initialize_tracking_models() {
     // track_instances_.clear();
     // track_instances_.reserve(num_threads_);
@@ -366,6 +513,33 @@ std::string BatchObjectTracking::get_stage_name() const {
     return "批次目标跟踪";
 }
 
+StageProfileSnapshot BatchObjectTracking::get_profile() const {
+    return profiler_.snapshot();
+}
+
+std::vector<ServiceSample> BatchObjectTracking::get_service_samples() const {
+    return profiler_.service_samples();
+}
+
+FrameBufferSet BatchObjectTracking::get_buffer_usage() const {
+    // 违停检测按需从原图生成缩放图
+    if (!config_.enable_parking_detection) {
+        return FRAME_BUFFERS_NONE;
+    }
+    return FrameBuffer::SOURCE_IMAGE | FrameBuffer::PARKING_INPUT;
+}
+
+cv::Size BatchObjectTracking::parking_image_size(const ImageData& image) {
+    // 违停检测输入长边缩放到640
+    int max_dim = std::max(image.width, image.height);
+    if (max_dim <= 0) {
+        return cv::Size(1, 1);
+    }
+    double scale = 640.0 / max_dim;
+    return cv::Size(std::max(1, static_cast<int>(image.width * scale)),
+                    std::max(1, static_cast<int>(image.height * scale)));
+}
+
 size_t BatchObjectTracking::get_processed_count() const {
     return processed_batch_count_.load();
 }
@@ -1,8 +1,11 @@
 #include "batch_pipeline_manager.h"
+#include "trace_recorder.h"
 #include "logger_manager.h"
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 #include <future>
+#include <limits>
 #include <queue>
 
 BatchPipelineManager::BatchPipelineManager(const PipelineConfig& config)
@@ -11,15 +14,50 @@ BatchPipelineManager::BatchPipelineManager(const PipelineConfig& config)
     
     LOG_INFO("初始化批次流水线管理器...");
     
-    // 创建批次收集器，设置就绪队列限制为50个批次
+    // 流水线结构（阶段、线程数、队列容量）统一由拓扑描述给出，仿真器使用同一份描述
+    topology_ = PipelineTopology::from_config(config_);
+    
+    // 创建批次收集器，就绪队列容量即背压阈值
     // 这样可以防止语义分割模块处理慢时内存无限增长
     input_buffer_ = std::make_unique<BatchBuffer>(
-        std::chrono::milliseconds(10000),  // 100ms超时刷新
-        1                               // 最多50个就绪批次，实现背压
+        std::chrono::milliseconds(topology_.flush_timeout_ms),
+        topology_.max_ready_batches,
+        config_.batch_by_shape,
+        static_cast<size_t>(std::max(0, config_.batch_max_bypass)),
+        topology_.batch_size
     );
     
+    // 进程级在途内存预算：所有检测器实例共享同一限额（取各实例配置的最大值），
+    // 本流水线运行期间在其中保留均分的配额
+    memory_account_ = MemoryBudget::global()->open_account("pipeline");
+    if (config_.memory_budget_mb > 0) {
+        MemoryBudget::global()->raise_limit(static_cast<size_t>(config_.memory_budget_mb) * 1024 * 1024);
+        LOG_INFO_F("✅ 在途内存预算: 进程限额 %zu MB",
+                   MemoryBudget::global()->get_limit() / (1024 * 1024));
+    }
+    
     // 创建结果连接器
-    final_result_connector_ = std::make_unique<BatchConnector>(20); // 允许更多批次排队
+    final_result_connector_ = std::make_unique<BatchConnector>(topology_.result_capacity);
+    
+    // 创建相机运动估计器，先于近重复帧消除执行，两者共用亮度金字塔
+    if (config_.enable_camera_motion) {
+        camera_motion_ = std::make_unique<CameraMotionEstimator>();
+        update_camera_motion_config(config_);
+        LOG_INFO("✅ 相机运动估计已启用");
+    }
+    
+    // 硬件计数器在各工作线程首次进入处理区间时按线程打开
+    HwPerfCounters::set_enabled(config_.enable_perf_counters);
+    if (config_.enable_perf_counters) {
+        LOG_INFO("✅ 阶段硬件性能计数器已启用");
+    }
+    
+    // 创建近重复帧消除器
+    if (config_.enable_frame_dedup) {
+        frame_dedup_ = std::make_unique<FrameDeduplicator>();
+        update_frame_dedup_config(config_);
+        LOG_INFO("✅ 近重复帧消除已启用");
+    }
     
     // 初始化处理阶段
     if (!initialize_stages()) {
@@ -46,6 +84,10 @@ void BatchPipelineManager::start() {
     
     LOG_INFO("启动批次流水线...");
     
+    // 在进程预算中保留配额；统计只反映本次运行（上次运行未取走的结果仍计入用量）
+    memory_account_->activate();
+    memory_account_->reset_stats();
+    
     // 启动批次收集器
     input_buffer_->start();
     
@@ -64,9 +106,23 @@ void BatchPipelineManager::start() {
         object_tracking_->start();
     }
     if (config_.enable_event_determine && event_determine_) {
+        // 事件日志打开失败不影响事件判定，只是不记录
+        if (event_journal_ && event_journal_->open(config_.event_journal_path)) {
+            event_determine_->set_event_journal(event_journal_.get());
+        } else {
+            event_determine_->set_event_journal(nullptr);
+        }
+        if (evidence_recorder_ && evidence_recorder_->start()) {
+            event_determine_->set_evidence_recorder(evidence_recorder_.get());
+        } else {
+            event_determine_->set_evidence_recorder(nullptr);
+        }
         event_determine_->start();
     }
     
+    // 阶段及其取证/可视化设置确定后再计算缓冲区释放点
+    build_buffer_release_plan();
+    
     // 启动连接器
     if (seg_to_mask_connector_) seg_to_mask_connector_->start();
     if (mask_to_detection_connector_) mask_to_detection_connector_->start();
@@ -82,6 +138,22 @@ void BatchPipelineManager::start() {
     event_coordinator_thread_ = std::thread(&BatchPipelineManager::event_coordinator_func, this);
     result_collector_thread_ = std::thread(&BatchPipelineManager::result_collector_func, this);
     
+    // 打开瓶颈分析采样记录文件
+    if (!config_.stats_record_path.empty() && !stats_record_file_.is_open()) {
+        stats_record_file_.open(config_.stats_record_path, std::ios::out | std::ios::trunc);
+        if (stats_record_file_) {
+            BottleneckAnalyzer::write_csv_header(stats_record_file_);
+            LOG_INFO_F("📝 流水线采样记录到: %s", config_.stats_record_path.c_str());
+        } else {
+            LOG_WARN_F("⚠️ 无法打开采样记录文件: %s", config_.stats_record_path.c_str());
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(sample_history_mutex_);
+        sample_history_.clear();
+        sample_history_.push_back(collect_sample());
+    }
+    
     // 启动状态监控线程
     status_monitor_thread_ = std::thread(&BatchPipelineManager::status_monitor_func, this);
     
@@ -98,8 +170,9 @@ void BatchPipelineManager::stop() {
     stop_requested_.store(true);
     running_.store(false);
     
-    // 停止批次收集器
+    // 停止批次收集器，唤醒等待内存预算的提交线程
     input_buffer_->stop();
+    memory_account_->deactivate();
     
     // 停止处理阶段
     if (semantic_seg_) semantic_seg_->stop();
@@ -127,6 +200,16 @@ void BatchPipelineManager::stop() {
     if (result_collector_thread_.joinable()) result_collector_thread_.join();
     if (status_monitor_thread_.joinable()) status_monitor_thread_.join();
     
+    // 事件判定已停止，结束进行中的事件并落盘
+    if (event_journal_) {
+        if (event_determine_) event_determine_->set_event_journal(nullptr);
+        event_journal_->close();
+    }
+    if (evidence_recorder_) {
+        if (event_determine_) event_determine_->set_evidence_recorder(nullptr);
+        evidence_recorder_->stop();
+    }
+    
     LOG_INFO("批次流水线已停止");
 }
 
@@ -136,7 +219,210 @@ bool BatchPipelineManager::add_image(ImageDataPtr image) {
     }
     
     total_images_input_.fetch_add(1);
-    return input_buffer_->add_image(image);
+    
+    if (!charge_frame(image, std::chrono::steady_clock::time_point::max())) {
+        return false;
+    }
+    // 入口阶段：估计相机运动，计算感知签名，标记近重复帧（接纳之后才更新流的参考状态）
+    IngressCheckpoint checkpoint;
+    run_ingress(image, checkpoint);
+    if (!input_buffer_->add_image(image)) {
+        revert_ingress(image, checkpoint);
+        image->memory_charge.reset();
+        return false;
+    }
+    return true;
+}
+
+bool BatchPipelineManager::add_image_with_timeout(ImageDataPtr image, int timeout_ms) {
+    if (!image) {
+        return false;
+    }
+    return add_images(&image, 1, timeout_ms) == 1;
+}
+
+size_t BatchPipelineManager::add_images(const ImageDataPtr* images, size_t count, int timeout_ms) {
+    if (!running_.load() || !images || count == 0) {
+        return 0;
+    }
+    
+    // 按剩余预算逐帧接纳，超时语义与批次缓冲区一致：<0 一直等待，0 不等待
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = timeout_ms < 0 ? std::chrono::steady_clock::time_point::max()
+                                   : start + std::chrono::milliseconds(timeout_ms);
+    size_t charged = 0;
+    while (charged < count && charge_frame(images[charged], deadline)) {
+        ++charged;
+    }
+    
+    // 入口阶段只处理已通过预算接纳的帧（不持有批次缓冲区的锁）
+    std::vector<IngressCheckpoint> checkpoints(charged);
+    for (size_t i = 0; i < charged; ++i) {
+        run_ingress(images[i], checkpoints[i]);
+    }
+    
+    int remaining_ms = timeout_ms;
+    if (timeout_ms > 0) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        remaining_ms = static_cast<int>(std::max<int64_t>(0, timeout_ms - elapsed));
+    }
+    size_t admitted = charged > 0 ? input_buffer_->add_images(images, charged, remaining_ms) : 0;
+    
+    // 未进入流水线的帧不占用预算，也不作为后续帧的参考（逆序撤销）
+    for (size_t i = charged; i-- > admitted;) {
+        revert_ingress(images[i], checkpoints[i]);
+        images[i]->memory_charge.reset();
+    }
+    total_images_input_.fetch_add(admitted);
+    return admitted;
+}
+
+void BatchPipelineManager::run_ingress(const ImageDataPtr& image, IngressCheckpoint& checkpoint) {
+    if (camera_motion_) {
+        camera_motion_->process(image, &checkpoint.motion);
+    }
+    if (frame_dedup_) {
+        frame_dedup_->process(image, &checkpoint.dedup);
+    }
+}
+
+void BatchPipelineManager::revert_ingress(const ImageDataPtr& image, const IngressCheckpoint& checkpoint) {
+    if (frame_dedup_) {
+        frame_dedup_->revert(image, checkpoint.dedup);
+    }
+    if (camera_motion_) {
+        camera_motion_->revert(image, checkpoint.motion);
+    }
+}
+
+void BatchPipelineManager::build_buffer_release_plan() {
+    buffer_release_plan_.clear();
+    if (!config_.enable_buffer_release) {
+        return;
+    }
+    
+    // 按处理顺序列出已启用的阶段（与协调线程的启用条件一致）
+    std::vector<const BatchStage*> stages;
+    if (config_.enable_segmentation && semantic_seg_) stages.push_back(semantic_seg_.get());
+    if (config_.enable_mask_postprocess && mask_postprocess_) stages.push_back(mask_postprocess_.get());
+    if (config_.enable_detection && object_detection_) stages.push_back(object_detection_.get());
+    if (config_.enable_tracking && object_tracking_) stages.push_back(object_tracking_.get());
+    if (config_.enable_event_determine && event_determine_) stages.push_back(event_determine_.get());
+    
+    FrameBufferSet retained = FRAME_BUFFERS_NONE;
+    if (config_.result_keep_source_image) {
+        retained = retained | FrameBuffer::SOURCE_IMAGE;
+    }
+    if (config_.result_keep_mask) {
+        retained = retained | FrameBuffer::MASK;
+    }
+    if (frame_dedup_) {
+        // 重复帧跨帧读取参考帧的标签与Mask
+        retained = retained | FrameBuffer::LABEL_MAP | FrameBuffer::MASK;
+    }
+    
+    std::vector<FrameBufferSet> usage;
+    for (const BatchStage* stage : stages) {
+        usage.push_back(stage->get_buffer_usage());
+    }
+    BufferLiveness liveness(usage, retained);
+    for (size_t i = 0; i < stages.size(); ++i) {
+        FrameBufferSet buffers = liveness.release_after(i);
+        if (buffers != FRAME_BUFFERS_NONE) {
+            buffer_release_plan_.emplace_back(stages[i], buffers);
+            LOG_INFO_F("♻️ %s 完成后释放: %s", stages[i]->get_stage_name().c_str(),
+                       BufferLiveness::describe(buffers).c_str());
+        }
+    }
+}
+
+void BatchPipelineManager::release_dead_buffers(const BatchStage* stage, const BatchPtr& batch) {
+    if (!batch) {
+        return;
+    }
+    FrameBufferSet buffers = FRAME_BUFFERS_NONE;
+    for (const auto& entry : buffer_release_plan_) {
+        if (entry.first == stage) {
+            buffers = entry.second;
+            break;
+        }
+    }
+    if (buffers == FRAME_BUFFERS_NONE) {
+        return;
+    }
+    
+    uint64_t released = 0;
+    for (size_t i = 0; i < batch->actual_size; ++i) {
+        const ImageDataPtr& image = batch->images[i];
+        if (!image) {
+            continue;
+        }
+        size_t bytes = BufferLiveness::release(*image, buffers, buffer_pool_.get());
+        if (bytes > 0 && image->memory_charge) {
+            image->memory_charge->release_partial(bytes);
+        }
+        released += bytes;
+    }
+    released_buffer_bytes_.fetch_add(released);
+}
+
+size_t BatchPipelineManager::estimate_frame_bytes(const ImageData& image) const {
+    // 原图（BGR 或 YUV）+ 分割标签图（构造时预留）
+    size_t bytes = image.source_bytes();
+    bytes += std::max(image.label_map.capacity(), image.label_map.size());
+    if (config_.enable_segmentation) {
+        // 分割输入图（1024x1024 BGR）
+        bytes += 1024 * 1024 * 3;
+    }
+    if (config_.enable_tracking && config_.enable_parking_detection) {
+        // 违停检测缩放图（长边640，跟踪阶段按需生成）
+        cv::Size parking_size = BatchObjectTracking::parking_image_size(image);
+        bytes += static_cast<size_t>(parking_size.width) * parking_size.height * 3;
+    }
+    return bytes;
+}
+
+bool BatchPipelineManager::charge_frame(const ImageDataPtr& image, std::chrono::steady_clock::time_point deadline) {
+    if (image->memory_charge) {
+        return true;
+    }
+    image->memory_charge = memory_account_->acquire(estimate_frame_bytes(*image), deadline, &running_);
+    return image->memory_charge != nullptr;
+}
+
+void BatchPipelineManager::update_frame_dedup_config(const PipelineConfig& config) {
+    if (!frame_dedup_) {
+        return;
+    }
+    FrameDedupConfig dedup_config;
+    dedup_config.thumb_width = std::max(8, config.dedup_thumb_width);
+    dedup_config.thumb_height = std::max(8, config.dedup_thumb_height);
+    dedup_config.diff_threshold = config.dedup_diff_threshold;
+    dedup_config.max_consecutive_skips = std::max(0, config.dedup_max_consecutive_skips);
+    frame_dedup_->set_config(dedup_config);
+}
+
+void BatchPipelineManager::update_camera_motion_config(const PipelineConfig& config) {
+    if (!camera_motion_) {
+        return;
+    }
+    CameraMotionConfig motion_config;
+    motion_config.motion_ratio = std::max(0.0f, config.camera_motion_ratio);
+    motion_config.min_confidence = config.camera_motion_min_confidence;
+    camera_motion_->set_config(motion_config);
+}
+
+void BatchPipelineManager::update_motion_gate_config(const PipelineConfig& config) {
+    if (object_detection_) {
+        object_detection_->update_motion_gate_config(config);
+    }
+}
+
+void BatchPipelineManager::update_stillness_config(const PipelineConfig& config) {
+    if (object_tracking_) {
+        object_tracking_->update_stillness_config(config);
+    }
 }
 
 bool BatchPipelineManager::get_result_batch(BatchPtr& batch) {
@@ -182,6 +468,7 @@ void BatchPipelineManager::seg_coordinator_func() {
                 // 获取处理完成的批次
                 BatchPtr processed_batch;
                 if (semantic_seg_->get_processed_batch(processed_batch)) {
+                    release_dead_buffers(semantic_seg_.get(), processed_batch);
                     if (config_.enable_mask_postprocess && seg_to_mask_connector_) {
                         // 发送到Mask后处理阶段
                         seg_to_mask_connector_->send_batch(processed_batch);
@@ -237,6 +524,7 @@ void BatchPipelineManager::mask_coordinator_func() {
                 // 获取处理完成的批次
                 BatchPtr processed_batch;
                 if (mask_postprocess_->get_processed_batch(processed_batch)) {
+                    release_dead_buffers(mask_postprocess_.get(), processed_batch);
                     if (config_.enable_detection && mask_to_detection_connector_) {
                         // 发送到检测阶段
                         mask_to_detection_connector_->send_batch(processed_batch);
@@ -279,6 +567,7 @@ void BatchPipelineManager::detection_coordinator_func() {
                 // 获取处理完成的批次
                 BatchPtr processed_batch;
                 if (object_detection_->get_processed_batch(processed_batch)) {
+                    release_dead_buffers(object_detection_.get(), processed_batch);
                     if (config_.enable_tracking && detection_to_tracking_connector_) {
                         // 发送到跟踪阶段
                         detection_to_tracking_connector_->send_batch(processed_batch);
@@ -321,6 +610,7 @@ void BatchPipelineManager::tracking_coordinator_func() {
                 // 获取处理完成的批次
                 BatchPtr processed_batch;
                 if (object_tracking_->get_processed_batch(processed_batch)) {
+                    release_dead_buffers(object_tracking_.get(), processed_batch);
                     if (config_.enable_event_determine && tracking_to_event_connector_) {
                         // 发送到事件判定阶段
                         tracking_to_event_connector_->send_batch(processed_batch);
@@ -363,6 +653,7 @@ void BatchPipelineManager::event_coordinator_func() {
                 // 获取处理完成的批次
                 BatchPtr processed_batch;
                 if (event_determine_->get_processed_batch(processed_batch)) {
+                    release_dead_buffers(event_determine_.get(), processed_batch);
                     // 发送到结果收集器
                     final_result_connector_->send_batch(processed_batch);
                 }
@@ -379,6 +670,7 @@ void BatchPipelineManager::event_coordinator_func() {
 
 void BatchPipelineManager::result_collector_func() {
     LOG_INFO("📦 结果收集线程已启动");
+    TraceRecorder::set_thread_name("结果收集");
     
     while (running_.load()) {
         BatchPtr batch;
@@ -409,9 +701,14 @@ void BatchPipelineManager::decompose_batch_to_images(BatchPtr batch) {
         return;
     }
     
+    TRACE_SCOPE("result", "result.decompose", batch->batch_id, -1);
     std::lock_guard<std::mutex> lock(result_queue_mutex_);
     
     for (size_t i = 0; i < batch->actual_size; ++i) {
+        // 交付后转为结果类占用，不再阻塞新帧接纳
+        if (batch->images[i]->memory_charge) {
+            batch->images[i]->memory_charge->move_to_result();
+        }
         result_image_queue_.push(batch->images[i]);
     }
     
@@ -428,6 +725,18 @@ void BatchPipelineManager::status_monitor_func() {
         }
         
         print_status();
+        
+        // 记录瓶颈分析采样
+        PipelineSample sample = collect_sample();
+        if (stats_record_file_.is_open()) {
+            BottleneckAnalyzer::append_csv(stats_record_file_, sample);
+            stats_record_file_.flush();
+        }
+        std::lock_guard<std::mutex> lock(sample_history_mutex_);
+        sample_history_.push_back(std::move(sample));
+        while (sample_history_.size() > MAX_SAMPLE_HISTORY) {
+            sample_history_.pop_front();
+        }
     }
 }
 
@@ -435,15 +744,35 @@ bool BatchPipelineManager::initialize_stages() {
     LOG_INFO("🏗️ 初始化批次处理阶段...");
     
     // 创建连接器
-    int connector_capacity = 10; // 每个连接器的容量
+    size_t connector_capacity = topology_.connector_capacity;
     seg_to_mask_connector_ = std::make_unique<BatchConnector>(connector_capacity);
     mask_to_detection_connector_ = std::make_unique<BatchConnector>(connector_capacity);
     detection_to_tracking_connector_ = std::make_unique<BatchConnector>(connector_capacity);
     tracking_to_event_connector_ = std::make_unique<BatchConnector>(connector_capacity);
     
+    // 阶段前连接器按各阶段批次大小重组批次（语义分割直接消费 BatchBuffer 的批次）
+    const std::pair<BatchConnector*, const char*> stage_inputs[] = {
+        {seg_to_mask_connector_.get(), "批次Mask后处理"},
+        {mask_to_detection_connector_.get(), "批次目标检测"},
+        {detection_to_tracking_connector_.get(), "批次目标跟踪"},
+        {tracking_to_event_connector_.get(), "批次事件判定"},
+    };
+    for (const auto& input : stage_inputs) {
+        const StageTopology* stage = topology_.find(input.second);
+        if (stage && stage->batch_size > 0) {
+            input.first->set_rebatch(stage->batch_size,
+                                     std::chrono::milliseconds(topology_.rebatch_flush_ms));
+        }
+    }
+    
     // 初始化语义分割阶段
     if (config_.enable_segmentation) {
         semantic_seg_ = std::make_unique<BatchSemanticSegmentation>(config_.semantic_threads, &config_);
+        if (config_.enable_buffer_release) {
+            // 每种尺寸最多缓存两个批次的缓冲区
+            buffer_pool_ = std::make_unique<FrameBufferPool>(2 * std::max<size_t>(1, topology_.batch_size));
+            semantic_seg_->set_buffer_pool(buffer_pool_.get());
+        }
         LOG_INFO("✅ 批次语义分割阶段初始化完成");
     }
     
@@ -468,6 +797,23 @@ bool BatchPipelineManager::initialize_stages() {
     // 初始化事件判定阶段
     if (config_.enable_event_determine) {
         event_determine_ = std::make_unique<BatchEventDetermine>(config_.event_determine_threads, &config_);
+        if (!config_.event_journal_path.empty()) {
+            EventJournalConfig journal_config;
+            journal_config.close_gap_frames = config_.event_close_gap_frames;
+            event_journal_ = std::make_unique<EventJournal>(journal_config);
+        }
+        if (!config_.evidence_output_dir.empty()) {
+            EvidenceRecorderConfig evidence_config;
+            evidence_config.output_dir = config_.evidence_output_dir;
+            evidence_config.memory_budget_bytes = static_cast<size_t>(std::max(1, config_.evidence_memory_budget_mb)) << 20;
+            evidence_config.thumb_width = config_.evidence_thumb_width;
+            evidence_config.jpeg_quality = config_.evidence_jpeg_quality;
+            evidence_config.frame_stride = config_.evidence_frame_stride;
+            evidence_config.pre_event_frames = config_.evidence_pre_frames;
+            evidence_config.post_event_frames = config_.evidence_post_frames;
+            evidence_config.close_gap_frames = config_.event_close_gap_frames;
+            evidence_recorder_ = std::make_unique<EvidenceRecorder>(evidence_config);
+        }
         LOG_INFO("✅ 批次事件判定阶段初始化完成");
     }
     
@@ -480,6 +826,8 @@ void BatchPipelineManager::cleanup_stages() {
     object_detection_.reset();
     object_tracking_.reset();
     event_determine_.reset();
+    event_journal_.reset();
+    evidence_recorder_.reset();
     
     seg_to_mask_connector_.reset();
     mask_to_detection_connector_.reset();
@@ -506,15 +854,66 @@ void BatchPipelineManager::print_status() const {
     status_stream << "  输出图像数: " << stats.total_images_output << "\n";
     status_stream << "  吞吐量: " << stats.throughput_images_per_second << " 图像/秒\n";
     status_stream << "  平均批次处理时间: " << stats.average_batch_processing_time_ms << " ms\n";
+    if (frame_dedup_) {
+        status_stream << "  近重复帧: 标记 " << stats.dedup_frames_marked << "/" << stats.dedup_frames_checked
+                      << " 帧, 实际跳过分割 " << stats.dedup_seg_skipped << " 帧, 跳过检测 "
+                      << stats.dedup_detect_skipped << " 帧\n";
+    }
+    if (camera_motion_) {
+        status_stream << "  相机运动: " << stats.camera_moving_frames << "/" << stats.camera_motion_frames
+                      << " 帧判定为运动, 平均 " << camera_motion_->get_average_cpu_us() << " us/帧\n";
+    }
+    
+    // 在途内存预算
+    const MemoryAccount& account = *memory_account_;
+    const MemoryBudget& budget = account.get_budget();
+    const double mb = 1024.0 * 1024.0;
+    status_stream << "  在途内存: " << account.get_used_bytes() / mb << " MB";
+    if (budget.get_limit() > 0) {
+        status_stream << " / 配额 " << account.get_reserved_bytes() / mb << " MB";
+    }
+    status_stream << " (流水线 " << account.get_pipeline_bytes() / mb << " MB, 待取结果 "
+                  << account.get_result_bytes() / mb << " MB), 峰值 " << account.get_peak_bytes() / mb << " MB";
+    if (account.get_waited() > 0) {
+        status_stream << ", 等待 " << account.get_waited() << " 次/" << account.get_wait_ms() << " ms, 拒绝 "
+                      << account.get_rejected() << " 次";
+    }
+    status_stream << "\n    进程合计: " << budget.get_used_bytes() / mb << " MB";
+    if (budget.get_limit() > 0) {
+        status_stream << " / " << budget.get_limit() / mb << " MB";
+    }
+    status_stream << ", 峰值 " << budget.get_peak_bytes() / mb << " MB, 运行中实例 " << budget.get_active_accounts()
+                  << "\n";
+    if (!buffer_release_plan_.empty()) {
+        status_stream << "  缓冲区提前释放: " << released_buffer_bytes_.load() / mb << " MB";
+        if (buffer_pool_) {
+            status_stream << ", 复用池 命中 " << buffer_pool_->get_hits() << "/未命中 " << buffer_pool_->get_misses()
+                          << ", 池内 " << buffer_pool_->get_pooled_bytes() / mb << " MB";
+        }
+        status_stream << "\n";
+    }
+    if (DerivedImageCache::get_source_computes() + DerivedImageCache::get_derived_computes() > 0) {
+        status_stream << "  派生图缓存: 原图计算 " << DerivedImageCache::get_source_computes()
+                      << " 次, 由已缓存派生图计算 " << DerivedImageCache::get_derived_computes()
+                      << " 次, 命中 " << DerivedImageCache::get_hits() << " 次\n";
+    }
+    if (yuv::get_fused_pixels() + yuv::get_full_frame_pixels() > 0) {
+        status_stream << "  YUV按需转换: 融合转换输出 " << yuv::get_fused_pixels() / 1e6 << " M像素, 整帧转换 "
+                      << yuv::get_full_frame_pixels() / 1e6 << " M像素\n";
+    }
     
     // 队列状态
     status_stream << "\n📋 队列状态:\n";
     
     // 输入缓冲区状态，包含背压信息
     bool is_backpressure = input_buffer_->is_ready_queue_full();
-    status_stream << "  输入缓冲区: " << input_buffer_->get_current_collecting_size() << "/32 (收集中), " 
+    status_stream << "  输入缓冲区: " << input_buffer_->get_current_collecting_size() << "/" << input_buffer_->get_batch_size() << " (收集中), " 
               << input_buffer_->get_ready_batch_count() << "/" << input_buffer_->get_max_ready_batches() 
               << " 批次就绪";
+    if (input_buffer_->get_collecting_bucket_count() > 1) {
+        status_stream << ", " << input_buffer_->get_collecting_bucket_count() << " 个分辨率桶收集中, 公平刷新 "
+                      << input_buffer_->get_fairness_flushes() << " 次";
+    }
     if (is_backpressure) {
         status_stream << " ⚠️ 背压激活";
     }
@@ -544,6 +943,10 @@ void BatchPipelineManager::print_status() const {
         status_stream << "  " << semantic_seg_->get_stage_name() << ": "
                   << semantic_seg_->get_processed_count() << " 批次, 平均 "
                   << semantic_seg_->get_average_processing_time() << " ms/批次\n";
+        if (semantic_seg_->get_scheduler().get_mode() != InferenceMode::GPU_ONLY) {
+            status_stream << "    推理后端(" << InferenceScheduler::mode_name(semantic_seg_->get_scheduler().get_mode())
+                          << "): " << semantic_seg_->get_scheduler().format_stats() << "\n";
+        }
     }
     if (mask_postprocess_) {
         status_stream << "  " << mask_postprocess_->get_stage_name() << ": "
@@ -554,16 +957,98 @@ void BatchPipelineManager::print_status() const {
         status_stream << "  " << object_detection_->get_stage_name() << ": "
                   << object_detection_->get_processed_count() << " 批次, 平均 "
                   << object_detection_->get_average_processing_time() << " ms/批次\n";
+        if (object_detection_->get_scheduler().get_mode() != InferenceMode::GPU_ONLY) {
+            status_stream << "    推理后端(" << InferenceScheduler::mode_name(object_detection_->get_scheduler().get_mode())
+                          << "): " << object_detection_->get_scheduler().format_stats() << "\n";
+        }
+        if (object_detection_->is_motion_gate_enabled()) {
+            auto gate_stats = object_detection_->get_motion_gate_stats();
+            status_stream << "    运动门控: 完整 " << gate_stats.full_frames
+                          << " / 复用 " << gate_stats.reuse_frames
+                          << " / 刷新 " << gate_stats.refresh_frames << " 帧\n";
+        }
     }
     if (object_tracking_) {
         status_stream << "  " << object_tracking_->get_stage_name() << ": "
                   << object_tracking_->get_processed_count() << " 批次, 平均 "
                   << object_tracking_->get_average_processing_time() << " ms/批次\n";
+        if (const MultiObjectTracker* tracker = object_tracking_->get_builtin_tracker()) {
+            uint64_t frames = tracker->get_frames_tracked();
+            status_stream << "    内置跟踪: 活跃轨迹 " << tracker->get_active_tracks()
+                          << ", 候选对 " << (frames > 0 ? tracker->get_candidate_pairs() / frames : 0) << "/帧\n";
+        }
+        auto stillness_stats = object_tracking_->get_stillness_stats();
+        // 检测器默认关闭时，按流开启的帧同样计入
+        if (object_tracking_->is_track_stillness_enabled() ||
+            stillness_stats.history_frames + stillness_stats.feature_frames > 0) {
+            status_stream << "    静止判定: 轨迹历史 " << stillness_stats.history_frames
+                          << " / 特征点 " << stillness_stats.feature_frames
+                          << " 帧, 相机运动 " << stillness_stats.camera_motion_events << " 次\n";
+        }
     }
     if (event_determine_) {
         status_stream << "  " << event_determine_->get_stage_name() << ": "
                   << event_determine_->get_processed_count() << " 批次, 平均 "
                   << event_determine_->get_average_processing_time() << " ms/批次\n";
+        if (event_journal_) {
+            status_stream << "    事件日志: " << event_journal_->get_records() << " 条记录, 进行中 "
+                          << event_journal_->get_open_events() << ", 丢弃观察 "
+                          << event_journal_->get_dropped_observations();
+            if (event_journal_->get_concurrent_observes() > 0) {
+                status_stream << "（其中并发调用 " << event_journal_->get_concurrent_observes() << "）";
+            }
+            status_stream << "\n";
+        }
+        if (evidence_recorder_) {
+            status_stream << "    取证片段: " << evidence_recorder_->get_clips_written() << " 个, 缓存 "
+                          << (evidence_recorder_->get_memory_bytes() >> 10) << " KB（配额 "
+                          << (evidence_recorder_->get_memory_quota_bytes() >> 10) << " KB，进程合计 "
+                          << (evidence_recorder_->get_process_memory_bytes() >> 10) << " KB）, 采集/淘汰/丢弃 "
+                          << evidence_recorder_->get_frames_captured() << "/" << evidence_recorder_->get_frames_evicted()
+                          << "/" << evidence_recorder_->get_frames_dropped() << " 帧\n";
+        }
+    }
+    
+    // 耗时分布：区分真正计算与阻塞等待，决定核数应该投向哪个阶段
+    status_stream << "\n⏱️ 阶段耗时分布:\n";
+    for (const auto& entry : get_stage_profiles()) {
+        status_stream << "  " << entry.stage_name << ": " << StageProfiler::format(entry.profile) << "\n";
+    }
+    if (HwPerfCounters::enabled() && !HwPerfCounters::available()) {
+        status_stream << "  硬件计数器不可用: " << HwPerfCounters::unavailable_reason() << "\n";
+    }
+    
+    // 连接器阻塞时间
+    const std::pair<const char*, const BatchConnector*> connectors[] = {
+        {"分割->Mask", seg_to_mask_connector_.get()},
+        {"Mask->检测", mask_to_detection_connector_.get()},
+        {"检测->跟踪", detection_to_tracking_connector_.get()},
+        {"跟踪->事件", tracking_to_event_connector_.get()},
+        {"结果收集", final_result_connector_.get()},
+    };
+    status_stream << "\n🔗 连接器阻塞:\n";
+    for (const auto& connector : connectors) {
+        if (connector.second) {
+            status_stream << "  " << connector.first << ": 发送等待 " << connector.second->get_send_wait_ms()
+                          << " ms, 接收等待 " << connector.second->get_receive_wait_ms() << " ms";
+            if (connector.second->get_target_batch_size() > 0) {
+                uint64_t batches = connector.second->get_batches_received();
+                status_stream << ", 重组 " << connector.second->get_target_batch_size() << " 帧/批, 平均 "
+                              << (batches > 0 ? static_cast<double>(connector.second->get_frames_received()) / batches : 0.0)
+                              << " 帧, 超时刷新 " << connector.second->get_timeout_flushes();
+            }
+            status_stream << "\n";
+        }
+    }
+    
+    // 锁竞争
+    status_stream << "\n🔒 锁竞争:\n";
+    for (const auto& lock_stats : get_lock_stats()) {
+        double contention = lock_stats.acquisitions > 0
+            ? 100.0 * lock_stats.contended / lock_stats.acquisitions : 0.0;
+        status_stream << "  " << lock_stats.name << ": " << lock_stats.acquisitions << " 次加锁, 竞争 "
+                      << contention << "%, 累计等待 " << lock_stats.wait_ns / 1e6
+                      << " ms, 最长 " << lock_stats.max_wait_ns / 1e6 << " ms\n";
     }
     
     status_stream << std::string(80, '=') << "\n\n";
@@ -606,6 +1091,16 @@ BatchPipelineManager::Statistics BatchPipelineManager::get_statistics() const {
         stats.average_batch_processing_time_ms += event_determine_->get_average_processing_time();
     }
     
+    // 近重复帧统计
+    stats.dedup_frames_checked = frame_dedup_ ? frame_dedup_->get_frames_checked() : 0;
+    stats.dedup_frames_marked = frame_dedup_ ? frame_dedup_->get_frames_marked() : 0;
+    stats.dedup_seg_skipped = semantic_seg_ ? semantic_seg_->get_dedup_reused_frames() : 0;
+    stats.dedup_detect_skipped = object_detection_ ? object_detection_->get_dedup_reused_frames() : 0;
+    
+    // 相机运动统计
+    stats.camera_motion_frames = camera_motion_ ? camera_motion_->get_frames_estimated() : 0;
+    stats.camera_moving_frames = camera_motion_ ? camera_motion_->get_frames_moving() : 0;
+    
     // 当前队列大小
     stats.current_input_buffer_size = input_buffer_->get_ready_batch_count();
     {
@@ -615,3 +1110,128 @@ BatchPipelineManager::Statistics BatchPipelineManager::get_statistics() const {
     
     return stats;
 }
+
+BatchPipelineManager::Occupancy BatchPipelineManager::get_occupancy() const {
+    Occupancy occupancy;
+    occupancy.collecting_images = input_buffer_->get_current_collecting_size();
+    occupancy.ready_batches = input_buffer_->get_ready_batch_count();
+    occupancy.ready_capacity = input_buffer_->get_max_ready_batches();
+    
+    const BatchConnector* connectors[] = {
+        seg_to_mask_connector_.get(), mask_to_detection_connector_.get(),
+        detection_to_tracking_connector_.get(), tracking_to_event_connector_.get(),
+        final_result_connector_.get()
+    };
+    for (const BatchConnector* connector : connectors) {
+        if (connector) {
+            occupancy.connector_batches += connector->get_queue_size();
+            occupancy.connector_capacity += connector->get_max_queue_size();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(result_queue_mutex_));
+        occupancy.result_images = result_image_queue_.size();
+    }
+    
+    uint64_t input = total_images_input_.load();
+    uint64_t output = total_images_output_.load();
+    occupancy.images_in_pipeline = input > output ? input - output : 0;
+    return occupancy;
+}
+
+std::vector<BatchPipelineManager::StageProfileEntry> BatchPipelineManager::get_stage_profiles() const {
+    std::vector<StageProfileEntry> profiles;
+    const BatchStage* stages[] = {
+        semantic_seg_.get(), mask_postprocess_.get(), object_detection_.get(),
+        object_tracking_.get(), event_determine_.get()
+    };
+    for (const BatchStage* stage : stages) {
+        if (stage) {
+            profiles.push_back({stage->get_stage_name(), stage->get_profile()});
+        }
+    }
+    return profiles;
+}
+
+std::vector<LockContentionSnapshot> BatchPipelineManager::get_lock_stats() const {
+    std::vector<LockContentionSnapshot> locks;
+    if (input_buffer_) {
+        locks = input_buffer_->get_lock_stats();
+    }
+    if (semantic_seg_) {
+        locks.push_back(semantic_seg_->get_lock_stats());
+    }
+    if (object_tracking_) {
+        locks.push_back(object_tracking_->get_lock_stats());
+    }
+    if (event_determine_) {
+        locks.push_back(event_determine_->get_lock_stats());
+    }
+    return locks;
+}
+
+PipelineSample BatchPipelineManager::collect_sample() const {
+    PipelineSample sample;
+    sample.timestamp_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    sample.images_input = total_images_input_.load();
+    sample.images_output = total_images_output_.load();
+    
+    for (const StagePlacement& placement : stage_placements()) {
+        StageSample stage_sample;
+        stage_sample.config_key = placement.topology->config_key;
+        stage_sample.stage_name = placement.stage->get_stage_name();
+        stage_sample.threads = placement.topology->threads;
+        stage_sample.serialized = placement.topology->serialized;
+        stage_sample.concurrency = placement.topology->concurrency();
+        stage_sample.max_concurrency = placement.topology->concurrency_with(std::numeric_limits<int>::max());
+        stage_sample.profile = placement.stage->get_profile();
+        stage_sample.batches = stage_sample.profile.batches;
+        stage_sample.images = stage_sample.profile.images;
+        stage_sample.input_queue = placement.stage->get_queue_size();
+        sample.stages.push_back(std::move(stage_sample));
+    }
+    return sample;
+}
+
+BottleneckReport BatchPipelineManager::analyze_bottleneck(int core_budget) const {
+    PipelineSample begin;
+    {
+        std::lock_guard<std::mutex> lock(sample_history_mutex_);
+        if (sample_history_.empty()) {
+            BottleneckReport report;
+            report.verdict = "流水线未启动，没有采样数据";
+            return report;
+        }
+        begin = sample_history_.front();
+    }
+    return BottleneckAnalyzer::analyze(begin, collect_sample(), core_budget);
+}
+
+std::vector<BatchPipelineManager::StagePlacement> BatchPipelineManager::stage_placements() const {
+    // 与 PipelineTopology::from_config 中阶段的名称一一对应
+    const std::pair<const BatchStage*, const char*> stages[] = {
+        {semantic_seg_.get(), "semantic_threads"},
+        {mask_postprocess_.get(), "mask_threads"},
+        {object_detection_.get(), "detection_threads"},
+        {object_tracking_.get(), "tracking_threads"},
+        {event_determine_.get(), "filter_threads"},
+    };
+    std::vector<StagePlacement> placements;
+    for (const auto& entry : stages) {
+        const StageTopology* stage_topology = topology_.find(entry.second);
+        if (entry.first && stage_topology) {
+            placements.push_back({entry.first, stage_topology});
+        }
+    }
+    return placements;
+}
+
+ServiceProfile BatchPipelineManager::collect_service_profile() const {
+    ServiceProfile profile;
+    profile.topology = topology_;
+    for (const StagePlacement& placement : stage_placements()) {
+        profile.samples[placement.topology->config_key] = placement.stage->get_service_samples();
+    }
+    return profile;
+}
@@ -1,4 +1,6 @@
 #include "batch_semantic_segmentation.h"
+#include "trace_recorder.h"
+#include "frame_dedup.h"
 #include "logger_manager.h"
 #include <iostream>
 #include <algorithm>
@@ -13,7 +15,7 @@ BatchSemanticSegmentation::BatchSemanticSegmentation(int num_threads, const Pipe
     LOG_INFO("🏗️ 初始化批次语义分割阶段...");
     
     // 创建线程池
-    thread_pool_ = std::make_unique<ThreadPool>(8);
+    thread_pool_ = std::make_unique<ThreadPool>(8, &profiler_);
     
     // 初始化配置
     if (config) {
@@ -38,9 +40,17 @@ BatchSemanticSegmentation::BatchSemanticSegmentation(int num_threads, const Pipe
         LOG_INFO("⚠️ 未检测到CUDA设备，批次语义分割将使用CPU");
     }
     
-    // 初始化语义分割模型
-    if (!initialize_seg_models()) {
-        LOG_ERROR("❌ 批次语义分割模型初始化失败");
+    // 初始化语义分割模型：cpu 模式不加载 TensorRT 模型
+    InferenceMode mode = InferenceScheduler::parse_mode(config_.inference_mode);
+    scheduler_ = std::make_unique<InferenceScheduler>(get_stage_name(), mode, 3.0, 300.0, &profiler_);
+    if (mode != InferenceMode::CPU_ONLY) {
+        if (!initialize_seg_models()) {
+            LOG_ERROR("❌ 批次语义分割模型初始化失败");
+        }
+        scheduler_->set_backend_available(InferenceBackend::GPU, !seg_instances_.empty());
+    }
+    if (mode != InferenceMode::GPU_ONLY) {
+        scheduler_->set_backend_available(InferenceBackend::CPU, initialize_cpu_seg_model());
     }
 }
 
@@ -127,16 +137,27 @@ bool BatchSemanticSegmentation::process_batch(BatchPtr batch) {
     
     try {
         // 第一步：预处理所有图像
-        preprocess_batch(batch);
+        {
+            TRACE_SCOPE("stage", "seg.preprocess", batch->batch_id, -1);
+            preprocess_batch(batch);
+        }
         
         // 第二步：批量推理
-        if (!inference_batch(batch)) {
+        bool inference_success;
+        {
+            TRACE_SCOPE("stage", "seg.inference", batch->batch_id, -1);
+            inference_success = inference_batch(batch);
+        }
+        if (!inference_success) {
             std::cerr << "❌ 批次 " << batch->batch_id << " 推理失败" << std::endl;
             return false;
         }
         
         // 第三步：后处理
-        postprocess_batch(batch);
+        {
+            TRACE_SCOPE("stage", "seg.postprocess", batch->batch_id, -1);
+            postprocess_batch(batch);
+        }
         
         // 标记批次完成
         batch->segmentation_completed.store(true);
@@ -163,6 +184,10 @@ bool BatchSemanticSegmentation::process_batch(BatchPtr batch) {
 }
 
 void BatchSemanticSegmentation::worker_thread_func() {
+    // 绑定剖析器，连接器等待与锁等待自动记入本阶段
+    StageProfiler::ThreadBinding binding(&profiler_);
+    TraceRecorder::set_thread_name(get_stage_name());
+    
     while (running_.load()) {
         BatchPtr batch;
         LOG_INFO("🔄 等待输入批次...");
@@ -170,7 +195,12 @@ void BatchSemanticSegmentation::worker_thread_func() {
         if (input_connector_->receive_batch(batch)) {
             if (batch) {
                 // 处理批次
-                bool success = process_batch(batch);
+                bool success;
+                {
+                    StageProfiler::BusyScope busy(profiler_, batch->actual_size);
+                    TRACE_SCOPE("stage", "seg.process", batch->batch_id, -1);
+                    success = process_batch(batch);
+                }
                 
                 if (success) {
                     // 发送到输出连接器
@@ -255,60 +285,102 @@ bool BatchSemanticSegmentation::preprocess_batch_with_threadpool(BatchPtr batch)
 
 bool BatchSemanticSegmentation::inference_batch(BatchPtr batch) {
     
-    if (seg_instances_.empty()) {
+    if (!scheduler_->any_available()) {
         LOG_ERROR("❌ 语义分割模型实例未初始化");
         return false;
     }
     
     std::cout << "🧠 批次 " << batch->batch_id << " 开始推理..." << std::endl;
 
-    // 准备批量输入数据
+    // 准备批量输入数据（已继承参考帧结果的重复帧不参与推理）
     std::vector<cv::Mat> image_mats;
+    std::vector<size_t> infer_indices;
     image_mats.reserve(batch->actual_size);
+    infer_indices.reserve(batch->actual_size);
     std::cout << "批次实际图像数量: " << batch->actual_size << std::endl;
     // exit(0);
     
     for (size_t i = 0; i < batch->actual_size; ++i) {
+        if (batch->images[i]->segmentation_completed.load()) {
+            continue;
+        }
         if (!batch->images[i]->segInResizeMat.empty()) {
             // cv::imwrite("resize_outs/output_" + std::to_string(batch->images[i]->frame_idx) + ".jpg", batch->images[i]->segInResizeMat);
             image_mats.push_back(batch->images[i]->segInResizeMat);
+            infer_indices.push_back(i);
         } else {
             std::cerr << "⚠️ 图像 " << i << " 预处理结果为空" << std::endl;
             return false;
         }
     }
     
-    // 使用第一个模型实例进行批量推理
-    std::vector<SegmentationResult> seg_results;
+    if (image_mats.empty()) {
+        // 整个批次均为重复帧，无需推理
+        return true;
+    }
+    
+    // 按微批次分配到 GPU / CPU 后端，结果统一写入 label_maps
+    std::vector<std::vector<uint8_t>> label_maps(image_mats.size());
+    std::vector<cv::Size> mask_sizes(image_mats.size(), cv::Size(1024, 1024));
     auto seg_start = std::chrono::high_resolution_clock::now();
     
-    bool inference_success = seg_instances_[0]->Predict(image_mats, seg_results);
+    auto run_gpu = [&](const std::vector<size_t>& items) -> bool {
+        // 使用第一个模型实例进行批量推理
+        std::vector<cv::Mat> gpu_mats;
+        gpu_mats.reserve(items.size());
+        for (size_t k : items) {
+            gpu_mats.push_back(image_mats[k]);
+        }
+        std::vector<SegmentationResult> seg_results;
+        if (!seg_instances_[0]->Predict(gpu_mats, seg_results)) {
+            LOG_ERROR("❌ GPU语义分割推理失败");
+            return false;
+        }
+        if (seg_results.size() != gpu_mats.size()) {
+            std::cerr << "❌ 推理结果数量不匹配，期望: " << gpu_mats.size() 
+                      << "，实际: " << seg_results.size() << std::endl;
+            return false;
+        }
+        for (size_t j = 0; j < items.size(); ++j) {
+            label_maps[items[j]] = std::move(seg_results[j].label_map);
+        }
+        return true;
+    };
+    auto run_cpu = [&](size_t begin, size_t end) -> bool {
+        std::vector<cv::Mat> cpu_mats(image_mats.begin() + begin, image_mats.begin() + end);
+        std::vector<CpuSegResult> cpu_results;
+        if (!cpu_seg_model_->infer(cpu_mats, cpu_results)) {
+            return false;
+        }
+        for (size_t j = 0; j < cpu_results.size(); ++j) {
+            label_maps[begin + j] = std::move(cpu_results[j].label_map);
+            mask_sizes[begin + j] = cv::Size(cpu_results[j].width, cpu_results[j].height);
+        }
+        return true;
+    };
+    bool inference_success = scheduler_->run(image_mats.size(), static_cast<size_t>(config_.infer_micro_batch),
+                                             run_gpu, run_cpu);
     
     auto seg_end = std::chrono::high_resolution_clock::now();
     auto seg_duration = std::chrono::duration_cast<std::chrono::milliseconds>(seg_end - seg_start);
     std::cout << "🧠 批次 " << batch->batch_id 
               << " 语义分割推理完成，耗时: " << seg_duration.count() << " ms" 
-              << ", 实际图像数量: " << batch->actual_size << std::endl;
+              << ", 推理图像数量: " << image_mats.size() << "/" << batch->actual_size << std::endl;
     if (!inference_success) {
         LOG_ERROR("❌ 批次推理失败");
         return false;
     }
     
-    if (seg_results.size() != batch->actual_size) {
-        std::cerr << "❌ 推理结果数量不匹配，期望: " << batch->actual_size 
-                  << "，实际: " << seg_results.size() << std::endl;
-        return false;
-    }
-    
     // 将推理结果分配给对应的图像
-    for (size_t i = 0; i < batch->actual_size; ++i) {
-        if (!seg_results[i].label_map.empty()) {
-            batch->images[i]->label_map = std::move(seg_results[i].label_map);
+    for (size_t k = 0; k < infer_indices.size(); ++k) {
+        size_t i = infer_indices[k];
+        if (!label_maps[k].empty()) {
+            batch->images[i]->label_map = std::move(label_maps[k]);
             // cv::Mat mask(1024, 1024, CV_8UC1, batch->images[i]->label_map.data());
             // cv::imwrite("mask_outs/output_" + std::to_string(batch->images[i]->frame_idx) + ".jpg", mask*255);
-            batch->images[i]->mask_height = 1024;
-            batch->images[i]->mask_width = 1024;
-            if(batch->images[i]->frame_idx % 200 == 0) {
+            batch->images[i]->mask_height = mask_sizes[k].height;
+            batch->images[i]->mask_width = mask_sizes[k].width;
+            if(batch->images[i]->frame_idx % 200 == 0 && mask_sizes[k] == cv::Size(1024, 1024)) {
                 cv::Mat label_map(1024, 1024, CV_8UC1, (void*) batch->images[i]->label_map.data());
                 // cv::imwrite(seg_show_image_path_+"/mask_" + std::to_string(batch->images[i]->frame_idx) + ".jpg", label_map*255);
                 // 创建彩色mask：浅绿色 (BGR格式: 绿色为主)
@@ -335,20 +407,29 @@ void BatchSemanticSegmentation::postprocess_batch(BatchPtr batch) {
 }
 
 void BatchSemanticSegmentation::preprocess_image(ImageDataPtr image, int thread_id) {
-    if (!image || image->imageMat.empty()) {
+    if (!image || !image->has_source()) {
         return;
     }
     
     try {
-        // 计算停车检测所需的缩放比例（长边到1920）
-        int max_dim = std::max(image->imageMat.rows, image->imageMat.cols);
-        double parking_scale = 640.0 / max_dim;
-        cv::Size parking_size(static_cast<int>(image->imageMat.cols * parking_scale),
-                             static_cast<int>(image->imageMat.rows * parking_scale));
+        // 重复帧：参考帧分割已完成时直接继承其分割结果，跳过1024x1024缩放与推理
+        bool seg_reused = false;
+        if (ImageDataPtr reference = FrameDeduplicator::reusable_reference(
+                image, &ImageData::segmentation_completed)) {
+            if (!reference->label_map.empty()) {
+                image->label_map = reference->label_map;
+                image->mask_height = reference->mask_height;
+                image->mask_width = reference->mask_width;
+                image->segmentation_completed = true;
+                seg_reused = true;
+                dedup_reused_frames_.fetch_add(1);
+            }
+        }
         
+        // 违停检测缩放图由跟踪阶段按需从 derived_images 取得，这里只生成分割输入
         if (false) {
             // 使用CUDA加速预处理，复用预分配的GPU缓存
-            std::lock_guard<std::mutex> lock(gpu_mutex_);
+            std::lock_guard<InstrumentedMutex> lock(gpu_mutex_);
             
             // 确保缓存大小足够
             if (gpu_src_cache_.rows < image->imageMat.rows || gpu_src_cache_.cols < image->imageMat.cols) {
@@ -372,17 +453,18 @@ void BatchSemanticSegmentation::preprocess_image(ImageDataPtr image, int thread_
             // 下载语义分割结果
             gpu_dst_cache_.download(image->segInResizeMat);
             
-            // 停车检测预处理：创建临时GPU Mat用于停车检测缩放
-            cv::cuda::GpuMat gpu_parking_resized;
-            cv::cuda::resize(gpu_src_roi, gpu_parking_resized, parking_size);
-            
-            // 下载停车检测结果
-            gpu_parking_resized.download(image->parkingResizeMat);
-            
-        } else {
-            // CPU预处理
-            cv::resize(image->imageMat, image->segInResizeMat, cv::Size(1024, 1024));
-            cv::resize(image->imageMat, image->parkingResizeMat, parking_size);
+        } else if (!seg_reused) {
+            // CPU预处理，目标缓冲区取自复用池（已释放帧归还的同尺寸缓冲区）
+            DerivedImageCache::Allocator allocator;
+            if (buffer_pool_) {
+                FrameBufferPool* pool = buffer_pool_;
+                allocator = [pool](int rows, int cols, int type) { return pool->acquire(rows, cols, type); };
+            }
+            image->segInResizeMat = image->derived(DerivedImageKey(cv::Size(1024, 1024)), allocator);
+            if (image->segInResizeMat.empty()) {
+                std::cerr << "❌ 图像预处理失败: " << image->frame_idx << std::endl;
+                image->segInResizeMat = cv::Mat::zeros(1024, 1024, CV_8UC3);
+            }
         }
     } catch (const cv::Exception& e) {
         std::cerr << "❌ 图像预处理失败: " << e.what() << std::endl;
@@ -429,6 +511,19 @@ bool BatchSemanticSegmentation::initialize_seg_models() {
     return true;
 }
 
+bool BatchSemanticSegmentation::initialize_cpu_seg_model() {
+    std::string model_path = config_.cpu_seg_model_path.empty() ? config_.seg_model_path : config_.cpu_seg_model_path;
+    cpu_seg_model_ = std::make_unique<CpuSegmentationModel>(
+        model_path, config_.cpu_infer_threads, CpuSegmentationModel::Params());
+    if (!cpu_seg_model_->load()) {
+        std::cerr << "❌ CPU语义分割模型初始化失败: " << model_path << std::endl;
+        cpu_seg_model_.reset();
+        return false;
+    }
+    std::cout << "✅ CPU语义分割模型初始化成功，推理线程 " << cpu_seg_model_->get_thread_count() << std::endl;
+    return true;
+}
+
 void BatchSemanticSegmentation::cleanup_seg_models() {
     for (auto& instance : seg_instances_) {
         if (instance) {
@@ -443,6 +538,19 @@ std::string BatchSemanticSegmentation::get_stage_name() const {
     return "批次语义分割";
 }
 
+StageProfileSnapshot BatchSemanticSegmentation::get_profile() const {
+    return profiler_.snapshot();
+}
+
+std::vector<ServiceSample> BatchSemanticSegmentation::get_service_samples() const {
+    return profiler_.service_samples();
+}
+
+FrameBufferSet BatchSemanticSegmentation::get_buffer_usage() const {
+    // 预处理读原图，生成分割输入与标签
+    return FrameBuffer::SOURCE_IMAGE | FrameBuffer::SEG_INPUT | FrameBuffer::LABEL_MAP;
+}
+
 size_t BatchSemanticSegmentation::get_processed_count() const {
     return processed_batch_count_.load();
 }
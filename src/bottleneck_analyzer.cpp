@@ -0,0 +1,304 @@
+#include "bottleneck_analyzer.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+constexpr size_t kCsvColumns = 23;   // write_csv_header 的列数
+
+uint64_t delta(uint64_t end, uint64_t begin) {
+    return end > begin ? end - begin : 0;
+}
+
+const StageSample* find_stage(const PipelineSample& sample, const std::string& key) {
+    for (const auto& stage : sample.stages) {
+        if (stage.config_key == key) {
+            return &stage;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string> split_csv_line(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ',')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+} // namespace
+
+BottleneckReport BottleneckAnalyzer::analyze(const PipelineSample& begin, const PipelineSample& end, int core_budget) {
+    BottleneckReport report;
+    report.core_budget = core_budget > 0 ? core_budget : static_cast<int>(std::thread::hardware_concurrency());
+    if (report.core_budget <= 0) {
+        report.core_budget = 4;
+    }
+
+    if (end.timestamp_ms <= begin.timestamp_ms) {
+        report.verdict = "采样窗口为空，至少需要两次间隔一段时间的采样";
+        return report;
+    }
+    report.interval_seconds = (end.timestamp_ms - begin.timestamp_ms) / 1000.0;
+    report.throughput_fps = delta(end.images_output, begin.images_output) / report.interval_seconds;
+
+    // 计算各阶段增量指标
+    for (const auto& stage_end : end.stages) {
+        const StageSample* stage_begin = find_stage(begin, stage_end.config_key);
+        StageSample zero;
+        if (!stage_begin) {
+            stage_begin = &zero;
+        }
+
+        StageAnalysis analysis;
+        analysis.config_key = stage_end.config_key;
+        analysis.stage_name = stage_end.stage_name;
+        analysis.threads = std::max(1, stage_end.threads);
+        analysis.serialized = stage_end.serialized;
+        analysis.concurrency = std::max(1, stage_end.concurrency);
+        analysis.max_concurrency = std::max(analysis.concurrency, stage_end.max_concurrency);
+
+        const StageProfileSnapshot& p0 = stage_begin->profile;
+        const StageProfileSnapshot& p1 = stage_end.profile;
+        uint64_t batches = delta(stage_end.batches, stage_begin->batches);
+        uint64_t images = delta(stage_end.images, stage_begin->images);
+        uint64_t busy_wall = delta(p1.busy_wall_ns, p0.busy_wall_ns);
+        uint64_t busy_cpu = delta(p1.busy_cpu_ns, p0.busy_cpu_ns);
+        uint64_t pool_cpu = delta(p1.pool_cpu_ns, p0.pool_cpu_ns);
+        uint64_t input_wait = delta(p1.input_wait_ns, p0.input_wait_ns);
+        uint64_t output_wait = delta(p1.output_wait_ns, p0.output_wait_ns);
+        uint64_t lock_wait = delta(p1.lock_wait_ns, p0.lock_wait_ns);
+        uint64_t total = busy_wall + input_wait + output_wait;
+
+        analysis.batches_per_second = batches / report.interval_seconds;
+        if (batches > 0) {
+            analysis.service_ms = busy_wall / 1e6 / batches;
+            analysis.cpu_ms_per_batch = (busy_cpu + pool_cpu) / 1e6 / batches;
+            analysis.frames_per_batch = static_cast<double>(images) / batches;
+        }
+        analysis.frames_per_second = analysis.batches_per_second * analysis.frames_per_batch;
+        analysis.utilisation = std::min(1.0, busy_wall / (report.interval_seconds * 1e9 * analysis.concurrency));
+        analysis.capacity_bps = analysis.service_ms > 0.0
+            ? analysis.concurrency * 1000.0 / analysis.service_ms
+            : std::numeric_limits<double>::infinity();
+        analysis.capacity_fps = analysis.capacity_bps * analysis.frames_per_batch;
+        analysis.queue_growth_per_second =
+            (static_cast<double>(stage_end.input_queue) - static_cast<double>(stage_begin->input_queue)) /
+            report.interval_seconds;
+        if (total > 0) {
+            analysis.input_wait_ratio = static_cast<double>(input_wait) / total;
+            analysis.output_wait_ratio = static_cast<double>(output_wait) / total;
+            analysis.lock_wait_ratio = static_cast<double>(lock_wait) / total;
+        }
+        if (busy_wall > 0) {
+            uint64_t on_cpu = std::min(busy_wall, busy_cpu + lock_wait);
+            analysis.offcpu_ratio = static_cast<double>(busy_wall - on_cpu) / busy_wall;
+        }
+        StageProfileSnapshot hw;
+        hw.hw_cycles = delta(p1.hw_cycles, p0.hw_cycles);
+        hw.hw_instructions = delta(p1.hw_instructions, p0.hw_instructions);
+        hw.hw_cache_misses = delta(p1.hw_cache_misses, p0.hw_cache_misses);
+        hw.hw_branch_misses = delta(p1.hw_branch_misses, p0.hw_branch_misses);
+        analysis.ipc = hw.ipc();
+        analysis.cache_mpki = hw.cache_mpki();
+        analysis.branch_mpki = hw.branch_mpki();
+        report.stages.push_back(analysis);
+    }
+
+    // 找出容量最低的阶段（只考虑窗口内有处理量的阶段）
+    const StageAnalysis* limiting = nullptr;
+    double max_utilisation = 0.0;
+    for (const auto& stage : report.stages) {
+        if (stage.batches_per_second <= 0.0) {
+            continue;
+        }
+        max_utilisation = std::max(max_utilisation, stage.utilisation);
+        if (!limiting || stage.capacity_fps < limiting->capacity_fps) {
+            limiting = &stage;
+        }
+    }
+    if (!limiting) {
+        report.verdict = "窗口内没有批次完成处理，无法判断瓶颈";
+        return report;
+    }
+    report.valid = true;
+
+    std::ostringstream verdict;
+    verdict << std::fixed << std::setprecision(2);
+    if (limiting->utilisation >= 0.7 || limiting->queue_growth_per_second > 0.0) {
+        report.limiting_stage = limiting->stage_name;
+        verdict << "限速阶段: " << limiting->stage_name
+                << "（利用率 " << limiting->utilisation * 100.0 << "%，容量 " << limiting->capacity_fps
+                << " 帧/秒，输入队列增长 " << limiting->queue_growth_per_second << " 批次/秒";
+        if (limiting->offcpu_ratio > 0.5) {
+            verdict << "，处理时间主要不在CPU上，增加CPU线程收益有限";
+        } else if (limiting->lock_wait_ratio > 0.2) {
+            verdict << "，锁等待占比高，先降低锁竞争";
+        }
+        verdict << "）";
+    } else if (max_utilisation < 0.5) {
+        verdict << "输入受限: 各阶段利用率均低于50%（最高 " << max_utilisation * 100.0
+                << "%），吞吐受数据源或提交速率限制";
+    } else {
+        report.limiting_stage = limiting->stage_name;
+        verdict << "可能的限速阶段: " << limiting->stage_name << "（容量最低 " << limiting->capacity_fps
+                << " 帧/秒，利用率 " << limiting->utilisation * 100.0 << "%，未饱和）";
+    }
+    // 线程数超过并发上限，或实际并发不足1时，额外线程没有被利用
+    for (const auto& stage : report.stages) {
+        if (stage.threads > stage.concurrency) {
+            verdict << "\n  提示: " << stage.stage_name << " 配置 " << stage.threads
+                    << " 个线程但同一时刻最多处理 " << stage.concurrency << " 个批次，多余线程处于空闲";
+        } else if (stage.concurrency > 1 && stage.utilisation * stage.concurrency <= 1.05 &&
+                   stage.utilisation > 0.0) {
+            verdict << "\n  提示: " << stage.stage_name << " 配置 " << stage.threads
+                    << " 个线程但平均并发不足1，多余线程处于空闲";
+        }
+    }
+    report.verdict = verdict.str();
+
+    // 线程分配：每阶段至少1个线程，剩余核数逐个给容量最低的可扩展阶段
+    std::vector<StageAnalysis*> active;
+    for (auto& stage : report.stages) {
+        stage.recommended_threads = 1;
+        if (stage.batches_per_second > 0.0) {
+            active.push_back(&stage);
+        }
+    }
+    int remaining = report.core_budget - static_cast<int>(report.stages.size());
+    auto capacity_with = [](const StageAnalysis* stage) {
+        int concurrency = std::min(stage->recommended_threads, stage->max_concurrency);
+        return stage->service_ms > 0.0 ? concurrency * 1000.0 / stage->service_ms * stage->frames_per_batch
+                                       : std::numeric_limits<double>::infinity();
+    };
+    while (remaining > 0 && !active.empty()) {
+        StageAnalysis* weakest = *std::min_element(active.begin(), active.end(),
+            [&capacity_with](const StageAnalysis* a, const StageAnalysis* b) {
+                return capacity_with(a) < capacity_with(b);
+            });
+        if (weakest->recommended_threads >= weakest->max_concurrency) {
+            break;   // 最慢的阶段已达并发上限，无法靠加线程提速，其余阶段加线程也不会提高整体吞吐
+        }
+        weakest->recommended_threads++;
+        remaining--;
+    }
+    report.spare_cores = std::max(0, remaining);
+    return report;
+}
+
+std::string BottleneckReport::to_string() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << "🔍 瓶颈分析（窗口 " << interval_seconds << " s，输出 " << throughput_fps << " 帧/秒，核数预算 "
+        << core_budget << "）\n";
+    out << "  " << verdict << "\n";
+    if (!valid) {
+        return out.str();
+    }
+    for (const auto& stage : stages) {
+        out << "  " << stage.stage_name << " [" << stage.config_key << "]: "
+            << stage.frames_per_second << " 帧/秒 (" << stage.batches_per_second << " 批次/秒 × "
+            << stage.frames_per_batch << " 帧), 服务 " << stage.service_ms << " ms/批次, CPU "
+            << stage.cpu_ms_per_batch << " ms/批次, 利用率 " << stage.utilisation * 100.0 << "%, 容量 "
+            << stage.capacity_fps << " 帧/秒, 队列增长 " << stage.queue_growth_per_second << " 批次/秒"
+            << ", 等输入 " << stage.input_wait_ratio * 100.0 << "%, 等输出 " << stage.output_wait_ratio * 100.0
+            << "%, 锁等待 " << stage.lock_wait_ratio * 100.0 << "%";
+        if (stage.ipc > 0.0) {
+            out << ", IPC " << stage.ipc << ", 缓存未命中 " << stage.cache_mpki << "/千指令, 分支未命中 "
+                << stage.branch_mpki << "/千指令";
+        }
+        out << ", 并发 " << stage.concurrency << (stage.serialized ? " (串行)" : "") << "\n";
+    }
+    out << "  建议线程分配:";
+    for (const auto& stage : stages) {
+        out << " " << stage.config_key << "=" << stage.recommended_threads;
+        if (stage.recommended_threads != stage.threads) {
+            out << "(当前" << stage.threads << ")";
+        }
+    }
+    if (spare_cores > 0) {
+        out << "，富余 " << spare_cores << " 核";
+    }
+    out << "\n";
+    return out.str();
+}
+
+void BottleneckAnalyzer::write_csv_header(std::ostream& out) {
+    out << "timestamp_ms,images_input,images_output,config_key,stage_name,threads,serialized,batches,"
+           "input_queue,busy_cpu_ns,busy_wall_ns,input_wait_ns,output_wait_ns,lock_wait_ns,pool_tasks,pool_cpu_ns,"
+           "hw_cycles,hw_instructions,hw_cache_misses,hw_branch_misses,concurrency,max_concurrency,images\n";
+}
+
+void BottleneckAnalyzer::append_csv(std::ostream& out, const PipelineSample& sample) {
+    for (const auto& stage : sample.stages) {
+        const StageProfileSnapshot& p = stage.profile;
+        out << sample.timestamp_ms << ',' << sample.images_input << ',' << sample.images_output << ','
+            << stage.config_key << ',' << stage.stage_name << ',' << stage.threads << ','
+            << (stage.serialized ? 1 : 0) << ',' << stage.batches << ',' << stage.input_queue << ','
+            << p.busy_cpu_ns << ',' << p.busy_wall_ns << ',' << p.input_wait_ns << ','
+            << p.output_wait_ns << ',' << p.lock_wait_ns << ',' << p.pool_tasks << ',' << p.pool_cpu_ns << ','
+            << p.hw_cycles << ',' << p.hw_instructions << ',' << p.hw_cache_misses << ',' << p.hw_branch_misses
+            << ',' << stage.concurrency << ',' << stage.max_concurrency << ',' << stage.images << '\n';
+    }
+}
+
+bool BottleneckAnalyzer::load_csv(const std::string& path, std::vector<PipelineSample>& samples) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    samples.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line.compare(0, 12, "timestamp_ms") == 0) {
+            continue;
+        }
+        std::vector<std::string> f = split_csv_line(line);
+        if (f.size() < kCsvColumns) {
+            continue;   // 不完整的行（如进程中途退出）
+        }
+        try {
+            uint64_t timestamp = std::stoull(f[0]);
+            if (samples.empty() || samples.back().timestamp_ms != timestamp) {
+                samples.emplace_back();
+                samples.back().timestamp_ms = timestamp;
+                samples.back().images_input = std::stoull(f[1]);
+                samples.back().images_output = std::stoull(f[2]);
+            }
+            StageSample stage;
+            stage.config_key = f[3];
+            stage.stage_name = f[4];
+            stage.threads = std::stoi(f[5]);
+            stage.serialized = f[6] == "1";
+            stage.batches = std::stoull(f[7]);
+            stage.input_queue = std::stoull(f[8]);
+            stage.profile.batches = stage.batches;
+            stage.profile.busy_cpu_ns = std::stoull(f[9]);
+            stage.profile.busy_wall_ns = std::stoull(f[10]);
+            stage.profile.input_wait_ns = std::stoull(f[11]);
+            stage.profile.output_wait_ns = std::stoull(f[12]);
+            stage.profile.lock_wait_ns = std::stoull(f[13]);
+            stage.profile.pool_tasks = std::stoull(f[14]);
+            stage.profile.pool_cpu_ns = std::stoull(f[15]);
+            stage.profile.hw_cycles = std::stoull(f[16]);
+            stage.profile.hw_instructions = std::stoull(f[17]);
+            stage.profile.hw_cache_misses = std::stoull(f[18]);
+            stage.profile.hw_branch_misses = std::stoull(f[19]);
+            stage.concurrency = std::stoi(f[20]);
+            stage.max_concurrency = std::stoi(f[21]);
+            stage.images = std::stoull(f[22]);
+            stage.profile.images = stage.images;
+            samples.back().stages.push_back(stage);
+        } catch (const std::exception&) {
+            continue;   // 跳过格式错误的行
+        }
+    }
+    return !samples.empty();
+}
@@ -0,0 +1,115 @@
+#include "buffer_liveness.h"
+
+FrameBufferPool::FrameBufferPool(size_t max_per_shape) : max_per_shape_(max_per_shape) {}
+
+cv::Mat FrameBufferPool::acquire(int rows, int cols, int type) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = free_.find(ShapeKey(rows, cols, type));
+        if (it != free_.end() && !it->second.empty()) {
+            cv::Mat mat = std::move(it->second.back());
+            it->second.pop_back();
+            pooled_bytes_.fetch_sub(mat.total() * mat.elemSize());
+            hits_.fetch_add(1);
+            return mat;
+        }
+    }
+    misses_.fetch_add(1);
+    return cv::Mat(rows, cols, type);
+}
+
+void FrameBufferPool::recycle(cv::Mat& mat) {
+    // 子矩阵、外部数据或仍有其他引用的缓冲区不能复用
+    bool exclusive = mat.u != nullptr && mat.u->refcount == 1 && mat.data == mat.datastart && mat.isContinuous();
+    if (!exclusive || mat.dims != 2) {
+        mat.release();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<cv::Mat>& bucket = free_[ShapeKey(mat.rows, mat.cols, mat.type())];
+    if (bucket.size() >= max_per_shape_) {
+        mat.release();
+        return;
+    }
+    pooled_bytes_.fetch_add(mat.total() * mat.elemSize());
+    bucket.push_back(std::move(mat));
+    mat = cv::Mat();
+}
+
+BufferLiveness::BufferLiveness(const std::vector<FrameBufferSet>& stage_usage, FrameBufferSet retained)
+    : release_after_(stage_usage.size(), FRAME_BUFFERS_NONE) {
+    for (FrameBufferSet bit = 1; bit <= FRAME_BUFFERS_ALL; bit <<= 1) {
+        if (retained & bit) {
+            continue;
+        }
+        // 最后一个使用该缓冲区的阶段完成后释放
+        for (size_t i = stage_usage.size(); i-- > 0;) {
+            if (stage_usage[i] & bit) {
+                release_after_[i] |= bit;
+                break;
+            }
+        }
+    }
+}
+
+FrameBufferSet BufferLiveness::release_after(size_t stage_index) const {
+    return stage_index < release_after_.size() ? release_after_[stage_index] : FRAME_BUFFERS_NONE;
+}
+
+size_t BufferLiveness::release(ImageData& image, FrameBufferSet buffers, FrameBufferPool* pool) {
+    size_t bytes = 0;
+    auto release_mat = [&bytes, pool, &image](cv::Mat& mat, bool recyclable) {
+        if (mat.empty()) {
+            return;
+        }
+        bytes += mat.total() * mat.elemSize();
+        // 派生图缓存也持有引用，先移除才能真正释放或归还复用池
+        image.derived_images.evict(mat);
+        if (recyclable && pool) {
+            pool->recycle(mat);
+        } else {
+            mat.release();
+        }
+    };
+
+    if (has_buffer(buffers, FrameBuffer::SOURCE_IMAGE)) {
+        release_mat(image.imageMat, false);
+        release_mat(image.yuvImage.data, false);
+        // YUV 原图按需转换出的整帧BGR（未计入预算，只移除缓存）
+        image.derived_images.evict(image.derived_images.peek(DerivedImageKey(cv::Size(image.width, image.height))));
+    }
+    if (has_buffer(buffers, FrameBuffer::SEG_INPUT)) {
+        release_mat(image.segInResizeMat, true);
+    }
+    if (has_buffer(buffers, FrameBuffer::PARKING_INPUT)) {
+        release_mat(image.parkingResizeMat, true);
+    }
+    if (has_buffer(buffers, FrameBuffer::LABEL_MAP)) {
+        bytes += image.label_map.capacity();
+        std::vector<uint8_t>().swap(image.label_map);
+    }
+    if (has_buffer(buffers, FrameBuffer::MASK)) {
+        release_mat(image.mask, false);
+    }
+    return bytes;
+}
+
+std::string BufferLiveness::describe(FrameBufferSet buffers) {
+    static const std::pair<FrameBuffer, const char*> names[] = {
+        {FrameBuffer::SOURCE_IMAGE, "原图"},
+        {FrameBuffer::SEG_INPUT, "分割输入"},
+        {FrameBuffer::PARKING_INPUT, "违停缩放图"},
+        {FrameBuffer::LABEL_MAP, "标签"},
+        {FrameBuffer::MASK, "Mask"},
+    };
+    std::string text;
+    for (const auto& entry : names) {
+        if (has_buffer(buffers, entry.first)) {
+            if (!text.empty()) {
+                text += "+";
+            }
+            text += entry.second;
+        }
+    }
+    return text.empty() ? "无" : text;
+}
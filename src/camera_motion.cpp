@@ -0,0 +1,167 @@
+#include "camera_motion.h"
+#include "frame_dedup.h"
+#include "stage_profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+
+CameraMotionEstimator::CameraMotionEstimator(const CameraMotionConfig& config)
+    : config_(config) {
+}
+
+void CameraMotionEstimator::set_config(const CameraMotionConfig& config) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    bool layout_changed = config.pyramid_base_width != config_.pyramid_base_width ||
+                          config.pyramid_levels != config_.pyramid_levels ||
+                          config.estimate_level != config_.estimate_level;
+    config_ = config;
+    if (layout_changed) {
+        // 估计层尺寸变化后上一帧不可比较
+        streams_.clear();
+    }
+}
+
+void CameraMotionEstimator::reset() {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    streams_.clear();
+}
+
+void CameraMotionEstimator::build_pyramid(const cv::Mat& image, int base_width, int levels,
+                                          std::vector<cv::Mat>& pyramid) {
+    pyramid.clear();
+    if (image.empty() || base_width <= 0 || levels <= 0) {
+        return;
+    }
+    int width = std::min(base_width, image.cols);
+    int height = std::max(1, image.rows * width / image.cols);
+
+    // 最近邻抽取后再转灰度，避免对全分辨率图像做颜色转换
+    cv::Mat small;
+    cv::resize(image, small, cv::Size(width, height), 0, 0, cv::INTER_NEAREST);
+    cv::Mat base;
+    if (small.channels() == 3) {
+        cv::cvtColor(small, base, cv::COLOR_BGR2GRAY);
+    } else {
+        base = small;
+    }
+    pyramid.reserve(levels);
+    pyramid.push_back(base);
+    for (int level = 1; level < levels; ++level) {
+        const cv::Mat& upper = pyramid.back();
+        if (upper.cols < 16 || upper.rows < 16) {
+            break;
+        }
+        cv::Mat lower;
+        cv::pyrDown(upper, lower);
+        pyramid.push_back(lower);
+    }
+}
+
+cv::Mat CameraMotionEstimator::luma_thumb(const ImageData& image, int thumb_width, int thumb_height) {
+    // 金字塔逐层减半，从后往前找到第一个不小于目标尺寸的层
+    for (auto it = image.luma_pyramid.rbegin(); it != image.luma_pyramid.rend(); ++it) {
+        if (it->cols >= thumb_width && it->rows >= thumb_height) {
+            if (it->cols == thumb_width && it->rows == thumb_height) {
+                return *it;
+            }
+            cv::Mat thumb;
+            cv::resize(*it, thumb, cv::Size(thumb_width, thumb_height), 0, 0, cv::INTER_AREA);
+            return thumb;
+        }
+    }
+    return FrameDeduplicator::compute_signature(image.luma_source(), thumb_width, thumb_height);
+}
+
+void CameraMotionEstimator::process(const ImageDataPtr& image, Checkpoint* checkpoint) {
+    if (!image || !image->has_source()) {
+        return;
+    }
+
+    uint64_t cpu_start = StageProfiler::thread_cpu_ns();
+    CameraMotionConfig config;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        config = config_;
+    }
+
+    // 金字塔构建与相位相关都不持锁，多个输入线程可并行
+    if (image->luma_pyramid.empty()) {
+        // YUV 原图直接使用亮度平面，无需色彩转换
+        build_pyramid(image->luma_source(), config.pyramid_base_width, config.pyramid_levels, image->luma_pyramid);
+    }
+    if (image->luma_pyramid.empty()) {
+        return;
+    }
+    int level = std::min<int>(std::max(0, config.estimate_level), image->luma_pyramid.size() - 1);
+    cv::Mat current;
+    image->luma_pyramid[level].convertTo(current, CV_32F);
+
+    cv::Mat previous;
+    cv::Mat window;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        StreamState& state = streams_[image->stream_id];
+        if (state.window.size() != current.size()) {
+            state.window.release();
+            state.previous.release();
+            cv::createHanningWindow(state.window, current.size(), CV_32F);
+        }
+        previous = state.previous;
+        window = state.window;
+        if (checkpoint) {
+            checkpoint->stream_id = image->stream_id;
+            checkpoint->frame = image.get();
+            checkpoint->previous = state.previous;
+            checkpoint->last_frame = state.last_frame;
+        }
+        state.previous = current;
+        state.last_frame = image.get();
+    }
+
+    CameraMotion motion;
+    if (!previous.empty()) {
+        double response = 0.0;
+        cv::Point2d shift = cv::phaseCorrelate(previous, current, window, &response);
+        double scale = static_cast<double>(image->width) / current.cols;
+        motion.valid = true;
+        motion.dx = static_cast<float>(shift.x * scale);
+        motion.dy = static_cast<float>(shift.y * scale);
+        motion.confidence = static_cast<float>(response);
+        motion.moving = response >= config.min_confidence &&
+                        std::hypot(motion.dx, motion.dy) > config.motion_ratio * image->width;
+        frames_estimated_.fetch_add(1);
+        if (motion.moving) {
+            frames_moving_.fetch_add(1);
+        }
+    }
+    image->camera_motion = motion;
+    frames_processed_.fetch_add(1);
+    cpu_ns_.fetch_add(StageProfiler::thread_cpu_ns() - cpu_start);
+}
+
+void CameraMotionEstimator::revert(const ImageDataPtr& image, const Checkpoint& checkpoint) {
+    if (!image || checkpoint.frame != image.get()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        auto it = streams_.find(checkpoint.stream_id);
+        if (it != streams_.end() && it->second.last_frame == image.get()) {
+            it->second.previous = checkpoint.previous;
+            it->second.last_frame = checkpoint.last_frame;
+        }
+    }
+    if (image->camera_motion.valid) {
+        frames_estimated_.fetch_sub(1);
+        if (image->camera_motion.moving) {
+            frames_moving_.fetch_sub(1);
+        }
+    }
+    // 重新提交时与撤销后的上一帧重新估计
+    image->camera_motion = CameraMotion();
+}
+
+double CameraMotionEstimator::get_average_cpu_us() const {
+    uint64_t frames = frames_processed_.load();
+    return frames > 0 ? cpu_ns_.load() / 1000.0 / frames : 0.0;
+}
@@ -0,0 +1,242 @@
+#include "cpu_inference.h"
+#include "logger_manager.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+CpuDnnModel::CpuDnnModel(const std::string& model_path, int threads)
+    : model_path_(model_path), threads_(threads) {
+    if (threads_ <= 0) {
+        threads_ = std::max(1u, std::thread::hardware_concurrency() / 2);
+    }
+#ifndef _OPENMP
+    threads_ = 1;
+#endif
+}
+
+bool CpuDnnModel::load() {
+    nets_.clear();
+    try {
+        for (int i = 0; i < threads_; ++i) {
+            cv::dnn::Net net = cv::dnn::readNetFromONNX(model_path_);
+            if (net.empty()) {
+                LOG_ERROR_F("❌ CPU模型加载失败: %s", model_path_.c_str());
+                nets_.clear();
+                return false;
+            }
+            net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+            net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+            nets_.push_back(std::move(net));
+        }
+    } catch (const cv::Exception& e) {
+        LOG_ERROR_F("❌ CPU模型加载失败: %s, %s", model_path_.c_str(), e.what());
+        nets_.clear();
+        return false;
+    }
+    LOG_INFO_F("✅ CPU模型加载成功: %s，%d 个推理实例", model_path_.c_str(), threads_);
+    return true;
+}
+
+bool CpuDnnModel::parallel_infer(size_t count, const std::function<bool(cv::dnn::Net&, size_t)>& fn) {
+    if (nets_.empty()) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+    std::atomic<bool> success{true};
+    const long total = static_cast<long>(count);
+#ifdef _OPENMP
+    const int threads = static_cast<int>(std::min(nets_.size(), count));
+    #pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+#endif
+    for (long i = 0; i < total; ++i) {
+#ifdef _OPENMP
+        cv::dnn::Net& net = nets_[omp_get_thread_num()];
+#else
+        cv::dnn::Net& net = nets_[0];
+#endif
+        // 异常不能跨出 OpenMP 并行区
+        try {
+            if (!fn(net, static_cast<size_t>(i))) {
+                success.store(false, std::memory_order_relaxed);
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR_F("❌ CPU推理异常: %s", e.what());
+            success.store(false, std::memory_order_relaxed);
+        }
+    }
+    return success.load();
+}
+
+CpuSegmentationModel::CpuSegmentationModel(const std::string& model_path, int threads, const Params& params)
+    : CpuDnnModel(model_path, threads), params_(params) {}
+
+bool CpuSegmentationModel::infer(const std::vector<cv::Mat>& images, std::vector<CpuSegResult>& results) {
+    results.assign(images.size(), CpuSegResult());
+    return parallel_infer(images.size(), [this, &images, &results](cv::dnn::Net& net, size_t i) {
+        return infer_one(net, images[i], results[i]);
+    });
+}
+
+bool CpuSegmentationModel::infer_one(cv::dnn::Net& net, const cv::Mat& image, CpuSegResult& result) const {
+    if (image.empty()) {
+        return false;
+    }
+    cv::Mat blob = cv::dnn::blobFromImage(image, params_.scale,
+                                          cv::Size(params_.input_width, params_.input_height),
+                                          params_.mean, params_.swap_rb, false);
+    net.setInput(blob);
+    cv::Mat output = net.forward();
+
+    // [1, C, H, W] 类别分数 或 [1, H, W] / [1, 1, H, W] 标签
+    int classes = 1;
+    int height = 0;
+    int width = 0;
+    if (output.dims == 4) {
+        classes = output.size[1];
+        height = output.size[2];
+        width = output.size[3];
+    } else if (output.dims == 3) {
+        height = output.size[1];
+        width = output.size[2];
+    } else {
+        LOG_ERROR_F("❌ 不支持的分割输出维度: %d", output.dims);
+        return false;
+    }
+
+    const size_t pixels = static_cast<size_t>(height) * width;
+    result.height = height;
+    result.width = width;
+    result.label_map.resize(pixels);
+
+    if (classes == 1) {
+        cv::Mat labels(height, width, output.type(), output.ptr());
+        cv::Mat label_u8(height, width, CV_8UC1, result.label_map.data());
+        labels.convertTo(label_u8, CV_8U);
+        return true;
+    }
+
+    if (output.type() != CV_32F) {
+        output.convertTo(output, CV_32F);
+    }
+    // 逐类别平面顺序扫描，保持访存连续
+    const float* scores = output.ptr<float>();
+    std::vector<float> best(scores, scores + pixels);
+    std::memset(result.label_map.data(), 0, pixels);
+    for (int c = 1; c < classes; ++c) {
+        const float* plane = scores + static_cast<size_t>(c) * pixels;
+        for (size_t p = 0; p < pixels; ++p) {
+            if (plane[p] > best[p]) {
+                best[p] = plane[p];
+                result.label_map[p] = static_cast<uint8_t>(c);
+            }
+        }
+    }
+    return true;
+}
+
+CpuDetectionModel::CpuDetectionModel(const std::string& model_path, int threads, const Params& params)
+    : CpuDnnModel(model_path, threads), params_(params) {}
+
+bool CpuDetectionModel::infer(const std::vector<cv::Mat>& images,
+                              std::vector<std::vector<ImageData::BoundingBox>>& results) {
+    results.assign(images.size(), std::vector<ImageData::BoundingBox>());
+    return parallel_infer(images.size(), [this, &images, &results](cv::dnn::Net& net, size_t i) {
+        return infer_one(net, images[i], results[i]);
+    });
+}
+
+bool CpuDetectionModel::infer_one(cv::dnn::Net& net, const cv::Mat& image,
+                                  std::vector<ImageData::BoundingBox>& boxes) const {
+    if (image.empty()) {
+        return false;
+    }
+    const int size = params_.input_size;
+
+    // letterbox：等比缩放后居中填充
+    float ratio = std::min(static_cast<float>(size) / image.cols, static_cast<float>(size) / image.rows);
+    int resized_w = std::max(1, static_cast<int>(std::round(image.cols * ratio)));
+    int resized_h = std::max(1, static_cast<int>(std::round(image.rows * ratio)));
+    int pad_x = (size - resized_w) / 2;
+    int pad_y = (size - resized_h) / 2;
+    cv::Mat input(size, size, CV_8UC3, cv::Scalar(114, 114, 114));
+    cv::resize(image, input(cv::Rect(pad_x, pad_y, resized_w, resized_h)), cv::Size(resized_w, resized_h));
+
+    cv::Mat blob = cv::dnn::blobFromImage(input, 1.0 / 255.0, cv::Size(size, size), cv::Scalar(), true, false);
+    net.setInput(blob);
+    cv::Mat output = net.forward();
+    if (output.dims != 3) {
+        LOG_ERROR_F("❌ 不支持的检测输出维度: %d", output.dims);
+        return false;
+    }
+
+    // 统一为每行一个候选框
+    cv::Mat rows;
+    int attr_offset;   // 类别分数起始列
+    if (params_.ultralytics) {
+        cv::Mat raw(output.size[1], output.size[2], CV_32F, output.ptr<float>());
+        cv::transpose(raw, rows);
+        attr_offset = 4;
+    } else {
+        rows = cv::Mat(output.size[1], output.size[2], CV_32F, output.ptr<float>());
+        attr_offset = 5;
+    }
+    const int num_classes = rows.cols - attr_offset;
+    if (num_classes <= 0) {
+        LOG_ERROR_F("❌ 检测输出列数异常: %d", rows.cols);
+        return false;
+    }
+
+    std::vector<cv::Rect> rects;
+    std::vector<float> scores;
+    std::vector<int> class_ids;
+    for (int r = 0; r < rows.rows; ++r) {
+        const float* row = rows.ptr<float>(r);
+        const float objectness = params_.ultralytics ? 1.0f : row[4];
+        if (objectness < params_.conf_threshold) {
+            continue;
+        }
+        const float* class_scores = row + attr_offset;
+        int best_class = static_cast<int>(std::max_element(class_scores, class_scores + num_classes) - class_scores);
+        float score = class_scores[best_class] * objectness;
+        if (score < params_.conf_threshold) {
+            continue;
+        }
+        // 中心点格式，映射回裁剪图坐标
+        float left = (row[0] - row[2] * 0.5f - pad_x) / ratio;
+        float top = (row[1] - row[3] * 0.5f - pad_y) / ratio;
+        float width = row[2] / ratio;
+        float height = row[3] / ratio;
+        rects.emplace_back(static_cast<int>(left), static_cast<int>(top),
+                           static_cast<int>(width), static_cast<int>(height));
+        scores.push_back(score);
+        class_ids.push_back(best_class);
+    }
+
+    std::vector<int> keep;
+    cv::dnn::NMSBoxes(rects, scores, params_.conf_threshold, params_.nms_threshold, keep);
+    boxes.reserve(keep.size());
+    for (int k : keep) {
+        const cv::Rect& rect = rects[k];
+        ImageData::BoundingBox box;
+        box.left = std::max(0, rect.x);
+        box.top = std::max(0, rect.y);
+        box.right = std::min(image.cols - 1, rect.x + rect.width);
+        box.bottom = std::min(image.rows - 1, rect.y + rect.height);
+        box.confidence = scores[k];
+        box.class_id = class_ids[k];
+        box.track_id = -1;
+        box.is_still = false;
+        box.status = ObjectStatus::NORMAL;
+        if (box.right > box.left && box.bottom > box.top) {
+            boxes.push_back(box);
+        }
+    }
+    return true;
+}
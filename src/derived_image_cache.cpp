@@ -0,0 +1,228 @@
+#include "derived_image_cache.h"
+#include <cmath>
+#include <stdexcept>
+#include <tuple>
+
+std::atomic<uint64_t> DerivedImageCache::hits_{0};
+std::atomic<uint64_t> DerivedImageCache::source_computes_{0};
+std::atomic<uint64_t> DerivedImageCache::derived_computes_{0};
+
+bool DerivedImageKey::operator<(const DerivedImageKey& other) const {
+    return std::make_tuple(size.width, size.height, static_cast<int>(format), crop.x, crop.y, crop.width, crop.height) <
+           std::make_tuple(other.size.width, other.size.height, static_cast<int>(other.format),
+                           other.crop.x, other.crop.y, other.crop.width, other.crop.height);
+}
+
+namespace {
+
+// 缩放来源与目标宽高比的最大相对偏差（容许尺寸取整带来的偏差）
+constexpr double kMaxAspectDeviation = 0.02;
+
+bool is_color(DerivedImageFormat format) {
+    return format != DerivedImageFormat::GRAY;
+}
+
+int conversion_code(DerivedImageFormat from, DerivedImageFormat to) {
+    if (from == DerivedImageFormat::GRAY) {
+        return to == DerivedImageFormat::RGB ? cv::COLOR_GRAY2RGB : cv::COLOR_GRAY2BGR;
+    }
+    if (to == DerivedImageFormat::GRAY) {
+        return from == DerivedImageFormat::RGB ? cv::COLOR_RGB2GRAY : cv::COLOR_BGR2GRAY;
+    }
+    return from == DerivedImageFormat::RGB ? cv::COLOR_RGB2BGR : cv::COLOR_BGR2RGB;
+}
+
+// 宽高比相同（在容差内）：a.w / a.h 与 b.w / b.h 的相对偏差不超过 kMaxAspectDeviation
+bool same_aspect(cv::Size a, cv::Size b) {
+    double lhs = static_cast<double>(a.width) * b.height;
+    double rhs = static_cast<double>(b.width) * a.height;
+    return std::abs(lhs - rhs) <= kMaxAspectDeviation * std::min(lhs, rhs);
+}
+
+}  // namespace
+
+cv::Mat DerivedImageCache::get(const cv::Mat& source, const DerivedImageKey& key, const Allocator& allocator) {
+    if (source.empty()) {
+        return cv::Mat();
+    }
+    DerivedImageFormat source_format = source.channels() == 1 ? DerivedImageFormat::GRAY : DerivedImageFormat::BGR;
+    return get_or_compute(source.size(), key, [&](const cv::Rect& crop) {
+        return compute(source(crop), source_format, key, allocator);
+    }, allocator);
+}
+
+cv::Mat DerivedImageCache::get(const YuvImage& source, const DerivedImageKey& key, const Allocator& allocator) {
+    if (!source.valid()) {
+        return cv::Mat();
+    }
+    return get_or_compute(source.size(), key, [&](const cv::Rect& crop) {
+        return compute_yuv(source, crop, key, allocator);
+    }, allocator);
+}
+
+cv::Mat DerivedImageCache::get_or_compute(cv::Size source_size, const DerivedImageKey& key,
+                                          const SourceCompute& compute_from_source, const Allocator& allocator) {
+    if (key.size.width <= 0 || key.size.height <= 0) {
+        return cv::Mat();
+    }
+
+    cv::Rect source_rect(cv::Point(0, 0), source_size);
+    cv::Rect crop = key.crop.empty() ? source_rect : (key.crop & source_rect);
+    if (crop.empty()) {
+        return cv::Mat();
+    }
+
+    std::shared_ptr<Entry> entry;
+    std::shared_ptr<Entry> base;
+    DerivedImageFormat base_format = DerivedImageFormat::BGR;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::shared_ptr<Entry>& slot = entries_[key];
+        if (!slot) {
+            slot = std::make_shared<Entry>();
+        }
+        entry = slot;
+        if (entry->ready.load(std::memory_order_acquire)) {
+            hits_.fetch_add(1);
+            return entry->image;
+        }
+        // 只从不大于源图的派生图缩放，否则不如直接从源图计算
+        base = find_base(key, crop.size(), base_format);
+    }
+
+    try {
+        // 同一键只计算一次；计算失败时抛出异常，call_once 允许下一个申请者重试
+        std::call_once(entry->once, [&]() {
+            cv::Mat result;
+            if (base) {
+                result = compute(base->image, base_format, key, allocator);
+                derived_computes_.fetch_add(1);
+            } else {
+                result = compute_from_source(crop);
+                source_computes_.fetch_add(1);
+            }
+            if (result.empty()) {
+                throw std::runtime_error("derived image empty");
+            }
+            entry->image = result;
+            entry->ready.store(true, std::memory_order_release);
+        });
+    } catch (const std::exception&) {
+        return cv::Mat();
+    }
+    return entry->image;
+}
+
+cv::Mat DerivedImageCache::peek(const DerivedImageKey& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end() || !it->second->ready.load(std::memory_order_acquire)) {
+        return cv::Mat();
+    }
+    return it->second->image;
+}
+
+void DerivedImageCache::evict(const cv::Mat& mat) {
+    if (!mat.data) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        const Entry& entry = *it->second;
+        if (entry.ready.load(std::memory_order_acquire) && entry.image.data == mat.data) {
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void DerivedImageCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+size_t DerivedImageCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+std::shared_ptr<DerivedImageCache::Entry> DerivedImageCache::find_base(const DerivedImageKey& key, cv::Size source_size,
+                                                                       DerivedImageFormat& base_format) const {
+    std::shared_ptr<Entry> best;
+    int64_t best_area = 0;
+    for (const auto& item : entries_) {
+        const DerivedImageKey& candidate = item.first;
+        if (candidate.crop != key.crop || !item.second->ready.load(std::memory_order_acquire)) {
+            continue;
+        }
+        // 灰度图不能还原彩色
+        if (is_color(key.format) && !is_color(candidate.format)) {
+            continue;
+        }
+        if (candidate.size.width < key.size.width || candidate.size.height < key.size.height ||
+            candidate.size.width > source_size.width || candidate.size.height > source_size.height) {
+            continue;
+        }
+        // 宽高比不同的派生图已在两个方向按不同比例重采样，再缩放会叠加各向异性失真，不如从源图计算
+        if (!same_aspect(candidate.size, key.size)) {
+            continue;
+        }
+        int64_t area = static_cast<int64_t>(candidate.size.width) * candidate.size.height;
+        if (!best || area < best_area) {
+            best = item.second;
+            best_area = area;
+            base_format = candidate.format;
+        }
+    }
+    return best;
+}
+
+cv::Mat DerivedImageCache::compute(const cv::Mat& base, DerivedImageFormat base_format, const DerivedImageKey& key,
+                                   const Allocator& allocator) {
+    const bool convert = base_format != key.format;
+
+    // 先缩放再转换格式，转换在较小的图上进行
+    cv::Mat scaled;
+    if (!convert && allocator) {
+        scaled = allocator(key.size.height, key.size.width, base.type());
+    }
+    if (base.size() == key.size) {
+        if (convert) {
+            scaled = base;
+        } else {
+            // 拷贝而非引用，派生图不持有原图数据
+            base.copyTo(scaled);
+        }
+    } else {
+        cv::resize(base, scaled, key.size);
+    }
+    if (!convert) {
+        return scaled;
+    }
+
+    cv::Mat converted;
+    if (allocator) {
+        converted = allocator(key.size.height, key.size.width, CV_MAKETYPE(base.depth(), is_color(key.format) ? 3 : 1));
+    }
+    cv::cvtColor(scaled, converted, conversion_code(base_format, key.format));
+    return converted;
+}
+
+cv::Mat DerivedImageCache::compute_yuv(const YuvImage& source, const cv::Rect& crop, const DerivedImageKey& key,
+                                       const Allocator& allocator) {
+    const bool color = is_color(key.format);
+    cv::Mat result;
+    if (allocator) {
+        result = allocator(key.size.height, key.size.width, color ? CV_8UC3 : CV_8UC1);
+    }
+    if (color && key.format == DerivedImageFormat::BGR && crop.size() == source.size() && key.size == crop.size()) {
+        // 整帧 BGR 走 OpenCV 的整帧转换实现
+        yuv::to_bgr(source, result);
+    } else if (color) {
+        yuv::convert_resize(source, crop, key.size, result, key.format == DerivedImageFormat::RGB);
+    } else {
+        yuv::luma_resize(source, crop, key.size, result);
+    }
+    return result;
+}
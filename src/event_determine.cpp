@@ -143,7 +143,7 @@ void EventDetermine::perform_event_determination(ImageDataPtr image, int thread_
     
     if(should_draw_lane && !lane_show_image_path_.empty()) {
       // 绘制车道线结果
-      cv::Mat show_mat = image->imageMat.clone();
+      cv::Mat show_mat = image->source_bgr().clone();
       drawEmergencyLaneQuarterPoints(show_mat, eRes);
       // 保存车道线结果图像
       std::string filename = lane_show_image_path_ + "/" + std::to_string(image->frame_idx) + ".jpg";
@@ -0,0 +1,383 @@
+#include "event_journal.h"
+#include "highway_event.h"
+#include "logger_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace event_journal;
+
+namespace {
+
+uint64_t now_ms() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+size_t round_up_to_power_of_2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+bool is_event_status(ObjectStatus status) {
+    return status != ObjectStatus::NORMAL && status != ObjectStatus::UNKNOWN;
+}
+
+} // namespace
+
+EventJournal::EventJournal(const EventJournalConfig& config)
+    : config_(config) {
+    config_.close_gap_frames = std::max(1, config_.close_gap_frames);
+    config_.time_bucket_ms = std::max<int64_t>(1, config_.time_bucket_ms);
+    config_.initial_records = std::max<size_t>(1, config_.initial_records);
+}
+
+EventJournal::~EventJournal() {
+    close();
+}
+
+bool EventJournal::open(const std::string& path) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOG_ERROR_F("❌ 无法打开事件日志 %s: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+    // 记录数在文件头中，两个写入方会互相覆盖已提交的记录
+    if (flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+        LOG_ERROR_F("❌ 事件日志 %s 已被其他写入方打开: %s", path.c_str(), std::strerror(errno));
+        close();
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        close();
+        return false;
+    }
+    bool created = st.st_size == 0;
+    size_t capacity = created ? config_.initial_records
+                              : (static_cast<size_t>(st.st_size) - std::min<size_t>(st.st_size, sizeof(EventJournalHeader))) /
+                                    sizeof(EventJournalRecord);
+    if (!grow(capacity)) {
+        LOG_ERROR_F("❌ 无法映射事件日志 %s", path.c_str());
+        close();
+        return false;
+    }
+
+    EventJournalHeader header;
+    if (created) {
+        std::memset(&header, 0, sizeof(header));
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.record_bytes = sizeof(EventJournalRecord);
+        std::memcpy(map_, &header, sizeof(header));
+    } else {
+        std::memcpy(&header, map_, sizeof(header));
+        if (header.magic != kMagic || header.version != kVersion || header.record_bytes != sizeof(EventJournalRecord) ||
+            header.record_count > map_records_) {
+            LOG_ERROR_F("❌ 事件日志 %s 格式无效", path.c_str());
+            close();
+            return false;
+        }
+        // 重建内存索引
+        for (size_t i = 0; i < header.record_count; ++i) {
+            EventJournalRecord record;
+            std::memcpy(&record, map_ + sizeof(EventJournalHeader) + i * sizeof(EventJournalRecord), sizeof(record));
+            index_record(i, record);
+            last_end_ms_ = std::max(last_end_ms_, record.end_ms);
+        }
+        record_count_.store(header.record_count);
+    }
+
+    slots_.assign(round_up_to_power_of_2(std::max<size_t>(2, config_.queue_slots)), Slot());
+    for (auto& slot : slots_) {
+        slot.boxes.reserve(64);
+    }
+    slot_mask_ = slots_.size() - 1;
+    write_pos_.store(0);
+    read_pos_.store(0);
+
+    running_.store(true);
+    journal_thread_ = std::thread(&EventJournal::journal_thread_func, this);
+    LOG_INFO_F("📝 事件日志: %s（已有 %llu 条记录）", path.c_str(),
+               static_cast<unsigned long long>(record_count_.load()));
+    return true;
+}
+
+void EventJournal::close() {
+    if (running_.exchange(false) && journal_thread_.joinable()) {
+        journal_thread_.join();
+    }
+
+    // 日志线程已退出，进行中的事件以最后一次观察为结束
+    if (map_) {
+        for (auto& stream : streams_) {
+            for (auto& entry : stream.second.open) {
+                close_event(entry.second);
+            }
+        }
+        msync(map_, sizeof(EventJournalHeader) + map_records_ * sizeof(EventJournalRecord), MS_SYNC);
+    }
+    streams_.clear();
+
+    std::unique_lock<std::shared_mutex> lock(map_mutex_);
+    if (map_) {
+        munmap(map_, sizeof(EventJournalHeader) + map_records_ * sizeof(EventJournalRecord));
+        map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    map_records_ = 0;
+    record_count_.store(0);
+    track_index_.clear();
+    bucket_first_.clear();
+    bucket_base_ms_ = 0;
+    open_snapshot_.clear();
+    open_event_count_.store(0);
+    last_end_ms_ = 0;
+}
+
+void EventJournal::observe(const ImageData& image) {
+    if (!running_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    // 单生产者约束：另一个线程正在写入时放弃本次观察，不能与其写同一槽位
+    if (producing_.exchange(true, std::memory_order_acquire)) {
+        if (concurrent_observes_.fetch_add(1, std::memory_order_relaxed) == 0) {
+            LOG_ERROR("❌ EventJournal::observe() 被多个线程并发调用，违反单生产者约束，并发的观察已丢弃");
+        }
+        dropped_observations_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t pos = write_pos_.load(std::memory_order_relaxed);
+    if (pos - read_pos_.load(std::memory_order_acquire) >= slots_.size()) {
+        dropped_observations_.fetch_add(1, std::memory_order_relaxed);
+        producing_.store(false, std::memory_order_release);
+        return;
+    }
+
+    Slot& slot = slots_[pos & slot_mask_];
+    slot.stream_id = image.stream_id;
+    slot.frame_idx = image.frame_idx;
+    slot.timestamp_ms = now_ms();
+    slot.boxes.clear();
+    for (const auto& box : image.track_results) {
+        // 与对外结果一致：静止目标按违停类事件计
+        ObjectStatus status = ResultView::remap_status(box.status, box.is_still);
+        if (box.track_id <= 0 || !is_event_status(status)) {
+            continue;
+        }
+        slot.boxes.push_back({box.track_id, static_cast<int8_t>(status), box.confidence,
+                              box.left, box.top, box.right, box.bottom});
+    }
+    write_pos_.store(pos + 1, std::memory_order_release);
+    producing_.store(false, std::memory_order_release);
+}
+
+void EventJournal::journal_thread_func() {
+    while (true) {
+        uint64_t pos = read_pos_.load(std::memory_order_relaxed);
+        if (pos == write_pos_.load(std::memory_order_acquire)) {
+            if (!running_.load()) {
+                break;
+            }
+            // 生产端不做唤醒（保持无锁），空闲时短暂轮询
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+        consume(slots_[pos & slot_mask_]);
+        read_pos_.store(pos + 1, std::memory_order_release);
+    }
+}
+
+void EventJournal::consume(const Slot& slot) {
+    StreamState& state = streams_[slot.stream_id];
+    if (state.has_frame && slot.frame_idx <= state.last_frame) {
+        dropped_observations_.fetch_add(1);   // 乱序到达的帧无法并入已推进的区间
+        return;
+    }
+    state.last_frame = slot.frame_idx;
+    state.has_frame = true;
+    // 结束间隔按本流自己的帧数计：frame_idx 是检测器内所有流共用的序号，只作为记录中的帧号
+    uint64_t seq = state.frames_seen++;
+
+    bool changed = !slot.boxes.empty();
+    for (const auto& box : slot.boxes) {
+        auto it = state.open.find(box.track_id);
+        if (it != state.open.end() && it->second.record.event_type != box.event_type) {
+            // 事件类型变化（如占道 -> 应急车道停车）：结束旧事件，开始新事件
+            close_event(it->second);
+            state.open.erase(it);
+            it = state.open.end();
+        }
+        if (it == state.open.end()) {
+            OpenEvent event;
+            EventJournalRecord& record = event.record;
+            std::memset(&record, 0, sizeof(record));
+            record.stream_id = slot.stream_id;
+            record.track_id = box.track_id;
+            record.event_type = box.event_type;
+            record.open = 1;
+            record.peak_confidence = box.confidence;
+            record.start_frame = record.end_frame = slot.frame_idx;
+            record.start_ms = record.end_ms = slot.timestamp_ms;
+            record.left = box.left;
+            record.top = box.top;
+            record.right = box.right;
+            record.bottom = box.bottom;
+            event.last_seen_seq = seq;
+            state.open.emplace(box.track_id, event);
+        } else {
+            EventJournalRecord& record = it->second.record;
+            record.end_frame = slot.frame_idx;
+            record.end_ms = slot.timestamp_ms;
+            record.peak_confidence = std::max(record.peak_confidence, box.confidence);
+            it->second.last_seen_seq = seq;
+        }
+    }
+
+    for (auto it = state.open.begin(); it != state.open.end();) {
+        if (seq - it->second.last_seen_seq > static_cast<uint64_t>(config_.close_gap_frames)) {
+            close_event(it->second);
+            it = state.open.erase(it);
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+
+    if (changed) {
+        std::vector<OpenEvent> snapshot;
+        for (const auto& stream : streams_) {
+            for (const auto& entry : stream.second.open) {
+                snapshot.push_back(entry.second);
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(map_mutex_);
+        open_snapshot_.swap(snapshot);
+        open_event_count_.store(open_snapshot_.size());
+    }
+}
+
+void EventJournal::close_event(const OpenEvent& event) {
+    EventJournalRecord record = event.record;
+    record.open = 0;
+    if (!append(record)) {
+        LOG_WARN_F("⚠️ 事件日志追加失败（流 %d 轨迹 %d）", record.stream_id, record.track_id);
+    }
+}
+
+bool EventJournal::grow(size_t min_records) {
+    size_t capacity = std::max(min_records, map_records_ * 2);
+    size_t bytes = sizeof(EventJournalHeader) + capacity * sizeof(EventJournalRecord);
+    if (ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+        return false;
+    }
+    void* map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    std::unique_lock<std::shared_mutex> lock(map_mutex_);
+    if (map_) {
+        munmap(map_, sizeof(EventJournalHeader) + map_records_ * sizeof(EventJournalRecord));
+    }
+    map_ = static_cast<uint8_t*>(map);
+    map_records_ = capacity;
+    return true;
+}
+
+bool EventJournal::append(const EventJournalRecord& input) {
+    EventJournalRecord record = input;
+    // 文件按 end_ms 有序是时间桶索引的前提，系统时间回拨时钳位到上一条
+    record.end_ms = std::max(record.end_ms, last_end_ms_);
+    last_end_ms_ = record.end_ms;
+
+    uint64_t count = record_count_.load();
+    if (count >= map_records_ && !grow(count + 1)) {
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(map_mutex_);
+    std::memcpy(map_ + sizeof(EventJournalHeader) + count * sizeof(EventJournalRecord), &record, sizeof(record));
+    // 记录写完后才提交计数，崩溃时最多丢失最后一条
+    uint64_t committed = count + 1;
+    std::memcpy(map_ + offsetof(EventJournalHeader, record_count), &committed, sizeof(committed));
+    index_record(count, record);
+    record_count_.store(committed);
+    return true;
+}
+
+void EventJournal::index_record(size_t i, const EventJournalRecord& record) {
+    track_index_[track_key(record.stream_id, record.track_id)].push_back(static_cast<uint32_t>(i));
+    if (bucket_first_.empty()) {
+        bucket_base_ms_ = record.end_ms - record.end_ms % config_.time_bucket_ms;
+    }
+    size_t bucket = (record.end_ms - bucket_base_ms_) / config_.time_bucket_ms;
+    while (bucket_first_.size() <= bucket) {
+        bucket_first_.push_back(static_cast<uint32_t>(i));
+    }
+}
+
+std::vector<EventJournalRecord> EventJournal::query_time_range(uint64_t from_ms, uint64_t to_ms) const {
+    std::vector<EventJournalRecord> result;
+    std::shared_lock<std::shared_mutex> lock(map_mutex_);
+    size_t count = record_count_.load();
+
+    // 从 from_ms 所在时间桶的第一条记录开始，之前的记录都已在 from_ms 前结束
+    size_t first = 0;
+    if (!bucket_first_.empty() && from_ms > bucket_base_ms_) {
+        size_t bucket = (from_ms - bucket_base_ms_) / config_.time_bucket_ms;
+        first = bucket < bucket_first_.size() ? bucket_first_[bucket] : count;
+    }
+    for (size_t i = first; i < count; ++i) {
+        EventJournalRecord record;
+        std::memcpy(&record, map_ + sizeof(EventJournalHeader) + i * sizeof(EventJournalRecord), sizeof(record));
+        if (record.end_ms >= from_ms && record.start_ms <= to_ms) {
+            result.push_back(record);
+        }
+    }
+    for (const auto& event : open_snapshot_) {
+        if (event.record.end_ms >= from_ms && event.record.start_ms <= to_ms) {
+            result.push_back(event.record);
+        }
+    }
+    return result;
+}
+
+std::vector<EventJournalRecord> EventJournal::query_recent(uint64_t last_ms) const {
+    uint64_t now = now_ms();
+    return query_time_range(now > last_ms ? now - last_ms : 0, UINT64_MAX);
+}
+
+std::vector<EventJournalRecord> EventJournal::query_track(int32_t stream_id, int32_t track_id) const {
+    std::vector<EventJournalRecord> result;
+    std::shared_lock<std::shared_mutex> lock(map_mutex_);
+    auto it = track_index_.find(track_key(stream_id, track_id));
+    if (it != track_index_.end()) {
+        result.reserve(it->second.size());
+        for (uint32_t i : it->second) {
+            EventJournalRecord record;
+            std::memcpy(&record, map_ + sizeof(EventJournalHeader) + i * sizeof(EventJournalRecord), sizeof(record));
+            result.push_back(record);
+        }
+    }
+    for (const auto& event : open_snapshot_) {
+        if (event.record.stream_id == stream_id && event.record.track_id == track_id) {
+            result.push_back(event.record);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,427 @@
+#include "evidence_recorder.h"
+#include "highway_event.h"
+#include "logger_manager.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// 片段号与实例编号进程内唯一：多个检测器共用输出目录时目录名不冲突
+std::atomic<uint64_t> g_next_clip_id{0};
+std::atomic<uint64_t> g_next_instance_id{0};
+
+// 进程内所有采集器共享的缓存预算（与流水线在途内存预算相互独立）
+const std::shared_ptr<MemoryBudget>& evidence_budget() {
+    // 不析构：进程退出时仍可能有片段帧在释放占用
+    static auto* instance = new std::shared_ptr<MemoryBudget>(std::make_shared<MemoryBudget>());
+    return *instance;
+}
+
+uint64_t now_ms() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+bool make_dir(const std::string& path) {
+    return ::mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+// 创建新目录，已存在时追加序号；成功时 name 为实际使用的目录名
+bool make_new_dir(const std::string& parent, std::string& name) {
+    std::string base = name;
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+        if (attempt > 0) {
+            name = base + "_" + std::to_string(attempt);
+        }
+        if (::mkdir((parent + "/" + name).c_str(), 0755) == 0) {
+            return true;
+        }
+        if (errno != EEXIST) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// 在文件锁内一次写入（追加方式打开的文件，多个实例/进程的行不会交错）
+bool write_locked(int fd, const std::string& text) {
+    if (flock(fd, LOCK_EX) != 0) {
+        return false;
+    }
+    size_t offset = 0;
+    while (offset < text.size()) {
+        ssize_t n = ::write(fd, text.data() + offset, text.size() - offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    flock(fd, LOCK_UN);
+    return offset == text.size();
+}
+
+} // namespace
+
+EvidenceRecorder::EvidenceRecorder(const EvidenceRecorderConfig& config)
+    : config_(config) {
+    config_.thumb_width = std::max(16, config_.thumb_width);
+    config_.jpeg_quality = std::min(100, std::max(0, config_.jpeg_quality));
+    config_.frame_stride = std::max(1, config_.frame_stride);
+    config_.pre_event_frames = std::max(0, config_.pre_event_frames);
+    config_.post_event_frames = std::max(0, config_.post_event_frames);
+    config_.max_clip_frames = std::max(config_.post_event_frames, config_.max_clip_frames);
+    config_.close_gap_frames = std::max(1, config_.close_gap_frames);
+    config_.encode_threads = std::max(1, config_.encode_threads);
+    ring_capacity_ = (config_.pre_event_frames + config_.frame_stride - 1) / config_.frame_stride;
+    instance_id_ = g_next_instance_id.fetch_add(1);
+    budget_account_ = evidence_budget()->open_account("evidence");
+    evidence_budget()->raise_limit(config_.memory_budget_bytes);
+}
+
+EvidenceRecorder::~EvidenceRecorder() {
+    stop();
+}
+
+bool EvidenceRecorder::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return true;
+    }
+    if (config_.output_dir.empty() || !make_dir(config_.output_dir)) {
+        LOG_ERROR_F("❌ 无法创建取证片段目录: %s", config_.output_dir.c_str());
+        return false;
+    }
+
+    std::string index_path = config_.output_dir + "/index.csv";
+    index_fd_ = ::open(index_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (index_fd_ < 0) {
+        LOG_ERROR_F("❌ 无法打开取证片段索引: %s", index_path.c_str());
+        return false;
+    }
+    // 表头在文件锁内判断并写入，共用目录的其他实例不会重复写表头
+    bool header_ok = flock(index_fd_, LOCK_EX) == 0;
+    struct stat st;
+    if (header_ok && fstat(index_fd_, &st) == 0 && st.st_size == 0) {
+        static const char kHeader[] =
+            "clip_id,stream_id,trigger_frame,first_frame,last_frame,first_ms,last_ms,frames,events,dir\n";
+        header_ok = ::write(index_fd_, kHeader, sizeof(kHeader) - 1) == static_cast<ssize_t>(sizeof(kHeader) - 1);
+    }
+    flock(index_fd_, LOCK_UN);
+    if (!header_ok) {
+        LOG_ERROR_F("❌ 无法写入取证片段索引: %s", index_path.c_str());
+        ::close(index_fd_);
+        index_fd_ = -1;
+        return false;
+    }
+
+    encode_pool_ = std::make_unique<ThreadPool>(config_.encode_threads);
+    budget_account_->activate();
+    budget_account_->reset_stats();
+    accepting_ = true;
+    running_ = true;
+    writer_thread_ = std::thread(&EvidenceRecorder::writer_thread_func, this);
+    LOG_INFO_F("🎞️ 事件取证片段输出到: %s（进程内采集器共享内存预算 %zu MB）", config_.output_dir.c_str(),
+               evidence_budget()->get_limit() >> 20);
+    return true;
+}
+
+void EvidenceRecorder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        accepting_ = false;
+        // 进行中的片段以已采集的帧为准提前结束
+        for (auto& entry : streams_) {
+            if (entry.second.clip) {
+                finish_clip(entry.second);
+            }
+        }
+    }
+
+    // 线程池停止前会执行完队列中的编码任务，此后所有片段帧都已就绪
+    encode_pool_->stop();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    writer_cv_.notify_all();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    encode_pool_.reset();
+    streams_.clear();
+    // 配额归还给其他运行中的采集器
+    budget_account_->deactivate();
+    ::close(index_fd_);
+    index_fd_ = -1;
+}
+
+void EvidenceRecorder::submit(const ImageDataPtr& image) {
+    if (!image || !image->has_source()) {
+        return;
+    }
+    uint64_t timestamp_ms = now_ms();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!accepting_) {
+        return;
+    }
+    StreamState& state = streams_[image->stream_id];
+    uint64_t seq = state.frames_seen++;
+
+    // 触发判断：(轨迹, 事件类型) 首次出现或间隔超过 close_gap_frames 后重新出现
+    for (const auto& box : image->track_results) {
+        ObjectStatus status = ResultView::remap_status(box.status, box.is_still);
+        if (box.track_id <= 0 || status == ObjectStatus::NORMAL || status == ObjectStatus::UNKNOWN) {
+            continue;
+        }
+        uint64_t key = event_key(box.track_id, static_cast<int>(status));
+        auto it = state.event_last_seen.find(key);
+        bool is_new = it == state.event_last_seen.end() ||
+                      seq - it->second > static_cast<uint64_t>(config_.close_gap_frames);
+        state.event_last_seen[key] = seq;
+        if (!is_new) {
+            continue;
+        }
+        if (!state.clip) {
+            state.clip = std::make_unique<Clip>();
+            state.clip->clip_id = g_next_clip_id.fetch_add(1);
+            state.clip->stream_id = image->stream_id;
+            state.clip->trigger_frame = image->frame_idx;
+            state.clip->max_end_seq = seq + config_.max_clip_frames;
+            state.clip->frames.assign(state.ring.begin(), state.ring.end());
+            state.ring.clear();
+        }
+        state.clip->events.push_back({box.track_id, static_cast<int>(status), image->frame_idx});
+        state.clip->end_seq = std::min(state.clip->max_end_seq, seq + config_.post_event_frames);
+    }
+    if (seq % 256 == 0) {
+        for (auto it = state.event_last_seen.begin(); it != state.event_last_seen.end();) {
+            it = seq - it->second > static_cast<uint64_t>(config_.close_gap_frames) ? state.event_last_seen.erase(it)
+                                                                                  : std::next(it);
+        }
+    }
+
+    if (seq % config_.frame_stride == 0) {
+        FramePtr frame = capture_frame(image, timestamp_ms);
+        if (frame && state.clip) {
+            state.clip->frames.push_back(frame);
+        } else if (frame) {
+            state.ring.push_back(frame);
+            while (state.ring.size() > ring_capacity_) {
+                state.ring.front()->charge.reset();
+                state.ring.pop_front();
+            }
+        }
+    }
+
+    if (state.clip && seq >= state.clip->end_seq) {
+        finish_clip(state);
+    }
+}
+
+EvidenceRecorder::FramePtr EvidenceRecorder::capture_frame(const ImageDataPtr& image, uint64_t timestamp_ms) {
+    const cv::Mat& source = image->imageMat;
+    const YuvImage& yuv = image->yuvImage;
+    int thumb_width = std::min(config_.thumb_width, image->width);
+    int thumb_height = std::max(1, image->height * thumb_width / image->width);
+    size_t raw_bytes = static_cast<size_t>(thumb_width) * thumb_height * (source.empty() ? 3 : source.elemSize());
+    size_t estimate = config_.jpeg_quality > 0 ? static_cast<size_t>(raw_bytes * jpeg_ratio_) : raw_bytes;
+
+    std::shared_ptr<MemoryCharge> charge = reserve_bytes(estimate);
+    if (!charge) {
+        frames_dropped_.fetch_add(1);
+        return nullptr;
+    }
+    auto frame = std::make_shared<EvidenceFrame>();
+    frame->frame_idx = image->frame_idx;
+    frame->timestamp_ms = timestamp_ms;
+    frame->charge = std::move(charge);
+
+    // 只持有原图的引用计数，缩放与编码在后台线程执行
+    try {
+        encode_pool_->enqueue([this, frame, source, yuv]() { encode_frame(frame, source, yuv); });
+    } catch (const std::exception&) {
+        frame->charge.reset();
+        frames_dropped_.fetch_add(1);
+        return nullptr;
+    }
+    frames_captured_.fetch_add(1);
+    return frame;
+}
+
+std::shared_ptr<MemoryCharge> EvidenceRecorder::reserve_bytes(size_t bytes) {
+    // 淘汰本实例各流中最旧的预录帧（其他实例的帧由其配额保护），片段中的帧不参与淘汰
+    while (true) {
+        std::shared_ptr<MemoryCharge> charge = budget_account_->try_acquire(bytes);
+        if (charge) {
+            return charge;
+        }
+        StreamState* oldest = nullptr;
+        for (auto& entry : streams_) {
+            auto& ring = entry.second.ring;
+            if (!ring.empty() && (!oldest || ring.front()->timestamp_ms < oldest->ring.front()->timestamp_ms)) {
+                oldest = &entry.second;
+            }
+        }
+        if (!oldest) {
+            return nullptr;
+        }
+        oldest->ring.front()->charge.reset();
+        oldest->ring.pop_front();
+        frames_evicted_.fetch_add(1);
+    }
+}
+
+void EvidenceRecorder::encode_frame(FramePtr frame, cv::Mat source, YuvImage yuv) {
+    cv::Mat thumb;
+    if (source.empty()) {
+        // 融合 转换+缩放，不生成整帧BGR
+        int thumb_width = std::min(config_.thumb_width, yuv.width());
+        int thumb_height = std::max(1, yuv.height() * thumb_width / yuv.width());
+        yuv::convert_resize(yuv, cv::Rect(cv::Point(0, 0), yuv.size()), cv::Size(thumb_width, thumb_height), thumb);
+    } else {
+        int thumb_width = std::min(config_.thumb_width, source.cols);
+        if (thumb_width < source.cols) {
+            int thumb_height = std::max(1, source.rows * thumb_width / source.cols);
+            cv::resize(source, thumb, cv::Size(thumb_width, thumb_height), 0, 0, cv::INTER_AREA);
+        } else {
+            thumb = source.clone();
+        }
+    }
+
+    std::vector<uchar> jpeg;
+    bool ok = true;
+    if (config_.jpeg_quality > 0) {
+        ok = cv::imencode(".jpg", thumb, jpeg, {cv::IMWRITE_JPEG_QUALITY, config_.jpeg_quality});
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frame->ready = true;
+        if (frame->charge && ok) {
+            size_t actual = config_.jpeg_quality > 0 ? jpeg.size() : thumb.total() * thumb.elemSize();
+            if (config_.jpeg_quality > 0) {
+                double ratio = static_cast<double>(actual) / (thumb.total() * thumb.elemSize());
+                jpeg_ratio_ = jpeg_ratio_ * 0.9 + ratio * 0.1;
+                frame->jpeg.swap(jpeg);
+            } else {
+                frame->raw = thumb;
+            }
+            if (actual <= frame->charge->get_bytes()) {
+                frame->charge->release_partial(frame->charge->get_bytes() - actual);
+            } else {
+                // 实际大小超出预估：数据已存在，先登记实际大小，再淘汰预录帧补回
+                frame->charge = budget_account_->charge(actual);
+                reserve_bytes(0);
+            }
+        } else {
+            frame->charge.reset();
+        }
+    }
+    writer_cv_.notify_all();
+}
+
+void EvidenceRecorder::finish_clip(StreamState& state) {
+    finished_clips_.push_back(std::move(state.clip));
+    writer_cv_.notify_all();
+}
+
+bool EvidenceRecorder::clip_ready(const Clip& clip) {
+    return std::all_of(clip.frames.begin(), clip.frames.end(), [](const FramePtr& frame) { return frame->ready; });
+}
+
+void EvidenceRecorder::writer_thread_func() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // 片段按结束顺序写出；停止时线程池已排空，所有帧都已就绪
+        writer_cv_.wait(lock, [this] {
+            return !running_ || (!finished_clips_.empty() && clip_ready(*finished_clips_.front()));
+        });
+        if (finished_clips_.empty()) {
+            if (!running_) {
+                break;
+            }
+            continue;
+        }
+        std::unique_ptr<Clip> clip = std::move(finished_clips_.front());
+        finished_clips_.pop_front();
+
+        lock.unlock();
+        write_clip(*clip);
+        lock.lock();
+
+        for (const auto& frame : clip->frames) {
+            frame->charge.reset();
+        }
+        clips_written_.fetch_add(1);
+    }
+}
+
+void EvidenceRecorder::write_clip(const Clip& clip) {
+    std::string name = "r" + std::to_string(instance_id_) + "_s" + std::to_string(clip.stream_id) + "_" +
+                       std::to_string(clip.clip_id) + "_" + std::to_string(clip.trigger_frame);
+    if (!make_new_dir(config_.output_dir, name)) {
+        LOG_WARN_F("⚠️ 无法创建取证片段目录: %s/%s", config_.output_dir.c_str(), name.c_str());
+        return;
+    }
+    std::string dir = config_.output_dir + "/" + name;
+
+    // 帧数据已在缓存中编码完成，写出线程只做文件IO（原始帧模式在此编码为PNG）
+    size_t written = 0;
+    uint64_t first_frame = 0, last_frame = 0, first_ms = 0, last_ms = 0;
+    for (const auto& frame : clip.frames) {
+        bool ok = false;
+        if (!frame->jpeg.empty()) {
+            std::ofstream out(dir + "/" + std::to_string(frame->frame_idx) + ".jpg", std::ios::binary);
+            ok = static_cast<bool>(out.write(reinterpret_cast<const char*>(frame->jpeg.data()), frame->jpeg.size()));
+        } else if (!frame->raw.empty()) {
+            ok = cv::imwrite(dir + "/" + std::to_string(frame->frame_idx) + ".png", frame->raw);
+        }
+        if (!ok) {
+            continue;
+        }
+        if (written == 0) {
+            first_frame = frame->frame_idx;
+            first_ms = frame->timestamp_ms;
+        }
+        last_frame = frame->frame_idx;
+        last_ms = frame->timestamp_ms;
+        ++written;
+    }
+
+    std::string events;
+    for (const auto& event : clip.events) {
+        if (!events.empty()) {
+            events += '|';
+        }
+        events += std::to_string(event.track_id) + ":" + std::to_string(event.event_type) + "@" +
+                  std::to_string(event.frame_idx);
+    }
+    std::string line = std::to_string(clip.clip_id) + ',' + std::to_string(clip.stream_id) + ',' +
+                       std::to_string(clip.trigger_frame) + ',' + std::to_string(first_frame) + ',' +
+                       std::to_string(last_frame) + ',' + std::to_string(first_ms) + ',' + std::to_string(last_ms) +
+                       ',' + std::to_string(written) + ',' + events + ',' + name + '\n';
+    append_index(line);
+}
+
+void EvidenceRecorder::append_index(const std::string& line) {
+    if (index_fd_ < 0 || !write_locked(index_fd_, line)) {
+        LOG_WARN_F("⚠️ 写入取证片段索引失败: %s/index.csv", config_.output_dir.c_str());
+    }
+}
@@ -0,0 +1,137 @@
+#include "frame_dedup.h"
+#include "camera_motion.h"
+#include "logger_manager.h"
+#include <opencv2/imgproc.hpp>
+
+FrameDeduplicator::FrameDeduplicator(const FrameDedupConfig& config)
+    : config_(config) {
+}
+
+void FrameDeduplicator::set_config(const FrameDedupConfig& config) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    bool size_changed = config.thumb_width != config_.thumb_width ||
+                        config.thumb_height != config_.thumb_height;
+    config_ = config;
+    if (size_changed) {
+        // 缩略图尺寸变化后旧签名不可比较
+        streams_.clear();
+    }
+}
+
+void FrameDeduplicator::reset() {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    streams_.clear();
+}
+
+cv::Mat FrameDeduplicator::compute_signature(const cv::Mat& image, int thumb_width, int thumb_height) {
+    if (image.empty()) {
+        return cv::Mat();
+    }
+    // 先用INTER_AREA直接缩小到签名尺寸（OpenCV内部为SIMD实现），
+    // 再在缩略图上做灰度转换，避免对全分辨率图像做颜色转换
+    cv::Mat small;
+    cv::resize(image, small, cv::Size(thumb_width, thumb_height), 0, 0, cv::INTER_AREA);
+    if (small.channels() == 3) {
+        cv::Mat luma;
+        cv::cvtColor(small, luma, cv::COLOR_BGR2GRAY);
+        return luma;
+    }
+    return small;
+}
+
+double FrameDeduplicator::signature_distance(const cv::Mat& a, const cv::Mat& b) {
+    if (a.empty() || b.empty() || a.size() != b.size() || a.type() != b.type()) {
+        return 255.0;
+    }
+    // NORM_L1 为SIMD实现的绝对差求和
+    return cv::norm(a, b, cv::NORM_L1) / static_cast<double>(a.total());
+}
+
+void FrameDeduplicator::process(const ImageDataPtr& image, Checkpoint* checkpoint) {
+    if (!image || !image->has_source()) {
+        return;
+    }
+
+    FrameDedupConfig config;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        config = config_;
+    }
+
+    // 签名计算不持锁，多个输入线程可并行
+    if (image->luma_thumb.empty()) {
+        // 入口已构建亮度金字塔时从金字塔缩放，否则从原图计算
+        image->luma_thumb = CameraMotionEstimator::luma_thumb(*image, config.thumb_width, config.thumb_height);
+    }
+    frames_checked_.fetch_add(1);
+
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    StreamState& state = streams_[image->stream_id];
+    if (checkpoint) {
+        checkpoint->stream_id = image->stream_id;
+        checkpoint->frame = image.get();
+        checkpoint->key_frame = state.key_frame;
+        checkpoint->key_signature = state.key_signature;
+        checkpoint->consecutive_skips = state.consecutive_skips;
+        checkpoint->last_frame = state.last_frame;
+    }
+    state.last_frame = image.get();
+    ImageDataPtr key_frame = state.key_frame.lock();
+
+    bool duplicate = false;
+    if (key_frame && key_frame != image && state.consecutive_skips < config.max_consecutive_skips) {
+        double distance = signature_distance(image->luma_thumb, state.key_signature);
+        duplicate = distance < config.diff_threshold;
+    }
+
+    if (duplicate) {
+        image->is_duplicate = true;
+        image->dedup_reference = key_frame;
+        state.consecutive_skips++;
+        frames_marked_.fetch_add(1);
+    } else {
+        // 当前帧成为新的关键帧
+        image->is_duplicate = false;
+        image->dedup_reference.reset();
+        state.key_frame = image;
+        state.key_signature = image->luma_thumb;
+        state.consecutive_skips = 0;
+    }
+}
+
+void FrameDeduplicator::revert(const ImageDataPtr& image, const Checkpoint& checkpoint) {
+    if (!image || checkpoint.frame != image.get()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        auto it = streams_.find(checkpoint.stream_id);
+        if (it != streams_.end() && it->second.last_frame == image.get()) {
+            StreamState& state = it->second;
+            state.key_frame = checkpoint.key_frame;
+            state.key_signature = checkpoint.key_signature;
+            state.consecutive_skips = checkpoint.consecutive_skips;
+            state.last_frame = checkpoint.last_frame;
+        }
+    }
+    frames_checked_.fetch_sub(1);
+    if (image->is_duplicate) {
+        frames_marked_.fetch_sub(1);
+    }
+    // 调用方可能稍后重新提交该帧，不保留对参考帧的引用
+    image->is_duplicate = false;
+    image->dedup_reference.reset();
+}
+
+ImageDataPtr FrameDeduplicator::reusable_reference(const ImageDataPtr& image,
+                                                   std::atomic<bool> ImageData::*stage_flag) {
+    if (!image || !image->is_duplicate || !image->dedup_reference) {
+        return nullptr;
+    }
+    const ImageDataPtr& reference = image->dedup_reference;
+    if (!((*reference).*stage_flag).load(std::memory_order_acquire)) {
+        // 参考帧尚未完成该阶段（例如被其他工作线程乱序处理），由当前帧自行计算
+        return nullptr;
+    }
+    return reference;
+}
@@ -2,6 +2,9 @@
 #include "image_data.h"
 #include "batch_pipeline_manager.h"
 #include "logger_manager.h"
+#include "result_archive.h"
+#include "trace_recorder.h"
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <mutex>
@@ -23,15 +26,35 @@ public:
     bool initialize(const HighwayEventConfig& config) override;
     bool change_params(const HighwayEventConfig& config) override;
     bool start() override;
-    int64_t add_frame(const cv::Mat& image) override;
-    int64_t add_frame(cv::Mat&& image) override;
+    int64_t add_frame(const cv::Mat& image, const FrameSource& source) override;
+    int64_t add_frame(cv::Mat&& image, const FrameSource& source) override;
+    AddFrameStatus try_add_frame(const cv::Mat& image, uint64_t& frame_id, const FrameSource& source) override;
+    AddFrameStatus add_frame_with_timeout(const cv::Mat& image, int timeout_ms, uint64_t& frame_id,
+                                          const FrameSource& source) override;
+    AddFrameStatus add_frames(const cv::Mat* images, size_t count,
+                              std::vector<int64_t>& frame_ids, int timeout_ms,
+                              const FrameSource* sources) override;
+    int64_t add_frame(const YuvImage& image, const FrameSource& source) override;
+    AddFrameStatus add_frames(const YuvImage* images, size_t count,
+                              std::vector<int64_t>& frame_ids, int timeout_ms,
+                              const FrameSource* sources) override;
+    using HighwayEventDetector::add_frames;
     ProcessResult get_result(uint64_t frame_id) override;
     ProcessResult get_result_with_timeout(uint64_t frame_id, int timeout_ms) override;
+    ResultView get_result_view(uint64_t frame_id) override;
+    ResultView get_result_view_with_timeout(uint64_t frame_id, int timeout_ms) override;
     void stop() override;
     bool is_initialized() const override;
     bool is_running() const override;
     const HighwayEventConfig& get_config() const override;
     std::string get_pipeline_status() const override;
+    bool start_trace_capture(size_t events_per_thread) override;
+    bool stop_trace_capture(const std::string& output_path) override;
+    BottleneckReport analyze_bottleneck(int core_budget) const override;
+    bool save_service_profile(const std::string& output_path) const override;
+    PipelineOccupancy get_occupancy() const override;
+    std::vector<event_journal::EventJournalRecord> query_recent_events(uint64_t last_ms) const override;
+    std::vector<event_journal::EventJournalRecord> query_track_events(int stream_id, int track_id) const override;
 
 private:
     // 成员变量
@@ -41,6 +64,9 @@ private:
     std::atomic<bool> is_running_{false};
     std::atomic<uint64_t> next_frame_id_{0};
     
+    // 提交锁：帧序号分配与入队在同一临界区内完成，未接纳的帧不占用序号
+    std::timed_mutex submit_mutex_;
+    
     // 结果管理
     mutable std::mutex result_mutex_;
     mutable std::condition_variable result_cv_;
@@ -48,6 +74,13 @@ private:
     std::unordered_map<uint64_t, ImageDataPtr> completed_results_;
     static constexpr size_t MAX_COMPLETED_RESULTS = 100; // 最大结果缓存数量
     
+    // 增量输出编码（仅在结果处理线程中调用）
+    ResultDeltaEncoder delta_encoder_;
+    std::atomic<bool> delta_output_enabled_{false};
+    
+    // 结果归档（仅在结果处理线程中写入）
+    std::unique_ptr<ResultArchiveWriter> archive_writer_;
+    
     // 内部结果处理线程
     std::thread result_thread_;
     std::atomic<bool> result_thread_running_{false};
@@ -55,8 +88,39 @@ private:
     // 内部方法
     void result_processing_thread();
     
-    // 转换函数：从ImageData转换为ProcessResult
-    ProcessResult convert_to_process_result(ImageDataPtr image_data);
+    /**
+     * 分配帧序号并提交到流水线
+     * @param timeout_ms 0不等待，<0一直等待
+     * @param frame_ids 输出帧序号，未接纳的为-1
+     */
+    AddFrameStatus submit_images(std::vector<ImageDataPtr>& images, int timeout_ms, int64_t* frame_ids);
+    
+    // 校验并拷贝 BGR/YUV 图像后整组提交
+    template <typename Frame>
+    AddFrameStatus add_frames_impl(const Frame* images, size_t count, std::vector<int64_t>& frame_ids, int timeout_ms,
+                                   const FrameSource* sources);
+    
+    // 写入帧来源信息
+    static void apply_source(ImageData& image, const FrameSource& source) {
+        image.stream_id = source.stream_id;
+        image.stream_class = source.stream_class;
+        image.track_stillness = source.track_stillness;
+    }
+    
+    // 解析超时参数
+    int resolve_add_timeout(int timeout_ms) const {
+        return timeout_ms == USE_CONFIG_TIMEOUT ? config_.add_timeout_ms : timeout_ms;
+    }
+    
+    // 应用增量输出配置
+    void apply_delta_config(const HighwayEventConfig& config) {
+        ResultDeltaConfig delta_config;
+        delta_config.keyframe_interval = std::max(1, config.delta_keyframe_interval);
+        delta_config.move_threshold_px = config.delta_move_threshold_px;
+        delta_config.move_threshold_ratio = config.delta_move_threshold_ratio;
+        delta_encoder_.set_config(delta_config);
+        delta_output_enabled_.store(config.enable_delta_output);
+    }
 };
 
 // 实现类的方法定义
@@ -69,11 +133,24 @@ HighwayEventDetectorImpl::~HighwayEventDetectorImpl() {
 }
 
 void HighwayEventDetectorImpl::result_processing_thread() {
+    TraceRecorder::set_thread_name("结果发布");
     while (result_thread_running_.load()) {
         ImageDataPtr result;
         
         // 从批次流水线获取完成的结果
         if (pipeline_manager_->get_result_image(result)) {
+            // 结果按帧序号顺序到达，在发布前编码增量
+            if (delta_output_enabled_.load()) {
+                delta_encoder_.encode(*result);
+            }
+            if (archive_writer_) {
+                result_record::RecordMeta meta;
+                meta.source_frame_id = result->frame_idx;
+                meta.timestamp_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count());
+                meta.stream_id = result->stream_id;
+                archive_writer_->append(ResultView(result).to_process_result(), meta);
+            }
             {
                 std::unique_lock<std::mutex> lock(result_mutex_);
                 
@@ -89,6 +166,7 @@ void HighwayEventDetectorImpl::result_processing_thread() {
                 
                 // 存储结果
                 completed_results_[result->frame_idx] = result;
+                TRACE_INSTANT("result", "result.publish", -1, static_cast<int64_t>(result->frame_idx));
                 
                 if (config_.enable_debug_log) {
                     LOG_INFO_F("✅ 结果处理完成，帧ID: %llu，当前缓存数量: %zu/%zu", 
@@ -103,108 +181,6 @@ void HighwayEventDetectorImpl::result_processing_thread() {
     }
 }
 
-ProcessResult HighwayEventDetectorImpl::convert_to_process_result(ImageDataPtr image_data) {
-    ProcessResult result;
-    result.status = ResultStatus::SUCCESS;
-    result.frame_id = image_data->frame_idx;
-    result.roi = image_data->roi;
-    // result.srcImage = image_data->imageMat.clone();
-    // cv::Mat image_src = image_data->imageMat;
-    // cv::Mat crop_image = image_src(image_data->roi);
-    // cv::imwrite("src_outs/output_" + std::to_string(result.frame_id) + ".jpg", crop_image);
-    // cv::imwrite("src_outs/output_" + std::to_string(result.frame_id) + ".jpg", image_src);
-    // if(!image_data->mask.empty()) {
-        // result.mask = image_data->mask.clone(); // 直接使用clone避免共享内存问题
-    //     cv::imwrite("mask_outs/output_" + std::to_string(result.frame_id) + ".jpg", mask);
-    // }
-    // result.mask = image_data->mask.clone(); // 直接使用clone避免共享内存问题
-    // cv::Mat mask = cv::Mat(image_data->mask_height, image_data->mask_width, CV_8UC1, image_data->label_map.data());
-    // cv::imwrite("mask_outs/output_" + std::to_string(result.frame_id) + ".png", mask*255);
-    // 转换检测结果
-    result.detections.reserve(image_data->track_results.size());
-    for (const auto& box : image_data->track_results) {
-        DetectionBox det_box;
-        det_box.left = box.left;
-        det_box.top = box.top;
-        det_box.right = box.right;
-        det_box.bottom = box.bottom;
-
-        det_box.confidence = box.confidence;
-        det_box.class_id = box.class_id;
-        det_box.track_id = box.track_id;
-        det_box.status = box.status;
-        det_box.is_still = box.is_still; // 添加静止状态
-        if(det_box.is_still) {
-            if(det_box.status == ObjectStatus::NORMAL)
-            det_box.status = ObjectStatus::PARKING_LANE; // 静止状态且正常状态视为违停
-            else if(det_box.status == ObjectStatus::OCCUPY_EMERGENCY_LANE) {
-                det_box.status = ObjectStatus::PARKING_EMERGENCY_LANE; // 非静止状态的违停视为占用应急车道
-            }
-            else {
-            det_box.status = ObjectStatus::PARKING_LANE; // 非静止状态且非违停视为正常状态
-            }
-        }
-        // cv::Scalar color = cv::Scalar(0, 255, 0); // 默认绿色
-        // if(det_box.status == ObjectStatus::OCCUPY_EMERGENCY_LANE) {
-        //     color = cv::Scalar(0, 0, 255); // 红色
-           
-        // }
-        result.detections.push_back(det_box);
-        // cv::Scalar color = box.is_still ? cv::Scalar(0, 0, 255) : cv::Scalar(0, 255, 0);
-
-        // cv::rectangle(image_data->imageMat, 
-        //             cv::Point(box.left, box.top), 
-        //             cv::Point(box.right, box.bottom), 
-        //             color);
-        // cv::putText(image_data->imageMat, 
-        //           std::to_string(box.track_id), 
-        //           cv::Point(box.left , box.top - 5 ), 
-        //           cv::FONT_HERSHEY_SIMPLEX, 
-        //           0.5,
-        //           color, 1);
-    }
-    // cv::imwrite("track_outs/output_" + std::to_string(result.frame_id) + ".jpg", image_data->imageMat);
-    // for (const auto& box : image_data->detection_results) {
-    //     DetectionBox det_box;
-    //     det_box.left = box.left;
-    //     det_box.top = box.top;
-    //     det_box.right = box.right;
-    //     det_box.bottom = box.bottom;
-
-    //     det_box.confidence = box.confidence;
-    //     det_box.class_id = box.class_id;
-    //     det_box.track_id = box.track_id;
-    //     det_box.status = box.status;
-    //     cv::rectangle(image_src, 
-    //                 cv::Point(box.left, box.top), 
-    //                 cv::Point(box.right, box.bottom), 
-    //                 cv::Scalar(0, 255, 0), 2);
-    //     cv::putText(image_src, 
-    //               std::to_string(box.track_id), 
-    //               cv::Point(box.left, box.top - 5), 
-    //               cv::FONT_HERSHEY_SIMPLEX, 
-    //               0.5,
-    //               cv::Scalar(0, 255, 0), 1);
-    // }
-    // cv::imwrite("detect_outs/output_" + std::to_string(result.frame_id) + ".jpg", image_src);
-    
-    // 转换筛选结果
-    result.has_filtered_box = image_data->has_filtered_box;
-    if (result.has_filtered_box) {
-        const auto& box = image_data->filtered_box;
-        result.filtered_box.left = box.left;
-        result.filtered_box.top = box.top;
-        result.filtered_box.right = box.right;
-        result.filtered_box.bottom = box.bottom;
-        result.filtered_box.confidence = box.confidence;
-        result.filtered_box.class_id = box.class_id;
-        result.filtered_box.track_id = box.track_id;
-        result.filtered_box.status = box.status;
-    }
-    
-    return result;
-}
-
 // HighwayEventDetectorImpl公共接口实现
 bool HighwayEventDetectorImpl::initialize(const HighwayEventConfig& config) {
     if (is_initialized_.load()) {
@@ -235,6 +211,7 @@ bool HighwayEventDetectorImpl::initialize(const HighwayEventConfig& config) {
         pipeline_config.enable_detection = config.enable_detection;
         pipeline_config.enable_tracking = config.enable_tracking;
         pipeline_config.enable_event_determine = config.enable_event_determine;
+        pipeline_config.enable_parking_detection = config.enable_parking_detection;
         pipeline_config.enable_pedestrian_detect = config.enable_pedestrian_detect;
         
         pipeline_config.seg_model_path = config.seg_model_path;
@@ -251,10 +228,64 @@ bool HighwayEventDetectorImpl::initialize(const HighwayEventConfig& config) {
         pipeline_config.times_car_width = config.times_car_width; // 车宽倍数
         pipeline_config.enable_lane_show = config.enable_lane_show;
         pipeline_config.lane_show_image_path = config.lane_show_image_path;
+        pipeline_config.batch_by_shape = config.batch_by_shape;
+        pipeline_config.batch_max_bypass = config.batch_max_bypass;
+        pipeline_config.seg_batch_size = config.seg_batch_size;
+        pipeline_config.mask_batch_size = config.mask_batch_size;
+        pipeline_config.detection_batch_size = config.detection_batch_size;
+        pipeline_config.tracking_batch_size = config.tracking_batch_size;
+        pipeline_config.event_batch_size = config.event_batch_size;
+        pipeline_config.rebatch_flush_ms = config.rebatch_flush_ms;
+        pipeline_config.memory_budget_mb = config.memory_budget_mb;
+        pipeline_config.enable_buffer_release = config.enable_buffer_release;
+        pipeline_config.result_keep_source_image = config.result_keep_source_image;
+        pipeline_config.result_keep_mask = config.result_keep_mask;
+        pipeline_config.enable_frame_dedup = config.enable_frame_dedup;
+        pipeline_config.dedup_thumb_width = config.dedup_thumb_width;
+        pipeline_config.dedup_thumb_height = config.dedup_thumb_height;
+        pipeline_config.dedup_diff_threshold = config.dedup_diff_threshold;
+        pipeline_config.dedup_max_consecutive_skips = config.dedup_max_consecutive_skips;
+        pipeline_config.enable_motion_gate = config.enable_motion_gate;
+        pipeline_config.motion_gate_thumb_width = config.motion_gate_thumb_width;
+        pipeline_config.motion_gate_thumb_height = config.motion_gate_thumb_height;
+        pipeline_config.motion_pixel_threshold = config.motion_pixel_threshold;
+        pipeline_config.motion_area_ratio = config.motion_area_ratio;
+        pipeline_config.motion_refresh_interval = config.motion_refresh_interval;
+        pipeline_config.enable_camera_motion = config.enable_camera_motion;
+        pipeline_config.camera_motion_ratio = config.camera_motion_ratio;
+        pipeline_config.camera_motion_min_confidence = config.camera_motion_min_confidence;
+        pipeline_config.use_builtin_tracker = config.use_builtin_tracker;
+        pipeline_config.tracker_frame_rate = config.tracker_frame_rate;
+        pipeline_config.tracker_buffer_frames = config.tracker_buffer_frames;
+        pipeline_config.tracker_track_thresh = config.tracker_track_thresh;
+        pipeline_config.tracker_high_thresh = config.tracker_high_thresh;
+        pipeline_config.tracker_match_thresh = config.tracker_match_thresh;
+        pipeline_config.enable_track_stillness = config.enable_track_stillness;
+        pipeline_config.stillness_history_frames = config.stillness_history_frames;
+        pipeline_config.stillness_displacement_ratio = config.stillness_displacement_ratio;
+        pipeline_config.stillness_camera_hold_frames = config.stillness_camera_hold_frames;
+        pipeline_config.track_record_path = config.track_record_path;
+        pipeline_config.event_journal_path = config.event_journal_path;
+        pipeline_config.event_close_gap_frames = config.event_close_gap_frames;
+        pipeline_config.evidence_output_dir = config.evidence_output_dir;
+        pipeline_config.evidence_memory_budget_mb = config.evidence_memory_budget_mb;
+        pipeline_config.evidence_thumb_width = config.evidence_thumb_width;
+        pipeline_config.evidence_jpeg_quality = config.evidence_jpeg_quality;
+        pipeline_config.evidence_frame_stride = config.evidence_frame_stride;
+        pipeline_config.evidence_pre_frames = config.evidence_pre_frames;
+        pipeline_config.evidence_post_frames = config.evidence_post_frames;
+        pipeline_config.stats_record_path = config.stats_record_path;
+        pipeline_config.enable_perf_counters = config.enable_perf_counters;
+        pipeline_config.inference_mode = config.inference_mode;
+        pipeline_config.cpu_seg_model_path = config.cpu_seg_model_path;
+        pipeline_config.cpu_det_model_path = config.cpu_det_model_path;
+        pipeline_config.cpu_infer_threads = config.cpu_infer_threads;
+        pipeline_config.infer_micro_batch = config.infer_micro_batch;
 
         
         // 创建批次流水线管理器（但不启动）
         pipeline_manager_ = std::make_unique<BatchPipelineManager>(pipeline_config);
+        apply_delta_config(config);
         
         is_initialized_.store(true);
         
@@ -276,6 +307,37 @@ bool HighwayEventDetectorImpl::change_params(const HighwayEventConfig& config) {
     // 更新配置
     config_ = config;
     
+    // 近重复帧、运动门控、相机运动和静止判定支持运行时更新
+    if (pipeline_manager_) {
+        PipelineConfig pipeline_config;
+        pipeline_config.dedup_thumb_width = config.dedup_thumb_width;
+        pipeline_config.dedup_thumb_height = config.dedup_thumb_height;
+        pipeline_config.dedup_diff_threshold = config.dedup_diff_threshold;
+        pipeline_config.dedup_max_consecutive_skips = config.dedup_max_consecutive_skips;
+        pipeline_manager_->update_frame_dedup_config(pipeline_config);
+        
+        pipeline_config.motion_gate_thumb_width = config.motion_gate_thumb_width;
+        pipeline_config.motion_gate_thumb_height = config.motion_gate_thumb_height;
+        pipeline_config.motion_pixel_threshold = config.motion_pixel_threshold;
+        pipeline_config.motion_area_ratio = config.motion_area_ratio;
+        pipeline_config.motion_refresh_interval = config.motion_refresh_interval;
+        pipeline_manager_->update_motion_gate_config(pipeline_config);
+        
+        pipeline_config.camera_motion_ratio = config.camera_motion_ratio;
+        pipeline_config.camera_motion_min_confidence = config.camera_motion_min_confidence;
+        pipeline_manager_->update_camera_motion_config(pipeline_config);
+        
+        // 静止判定方式可按路切换（每个检测器实例对应一路视频）
+        pipeline_config.enable_track_stillness = config.enable_track_stillness;
+        pipeline_config.stillness_history_frames = config.stillness_history_frames;
+        pipeline_config.stillness_displacement_ratio = config.stillness_displacement_ratio;
+        pipeline_config.stillness_camera_hold_frames = config.stillness_camera_hold_frames;
+        pipeline_manager_->update_stillness_config(pipeline_config);
+    }
+    
+    // 增量输出切换后从关键帧重新开始
+    apply_delta_config(config);
+    
     // 注意：BatchPipelineManager可能不支持运行时参数更改
     // 这里只更新内部配置，如需完整支持，可能需要重启流水线
     LOG_WARN("批次流水线的参数更改支持有限，某些参数可能需要重启才能生效");
@@ -296,6 +358,16 @@ bool HighwayEventDetectorImpl::start() {
     
     
     try {
+        // 结果归档在流水线启动前打开，已存在时继续追加
+        if (!config_.result_archive_path.empty()) {
+            ResultArchiveConfig archive_config;
+            archive_config.fsync_interval_ms = config_.result_archive_fsync_ms;
+            archive_writer_ = std::make_unique<ResultArchiveWriter>(archive_config);
+            if (!archive_writer_->open(config_.result_archive_path)) {
+                archive_writer_.reset();
+            }
+        }
+        
         // 启动流水线
         pipeline_manager_->start();
         
@@ -313,7 +385,62 @@ bool HighwayEventDetectorImpl::start() {
     }
 }
 
-int64_t HighwayEventDetectorImpl::add_frame(const cv::Mat& image) {
+AddFrameStatus HighwayEventDetectorImpl::submit_images(std::vector<ImageDataPtr>& images, int timeout_ms,
+                                                      int64_t* frame_ids) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, timeout_ms));
+    
+    std::unique_lock<std::timed_mutex> lock(submit_mutex_, std::defer_lock);
+    if (timeout_ms < 0) {
+        lock.lock();
+    } else if (timeout_ms == 0) {
+        if (!lock.try_lock()) {
+            return AddFrameStatus::BUSY;
+        }
+    } else if (!lock.try_lock_until(deadline)) {
+        return AddFrameStatus::BUSY;
+    }
+    
+    // 连续分配帧序号，只有实际接纳的帧才推进序号
+    uint64_t base_id = next_frame_id_.load();
+    for (size_t i = 0; i < images.size(); ++i) {
+        images[i]->frame_idx = base_id + i;
+    }
+    
+    int remaining_ms = timeout_ms;
+    if (timeout_ms > 0) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        remaining_ms = static_cast<int>(std::max<int64_t>(0, left.count()));
+    }
+    size_t admitted;
+    {
+        TRACE_SCOPE("frame", "frame.submit", -1, static_cast<int64_t>(base_id));
+        admitted = pipeline_manager_->add_images(images.data(), images.size(), remaining_ms);
+    }
+    next_frame_id_.store(base_id + admitted);
+    
+    for (size_t i = 0; i < images.size(); ++i) {
+        frame_ids[i] = i < admitted ? static_cast<int64_t>(base_id + i) : -1;
+    }
+    
+    if (admitted < images.size()) {
+        if (config_.enable_debug_log) {
+            LOG_DEBUG_F("流水线繁忙，%zu 帧中仅接纳 %zu 帧", images.size(), admitted);
+        }
+        return AddFrameStatus::BUSY;
+    }
+    return AddFrameStatus::OK;
+}
+
+int64_t HighwayEventDetectorImpl::add_frame(const cv::Mat& image, const FrameSource& source) {
+    uint64_t frame_id = 0;
+    AddFrameStatus status = add_frame_with_timeout(image, config_.add_timeout_ms, frame_id, source);
+    if (status == AddFrameStatus::BUSY) {
+        LOG_WARN_F("添加帧超时（%d ms），流水线繁忙", config_.add_timeout_ms);
+    }
+    return status == AddFrameStatus::OK ? static_cast<int64_t>(frame_id) : -1;
+}
+
+int64_t HighwayEventDetectorImpl::add_frame(cv::Mat&& image, const FrameSource& source) {
     if (!is_running_.load()) {
         LOG_ERROR("流水线未初始化或未运行，请先调用 initialize()");
         return -1;
@@ -325,17 +452,17 @@ int64_t HighwayEventDetectorImpl::add_frame(const cv::Mat& image) {
     }
     
     try {
-        // 分配帧ID
-        uint64_t frame_id = next_frame_id_.fetch_add(1);
-        // 创建图像数据（拷贝） - 使用异常安全的方式
-        ImageDataPtr img_data = std::make_shared<ImageData>(image);
-        img_data->frame_idx = frame_id;
-        img_data->roi = cv::Rect(0, 0, image.cols, image.rows); // 默认ROI为整个图像
+        // 创建图像数据（移动） - 使用异常安全的方式
+        std::vector<ImageDataPtr> images(1, std::make_shared<ImageData>(std::move(image)));
+        images[0]->roi = cv::Rect(0, 0, images[0]->width, images[0]->height); // 设置默认ROI为整个图像
+        apply_source(*images[0], source);
         
         // 添加到流水线
-        pipeline_manager_->add_image(img_data);
-        
-        return static_cast<int64_t>(frame_id);
+        int64_t frame_id = -1;
+        if (submit_images(images, config_.add_timeout_ms, &frame_id) == AddFrameStatus::BUSY) {
+            LOG_WARN_F("添加帧超时（%d ms），流水线繁忙", config_.add_timeout_ms);
+        }
+        return frame_id;
     } catch (const std::exception& e) {
         // 异常安全：报告错误
         LOG_ERROR_F("添加帧失败: %s", e.what());
@@ -343,97 +470,141 @@ int64_t HighwayEventDetectorImpl::add_frame(const cv::Mat& image) {
     }
 }
 
-int64_t HighwayEventDetectorImpl::add_frame(cv::Mat&& image) {
+AddFrameStatus HighwayEventDetectorImpl::try_add_frame(const cv::Mat& image, uint64_t& frame_id,
+                                                       const FrameSource& source) {
+    return add_frame_with_timeout(image, 0, frame_id, source);
+}
+
+AddFrameStatus HighwayEventDetectorImpl::add_frame_with_timeout(const cv::Mat& image, int timeout_ms, uint64_t& frame_id,
+                                                                const FrameSource& source) {
+    std::vector<int64_t> frame_ids;
+    AddFrameStatus status = add_frames(&image, 1, frame_ids, timeout_ms, &source);
+    if (status == AddFrameStatus::OK) {
+        frame_id = static_cast<uint64_t>(frame_ids[0]);
+    }
+    return status;
+}
+
+namespace {
+
+bool frame_valid(const cv::Mat& image) {
+    return !image.empty();
+}
+
+bool frame_valid(const YuvImage& image) {
+    return image.valid();
+}
+
+}  // namespace
+
+template <typename Frame>
+AddFrameStatus HighwayEventDetectorImpl::add_frames_impl(const Frame* images, size_t count,
+                                                         std::vector<int64_t>& frame_ids, int timeout_ms,
+                                                         const FrameSource* sources) {
+    frame_ids.assign(count, -1);
+    
     if (!is_running_.load()) {
         LOG_ERROR("流水线未初始化或未运行，请先调用 initialize()");
-        return -1;
+        return AddFrameStatus::NOT_RUNNING;
     }
     
-    if (image.empty()) {
+    if (!images || count == 0) {
         LOG_ERROR("输入图像为空");
-        return -1;
+        return AddFrameStatus::INVALID_INPUT;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!frame_valid(images[i])) {
+            LOG_ERROR_F("输入图像为空或格式无效，索引: %zu", i);
+            return AddFrameStatus::INVALID_INPUT;
+        }
     }
     
     try {
-        // 分配帧ID
-        uint64_t frame_id = next_frame_id_.fetch_add(1);
-        
-        // 创建图像数据（移动） - 使用异常安全的方式
-        ImageDataPtr img_data = std::make_shared<ImageData>(std::move(image));
-        img_data->frame_idx = frame_id;
-        img_data->roi = cv::Rect(0, 0, img_data->width, img_data->height); // 设置默认ROI为整个图像
-        
-        // 添加到流水线
-        pipeline_manager_->add_image(img_data);
+        // 图像拷贝在提交锁之外完成
+        std::vector<ImageDataPtr> img_data;
+        img_data.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            ImageDataPtr data = std::make_shared<ImageData>(images[i]);
+            data->roi = cv::Rect(0, 0, data->width, data->height); // 默认ROI为整个图像
+            if (sources) {
+                apply_source(*data, sources[i]);
+            }
+            img_data.push_back(std::move(data));
+        }
         
-        return static_cast<int64_t>(frame_id);
+        return submit_images(img_data, resolve_add_timeout(timeout_ms), frame_ids.data());
     } catch (const std::exception& e) {
         // 异常安全：报告错误
         LOG_ERROR_F("添加帧失败: %s", e.what());
-        return -1;
+        return AddFrameStatus::ERROR;
     }
 }
 
+AddFrameStatus HighwayEventDetectorImpl::add_frames(const cv::Mat* images, size_t count,
+                                                    std::vector<int64_t>& frame_ids, int timeout_ms,
+                                                    const FrameSource* sources) {
+    return add_frames_impl(images, count, frame_ids, timeout_ms, sources);
+}
+
+int64_t HighwayEventDetectorImpl::add_frame(const YuvImage& image, const FrameSource& source) {
+    std::vector<int64_t> frame_ids;
+    AddFrameStatus status = add_frames(&image, 1, frame_ids, config_.add_timeout_ms, &source);
+    if (status == AddFrameStatus::BUSY) {
+        LOG_WARN_F("添加帧超时（%d ms），流水线繁忙", config_.add_timeout_ms);
+    }
+    return status == AddFrameStatus::OK ? frame_ids[0] : -1;
+}
+
+AddFrameStatus HighwayEventDetectorImpl::add_frames(const YuvImage* images, size_t count,
+                                                    std::vector<int64_t>& frame_ids, int timeout_ms,
+                                                    const FrameSource* sources) {
+    return add_frames_impl(images, count, frame_ids, timeout_ms, sources);
+}
+
 ProcessResult HighwayEventDetectorImpl::get_result(uint64_t frame_id) {
     return get_result_with_timeout(frame_id, config_.get_timeout_ms);
 }
 
 ProcessResult HighwayEventDetectorImpl::get_result_with_timeout(uint64_t frame_id, int timeout_ms) {
-    ProcessResult result;
-    result.frame_id = frame_id;
-    
+    // 在结果锁之外拷贝，视图析构时释放帧数据
+    return get_result_view_with_timeout(frame_id, timeout_ms).to_process_result();
+}
+
+ResultView HighwayEventDetectorImpl::get_result_view(uint64_t frame_id) {
+    return get_result_view_with_timeout(frame_id, config_.get_timeout_ms);
+}
+
+ResultView HighwayEventDetectorImpl::get_result_view_with_timeout(uint64_t frame_id, int timeout_ms) {
     if (!is_running_.load()) {
-        result.status = ResultStatus::ERROR;
-        return result;
+        return ResultView(ResultStatus::ERROR, frame_id);
     }
-    std::unique_lock<std::mutex> lock(result_mutex_);
-    
-    // 先检查结果是否已经存在
-    auto it = completed_results_.find(frame_id);
-    if (it != completed_results_.end()) {
-        result = convert_to_process_result(it->second);
-        completed_results_.erase(it);
+    ImageDataPtr image_data;
+    {
+        std::unique_lock<std::mutex> lock(result_mutex_);
         
-        // 通知结果处理线程有空间了
-        result_space_cv_.notify_one();
-
-        return result;
-    }
-    
-    // 等待结果完成
-    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
-    
-    bool found = result_cv_.wait_until(lock, deadline, [&]() {
-        return completed_results_.find(frame_id) != completed_results_.end();
-    });
-    
-    if (!found) {
-        if (config_.enable_debug_log) {
-            LOG_DEBUG_F("帧 %llu 等待超时，当前缓存数量: %zu", frame_id, completed_results_.size());
-        }
-        result.status = ResultStatus::TIMEOUT;
-        return result;
-    }
-    
-    it = completed_results_.find(frame_id);
-    if (it != completed_results_.end()) {
-        if (config_.enable_debug_log) {
-            LOG_DEBUG_F("帧 %llu 等待成功，开始转换结果", frame_id);
-        }
-        result = convert_to_process_result(it->second);
-        // 获取后删除结果，避免内存积累
-        completed_results_.erase(it);
+        // 等待结果完成（已存在时立即返回）
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        bool found = result_cv_.wait_until(lock, deadline, [&]() {
+            return completed_results_.find(frame_id) != completed_results_.end();
+        });
         
-        // 通知结果处理线程有空间了
-        result_space_cv_.notify_one();
-    } else {
-        if (config_.enable_debug_log) {
-            LOG_DEBUG_F("帧 %llu 等待结束后未找到结果", frame_id);
+        if (!found) {
+            if (config_.enable_debug_log) {
+                LOG_DEBUG_F("帧 %llu 等待超时，当前缓存数量: %zu", frame_id, completed_results_.size());
+            }
+            return ResultView(ResultStatus::TIMEOUT, frame_id);
         }
-        result.status = ResultStatus::NOT_FOUND;
+        
+        // 取出后从缓存删除，帧数据的所有权转移给视图
+        auto it = completed_results_.find(frame_id);
+        image_data = std::move(it->second);
+        completed_results_.erase(it);
     }
     
-    return result;
+    // 通知结果处理线程有空间了
+    result_space_cv_.notify_one();
+    
+    return ResultView(std::move(image_data));
 }
 
 void HighwayEventDetectorImpl::stop() {
@@ -456,10 +627,17 @@ void HighwayEventDetectorImpl::stop() {
             }
         }
         
+        // 结果线程已退出，落盘并关闭归档
+        if (archive_writer_) {
+            archive_writer_->close();
+            archive_writer_.reset();
+        }
+        
         // 停止流水线
         if (pipeline_manager_) {
             pipeline_manager_->stop();
         }
+        delta_encoder_.reset();
         
         // 清理结果
         {
@@ -501,9 +679,84 @@ std::string HighwayEventDetectorImpl::get_pipeline_status() const {
     oss << ", 吞吐量: " << std::fixed << std::setprecision(2) << stats.throughput_images_per_second << " FPS";
     oss << ", 处理批次数: " << stats.total_batches_processed;
     
+    if (delta_output_enabled_.load() && delta_encoder_.get_full_boxes() > 0) {
+        oss << ", 增量输出: " << std::setprecision(1)
+            << 100.0 * delta_encoder_.get_sent_boxes() / delta_encoder_.get_full_boxes() << "% 目标框, 关键帧 "
+            << delta_encoder_.get_keyframes() << "/" << delta_encoder_.get_frames_encoded();
+    }
+    
     return oss.str();
 }
 
+bool HighwayEventDetectorImpl::start_trace_capture(size_t events_per_thread) {
+    if (!TraceRecorder::start(events_per_thread)) {
+        LOG_WARN("⚠️ 追踪抓取已在进行中");
+        return false;
+    }
+    return true;
+}
+
+bool HighwayEventDetectorImpl::stop_trace_capture(const std::string& output_path) {
+    TraceRecorder::stop();
+    return TraceRecorder::dump_chrome_json(output_path);
+}
+
+BottleneckReport HighwayEventDetectorImpl::analyze_bottleneck(int core_budget) const {
+    if (!pipeline_manager_) {
+        BottleneckReport report;
+        report.verdict = "检测器未初始化";
+        return report;
+    }
+    return pipeline_manager_->analyze_bottleneck(core_budget);
+}
+
+bool HighwayEventDetectorImpl::save_service_profile(const std::string& output_path) const {
+    if (!pipeline_manager_) {
+        LOG_ERROR("❌ 检测器未初始化，无法保存服务时间画像");
+        return false;
+    }
+    ServiceProfile profile = pipeline_manager_->collect_service_profile();
+    for (const auto& stage : profile.missing_stages()) {
+        LOG_WARN_F("⚠️ 阶段 %s 尚无服务时间样本", stage.c_str());
+    }
+    if (!profile.save(output_path)) {
+        LOG_ERROR_F("❌ 无法写入服务时间画像: %s", output_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+PipelineOccupancy HighwayEventDetectorImpl::get_occupancy() const {
+    PipelineOccupancy occupancy;
+    if (!pipeline_manager_) {
+        return occupancy;
+    }
+    occupancy.pipeline = pipeline_manager_->get_occupancy();
+    {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        occupancy.result_cache = completed_results_.size();
+    }
+    occupancy.result_cache_capacity = MAX_COMPLETED_RESULTS;
+    return occupancy;
+}
+
+std::vector<event_journal::EventJournalRecord> HighwayEventDetectorImpl::query_recent_events(uint64_t last_ms) const {
+    const EventJournal* journal = pipeline_manager_ ? pipeline_manager_->get_event_journal() : nullptr;
+    if (!journal) {
+        return {};
+    }
+    return journal->query_recent(last_ms);
+}
+
+std::vector<event_journal::EventJournalRecord> HighwayEventDetectorImpl::query_track_events(int stream_id,
+                                                                                           int track_id) const {
+    const EventJournal* journal = pipeline_manager_ ? pipeline_manager_->get_event_journal() : nullptr;
+    if (!journal) {
+        return {};
+    }
+    return journal->query_track(stream_id, track_id);
+}
+
 // 工厂函数实现
 std::unique_ptr<HighwayEventDetector> create_highway_event_detector() {
     return std::make_unique<HighwayEventDetectorImpl>();
@@ -12,4 +12,27 @@ ImageData::~ImageData() {
 bool ImageData::is_fully_processed() const {
   // 简化版本：基于数据本身判断是否处理完成
   return !track_results.empty() || !detection_results.empty();
-}
\ No newline at end of file
+}
+
+cv::Mat ImageData::derived(const DerivedImageKey& key, const DerivedImageCache::Allocator& allocator) {
+  if (!imageMat.empty()) {
+    return derived_images.get(imageMat, key, allocator);
+  }
+  return derived_images.get(yuvImage, key, allocator);
+}
+
+cv::Mat ImageData::source_region(const cv::Rect& region) const {
+  if (!imageMat.empty()) {
+    return imageMat(region & cv::Rect(0, 0, imageMat.cols, imageMat.rows));
+  }
+  cv::Mat bgr;
+  yuv::convert_crop(yuvImage, region, bgr);
+  return bgr;
+}
+
+cv::Mat ImageData::source_bgr() {
+  if (!imageMat.empty() || yuvImage.empty()) {
+    return imageMat;
+  }
+  return derived(DerivedImageKey(cv::Size(width, height)));
+}
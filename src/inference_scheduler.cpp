@@ -0,0 +1,205 @@
+#include "inference_scheduler.h"
+#include "logger_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+
+InferenceScheduler::InferenceScheduler(const std::string& name, InferenceMode mode, double gpu_ms_hint,
+                                       double cpu_ms_hint, StageProfiler* profiler)
+    : name_(name), mode_(mode), profiler_(profiler) {
+    backends_[static_cast<int>(InferenceBackend::GPU)].ms_per_item = std::max(0.01, gpu_ms_hint);
+    backends_[static_cast<int>(InferenceBackend::CPU)].ms_per_item = std::max(0.01, cpu_ms_hint);
+}
+
+InferenceScheduler::~InferenceScheduler() {
+    if (cpu_pool_) {
+        cpu_pool_->stop();
+    }
+}
+
+InferenceMode InferenceScheduler::parse_mode(const std::string& name) {
+    if (name == "cpu") {
+        return InferenceMode::CPU_ONLY;
+    }
+    if (name == "hybrid") {
+        return InferenceMode::HYBRID;
+    }
+    if (!name.empty() && name != "gpu") {
+        LOG_WARN_F("⚠️ 未知推理模式 %s，按 gpu 处理", name.c_str());
+    }
+    return InferenceMode::GPU_ONLY;
+}
+
+const char* InferenceScheduler::mode_name(InferenceMode mode) {
+    switch (mode) {
+        case InferenceMode::CPU_ONLY: return "cpu";
+        case InferenceMode::HYBRID: return "hybrid";
+        default: return "gpu";
+    }
+}
+
+void InferenceScheduler::set_backend_available(InferenceBackend backend, bool available) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        backends_[static_cast<int>(backend)].available = available;
+    }
+    if (backend == InferenceBackend::CPU && available && !cpu_pool_) {
+        cpu_pool_ = std::make_unique<ThreadPool>(1, profiler_);
+    }
+}
+
+bool InferenceScheduler::any_available() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return backends_[0].available || backends_[1].available;
+}
+
+bool InferenceScheduler::acquire(size_t items, InferenceBackend& backend) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    BackendState& gpu = backends_[static_cast<int>(InferenceBackend::GPU)];
+    BackendState& cpu = backends_[static_cast<int>(InferenceBackend::CPU)];
+    bool gpu_ok = gpu.available && mode_ != InferenceMode::CPU_ONLY;
+    bool cpu_ok = cpu.available && mode_ != InferenceMode::GPU_ONLY;
+    if (!gpu_ok && !cpu_ok) {
+        return false;
+    }
+    if (gpu_ok && cpu_ok) {
+        double gpu_eta = (gpu.in_flight + items) * gpu.ms_per_item;
+        double cpu_eta = (cpu.in_flight + items) * cpu.ms_per_item;
+        backend = cpu_eta < gpu_eta ? InferenceBackend::CPU : InferenceBackend::GPU;
+    } else {
+        backend = gpu_ok ? InferenceBackend::GPU : InferenceBackend::CPU;
+    }
+    BackendState& chosen = backends_[static_cast<int>(backend)];
+    chosen.in_flight += items;
+    chosen.micro_batches++;
+    return true;
+}
+
+void InferenceScheduler::release(InferenceBackend backend, size_t items, double elapsed_ms, bool success) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    BackendState& state = backends_[static_cast<int>(backend)];
+    state.in_flight -= std::min(state.in_flight, items);
+    if (!success) {
+        state.failures++;
+        return;
+    }
+    state.items += items;
+    if (items > 0) {
+        double sample = elapsed_ms / items;
+        state.ms_per_item = state.measured ? (1.0 - kCostAlpha) * state.ms_per_item + kCostAlpha * sample : sample;
+        state.measured = true;
+    }
+}
+
+bool InferenceScheduler::run(size_t item_count, size_t micro_batch,
+                             const std::function<bool(const std::vector<size_t>&)>& run_gpu,
+                             const std::function<bool(size_t, size_t)>& run_cpu) {
+    if (item_count == 0) {
+        return true;
+    }
+    micro_batch = std::max<size_t>(1, micro_batch);
+
+    bool success = true;
+    std::vector<size_t> gpu_items;
+    std::vector<std::future<bool>> cpu_futures;
+    for (size_t begin = 0; begin < item_count; begin += micro_batch) {
+        size_t end = std::min(item_count, begin + micro_batch);
+        InferenceBackend backend;
+        if (!acquire(end - begin, backend)) {
+            LOG_ERROR_F("❌ %s 没有可用的推理后端", name_.c_str());
+            success = false;
+            break;
+        }
+        if (backend == InferenceBackend::GPU) {
+            for (size_t i = begin; i < end; ++i) {
+                gpu_items.push_back(i);
+            }
+            continue;
+        }
+        auto task = [this, &run_cpu, begin, end]() -> bool {
+            auto start = std::chrono::steady_clock::now();
+            bool ok = false;
+            try {
+                ok = run_cpu(begin, end);
+            } catch (const std::exception& e) {
+                LOG_ERROR_F("❌ %s CPU推理异常: %s", name_.c_str(), e.what());
+            }
+            double elapsed_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+            release(InferenceBackend::CPU, end - begin, elapsed_ms, ok);
+            return ok;
+        };
+        try {
+            cpu_futures.push_back(cpu_pool_->enqueue(task));
+        } catch (const std::exception&) {
+            // CPU 线程池队列已满或已停止：在当前线程执行
+            if (!task()) {
+                success = false;
+            }
+        }
+    }
+
+    // GPU 微批次合并为一次调用，与 CPU 微批次并行
+    if (!gpu_items.empty()) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = false;
+        try {
+            ok = run_gpu(gpu_items);
+        } catch (const std::exception& e) {
+            LOG_ERROR_F("❌ %s GPU推理异常: %s", name_.c_str(), e.what());
+        }
+        double elapsed_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        release(InferenceBackend::GPU, gpu_items.size(), elapsed_ms, ok);
+        if (!ok) {
+            success = false;
+        }
+    }
+
+    // run_cpu 以引用捕获，必须等全部 CPU 微批次结束才能返回
+    for (auto& future : cpu_futures) {
+        if (!future.get()) {
+            success = false;
+        }
+    }
+    return success;
+}
+
+InferenceBackendStats InferenceScheduler::get_stats(InferenceBackend backend) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const BackendState& state = backends_[static_cast<int>(backend)];
+    InferenceBackendStats stats;
+    stats.available = state.available;
+    stats.items = state.items;
+    stats.micro_batches = state.micro_batches;
+    stats.failures = state.failures;
+    stats.in_flight = state.in_flight;
+    stats.ms_per_item = state.ms_per_item;
+    return stats;
+}
+
+std::string InferenceScheduler::format_stats() const {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1);
+    const char* names[2] = {"GPU", "CPU"};
+    bool first = true;
+    for (int i = 0; i < 2; ++i) {
+        InferenceBackendStats stats = get_stats(static_cast<InferenceBackend>(i));
+        if (!stats.available) {
+            continue;
+        }
+        if (!first) {
+            oss << " | ";
+        }
+        first = false;
+        oss << names[i] << " " << stats.items << "张 " << stats.ms_per_item << "ms/张 在途" << stats.in_flight;
+        if (stats.failures > 0) {
+            oss << " 失败" << stats.failures;
+        }
+    }
+    if (first) {
+        oss << "无可用后端";
+    }
+    return oss.str();
+}
@@ -0,0 +1,246 @@
+#include "memory_budget.h"
+#include "stage_profiler.h"
+#include <algorithm>
+
+MemoryCharge::MemoryCharge(std::shared_ptr<MemoryAccount> account, size_t bytes)
+    : account_(std::move(account)), bytes_(bytes) {}
+
+MemoryCharge::~MemoryCharge() {
+    account_->get_budget().release(*account_, bytes_, is_result_.load());
+}
+
+void MemoryCharge::move_to_result() {
+    account_->get_budget().move_to_result(*this);
+}
+
+void MemoryCharge::release_partial(size_t bytes) {
+    account_->get_budget().release_partial(*this, bytes);
+}
+
+MemoryAccount::MemoryAccount(std::shared_ptr<MemoryBudget> budget, std::string name)
+    : budget_(std::move(budget)), name_(std::move(name)) {}
+
+MemoryAccount::~MemoryAccount() {
+    budget_->remove_account(this);
+}
+
+std::shared_ptr<MemoryCharge> MemoryAccount::acquire(size_t bytes, std::chrono::steady_clock::time_point deadline,
+                                                     const std::atomic<bool>* running) {
+    MemoryBudget& budget = *budget_;
+    std::unique_lock<std::mutex> lock(budget.mutex_);
+    if (!budget.fits(*this, bytes)) {
+        waited_.fetch_add(1);
+        uint64_t wait_start = StageProfiler::now_ns();
+        auto ready = [&]() { return budget.fits(*this, bytes) || (running && !running->load()); };
+        if (deadline == std::chrono::steady_clock::time_point::max()) {
+            budget.cv_.wait(lock, ready);
+        } else {
+            budget.cv_.wait_until(lock, deadline, ready);
+        }
+        wait_ns_.fetch_add(StageProfiler::now_ns() - wait_start);
+        if (!budget.fits(*this, bytes)) {
+            rejected_.fetch_add(1);
+            return nullptr;
+        }
+    }
+    pipeline_bytes_.fetch_add(bytes);
+    budget.pipeline_bytes_.fetch_add(bytes);
+    budget.update_peaks(*this);
+    admitted_.fetch_add(1);
+    lock.unlock();
+    return std::make_shared<MemoryCharge>(shared_from_this(), bytes);
+}
+
+std::shared_ptr<MemoryCharge> MemoryAccount::try_acquire(size_t bytes) {
+    MemoryBudget& budget = *budget_;
+    std::unique_lock<std::mutex> lock(budget.mutex_);
+    if (!budget.fits(*this, bytes)) {
+        rejected_.fetch_add(1);
+        return nullptr;
+    }
+    pipeline_bytes_.fetch_add(bytes);
+    budget.pipeline_bytes_.fetch_add(bytes);
+    budget.update_peaks(*this);
+    admitted_.fetch_add(1);
+    lock.unlock();
+    return std::make_shared<MemoryCharge>(shared_from_this(), bytes);
+}
+
+std::shared_ptr<MemoryCharge> MemoryAccount::charge(size_t bytes) {
+    MemoryBudget& budget = *budget_;
+    {
+        std::lock_guard<std::mutex> lock(budget.mutex_);
+        pipeline_bytes_.fetch_add(bytes);
+        budget.pipeline_bytes_.fetch_add(bytes);
+        budget.update_peaks(*this);
+    }
+    return std::make_shared<MemoryCharge>(shared_from_this(), bytes);
+}
+
+void MemoryAccount::activate() {
+    {
+        std::lock_guard<std::mutex> lock(budget_->mutex_);
+        if (active_) {
+            return;
+        }
+        active_ = true;
+        budget_->active_accounts_++;
+    }
+    // 其他账户的配额变小，不影响已登记的占用
+    budget_->cv_.notify_all();
+}
+
+void MemoryAccount::deactivate() {
+    {
+        std::lock_guard<std::mutex> lock(budget_->mutex_);
+        if (active_) {
+            active_ = false;
+            budget_->active_accounts_--;
+        }
+    }
+    // 归还的配额可被其他账户使用；本账户的等待者按 running 标志退出
+    budget_->cv_.notify_all();
+}
+
+void MemoryAccount::reset_stats() {
+    std::lock_guard<std::mutex> lock(budget_->mutex_);
+    peak_bytes_.store(pipeline_bytes_.load() + result_bytes_.load());
+    admitted_.store(0);
+    waited_.store(0);
+    rejected_.store(0);
+    wait_ns_.store(0);
+}
+
+size_t MemoryAccount::get_reserved_bytes() const {
+    std::lock_guard<std::mutex> lock(budget_->mutex_);
+    return budget_->reserved_locked(*this);
+}
+
+const std::shared_ptr<MemoryBudget>& MemoryBudget::global() {
+    // 不析构：进程退出时仍可能有帧在释放占用
+    static auto* instance = new std::shared_ptr<MemoryBudget>(std::make_shared<MemoryBudget>());
+    return *instance;
+}
+
+MemoryBudget::MemoryBudget(size_t limit_bytes) : limit_bytes_(limit_bytes) {}
+
+void MemoryBudget::set_limit(size_t limit_bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        limit_bytes_.store(limit_bytes);
+    }
+    cv_.notify_all();
+}
+
+void MemoryBudget::raise_limit(size_t limit_bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (limit_bytes <= limit_bytes_.load()) {
+            return;
+        }
+        limit_bytes_.store(limit_bytes);
+    }
+    cv_.notify_all();
+}
+
+std::shared_ptr<MemoryAccount> MemoryBudget::open_account(const std::string& name) {
+    std::shared_ptr<MemoryAccount> account(new MemoryAccount(shared_from_this(), name));
+    std::lock_guard<std::mutex> lock(mutex_);
+    accounts_.push_back(account.get());
+    return account;
+}
+
+size_t MemoryBudget::get_active_accounts() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_accounts_;
+}
+
+void MemoryBudget::remove_account(MemoryAccount* account) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (account->active_) {
+            active_accounts_--;
+        }
+        accounts_.erase(std::remove(accounts_.begin(), accounts_.end(), account), accounts_.end());
+    }
+    cv_.notify_all();
+}
+
+size_t MemoryBudget::reserved_locked(const MemoryAccount& account) const {
+    size_t limit = limit_bytes_.load();
+    if (limit == 0 || !account.active_ || active_accounts_ == 0) {
+        return 0;
+    }
+    return limit / active_accounts_;
+}
+
+bool MemoryBudget::fits(const MemoryAccount& account, size_t bytes) const {
+    size_t limit = limit_bytes_.load();
+    if (limit == 0 || account.pipeline_bytes_.load() == 0) {
+        return true;
+    }
+    size_t used = account.get_used_bytes();
+    if (used + bytes <= reserved_locked(account)) {
+        return true;
+    }
+    // 借用：其他账户保留但未用的部分不可占用
+    size_t committed = 0;
+    for (const MemoryAccount* other : accounts_) {
+        size_t other_used = other == &account ? used + bytes : other->get_used_bytes();
+        committed += std::max(other_used, reserved_locked(*other));
+    }
+    return committed <= limit;
+}
+
+void MemoryBudget::update_peaks(MemoryAccount& account) {
+    size_t used = pipeline_bytes_.load() + result_bytes_.load();
+    if (used > peak_bytes_.load()) {
+        peak_bytes_.store(used);
+    }
+    size_t account_used = account.get_used_bytes();
+    if (account_used > account.peak_bytes_.load()) {
+        account.peak_bytes_.store(account_used);
+    }
+}
+
+void MemoryBudget::release(MemoryAccount& account, size_t bytes, bool is_result) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::atomic<size_t>& counter = is_result ? account.result_bytes_ : account.pipeline_bytes_;
+        std::atomic<size_t>& total = is_result ? result_bytes_ : pipeline_bytes_;
+        counter.fetch_sub(std::min(counter.load(), bytes));
+        total.fetch_sub(std::min(total.load(), bytes));
+    }
+    cv_.notify_all();
+}
+
+void MemoryBudget::release_partial(MemoryCharge& charge, size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t n = std::min(bytes, charge.bytes_.load());
+        charge.bytes_.fetch_sub(n);
+        bool is_result = charge.is_result_.load();
+        std::atomic<size_t>& counter = is_result ? charge.account_->result_bytes_ : charge.account_->pipeline_bytes_;
+        std::atomic<size_t>& total = is_result ? result_bytes_ : pipeline_bytes_;
+        counter.fetch_sub(std::min(counter.load(), n));
+        total.fetch_sub(std::min(total.load(), n));
+    }
+    cv_.notify_all();
+}
+
+void MemoryBudget::move_to_result(MemoryCharge& charge) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (charge.is_result_.exchange(true)) {
+            return;
+        }
+        size_t bytes = charge.bytes_.load();
+        MemoryAccount& account = *charge.account_;
+        account.pipeline_bytes_.fetch_sub(std::min(account.pipeline_bytes_.load(), bytes));
+        account.result_bytes_.fetch_add(bytes);
+        pipeline_bytes_.fetch_sub(std::min(pipeline_bytes_.load(), bytes));
+        result_bytes_.fetch_add(bytes);
+    }
+    // 账户的流水线用量归零时等待者可被接纳
+    cv_.notify_all();
+}
@@ -0,0 +1,141 @@
+#include "motion_gate.h"
+#include "frame_dedup.h"
+#include "camera_motion.h"
+#include <algorithm>
+#include <cstdlib>
+#include <opencv2/imgproc.hpp>
+
+MotionGate::MotionGate(const MotionGateConfig& config)
+    : config_(config) {
+}
+
+void MotionGate::set_config(const MotionGateConfig& config) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    bool size_changed = config.thumb_width != config_.thumb_width ||
+                        config.thumb_height != config_.thumb_height;
+    config_ = config;
+    if (size_changed) {
+        // 缩略图尺寸变化后锚点不可比较，下一帧重新完整检测
+        streams_.clear();
+    }
+}
+
+void MotionGate::reset() {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    streams_.clear();
+}
+
+bool MotionGate::roi_compatible(const cv::Rect& a, const cv::Rect& b) {
+    // ROI允许平移（复用时平移检测框），尺寸变化超过2%则视为不兼容
+    auto close = [](int x, int y) {
+        return std::abs(x - y) <= std::max(2, std::max(x, y) / 50);
+    };
+    return close(a.width, b.width) && close(a.height, b.height);
+}
+
+double MotionGate::motion_ratio(const cv::Mat& current, const cv::Mat& anchor, const cv::Rect& roi,
+                                int image_width, int image_height, int pixel_threshold) {
+    if (current.empty() || anchor.empty() || current.size() != anchor.size() ||
+        current.type() != anchor.type() || image_width <= 0 || image_height <= 0) {
+        return 1.0;
+    }
+
+    // 将原图坐标的ROI映射到缩略图坐标
+    cv::Rect thumb_roi(0, 0, current.cols, current.rows);
+    if (roi.area() > 0) {
+        int x0 = roi.x * current.cols / image_width;
+        int y0 = roi.y * current.rows / image_height;
+        int x1 = (roi.x + roi.width) * current.cols / image_width;
+        int y1 = (roi.y + roi.height) * current.rows / image_height;
+        thumb_roi = cv::Rect(x0, y0, std::max(1, x1 - x0), std::max(1, y1 - y0)) &
+                    cv::Rect(0, 0, current.cols, current.rows);
+        if (thumb_roi.area() <= 0) {
+            return 1.0;
+        }
+    }
+
+    cv::Mat diff;
+    cv::absdiff(current(thumb_roi), anchor(thumb_roi), diff);
+    cv::threshold(diff, diff, pixel_threshold, 255, cv::THRESH_BINARY);
+    return static_cast<double>(cv::countNonZero(diff)) / thumb_roi.area();
+}
+
+MotionGate::Decision MotionGate::decide(const ImageDataPtr& image) const {
+    Decision decision;
+    if (!image || !image->has_source()) {
+        return decision;
+    }
+
+    MotionGateConfig config;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        config = config_;
+    }
+
+    // 入口去重已计算同尺寸缩略图时直接复用
+    if (!image->luma_thumb.empty() && image->luma_thumb.cols == config.thumb_width &&
+        image->luma_thumb.rows == config.thumb_height) {
+        decision.thumb = image->luma_thumb;
+    } else {
+        decision.thumb = CameraMotionEstimator::luma_thumb(*image, config.thumb_width, config.thumb_height);
+    }
+
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    auto it = streams_.find(image->stream_id);
+    if (it == streams_.end()) {
+        return decision;
+    }
+    const StreamState& state = it->second;
+    ImageDataPtr anchor = state.anchor.lock();
+
+    // 相机运动时锚点画面已不对齐，直接完整检测
+    if (anchor && !image->camera_motion.moving && roi_compatible(image->roi, state.anchor_roi)) {
+        double ratio = motion_ratio(decision.thumb, state.anchor_thumb, image->roi,
+                                    image->width, image->height, config.pixel_threshold);
+        if (ratio <= config.motion_area_ratio) {
+            if (state.frames_since_anchor + 1 >= config.refresh_interval) {
+                decision.schedule = DetectSchedule::REFRESH;
+            } else {
+                decision.schedule = DetectSchedule::REUSE;
+                decision.anchor = anchor;
+            }
+        }
+    }
+    return decision;
+}
+
+void MotionGate::commit(const ImageDataPtr& image, const Decision& decision) {
+    if (!image) {
+        return;
+    }
+    DetectSchedule schedule = decision.schedule;
+    if (schedule == DetectSchedule::REUSE && !decision.anchor) {
+        schedule = DetectSchedule::FULL;
+    }
+    image->detect_schedule = schedule;
+    if (!image->has_source()) {
+        // 无原图的帧不参与锚点比较
+        image->detect_anchor.reset();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    StreamState& state = streams_[image->stream_id];
+    if (schedule == DetectSchedule::REUSE) {
+        image->detect_anchor = decision.anchor;
+        state.frames_since_anchor++;
+        reuse_count_.fetch_add(1);
+    } else {
+        // 完整检测的帧成为新的锚点
+        image->detect_anchor.reset();
+        state.anchor = image;
+        state.anchor_thumb = decision.thumb;
+        state.anchor_roi = image->roi;
+        state.frames_since_anchor = 0;
+        if (schedule == DetectSchedule::REFRESH) {
+            refresh_count_.fetch_add(1);
+        } else {
+            full_count_.fetch_add(1);
+        }
+    }
+}
@@ -0,0 +1,428 @@
+#include "multi_object_tracker.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 与 ByteTrack 卡尔曼滤波相同的噪声权重（相对于框高）
+constexpr float kStdWeightPosition = 1.0f / 20;
+constexpr float kStdWeightVelocity = 1.0f / 160;
+
+float box_iou(const float* a, const TrackedObject& b) {
+    float w = std::min(a[2], b.right) - std::max(a[0], b.left);
+    float h = std::min(a[3], b.bottom) - std::max(a[1], b.top);
+    if (w <= 0.0f || h <= 0.0f) {
+        return 0.0f;
+    }
+    float inter = w * h;
+    float area_a = (a[2] - a[0]) * (a[3] - a[1]);
+    float area_b = (b.right - b.left) * (b.bottom - b.top);
+    return inter / (area_a + area_b - inter);
+}
+
+// 两框各边按自身宽高的 buffer 倍外扩后的 IoU（C-BIoU）
+float buffered_iou(const float* a, const TrackedObject& b, float buffer) {
+    float aw = (a[2] - a[0]) * buffer, ah = (a[3] - a[1]) * buffer;
+    const float expanded[4] = {a[0] - aw, a[1] - ah, a[2] + aw, a[3] + ah};
+    float bw = (b.right - b.left) * buffer, bh = (b.bottom - b.top) * buffer;
+    TrackedObject other = b;
+    other.left -= bw;
+    other.top -= bh;
+    other.right += bw;
+    other.bottom += bh;
+    return box_iou(expanded, other);
+}
+
+void measurement(const TrackedObject& object, float* z) {
+    float w = object.right - object.left;
+    float h = std::max(1e-3f, object.bottom - object.top);
+    z[0] = object.left + w * 0.5f;
+    z[1] = object.top + h * 0.5f;
+    z[2] = w / h;
+    z[3] = h;
+}
+
+}  // namespace
+
+MultiObjectTracker::MultiObjectTracker(const TrackerConfig& config)
+    : config_(config) {
+}
+
+void MultiObjectTracker::set_config(const TrackerConfig& config) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    config_ = config;
+}
+
+void MultiObjectTracker::reset_stream(int stream_id) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    streams_.erase(stream_id);
+}
+
+void MultiObjectTracker::reset() {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    streams_.clear();
+}
+
+size_t MultiObjectTracker::get_active_tracks() const {
+    std::vector<std::shared_ptr<StreamState>> streams;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        for (const auto& entry : streams_) {
+            streams.push_back(entry.second);
+        }
+    }
+    size_t active = 0;
+    for (const auto& state : streams) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        for (const auto& track : state->tracks) {
+            active += track.state == TrackState::TRACKED ? 1 : 0;
+        }
+    }
+    return active;
+}
+
+void MultiObjectTracker::initiate(Track& track, const TrackedObject& object) {
+    float z[4];
+    measurement(object, z);
+    float h = z[3];
+    const float std_pos[4] = {2 * kStdWeightPosition * h, 2 * kStdWeightPosition * h, 1e-2f,
+                              2 * kStdWeightPosition * h};
+    const float std_vel[4] = {10 * kStdWeightVelocity * h, 10 * kStdWeightVelocity * h, 1e-5f,
+                              10 * kStdWeightVelocity * h};
+    for (int i = 0; i < 4; ++i) {
+        KalmanDim& dim = track.dims[i];
+        dim.x = z[i];
+        dim.v = 0.0f;
+        dim.p00 = std_pos[i] * std_pos[i];
+        dim.p01 = 0.0f;
+        dim.p11 = std_vel[i] * std_vel[i];
+    }
+    track.box[0] = object.left;
+    track.box[1] = object.top;
+    track.box[2] = object.right;
+    track.box[3] = object.bottom;
+}
+
+void MultiObjectTracker::predict(Track& track) {
+    float h = track.dims[3].x;
+    const float std_pos[4] = {kStdWeightPosition * h, kStdWeightPosition * h, 1e-2f, kStdWeightPosition * h};
+    const float std_vel[4] = {kStdWeightVelocity * h, kStdWeightVelocity * h, 1e-5f, kStdWeightVelocity * h};
+    if (track.state != TrackState::TRACKED) {
+        // 丢失的轨迹不再外推高度变化（与 ByteTrack 一致）
+        track.dims[3].v = 0.0f;
+    }
+    for (int i = 0; i < 4; ++i) {
+        KalmanDim& dim = track.dims[i];
+        dim.x += dim.v;
+        dim.p00 += 2 * dim.p01 + dim.p11 + std_pos[i] * std_pos[i];
+        dim.p01 += dim.p11;
+        dim.p11 += std_vel[i] * std_vel[i];
+    }
+    float box_h = std::max(1e-3f, track.dims[3].x);
+    float box_w = track.dims[2].x * box_h;
+    track.box[0] = track.dims[0].x - box_w * 0.5f;
+    track.box[1] = track.dims[1].x - box_h * 0.5f;
+    track.box[2] = track.box[0] + box_w;
+    track.box[3] = track.box[1] + box_h;
+}
+
+void MultiObjectTracker::correct(Track& track, const TrackedObject& object) {
+    float z[4];
+    measurement(object, z);
+    float h = track.dims[3].x;
+    const float std_meas[4] = {kStdWeightPosition * h, kStdWeightPosition * h, 1e-1f, kStdWeightPosition * h};
+    for (int i = 0; i < 4; ++i) {
+        KalmanDim& dim = track.dims[i];
+        float s = dim.p00 + std_meas[i] * std_meas[i];
+        float k0 = dim.p00 / s;
+        float k1 = dim.p01 / s;
+        float innovation = z[i] - dim.x;
+        dim.x += k0 * innovation;
+        dim.v += k1 * innovation;
+        dim.p11 -= k1 * dim.p01;
+        dim.p01 *= 1.0f - k0;
+        dim.p00 *= 1.0f - k0;
+    }
+    track.box[0] = object.left;
+    track.box[1] = object.top;
+    track.box[2] = object.right;
+    track.box[3] = object.bottom;
+    track.cls_id = object.cls_id;
+    track.score = object.score;
+    track.frames_since_update = 0;
+}
+
+uint64_t MultiObjectTracker::associate(StreamState& state, const std::vector<TrackedObject>& objects,
+                                       std::vector<int>& track_ids, std::vector<int>& object_ids, float min_iou,
+                                       float buffer, const TrackerConfig& config, std::vector<std::pair<int, int>>& matches) {
+    matches.clear();
+    if (track_ids.empty() || object_ids.empty()) {
+        return 0;
+    }
+    const std::vector<Track>& tracks = state.tracks;
+    std::vector<Edge>& edges = state.edges;
+    edges.clear();
+
+    uint64_t pairs = 0;
+    auto try_pair = [&](int t, int o) {
+        if (config.class_aware && tracks[t].cls_id != objects[o].cls_id) {
+            return;
+        }
+        ++pairs;
+        float iou = box_iou(tracks[t].box, objects[o]);
+        float gate = buffer > 0.0f ? buffered_iou(tracks[t].box, objects[o], buffer) : iou;
+        if (gate > 0.0f && gate >= min_iou) {
+            edges.push_back({iou, gate, t, o});
+        }
+    };
+
+    if (!config.use_spatial_hash || track_ids.size() * object_ids.size() <= 64) {
+        for (int t : track_ids) {
+            for (int o : object_ids) {
+                try_pair(t, o);
+            }
+        }
+    } else {
+        // 网格边长取轨迹框长边的中位数，典型框覆盖 1-4 个单元
+        std::vector<float> sizes;
+        sizes.reserve(track_ids.size());
+        float min_x = tracks[track_ids[0]].box[0], min_y = tracks[track_ids[0]].box[1];
+        float max_x = tracks[track_ids[0]].box[2], max_y = tracks[track_ids[0]].box[3];
+        for (int t : track_ids) {
+            const float* box = tracks[t].box;
+            sizes.push_back(std::max(box[2] - box[0], box[3] - box[1]));
+            min_x = std::min(min_x, box[0]);
+            min_y = std::min(min_y, box[1]);
+            max_x = std::max(max_x, box[2]);
+            max_y = std::max(max_y, box[3]);
+        }
+        std::nth_element(sizes.begin(), sizes.begin() + sizes.size() / 2, sizes.end());
+        float cell = std::max(8.0f, sizes[sizes.size() / 2]);
+        // 网格覆盖所有轨迹框的外接矩形，单元数不超过轨迹数的8倍（个别离群框不会撑大网格）
+        float max_cells = 8.0f * track_ids.size() + 64.0f;
+        while (((max_x - min_x) / cell + 1.0f) * ((max_y - min_y) / cell + 1.0f) > max_cells) {
+            cell *= 2.0f;
+        }
+        int grid_w = static_cast<int>((max_x - min_x) / cell) + 1;
+        int grid_h = static_cast<int>((max_y - min_y) / cell) + 1;
+        // 外扩后才相交的框也要落到共同的单元里
+        auto cell_range = [&](float lo, float hi, float origin, int limit, int& first, int& last) {
+            float pad = (hi - lo) * buffer;
+            first = std::max(0, static_cast<int>(std::floor((lo - pad - origin) / cell)));
+            last = std::min(limit - 1, static_cast<int>(std::floor((hi + pad - origin) / cell)));
+        };
+
+        // 计数排序建立按单元分组的轨迹表（CSR），查找为 O(1)
+        auto& cell_start = state.cell_start;
+        auto& cell_tracks = state.cell_tracks;
+        size_t cells = static_cast<size_t>(grid_w) * grid_h;
+        cell_start.assign(cells + 1, 0);
+        for (int pass = 0; pass < 2; ++pass) {
+            if (pass == 1) {
+                // 前缀和后 cell_start[c] 为单元 c 的末尾，倒序填充后变为起始位置
+                for (size_t c = 1; c < cells; ++c) {
+                    cell_start[c] += cell_start[c - 1];
+                }
+                cell_start[cells] = cell_start[cells - 1];
+                cell_tracks.resize(cell_start[cells]);
+            }
+            for (int t : track_ids) {
+                const float* box = tracks[t].box;
+                int x0, x1, y0, y1;
+                cell_range(box[0], box[2], min_x, grid_w, x0, x1);
+                cell_range(box[1], box[3], min_y, grid_h, y0, y1);
+                for (int cy = y0; cy <= y1; ++cy) {
+                    for (int cx = x0; cx <= x1; ++cx) {
+                        size_t c = static_cast<size_t>(cy) * grid_w + cx;
+                        if (pass == 0) {
+                            cell_start[c]++;
+                        } else {
+                            cell_tracks[--cell_start[c]] = t;
+                        }
+                    }
+                }
+            }
+        }
+
+        // 同一轨迹可能与检测框共享多个单元，用访问标记去重
+        state.visit_stamp.assign(tracks.size(), -1);
+        for (int o : object_ids) {
+            const TrackedObject& object = objects[o];
+            int x0, x1, y0, y1;
+            cell_range(object.left, object.right, min_x, grid_w, x0, x1);
+            cell_range(object.top, object.bottom, min_y, grid_h, y0, y1);
+            for (int cy = y0; cy <= y1; ++cy) {
+                for (int cx = x0; cx <= x1; ++cx) {
+                    size_t c = static_cast<size_t>(cy) * grid_w + cx;
+                    for (int i = cell_start[c]; i < cell_start[c + 1]; ++i) {
+                        int t = cell_tracks[i];
+                        if (state.visit_stamp[t] != o) {
+                            state.visit_stamp[t] = o;
+                            try_pair(t, o);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // 按 IoU 从大到小贪心匹配（原始 IoU 相同，如都为0时，按外扩 IoU）
+    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+        if (a.iou != b.iou) return a.iou > b.iou;
+        if (a.buffered_iou != b.buffered_iou) return a.buffered_iou > b.buffered_iou;
+        if (a.track != b.track) return a.track < b.track;
+        return a.object < b.object;
+    });
+    std::vector<char> track_used(tracks.size(), 0);
+    std::vector<char> object_used(objects.size(), 0);
+    for (const Edge& edge : edges) {
+        if (!track_used[edge.track] && !object_used[edge.object]) {
+            track_used[edge.track] = 1;
+            object_used[edge.object] = 1;
+            matches.emplace_back(edge.track, edge.object);
+        }
+    }
+    track_ids.erase(std::remove_if(track_ids.begin(), track_ids.end(),
+                                   [&](int t) { return track_used[t] != 0; }),
+                    track_ids.end());
+    object_ids.erase(std::remove_if(object_ids.begin(), object_ids.end(),
+                                    [&](int o) { return object_used[o] != 0; }),
+                     object_ids.end());
+    return pairs;
+}
+
+std::shared_ptr<MultiObjectTracker::StreamState> MultiObjectTracker::acquire_stream(int stream_id,
+                                                                                  TrackerConfig& config) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    config = config_;
+    auto& entry = streams_[stream_id];
+    if (!entry) {
+        entry = std::make_shared<StreamState>();
+    }
+    return entry;
+}
+
+void MultiObjectTracker::update(int stream_id, std::vector<TrackedObject>& objects) {
+    TrackerConfig config;
+    std::shared_ptr<StreamState> state_ptr = acquire_stream(stream_id, config);
+    StreamState& state = *state_ptr;
+    std::lock_guard<std::mutex> lock(state.mutex);
+    std::vector<Track>& tracks = state.tracks;
+    state.frame_count++;
+
+    for (auto& track : tracks) {
+        predict(track);
+        track.frames_since_update++;
+    }
+    for (auto& object : objects) {
+        object.track_id = -1;
+    }
+
+    std::vector<int> high, low;
+    for (int i = 0; i < static_cast<int>(objects.size()); ++i) {
+        if (objects[i].score >= config.track_thresh) {
+            high.push_back(i);
+        } else if (objects[i].score >= config.low_thresh) {
+            low.push_back(i);
+        }
+    }
+    std::vector<int> confirmed, unconfirmed;
+    for (int i = 0; i < static_cast<int>(tracks.size()); ++i) {
+        (tracks[i].state == TrackState::TENTATIVE ? unconfirmed : confirmed).push_back(i);
+    }
+
+    uint64_t pairs = 0;
+    std::vector<std::pair<int, int>> matches;
+    auto apply_matches = [&]() {
+        for (const auto& match : matches) {
+            Track& track = tracks[match.first];
+            correct(track, objects[match.second]);
+            if (track.state == TrackState::TENTATIVE) {
+                track.id = state.next_id++;
+            }
+            track.state = TrackState::TRACKED;
+            objects[match.second].track_id = track.id;
+        }
+    };
+
+    // 第一轮：高分检测 ↔ 跟踪中与丢失的轨迹（外扩框判定，找回位移接近自身尺寸的小目标）
+    pairs += associate(state, objects, confirmed, high, 1.0f - config.match_thresh,
+                       std::max(0.0f, config.match_buffer), config, matches);
+    apply_matches();
+
+    // 第二轮：低分检测 ↔ 第一轮未匹配、仍在跟踪中的轨迹
+    std::vector<int> remaining;
+    for (int t : confirmed) {
+        if (tracks[t].state == TrackState::TRACKED) {
+            remaining.push_back(t);
+        }
+    }
+    pairs += associate(state, objects, remaining, low, config.low_match_iou, 0.0f, config, matches);
+    apply_matches();
+    for (int t : remaining) {
+        tracks[t].state = TrackState::LOST;
+    }
+
+    // 第三轮：剩余高分检测 ↔ 待确认轨迹，未匹配的待确认轨迹直接删除
+    pairs += associate(state, objects, unconfirmed, high, config.unconfirmed_match_iou, 0.0f, config, matches);
+    apply_matches();
+
+    // 新建轨迹：流的第一帧直接确认，其余帧需下一帧再次匹配
+    for (int o : high) {
+        if (objects[o].score < config.high_thresh) {
+            continue;
+        }
+        Track track;
+        initiate(track, objects[o]);
+        track.cls_id = objects[o].cls_id;
+        track.score = objects[o].score;
+        if (state.frame_count == 1) {
+            track.state = TrackState::TRACKED;
+            track.id = state.next_id++;
+            objects[o].track_id = track.id;
+        }
+        tracks.push_back(track);
+    }
+
+    int max_lost = std::max(1, config.track_buffer * std::max(1, config.frame_rate) / 30);
+    tracks.erase(std::remove_if(tracks.begin(), tracks.end(),
+                                [&](const Track& track) {
+                                    return (track.state == TrackState::TENTATIVE && track.frames_since_update > 0) ||
+                                           (track.state == TrackState::LOST && track.frames_since_update > max_lost);
+                                }),
+                 tracks.end());
+
+    // 只输出已确认轨迹匹配到的检测
+    objects.erase(std::remove_if(objects.begin(), objects.end(),
+                                 [](const TrackedObject& object) { return object.track_id < 0; }),
+                  objects.end());
+
+    frames_tracked_.fetch_add(1);
+    candidate_pairs_.fetch_add(pairs);
+}
+
+void MultiObjectTracker::coast(int stream_id, std::vector<TrackedObject>& objects) {
+    objects.clear();
+    TrackerConfig config;
+    std::shared_ptr<StreamState> state_ptr = acquire_stream(stream_id, config);
+    StreamState& state = *state_ptr;
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    // 每帧预测一步，保持与逐帧检测时相同的时间步长；没有检测不代表目标消失，不累计未匹配帧数
+    for (auto& track : state.tracks) {
+        predict(track);
+        if (track.state != TrackState::TRACKED) {
+            continue;
+        }
+        TrackedObject object;
+        object.left = track.box[0];
+        object.top = track.box[1];
+        object.right = track.box[2];
+        object.bottom = track.box[3];
+        object.score = track.score;
+        object.cls_id = track.cls_id;
+        object.track_id = track.id;
+        objects.push_back(object);
+    }
+    frames_coasted_.fetch_add(1);
+}
@@ -0,0 +1,162 @@
+#include "perf_counters.h"
+#include "logger_manager.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <linux/perf_event.h>
+#include <mutex>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+std::atomic<bool> g_enabled{false};
+std::atomic<bool> g_available{true};
+std::mutex g_reason_mutex;
+std::string g_reason;
+
+constexpr int kEventCount = 4;
+constexpr uint64_t kEventConfigs[kEventCount] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+long perf_event_open(perf_event_attr* attr, pid_t pid, int cpu, int group_fd, unsigned long flags) {
+    return syscall(SYS_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+
+int read_paranoid_level() {
+    std::ifstream file("/proc/sys/kernel/perf_event_paranoid");
+    int level = -100;
+    file >> level;
+    return level;
+}
+
+// 权限类错误对所有线程都成立，标记全局不可用
+void mark_unavailable(int err) {
+    if (!g_available.exchange(false)) {
+        return;
+    }
+    std::string reason = std::strerror(err);
+    int paranoid = read_paranoid_level();
+    if (paranoid != -100) {
+        reason += "（perf_event_paranoid=" + std::to_string(paranoid) + "）";
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_reason_mutex);
+        g_reason = reason;
+    }
+    LOG_WARN_F("⚠️ 硬件性能计数器不可用，已降级为仅计时: %s", reason.c_str());
+}
+
+/**
+ * 线程私有计数器组，线程退出时关闭
+ */
+struct ThreadCounterGroup {
+    int leader_fd = -1;
+    int fds[kEventCount] = {-1, -1, -1, -1};
+    int slot[kEventCount] = {-1, -1, -1, -1};   // 事件在组读数中的位置，未打开为-1
+    int opened = 0;
+    bool attempted = false;
+
+    ~ThreadCounterGroup() {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    bool open() {
+        attempted = true;
+        for (int i = 0; i < kEventCount; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = kEventConfigs[i];
+            attr.disabled = i == 0 ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = static_cast<int>(perf_event_open(&attr, 0, -1, i == 0 ? -1 : leader_fd, PERF_FLAG_FD_CLOEXEC));
+            if (fd < 0) {
+                if (i == 0) {
+                    if (errno == EACCES || errno == EPERM || errno == ENOENT || errno == ENOSYS ||
+                        errno == EOPNOTSUPP) {
+                        mark_unavailable(errno);
+                    }
+                    return false;
+                }
+                continue;   // 该事件不被支持，其余照常
+            }
+            fds[i] = fd;
+            slot[i] = opened++;
+            if (i == 0) {
+                leader_fd = fd;
+            }
+        }
+        ioctl(leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return true;
+    }
+
+    bool read(HwCounterValues& values) {
+        // 布局：nr, time_enabled, time_running, value[nr]
+        uint64_t buffer[3 + kEventCount];
+        ssize_t bytes = ::read(leader_fd, buffer, sizeof(buffer));
+        if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buffer[0] != static_cast<uint64_t>(opened)) {
+            return false;
+        }
+        uint64_t time_enabled = buffer[1];
+        uint64_t time_running = buffer[2];
+        if (time_running == 0) {
+            return false;
+        }
+        double scale = time_running < time_enabled ? static_cast<double>(time_enabled) / time_running : 1.0;
+        uint64_t* fields[kEventCount] = {&values.cycles, &values.instructions, &values.cache_misses,
+                                         &values.branch_misses};
+        for (int i = 0; i < kEventCount; ++i) {
+            *fields[i] = slot[i] >= 0 ? static_cast<uint64_t>(buffer[3 + slot[i]] * scale) : 0;
+        }
+        return true;
+    }
+};
+
+thread_local ThreadCounterGroup t_group;
+
+} // namespace
+
+void HwPerfCounters::set_enabled(bool enabled) {
+    g_enabled.store(enabled);
+}
+
+bool HwPerfCounters::enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+bool HwPerfCounters::available() {
+    return g_available.load(std::memory_order_relaxed);
+}
+
+std::string HwPerfCounters::unavailable_reason() {
+    std::lock_guard<std::mutex> lock(g_reason_mutex);
+    return g_reason;
+}
+
+bool HwPerfCounters::read(HwCounterValues& values) {
+    if (!g_enabled.load(std::memory_order_relaxed) || !g_available.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (t_group.leader_fd < 0) {
+        // 每个线程只尝试打开一次
+        if (t_group.attempted || !t_group.open()) {
+            return false;
+        }
+    }
+    return t_group.read(values);
+}
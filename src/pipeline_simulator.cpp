@@ -0,0 +1,720 @@
+#include "pipeline_simulator.h"
+#include "batch_data.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <queue>
+#include <sstream>
+
+namespace {
+
+std::vector<std::string> split_csv_line(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ',')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    rank = std::min(sorted.size(), std::max<size_t>(1, rank));
+    return sorted[rank - 1];
+}
+
+enum class EventType {
+    ARRIVAL,         // a = 流编号
+    FLUSH_TICK,      // BatchBuffer 刷新线程醒来
+    SERVICE_DONE,    // a = 阶段，b = 服务者
+    SUBMIT_TIMEOUT,  // a = 流编号，b = 该流的提交序号
+    REBATCH_FLUSH    // a = 阶段，待合并的图像到达刷新期限（只用于唤醒）
+};
+
+struct Event {
+    double time;
+    uint64_t seq;
+    EventType type;
+    int a;
+    int b;
+};
+
+struct EventLater {
+    bool operator()(const Event& x, const Event& y) const {
+        return x.time > y.time || (x.time == y.time && x.seq > y.seq);
+    }
+};
+
+struct SimBatch {
+    double created = 0.0;
+    std::vector<double> arrivals;  // 各帧采集时刻
+};
+
+enum class ServerState { IDLE, SERVING, BLOCKED };
+
+struct Server {
+    ServerState state = ServerState::IDLE;
+    int batch = -1;
+    double since = 0.0;
+};
+
+struct StageState {
+    std::deque<int> queue;      // 输入队列（首阶段为 BatchBuffer 就绪队列）
+    size_t capacity = 1;
+    size_t rebatch = 0;         // 前置连接器重组的批次大小，0 表示原样转发
+    size_t max_frames = 0;      // 重组时按图像数计的容量
+    size_t queued_frames = 0;   // 重组时队列中与待合并的图像数
+    SimBatch pending;           // 待合并的图像
+    uint64_t timeout_flushes = 0;
+    std::vector<Server> servers;
+    double busy_ms = 0.0;
+    double blocked_ms = 0.0;
+    double queue_area = 0.0;
+    size_t max_queue = 0;
+    uint64_t batches = 0;
+    uint64_t images = 0;
+};
+
+/**
+ * 单次仿真的全部状态
+ */
+class Simulation {
+public:
+    Simulation(const PipelineTopology& topology, const std::vector<ServiceDistribution>& distributions,
+               const SimulationOptions& options)
+        : topology_(topology), distributions_(distributions), options_(options), rng_(options.seed) {
+        end_ms_ = options.duration_s * 1000.0;
+        warmup_ms_ = std::min(options.warmup_s * 1000.0, end_ms_);
+        interval_ms_ = 1000.0 / options.fps_per_stream;
+        batch_size_ = std::max<size_t>(1, topology.batch_size);
+        flush_ms_ = std::max(1, topology.flush_timeout_ms);
+
+        rebatch_flush_ms_ = std::max(1, topology.rebatch_flush_ms);
+        for (const auto& stage : topology.stages) {
+            StageState state;
+            state.capacity = std::max<size_t>(1, stage.input_capacity);
+            state.servers.resize(stage.concurrency());
+            // 首阶段直接消费 BatchBuffer 的批次
+            if (!stages_.empty() && stage.batch_size > 0) {
+                state.rebatch = stage.batch_size;
+                state.max_frames = state.capacity * std::max(stage.batch_size, ImageBatch::BATCH_SIZE);
+            }
+            stages_.push_back(std::move(state));
+        }
+        pending_seq_.assign(options.streams, 0);
+        pending_.assign(options.streams, false);
+    }
+
+    SimulationResult run() {
+        std::uniform_real_distribution<double> phase(0.0, interval_ms_);
+        for (int s = 0; s < options_.streams; ++s) {
+            schedule(phase(rng_), EventType::ARRIVAL, s, 0);
+        }
+        schedule(flush_ms_, EventType::FLUSH_TICK, 0, 0);
+
+        while (!events_.empty() && events_.top().time <= end_ms_) {
+            Event event = events_.top();
+            events_.pop();
+            advance(event.time);
+            switch (event.type) {
+                case EventType::ARRIVAL: on_arrival(event.a); break;
+                case EventType::FLUSH_TICK: on_flush_tick(); break;
+                case EventType::SERVICE_DONE: on_service_done(event.a, event.b); break;
+                case EventType::SUBMIT_TIMEOUT: on_submit_timeout(event.a, event.b); break;
+                case EventType::REBATCH_FLUSH: break;   // settle() 中检查刷新期限
+            }
+            settle();
+        }
+        advance(end_ms_);
+        return finish();
+    }
+
+private:
+    const PipelineTopology& topology_;
+    const std::vector<ServiceDistribution>& distributions_;
+    const SimulationOptions& options_;
+    std::mt19937 rng_;
+
+    double end_ms_ = 0.0;
+    double warmup_ms_ = 0.0;
+    double interval_ms_ = 40.0;
+    size_t batch_size_ = 32;
+    int flush_ms_ = 10000;
+    int rebatch_flush_ms_ = 50;
+
+    double now_ = 0.0;
+    uint64_t next_seq_ = 0;
+    std::priority_queue<Event, std::vector<Event>, EventLater> events_;
+
+    std::vector<SimBatch> batches_;
+    int collecting_ = -1;
+    std::vector<StageState> stages_;
+
+    // 因背压等待提交的帧（按等待顺序），每路最多一帧
+    std::deque<std::pair<int, double>> submit_queue_;
+    std::vector<bool> pending_;
+    std::vector<uint64_t> pending_seq_;
+
+    size_t in_flight_ = 0;
+    size_t peak_in_flight_ = 0;
+    double in_flight_area_ = 0.0;
+
+    SimulationResult result_;
+    std::vector<double> latencies_;
+    uint64_t completed_in_window_ = 0;
+
+    void schedule(double time, EventType type, int a, int b) {
+        events_.push(Event{time, next_seq_++, type, a, b});
+    }
+
+    // 只统计预热之后的时间段
+    double window(double from, double to) const {
+        return std::max(0.0, std::min(to, end_ms_) - std::max(from, warmup_ms_));
+    }
+
+    void advance(double time) {
+        double span = window(now_, time);
+        if (span > 0.0) {
+            in_flight_area_ += span * in_flight_;
+            for (auto& stage : stages_) {
+                stage.queue_area += span * stage.queue.size();
+            }
+        }
+        now_ = time;
+    }
+
+    void add_in_flight(size_t count) {
+        in_flight_ += count;
+        if (now_ >= warmup_ms_) {
+            peak_in_flight_ = std::max(peak_in_flight_, in_flight_);
+        }
+    }
+
+    void on_arrival(int stream) {
+        double next = now_ + interval_ms_;
+        if (next <= end_ms_) {
+            schedule(next, EventType::ARRIVAL, stream, 0);
+        }
+        result_.frames_offered++;
+
+        // 提交线程仍阻塞在上一帧上，采集端丢弃这一帧
+        if (pending_[stream]) {
+            result_.frames_overrun++;
+            return;
+        }
+        pending_[stream] = true;
+        pending_seq_[stream]++;
+        submit_queue_.emplace_back(stream, now_);
+        add_in_flight(1);
+
+        if (options_.add_timeout_ms >= 0) {
+            schedule(now_ + options_.add_timeout_ms, EventType::SUBMIT_TIMEOUT, stream,
+                     static_cast<int>(pending_seq_[stream]));
+        }
+    }
+
+    void on_submit_timeout(int stream, int seq) {
+        if (!pending_[stream] || static_cast<int>(pending_seq_[stream]) != seq) {
+            return;
+        }
+        auto it = std::find_if(submit_queue_.begin(), submit_queue_.end(),
+                               [stream](const std::pair<int, double>& p) { return p.first == stream; });
+        if (it != submit_queue_.end()) {
+            submit_queue_.erase(it);
+        }
+        pending_[stream] = false;
+        in_flight_--;
+        result_.frames_rejected++;
+    }
+
+    // 刷新线程每 flush_timeout 醒来一次，只刷新已等待满 flush_timeout 的批次
+    void on_flush_tick() {
+        schedule(now_ + flush_ms_, EventType::FLUSH_TICK, 0, 0);
+        if (collecting_ < 0 || now_ - batches_[collecting_].created < flush_ms_) {
+            return;
+        }
+        int batch = collecting_;
+        collecting_ = -1;
+        push_ready(batch);
+    }
+
+    void on_service_done(int stage, int server) {
+        Server& sv = stages_[stage].servers[server];
+        stages_[stage].busy_ms += window(sv.since, now_);
+        sv.state = ServerState::BLOCKED;
+        sv.since = now_;
+    }
+
+    bool ready_full() const {
+        return !stages_.empty() && stages_[0].queue.size() >= stages_[0].capacity;
+    }
+
+    void push_ready(int batch) {
+        if (stages_.empty()) {
+            complete(batch);
+            return;
+        }
+        if (ready_full()) {
+            // 与 BatchBuffer::move_batch_to_ready 一致：就绪队列满时丢弃批次
+            size_t size = batches_[batch].arrivals.size();
+            result_.frames_flush_dropped += size;
+            in_flight_ -= size;
+            return;
+        }
+        stages_[0].queue.push_back(batch);
+        stages_[0].max_queue = std::max(stages_[0].max_queue, stages_[0].queue.size());
+    }
+
+    // 就绪队列有空位时按等待顺序接纳帧
+    bool try_admit() {
+        bool progress = false;
+        while (!submit_queue_.empty() && !ready_full()) {
+            auto frame = submit_queue_.front();
+            submit_queue_.pop_front();
+            pending_[frame.first] = false;
+            progress = true;
+
+            if (collecting_ < 0) {
+                batches_.emplace_back();
+                batches_.back().created = now_;
+                batches_.back().arrivals.reserve(batch_size_);
+                collecting_ = static_cast<int>(batches_.size() - 1);
+            }
+            batches_[collecting_].arrivals.push_back(frame.second);
+            if (batches_[collecting_].arrivals.size() >= batch_size_) {
+                int batch = collecting_;
+                collecting_ = -1;
+                push_ready(batch);
+            }
+        }
+        return progress;
+    }
+
+    // 发出待合并的图像（与 BatchConnector::emit_group 一致）
+    void emit_pending(StageState& state) {
+        if (state.pending.arrivals.empty()) {
+            return;
+        }
+        batches_.push_back(std::move(state.pending));
+        state.pending = SimBatch();
+        state.queue.push_back(static_cast<int>(batches_.size() - 1));
+        state.max_queue = std::max(state.max_queue, state.queue.size());
+    }
+
+    // 按下游批次大小拆分/合并（与 BatchConnector::enqueue_rebatched 一致）
+    void enqueue_rebatched(size_t stage, int batch) {
+        StageState& state = stages_[stage];
+        std::vector<double> arrivals;
+        arrivals.swap(batches_[batch].arrivals);
+        for (double arrival : arrivals) {
+            if (state.pending.arrivals.empty()) {
+                state.pending.created = now_;
+                state.pending.arrivals.reserve(state.rebatch);
+                schedule(now_ + rebatch_flush_ms_, EventType::REBATCH_FLUSH, static_cast<int>(stage), 0);
+            }
+            state.pending.arrivals.push_back(arrival);
+            state.queued_frames++;
+            if (state.pending.arrivals.size() >= state.rebatch) {
+                emit_pending(state);
+            }
+        }
+    }
+
+    // 接收方空闲且队列为空时，超过刷新期限的未满批次被取走（与 BatchConnector::flush_expired_group 一致）
+    bool flush_expired(StageState& state) {
+        if (state.rebatch == 0 || !state.queue.empty() || state.pending.arrivals.empty() ||
+            now_ < state.pending.created + rebatch_flush_ms_) {
+            return false;
+        }
+        emit_pending(state);
+        state.timeout_flushes++;
+        return true;
+    }
+
+    // 完成服务的批次送往下游，下游满时保持阻塞
+    bool forward(size_t stage, Server& sv) {
+        if (stage + 1 < stages_.size()) {
+            StageState& next = stages_[stage + 1];
+            if (next.rebatch > 0) {
+                // 重组时按图像数计容量，有空位即整批接收（与 send_batch 一致）
+                if (next.queued_frames >= next.max_frames) {
+                    return false;
+                }
+                enqueue_rebatched(stage + 1, sv.batch);
+            } else {
+                if (next.queue.size() >= next.capacity) {
+                    return false;
+                }
+                next.queue.push_back(sv.batch);
+                next.max_queue = std::max(next.max_queue, next.queue.size());
+            }
+        } else {
+            complete(sv.batch);
+        }
+        stages_[stage].blocked_ms += window(sv.since, now_);
+        sv.state = ServerState::IDLE;
+        sv.batch = -1;
+        return true;
+    }
+
+    void start_service(size_t stage, size_t server) {
+        StageState& state = stages_[stage];
+        Server& sv = state.servers[server];
+        sv.batch = state.queue.front();
+        state.queue.pop_front();
+        sv.state = ServerState::SERVING;
+        sv.since = now_;
+
+        size_t size = batches_[sv.batch].arrivals.size();
+        if (state.rebatch > 0) {
+            state.queued_frames -= std::min(state.queued_frames, size);
+        }
+        if (now_ >= warmup_ms_) {
+            state.batches++;
+            state.images += size;
+        }
+        double service_ms = std::max(0.0, distributions_[stage].draw(size, rng_));
+        schedule(now_ + service_ms, EventType::SERVICE_DONE, static_cast<int>(stage), static_cast<int>(server));
+    }
+
+    // 从下游到上游反复推进，直到没有可移动的批次
+    void settle() {
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            for (size_t i = stages_.size(); i-- > 0;) {
+                StageState& state = stages_[i];
+                for (auto& sv : state.servers) {
+                    if (sv.state == ServerState::BLOCKED && forward(i, sv)) {
+                        progress = true;
+                    }
+                }
+                for (size_t k = 0; k < state.servers.size(); ++k) {
+                    if (state.servers[k].state != ServerState::IDLE) {
+                        continue;
+                    }
+                    if (state.queue.empty() && !flush_expired(state)) {
+                        break;
+                    }
+                    start_service(i, k);
+                    progress = true;
+                }
+            }
+            if (try_admit()) {
+                progress = true;
+            }
+        }
+    }
+
+    void complete(int batch) {
+        std::vector<double> arrivals;
+        arrivals.swap(batches_[batch].arrivals);
+        in_flight_ -= arrivals.size();
+        if (now_ < warmup_ms_) {
+            return;
+        }
+        completed_in_window_ += arrivals.size();
+        for (double arrival : arrivals) {
+            if (arrival >= warmup_ms_) {
+                latencies_.push_back(now_ - arrival);
+            }
+        }
+    }
+
+    SimulationResult finish() {
+        // 仿真结束时仍在服务或阻塞的时间计入利用率
+        for (auto& stage : stages_) {
+            for (auto& sv : stage.servers) {
+                if (sv.state == ServerState::SERVING) {
+                    stage.busy_ms += window(sv.since, end_ms_);
+                } else if (sv.state == ServerState::BLOCKED) {
+                    stage.blocked_ms += window(sv.since, end_ms_);
+                }
+            }
+        }
+
+        SimulationResult& r = result_;
+        r.valid = true;
+        r.streams = options_.streams;
+        r.offered_fps = options_.streams * options_.fps_per_stream;
+        double window_ms = end_ms_ - warmup_ms_;
+        if (window_ms > 0.0) {
+            r.throughput_fps = completed_in_window_ * 1000.0 / window_ms;
+            r.mean_frames_in_flight = in_flight_area_ / window_ms;
+        }
+        r.frames_completed = completed_in_window_;
+        r.peak_frames_in_flight = peak_in_flight_;
+        r.mean_memory_mb = r.mean_frames_in_flight * options_.frame_bytes / (1024.0 * 1024.0);
+        r.peak_memory_mb = r.peak_frames_in_flight * options_.frame_bytes / (1024.0 * 1024.0);
+
+        std::sort(latencies_.begin(), latencies_.end());
+        r.latency_p50_ms = percentile(latencies_, 0.50);
+        r.latency_p95_ms = percentile(latencies_, 0.95);
+        r.latency_p99_ms = percentile(latencies_, 0.99);
+        r.latency_max_ms = latencies_.empty() ? 0.0 : latencies_.back();
+
+        for (size_t i = 0; i < stages_.size(); ++i) {
+            const StageState& state = stages_[i];
+            StageSimulation stage;
+            stage.name = topology_.stages[i].name;
+            stage.config_key = topology_.stages[i].config_key;
+            stage.concurrency = static_cast<int>(state.servers.size());
+            if (window_ms > 0.0) {
+                stage.utilisation = state.busy_ms / (window_ms * state.servers.size());
+                stage.blocked_ratio = state.blocked_ms / (window_ms * state.servers.size());
+                stage.mean_queue = state.queue_area / window_ms;
+            }
+            stage.max_queue = state.max_queue;
+            stage.mean_batch_size = state.batches > 0 ? static_cast<double>(state.images) / state.batches : 0.0;
+            if (window_ms > 0.0) {
+                stage.throughput_fps = state.images * 1000.0 / window_ms;
+            }
+            size_t nominal = static_cast<size_t>(std::lround(stage.mean_batch_size));
+            double service_ms = nominal > 0 ? distributions_[i].mean(nominal) : 0.0;
+            if (service_ms > 0.0) {
+                stage.capacity_fps = stage.concurrency * stage.mean_batch_size * 1000.0 / service_ms;
+            }
+            stage.timeout_flushes = state.timeout_flushes;
+            r.stages.push_back(stage);
+        }
+        return r;
+    }
+};
+
+} // namespace
+
+std::vector<std::string> ServiceProfile::missing_stages() const {
+    std::vector<std::string> missing;
+    for (const auto& stage : topology.stages) {
+        auto it = samples.find(stage.config_key);
+        if (it == samples.end() || it->second.empty()) {
+            missing.push_back(stage.name);
+        }
+    }
+    return missing;
+}
+
+bool ServiceProfile::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    topology.save(out);
+    for (const auto& entry : samples) {
+        for (const auto& sample : entry.second) {
+            out << "sample," << entry.first << ',' << sample.batch_size << ',' << sample.wall_ns << '\n';
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+bool ServiceProfile::load(const std::string& path, ServiceProfile& profile) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    profile = ServiceProfile();
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> fields = split_csv_line(line);
+        if (fields.size() >= 4 && fields[0] == "sample") {
+            try {
+                ServiceSample sample;
+                sample.batch_size = static_cast<uint32_t>(std::stoul(fields[2]));
+                sample.wall_ns = std::stoull(fields[3]);
+                profile.samples[fields[1]].push_back(sample);
+            } catch (const std::exception&) {
+                // 跳过损坏的行
+            }
+            continue;
+        }
+        profile.topology.parse_line(fields);
+    }
+    return !profile.topology.stages.empty();
+}
+
+ServiceDistribution ServiceDistribution::fit(const std::vector<ServiceSample>& samples) {
+    ServiceDistribution dist;
+    double sum_n = 0.0, sum_t = 0.0, sum_nn = 0.0, sum_nt = 0.0;
+    for (const auto& sample : samples) {
+        if (sample.batch_size == 0) {
+            continue;
+        }
+        double n = sample.batch_size;
+        double t = sample.wall_ns / 1e6;
+        dist.by_batch_size[sample.batch_size].push_back(t);
+        sum_n += n;
+        sum_t += t;
+        sum_nn += n * n;
+        sum_nt += n * t;
+    }
+    double count = 0.0;
+    for (const auto& bucket : dist.by_batch_size) {
+        count += bucket.second.size();
+    }
+    if (count == 0.0) {
+        return dist;
+    }
+
+    // 最小二乘拟合 t = a + b*n；只有一种批次大小时按图像数等比缩放
+    double denom = count * sum_nn - sum_n * sum_n;
+    if (dist.by_batch_size.size() >= 2 && denom > 0.0) {
+        dist.per_image_ms = (count * sum_nt - sum_n * sum_t) / denom;
+        dist.intercept_ms = (sum_t - dist.per_image_ms * sum_n) / count;
+    }
+    if (dist.by_batch_size.size() < 2 || dist.per_image_ms < 0.0 || dist.intercept_ms < 0.0) {
+        dist.intercept_ms = 0.0;
+        dist.per_image_ms = sum_t / sum_n;
+    }
+    return dist;
+}
+
+double ServiceDistribution::mean(size_t batch_size) const {
+    return intercept_ms + per_image_ms * batch_size;
+}
+
+double ServiceDistribution::draw(size_t batch_size, std::mt19937& rng) const {
+    if (by_batch_size.empty()) {
+        return 0.0;
+    }
+    // 选取最接近的批次大小
+    auto it = by_batch_size.lower_bound(batch_size);
+    if (it == by_batch_size.end()) {
+        it = std::prev(it);
+    } else if (it->first != batch_size && it != by_batch_size.begin()) {
+        auto below = std::prev(it);
+        if (batch_size - below->first < it->first - batch_size) {
+            it = below;
+        }
+    }
+    const std::vector<double>& bucket = it->second;
+    std::uniform_int_distribution<size_t> pick(0, bucket.size() - 1);
+    double value = bucket[pick(rng)];
+    if (it->first != batch_size) {
+        double base = mean(it->first);
+        if (base > 0.0) {
+            value *= mean(batch_size) / base;
+        }
+    }
+    return value;
+}
+
+bool SimulationResult::sustainable() const {
+    return valid && frames_overrun == 0 && frames_rejected == 0 && frames_flush_dropped == 0 &&
+           throughput_fps >= offered_fps * 0.98;
+}
+
+std::string SimulationResult::to_string() const {
+    std::ostringstream out;
+    if (!valid) {
+        out << "❌ 仿真失败: " << error << "\n";
+        return out.str();
+    }
+    out << std::fixed << std::setprecision(2);
+    out << "📐 仿真结果: " << streams << " 路，输入 " << offered_fps << " 帧/秒，输出 " << throughput_fps
+        << " 帧/秒" << (sustainable() ? "" : " ⚠️ 无法持续") << "\n";
+    out << "  延迟: p50 " << latency_p50_ms << " ms, p95 " << latency_p95_ms << " ms, p99 " << latency_p99_ms
+        << " ms, 最大 " << latency_max_ms << " ms\n";
+    out << "  在途帧: 平均 " << mean_frames_in_flight << ", 峰值 " << peak_frames_in_flight
+        << "；帧数据内存: 平均 " << mean_memory_mb << " MB, 峰值 " << peak_memory_mb << " MB\n";
+    if (frames_overrun > 0 || frames_rejected > 0 || frames_flush_dropped > 0) {
+        out << "  丢帧: 采集端 " << frames_overrun << ", 提交超时 " << frames_rejected << ", 刷新丢弃 "
+            << frames_flush_dropped << "（共产生 " << frames_offered << " 帧）\n";
+    }
+    for (const auto& stage : stages) {
+        out << "  " << stage.name << " [并发 " << stage.concurrency << "]: " << stage.throughput_fps
+            << " 帧/秒（容量约 " << stage.capacity_fps << " 帧/秒）, 忙碌 " << stage.utilisation * 100.0
+            << "%, 阻塞 " << stage.blocked_ratio * 100.0 << "%, 队列 平均 " << stage.mean_queue << " / 最大 "
+            << stage.max_queue << " 批次, 平均批次 " << stage.mean_batch_size << " 帧";
+        if (stage.timeout_flushes > 0) {
+            out << ", 超时发出 " << stage.timeout_flushes << " 批";
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+PipelineSimulator::PipelineSimulator(ServiceProfile profile) : profile_(std::move(profile)) {
+    for (const auto& stage : profile_.topology.stages) {
+        auto it = profile_.samples.find(stage.config_key);
+        distributions_.push_back(it != profile_.samples.end() ? ServiceDistribution::fit(it->second)
+                                                              : ServiceDistribution());
+    }
+}
+
+SimulationResult PipelineSimulator::run(const SimulationOptions& options) const {
+    SimulationResult result;
+    result.streams = options.streams;
+    if (options.streams <= 0 || options.fps_per_stream <= 0.0 || options.duration_s <= options.warmup_s) {
+        result.error = "流数量、帧率须为正，仿真时长须大于预热时长";
+        return result;
+    }
+    std::vector<std::string> missing = profile_.missing_stages();
+    if (!missing.empty()) {
+        result.error = "阶段缺少服务时间样本: " + missing.front();
+        return result;
+    }
+    Simulation simulation(profile_.topology, distributions_, options);
+    return simulation.run();
+}
+
+int PipelineSimulator::find_max_streams(const SimulationOptions& options, double latency_budget_ms,
+                                        int max_streams, SimulationResult* best) const {
+    auto evaluate = [&](int streams, SimulationResult& result) {
+        SimulationOptions trial = options;
+        trial.streams = streams;
+        result = run(trial);
+        return result.sustainable() && (latency_budget_ms <= 0.0 || result.latency_p99_ms <= latency_budget_ms);
+    };
+
+    SimulationResult result;
+    if (max_streams <= 0 || !evaluate(1, result)) {
+        if (best) {
+            *best = result;
+        }
+        return 0;
+    }
+    SimulationResult best_result = result;
+
+    // 倍增找到第一个不满足的流数，再二分
+    int good = 1;
+    int bad = max_streams + 1;
+    for (int n = 2; n <= max_streams; n *= 2) {
+        if (!evaluate(n, result)) {
+            bad = n;
+            break;
+        }
+        good = n;
+        best_result = result;
+    }
+    if (bad > max_streams && good < max_streams) {
+        if (evaluate(max_streams, result)) {
+            good = max_streams;
+            best_result = result;
+        } else {
+            bad = max_streams;
+        }
+    }
+    while (bad - good > 1) {
+        int mid = good + (bad - good) / 2;
+        if (evaluate(mid, result)) {
+            good = mid;
+            best_result = result;
+        } else {
+            bad = mid;
+        }
+    }
+    if (best) {
+        *best = best_result;
+    }
+    return good;
+}
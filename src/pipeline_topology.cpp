@@ -0,0 +1,141 @@
+#include "pipeline_topology.h"
+#include "batch_data.h"
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+
+int StageTopology::concurrency() const {
+    return concurrency_with(threads);
+}
+
+int StageTopology::concurrency_with(int threads) const {
+    int limit = std::max(1, threads);
+    if (model_instances > 0) {
+        limit = std::min(limit, model_instances);
+    }
+    if (max_in_flight > 0) {
+        limit = std::min(limit, max_in_flight);
+    }
+    if (serialized) {
+        limit = 1;
+    }
+    return limit;
+}
+
+PipelineTopology PipelineTopology::from_config(const PipelineConfig& config) {
+    PipelineTopology topology;
+    topology.batch_size = config.seg_batch_size > 0 ? static_cast<size_t>(config.seg_batch_size)
+                                                    : ImageBatch::BATCH_SIZE;
+    topology.rebatch_flush_ms = std::max(1, config.rebatch_flush_ms);
+
+    auto add_stage = [&topology](const char* name, const char* config_key, int threads,
+                                 int model_instances, bool serialized, int batch_size) {
+        StageTopology stage;
+        stage.name = name;
+        stage.config_key = config_key;
+        stage.threads = std::max(1, threads);
+        stage.model_instances = model_instances;
+        stage.serialized = serialized;
+        stage.batch_size = static_cast<size_t>(std::max(0, batch_size));
+        stage.input_capacity = topology.stages.empty() ? topology.max_ready_batches : topology.connector_capacity;
+        topology.stages.push_back(stage);
+    };
+
+    // 分割推理持 gpu_mutex_、检测只使用一个模型实例；跟踪和事件判定持锁逐批次处理
+    // 语义分割直接消费 BatchBuffer 的批次（大小为 topology.batch_size），其余阶段可由前置连接器重组
+    if (config.enable_segmentation) {
+        add_stage("批次语义分割", "semantic_threads", config.semantic_threads, 1, false, 0);
+    }
+    if (config.enable_mask_postprocess) {
+        add_stage("批次Mask后处理", "mask_threads", config.mask_postprocess_threads, 0, false,
+                  config.mask_batch_size);
+    }
+    if (config.enable_detection) {
+        add_stage("批次目标检测", "detection_threads", config.detection_threads, 1, false,
+                  config.detection_batch_size);
+    }
+    if (config.enable_tracking) {
+        add_stage("批次目标跟踪", "tracking_threads", config.tracking_threads, 1, true,
+                  config.tracking_batch_size);
+    }
+    if (config.enable_event_determine) {
+        add_stage("批次事件判定", "filter_threads", config.event_determine_threads, 1, true,
+                  config.event_batch_size);
+    }
+    return topology;
+}
+
+const StageTopology* PipelineTopology::find(const std::string& name) const {
+    for (const auto& stage : stages) {
+        if (stage.name == name || stage.config_key == name) {
+            return &stage;
+        }
+    }
+    return nullptr;
+}
+
+StageTopology* PipelineTopology::find(const std::string& name) {
+    return const_cast<StageTopology*>(static_cast<const PipelineTopology*>(this)->find(name));
+}
+
+void PipelineTopology::save(std::ostream& out) const {
+    out << "topology," << batch_size << ',' << flush_timeout_ms << ',' << max_ready_batches << ','
+        << connector_capacity << ',' << result_capacity << ',' << rebatch_flush_ms << '\n';
+    for (const auto& stage : stages) {
+        out << "stage," << stage.name << ',' << stage.config_key << ',' << stage.threads << ','
+            << stage.model_instances << ',' << stage.max_in_flight << ',' << (stage.serialized ? 1 : 0) << ','
+            << stage.input_capacity << ',' << stage.batch_size << '\n';
+    }
+}
+
+bool PipelineTopology::parse_line(const std::vector<std::string>& fields) {
+    if (fields.empty()) {
+        return false;
+    }
+    try {
+        if (fields[0] == "topology" && fields.size() >= 6) {
+            batch_size = std::stoul(fields[1]);
+            flush_timeout_ms = std::stoi(fields[2]);
+            max_ready_batches = std::stoul(fields[3]);
+            connector_capacity = std::stoul(fields[4]);
+            result_capacity = std::stoul(fields[5]);
+            if (fields.size() >= 7) {
+                rebatch_flush_ms = std::stoi(fields[6]);
+            }
+            return true;
+        }
+        if (fields[0] == "stage" && fields.size() >= 8) {
+            StageTopology stage;
+            stage.name = fields[1];
+            stage.config_key = fields[2];
+            stage.threads = std::stoi(fields[3]);
+            stage.model_instances = std::stoi(fields[4]);
+            stage.max_in_flight = std::stoi(fields[5]);
+            stage.serialized = fields[6] == "1";
+            stage.input_capacity = std::stoul(fields[7]);
+            if (fields.size() >= 9) {
+                stage.batch_size = std::stoul(fields[8]);
+            }
+            stages.push_back(stage);
+            return true;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return false;
+}
+
+std::string PipelineTopology::to_string() const {
+    std::ostringstream out;
+    out << "批次大小 " << batch_size << "，超时刷新 " << flush_timeout_ms << " ms，就绪队列 " << max_ready_batches
+        << "，连接器容量 " << connector_capacity << "，重组等待 " << rebatch_flush_ms << " ms\n";
+    for (const auto& stage : stages) {
+        out << "  " << stage.name << " [" << stage.config_key << "=" << stage.threads << "]"
+            << " 模型实例 " << (stage.model_instances > 0 ? std::to_string(stage.model_instances) : "不限")
+            << "，在途批次上限 " << stage.max_in_flight << "，并发 " << stage.concurrency()
+            << "，输入队列 " << stage.input_capacity
+            << (stage.batch_size > 0 ? "，重组 " + std::to_string(stage.batch_size) + " 帧/批" : std::string())
+            << (stage.serialized ? "（串行）" : "") << "\n";
+    }
+    return out.str();
+}
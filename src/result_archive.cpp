@@ -0,0 +1,473 @@
+#include "result_archive.h"
+#include "logger_manager.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace result_archive;
+
+namespace {
+
+/**
+ * 从 offset 开始扫描完整记录，追加到 entries
+ * @return 最后一条完整记录之后的偏移
+ */
+uint64_t scan_records(const uint8_t* data, uint64_t size, uint64_t offset,
+                      std::vector<ArchiveIndexEntry>& entries) {
+    while (offset + sizeof(result_record::ResultRecordHeader) <= size) {
+        result_record::ResultRecordHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+        uint64_t expected = sizeof(header) +
+                            (header.box_count + (header.has_filtered_box ? 1 : 0)) *
+                                sizeof(result_record::ResultRecordBox);
+        if (header.magic != result_record::kMagic || header.version != result_record::kVersion ||
+            header.record_bytes != expected || offset + expected > size) {
+            break;
+        }
+        ArchiveIndexEntry entry;
+        entry.frame_id = header.frame_id;
+        entry.timestamp_ms = header.timestamp_ms;
+        entry.offset = offset;
+        entry.stream_id = header.stream_id;
+        entry.record_bytes = header.record_bytes;
+        entries.push_back(entry);
+        offset += expected;
+    }
+    return offset;
+}
+
+bool valid_file_header(const uint8_t* data, uint64_t size) {
+    if (size < sizeof(ArchiveFileHeader)) {
+        return false;
+    }
+    ArchiveFileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    return header.magic == kFileMagic && header.version == kFileVersion &&
+           header.record_version == result_record::kVersion;
+}
+
+bool write_all(int fd, const void* data, size_t size) {
+    const uint8_t* cursor = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, cursor, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        cursor += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+uint64_t file_size(int fd) {
+    struct stat st;
+    return fstat(fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+}
+
+} // namespace
+
+// ==================== ResultArchiveWriter ====================
+
+ResultArchiveWriter::ResultArchiveWriter(const ResultArchiveConfig& config)
+    : config_(config) {
+}
+
+ResultArchiveWriter::~ResultArchiveWriter() {
+    close();
+}
+
+bool ResultArchiveWriter::open(const std::string& path) {
+    close();
+    data_fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (data_fd_ < 0) {
+        LOG_ERROR_F("❌ 无法打开结果归档 %s: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+    // 两个写入方交错追加会破坏记录与索引的对应关系
+    if (flock(data_fd_, LOCK_EX | LOCK_NB) != 0) {
+        LOG_ERROR_F("❌ 结果归档 %s 已被其他写入方打开: %s", path.c_str(), std::strerror(errno));
+        close();
+        return false;
+    }
+    index_fd_ = ::open((path + ".idx").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (index_fd_ < 0) {
+        LOG_ERROR_F("❌ 无法打开结果归档索引 %s.idx: %s", path.c_str(), std::strerror(errno));
+        close();
+        return false;
+    }
+
+    uint64_t data_size = file_size(data_fd_);
+    if (data_size == 0) {
+        ArchiveFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        header.magic = kFileMagic;
+        header.version = kFileVersion;
+        header.record_version = result_record::kVersion;
+        header.created_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        if (!write_all(data_fd_, &header, sizeof(header)) || ftruncate(index_fd_, 0) != 0 ||
+            fsync(data_fd_) != 0) {
+            LOG_ERROR_F("❌ 无法写入结果归档文件头 %s", path.c_str());
+            close();
+            return false;
+        }
+        data_offset_ = sizeof(header);
+    } else if (!recover(data_size)) {
+        LOG_ERROR_F("❌ 结果归档 %s 格式无效", path.c_str());
+        close();
+        return false;
+    }
+
+    lseek(data_fd_, static_cast<off_t>(data_offset_), SEEK_SET);
+    lseek(index_fd_, 0, SEEK_END);
+    data_buffer_.reserve(config_.buffer_bytes);
+    failed_.store(false);
+    records_since_sync_ = 0;
+    last_sync_ = std::chrono::steady_clock::now();
+    sync_requested_ = 0;
+    sync_done_ = 0;
+    sync_stop_ = false;
+    sync_thread_ = std::thread(&ResultArchiveWriter::sync_thread_func, this);
+    return true;
+}
+
+bool ResultArchiveWriter::recover(uint64_t data_size) {
+    void* map = mmap(nullptr, data_size, PROT_READ, MAP_SHARED, data_fd_, 0);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(map);
+    bool ok = valid_file_header(data, data_size);
+    std::vector<ArchiveIndexEntry> entries;
+    if (ok) {
+        data_offset_ = scan_records(data, data_size, sizeof(ArchiveFileHeader), entries);
+    }
+    munmap(map, data_size);
+    if (!ok) {
+        return false;
+    }
+
+    // 截掉半条记录，索引以数据文件为准整体重写
+    if (data_offset_ < data_size) {
+        LOG_WARN_F("⚠️ 结果归档尾部有 %llu 字节不完整记录，已截断",
+                   static_cast<unsigned long long>(data_size - data_offset_));
+        if (ftruncate(data_fd_, static_cast<off_t>(data_offset_)) != 0) {
+            return false;
+        }
+    }
+    uint64_t index_entries = file_size(index_fd_) / sizeof(ArchiveIndexEntry);
+    if (index_entries != entries.size()) {
+        if (ftruncate(index_fd_, 0) != 0 || lseek(index_fd_, 0, SEEK_SET) != 0 ||
+            !write_all(index_fd_, entries.data(), entries.size() * sizeof(ArchiveIndexEntry))) {
+            return false;
+        }
+    }
+    return fsync(data_fd_) == 0 && fsync(index_fd_) == 0;
+}
+
+bool ResultArchiveWriter::append(const ProcessResult& result, const result_record::RecordMeta& meta) {
+    if (data_fd_ < 0 || failed_.load()) {
+        return false;
+    }
+
+    size_t offset = data_buffer_.size();
+    size_t bytes = result_record::encode(result, meta, data_buffer_);
+    if (bytes == 0) {
+        data_buffer_.resize(offset);
+        return false;
+    }
+
+    ArchiveIndexEntry entry;
+    entry.frame_id = result.frame_id;
+    entry.timestamp_ms = meta.timestamp_ms;
+    entry.offset = data_offset_;
+    entry.stream_id = meta.stream_id;
+    entry.record_bytes = static_cast<uint32_t>(bytes);
+    index_buffer_.push_back(entry);
+    data_offset_ += bytes;
+    records_written_++;
+    records_since_sync_++;
+
+    bool sync_due = (config_.fsync_interval_records > 0 && records_since_sync_ >= config_.fsync_interval_records) ||
+                    (config_.fsync_interval_ms > 0 &&
+                     std::chrono::steady_clock::now() - last_sync_ >= std::chrono::milliseconds(config_.fsync_interval_ms));
+    if (sync_due) {
+        return flush();
+    }
+    if (data_buffer_.size() >= config_.buffer_bytes) {
+        return write_buffers();
+    }
+    return true;
+}
+
+bool ResultArchiveWriter::write_buffers() {
+    if (data_buffer_.empty()) {
+        return true;
+    }
+    // 先数据后索引，索引不会领先于数据
+    bool ok = write_all(data_fd_, data_buffer_.data(), data_buffer_.size()) &&
+              write_all(index_fd_, index_buffer_.data(), index_buffer_.size() * sizeof(ArchiveIndexEntry));
+    data_buffer_.clear();
+    index_buffer_.clear();
+    if (!ok) {
+        LOG_ERROR_F("❌ 写入结果归档失败: %s", std::strerror(errno));
+        failed_.store(true);
+    }
+    return ok;
+}
+
+uint64_t ResultArchiveWriter::request_sync() {
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(sync_mutex_);
+        ticket = ++sync_requested_;
+    }
+    sync_cv_.notify_all();
+    records_since_sync_ = 0;
+    last_sync_ = std::chrono::steady_clock::now();
+    return ticket;
+}
+
+void ResultArchiveWriter::sync_thread_func() {
+    std::unique_lock<std::mutex> lock(sync_mutex_);
+    while (true) {
+        sync_cv_.wait(lock, [this]() { return sync_stop_ || sync_requested_ > sync_done_; });
+        if (sync_requested_ == sync_done_) {
+            return;   // 停止且没有未完成的请求
+        }
+        // 本次落盘覆盖目前为止的所有请求（对应数据在请求前已 write）
+        uint64_t target = sync_requested_;
+        lock.unlock();
+        // 先数据后索引
+        bool ok = fdatasync(data_fd_) == 0 && fdatasync(index_fd_) == 0;
+        if (!ok) {
+            LOG_ERROR_F("❌ 结果归档落盘失败: %s", std::strerror(errno));
+            failed_.store(true);
+        }
+        fsync_count_++;
+        lock.lock();
+        sync_done_ = target;
+        sync_cv_.notify_all();
+    }
+}
+
+bool ResultArchiveWriter::flush() {
+    if (data_fd_ < 0 || failed_.load()) {
+        return false;
+    }
+    if (!write_buffers()) {
+        return false;
+    }
+    request_sync();
+    return true;
+}
+
+bool ResultArchiveWriter::sync() {
+    if (data_fd_ < 0 || failed_.load()) {
+        return false;
+    }
+    if (!write_buffers()) {
+        return false;
+    }
+    uint64_t ticket = request_sync();
+    std::unique_lock<std::mutex> lock(sync_mutex_);
+    sync_cv_.wait(lock, [this, ticket]() { return sync_done_ >= ticket; });
+    return !failed_.load();
+}
+
+void ResultArchiveWriter::close() {
+    if (data_fd_ >= 0 && index_fd_ >= 0) {
+        sync();
+    }
+    if (sync_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(sync_mutex_);
+            sync_stop_ = true;
+        }
+        sync_cv_.notify_all();
+        sync_thread_.join();
+    }
+    if (data_fd_ >= 0) {
+        ::close(data_fd_);
+        data_fd_ = -1;
+    }
+    if (index_fd_ >= 0) {
+        ::close(index_fd_);
+        index_fd_ = -1;
+    }
+    data_buffer_.clear();
+    index_buffer_.clear();
+}
+
+// ==================== ResultArchiveReader ====================
+
+ResultArchiveReader::~ResultArchiveReader() {
+    close();
+}
+
+bool ResultArchiveReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    uint64_t size = file_size(fd);
+    void* map = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(map);
+    data_size_ = size;
+    if (!valid_file_header(data_, data_size_)) {
+        close();
+        return false;
+    }
+    // 顺序扫描时让内核加大预读
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    // 索引中超出数据文件的条目（数据被截断）不可信，只取与数据对得上的前缀
+    size_t usable = 0;
+    int index_fd = ::open((path + ".idx").c_str(), O_RDONLY | O_CLOEXEC);
+    if (index_fd >= 0) {
+        uint64_t index_size = file_size(index_fd) / sizeof(ArchiveIndexEntry) * sizeof(ArchiveIndexEntry);
+        if (index_size > 0) {
+            void* index_map = mmap(nullptr, index_size, PROT_READ, MAP_SHARED, index_fd, 0);
+            if (index_map != MAP_FAILED) {
+                index_map_ = index_map;
+                index_map_size_ = index_size;
+                index_ = static_cast<const ArchiveIndexEntry*>(index_map);
+                size_t count = index_size / sizeof(ArchiveIndexEntry);
+                while (usable < count && index_[usable].offset + index_[usable].record_bytes <= data_size_) {
+                    ++usable;
+                }
+            }
+        }
+        ::close(index_fd);
+    }
+
+    uint64_t scanned_from = usable > 0 ? index_[usable - 1].offset + index_[usable - 1].record_bytes
+                                       : sizeof(ArchiveFileHeader);
+    std::vector<ArchiveIndexEntry> tail;
+    scan_records(data_, data_size_, scanned_from, tail);
+    if (tail.empty()) {
+        index_count_ = usable;
+    } else {
+        // 索引落后于数据（写入方崩溃），合并为内存索引
+        rebuilt_index_.assign(index_, index_ + usable);
+        rebuilt_index_.insert(rebuilt_index_.end(), tail.begin(), tail.end());
+        index_ = rebuilt_index_.data();
+        index_count_ = rebuilt_index_.size();
+    }
+
+    auto frame_less = [this](size_t a, size_t b) {
+        return index_[a].stream_id != index_[b].stream_id ? index_[a].stream_id < index_[b].stream_id
+                                                          : index_[a].frame_id < index_[b].frame_id;
+    };
+    auto time_less = [this](size_t a, size_t b) { return index_[a].timestamp_ms < index_[b].timestamp_ms; };
+    for (size_t i = 1; i < index_count_ && (frame_sorted_ || time_sorted_); ++i) {
+        frame_sorted_ = frame_sorted_ && !frame_less(i, i - 1);
+        time_sorted_ = time_sorted_ && !time_less(i, i - 1);
+    }
+    if (!frame_sorted_) {
+        by_frame_.resize(index_count_);
+        for (size_t i = 0; i < index_count_; ++i) by_frame_[i] = static_cast<uint32_t>(i);
+        std::stable_sort(by_frame_.begin(), by_frame_.end(), frame_less);
+    }
+    if (!time_sorted_) {
+        by_time_.resize(index_count_);
+        for (size_t i = 0; i < index_count_; ++i) by_time_[i] = static_cast<uint32_t>(i);
+        std::stable_sort(by_time_.begin(), by_time_.end(), time_less);
+    }
+    return true;
+}
+
+void ResultArchiveReader::close() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), data_size_);
+    }
+    if (index_map_) {
+        munmap(index_map_, index_map_size_);
+    }
+    data_ = nullptr;
+    data_size_ = 0;
+    index_ = nullptr;
+    index_count_ = 0;
+    index_map_ = nullptr;
+    index_map_size_ = 0;
+    rebuilt_index_.clear();
+    by_frame_.clear();
+    by_time_.clear();
+    frame_sorted_ = true;
+    time_sorted_ = true;
+}
+
+ResultArchiveReader::RecordRef ResultArchiveReader::record(size_t i) const {
+    RecordRef ref;
+    const uint8_t* base = data_ + index_[i].offset;
+    ref.header = reinterpret_cast<const result_record::ResultRecordHeader*>(base);
+    ref.boxes = reinterpret_cast<const result_record::ResultRecordBox*>(base + sizeof(result_record::ResultRecordHeader));
+    if (ref.header->has_filtered_box) {
+        ref.filtered_box = ref.boxes + ref.header->box_count;
+    }
+    return ref;
+}
+
+bool ResultArchiveReader::decode(size_t i, result_record::DecodedRecord& record) const {
+    if (i >= index_count_) {
+        return false;
+    }
+    return result_record::decode(data_ + index_[i].offset, index_[i].record_bytes, record) > 0;
+}
+
+size_t ResultArchiveReader::find_frame(uint64_t frame_id, int32_t stream_id) const {
+    auto key_less = [this, frame_id, stream_id](size_t i) {
+        return index_[i].stream_id != stream_id ? index_[i].stream_id < stream_id : index_[i].frame_id < frame_id;
+    };
+    // 在（可能经过排序表间接的）有序序列上找第一个不小于目标的位置
+    size_t lo = 0, hi = index_count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t i = frame_sorted_ ? mid : by_frame_[mid];
+        if (key_less(i)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == index_count_) {
+        return index_count_;
+    }
+    size_t i = frame_sorted_ ? lo : by_frame_[lo];
+    return index_[i].frame_id == frame_id && index_[i].stream_id == stream_id ? i : index_count_;
+}
+
+std::vector<size_t> ResultArchiveReader::time_range(uint64_t from_ms, uint64_t to_ms) const {
+    auto lower = [this](uint64_t t) {
+        size_t lo = 0, hi = index_count_;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            size_t i = time_sorted_ ? mid : by_time_[mid];
+            if (index_[i].timestamp_ms < t) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    };
+    std::vector<size_t> result;
+    size_t end = lower(to_ms);
+    for (size_t pos = lower(from_ms); pos < end; ++pos) {
+        result.push_back(time_sorted_ ? pos : by_time_[pos]);
+    }
+    return result;
+}
@@ -0,0 +1,95 @@
+#include "result_delta.h"
+#include "highway_event.h"
+#include <algorithm>
+#include <cstdlib>
+
+ResultDeltaEncoder::ResultDeltaEncoder(const ResultDeltaConfig& config)
+    : config_(config) {
+}
+
+void ResultDeltaEncoder::set_config(const ResultDeltaConfig& config) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    config_ = config;
+    // 阈值变化后已下发的状态不再满足偏差约束，统一从关键帧重新开始
+    streams_.clear();
+}
+
+void ResultDeltaEncoder::reset() {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    streams_.clear();
+}
+
+bool ResultDeltaEncoder::moved(const DetectionBox& sent, const DetectionBox& current,
+                               const ResultDeltaConfig& config) const {
+    int height = std::max(1, current.bottom - current.top);
+    int threshold = std::max(config.move_threshold_px, static_cast<int>(config.move_threshold_ratio * height));
+    return std::abs(current.left - sent.left) > threshold || std::abs(current.top - sent.top) > threshold ||
+           std::abs(current.right - sent.right) > threshold || std::abs(current.bottom - sent.bottom) > threshold;
+}
+
+void ResultDeltaEncoder::encode(ImageData& image) {
+    auto delta = std::make_shared<ResultDelta>();
+    size_t box_count = image.track_results.size();
+
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    StreamState& state = streams_[image.stream_id];
+    delta->keyframe = !state.has_base || state.frames_since_keyframe + 1 >= config_.keyframe_interval;
+    delta->base_frame_id = state.last_frame_id;
+
+    if (delta->keyframe) {
+        state.sent.clear();
+        for (const auto& raw : image.track_results) {
+            DetectionBox box = ResultView::to_detection_box(raw);
+            if (box.track_id > 0) {
+                state.sent[box.track_id] = box;
+            }
+        }
+        state.frames_since_keyframe = 0;
+        keyframes_.fetch_add(1);
+        sent_boxes_.fetch_add(box_count);
+    } else {
+        // 本帧出现过的轨迹从 sent 中暂时摘出，剩下的即为消失的轨迹
+        std::unordered_map<int, DetectionBox> current;
+        current.reserve(state.sent.size());
+        for (const auto& raw : image.track_results) {
+            DetectionBox box = ResultView::to_detection_box(raw);
+            if (box.track_id <= 0) {
+                delta->changes.push_back({CHANGE_UNTRACKED, box});
+                continue;
+            }
+            auto it = state.sent.find(box.track_id);
+            if (it == state.sent.end()) {
+                delta->changes.push_back({CHANGE_APPEARED, box});
+                current[box.track_id] = box;
+                continue;
+            }
+            uint8_t flags = 0;
+            if (it->second.status != box.status || it->second.is_still != box.is_still) {
+                flags |= CHANGE_STATUS;
+            }
+            if (moved(it->second, box, config_)) {
+                flags |= CHANGE_MOVED;
+            }
+            if (flags != 0) {
+                delta->changes.push_back({flags, box});
+                current[box.track_id] = box;
+            } else {
+                // 未下发的目标保留上次下发的位置，作为下一帧的比较基准
+                current[box.track_id] = it->second;
+            }
+            state.sent.erase(it);
+        }
+        for (const auto& entry : state.sent) {
+            delta->changes.push_back({CHANGE_DISAPPEARED, entry.second});
+        }
+        state.sent.swap(current);
+        state.frames_since_keyframe++;
+        sent_boxes_.fetch_add(delta->changes.size());
+    }
+
+    state.last_frame_id = image.frame_idx;
+    state.has_base = true;
+    frames_encoded_.fetch_add(1);
+    full_boxes_.fetch_add(box_count);
+    image.result_delta = std::move(delta);
+}
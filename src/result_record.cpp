@@ -0,0 +1,139 @@
+#include "result_record.h"
+#include <algorithm>
+#include <cstring>
+
+namespace result_record {
+
+namespace {
+
+ResultRecordBox to_record_box(const DetectionBox& box) {
+    ResultRecordBox out;
+    std::memset(&out, 0, sizeof(out));
+    out.left = box.left;
+    out.top = box.top;
+    out.right = box.right;
+    out.bottom = box.bottom;
+    float confidence = std::min(std::max(box.confidence, 0.0f), 1.0f);
+    out.confidence = static_cast<uint16_t>(confidence * 10000.0f + 0.5f);
+    out.class_id = static_cast<int16_t>(box.class_id);
+    out.track_id = box.track_id;
+    out.status = static_cast<int8_t>(box.status);
+    out.is_still = box.is_still ? 1 : 0;
+    return out;
+}
+
+DetectionBox from_record_box(const ResultRecordBox& box) {
+    DetectionBox out;
+    out.left = box.left;
+    out.top = box.top;
+    out.right = box.right;
+    out.bottom = box.bottom;
+    out.confidence = box.confidence / 10000.0f;
+    out.class_id = box.class_id;
+    out.track_id = box.track_id;
+    out.status = static_cast<ObjectStatus>(box.status);
+    out.is_still = box.is_still != 0;
+    return out;
+}
+
+} // namespace
+
+size_t encoded_size(const ProcessResult& result) {
+    size_t box_count = std::min<size_t>(result.detections.size(), UINT16_MAX);
+    return sizeof(ResultRecordHeader) +
+           (box_count + (result.has_filtered_box ? 1 : 0)) * sizeof(ResultRecordBox);
+}
+
+size_t encode_to(const ProcessResult& result, const RecordMeta& meta, uint8_t* buffer, size_t capacity) {
+    size_t total = encoded_size(result);
+    if (!buffer || capacity < total) {
+        return 0;
+    }
+
+    size_t box_count = std::min<size_t>(result.detections.size(), UINT16_MAX);
+
+    ResultRecordHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.box_count = static_cast<uint16_t>(box_count);
+    header.record_bytes = static_cast<uint32_t>(total);
+    header.status = static_cast<uint8_t>(result.status);
+    header.has_filtered_box = result.has_filtered_box ? 1 : 0;
+    header.frame_id = result.frame_id;
+    header.source_frame_id = meta.source_frame_id;
+    header.timestamp_ms = meta.timestamp_ms;
+    header.stream_id = meta.stream_id;
+    header.roi_x = result.roi.x;
+    header.roi_y = result.roi.y;
+    header.roi_width = result.roi.width;
+    header.roi_height = result.roi.height;
+
+    uint8_t* cursor = buffer;
+    std::memcpy(cursor, &header, sizeof(header));
+    cursor += sizeof(header);
+
+    for (size_t i = 0; i < box_count; ++i) {
+        ResultRecordBox box = to_record_box(result.detections[i]);
+        std::memcpy(cursor, &box, sizeof(box));
+        cursor += sizeof(box);
+    }
+    if (result.has_filtered_box) {
+        ResultRecordBox box = to_record_box(result.filtered_box);
+        std::memcpy(cursor, &box, sizeof(box));
+        cursor += sizeof(box);
+    }
+    return total;
+}
+
+size_t encode(const ProcessResult& result, const RecordMeta& meta, std::vector<uint8_t>& out) {
+    size_t offset = out.size();
+    out.resize(offset + encoded_size(result));
+    return encode_to(result, meta, out.data() + offset, out.size() - offset);
+}
+
+size_t decode(const uint8_t* data, size_t size, DecodedRecord& record) {
+    if (!data || size < sizeof(ResultRecordHeader)) {
+        return 0;
+    }
+
+    ResultRecordHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion) {
+        return 0;
+    }
+
+    size_t expected = sizeof(ResultRecordHeader) +
+                      (header.box_count + (header.has_filtered_box ? 1 : 0)) * sizeof(ResultRecordBox);
+    if (header.record_bytes != expected || size < expected) {
+        return 0;
+    }
+
+    record.meta.source_frame_id = header.source_frame_id;
+    record.meta.timestamp_ms = header.timestamp_ms;
+    record.meta.stream_id = header.stream_id;
+
+    ProcessResult& result = record.result;
+    result = ProcessResult();
+    result.status = static_cast<ResultStatus>(header.status);
+    result.frame_id = header.frame_id;
+    result.roi = cv::Rect(header.roi_x, header.roi_y, header.roi_width, header.roi_height);
+    result.has_filtered_box = header.has_filtered_box != 0;
+
+    const uint8_t* cursor = data + sizeof(header);
+    result.detections.reserve(header.box_count);
+    for (uint16_t i = 0; i < header.box_count; ++i) {
+        ResultRecordBox box;
+        std::memcpy(&box, cursor, sizeof(box));
+        cursor += sizeof(box);
+        result.detections.push_back(from_record_box(box));
+    }
+    if (result.has_filtered_box) {
+        ResultRecordBox box;
+        std::memcpy(&box, cursor, sizeof(box));
+        result.filtered_box = from_record_box(box);
+    }
+    return expected;
+}
+
+} // namespace result_record
@@ -0,0 +1,114 @@
+#include "highway_event.h"
+
+ResultView::ResultView()
+    : status_(ResultStatus::PENDING), frame_id_(0) {
+}
+
+ResultView::ResultView(ResultStatus status, uint64_t frame_id)
+    : status_(status), frame_id_(frame_id) {
+}
+
+ResultView::ResultView(ImageDataPtr image_data)
+    : status_(image_data ? ResultStatus::SUCCESS : ResultStatus::NOT_FOUND),
+      frame_id_(image_data ? image_data->frame_idx : 0),
+      image_data_(std::move(image_data)) {
+}
+
+ObjectStatus ResultView::remap_status(ObjectStatus status, bool is_still) {
+    if (!is_still) {
+        return status;
+    }
+    if (status == ObjectStatus::OCCUPY_EMERGENCY_LANE) {
+        return ObjectStatus::PARKING_EMERGENCY_LANE; // 静止的占道目标视为应急车道停车
+    }
+    return ObjectStatus::PARKING_LANE;               // 其余静止目标视为违停
+}
+
+DetectionBox ResultView::to_detection_box(const ImageData::BoundingBox& box) {
+    DetectionBox det_box;
+    det_box.left = box.left;
+    det_box.top = box.top;
+    det_box.right = box.right;
+    det_box.bottom = box.bottom;
+    det_box.confidence = box.confidence;
+    det_box.class_id = box.class_id;
+    det_box.track_id = box.track_id;
+    det_box.is_still = box.is_still;
+    det_box.status = remap_status(box.status, box.is_still);
+    return det_box;
+}
+
+size_t ResultView::box_count() const {
+    return image_data_ ? image_data_->track_results.size() : 0;
+}
+
+DetectionBox ResultView::box(size_t index) const {
+    return to_detection_box(image_data_->track_results.at(index));
+}
+
+ResultView::BoxIterator ResultView::begin() const {
+    return image_data_ ? BoxIterator(image_data_->track_results.data()) : BoxIterator();
+}
+
+ResultView::BoxIterator ResultView::end() const {
+    return image_data_ ? BoxIterator(image_data_->track_results.data() + image_data_->track_results.size())
+                       : BoxIterator();
+}
+
+bool ResultView::has_filtered_box() const {
+    return image_data_ && image_data_->has_filtered_box;
+}
+
+DetectionBox ResultView::filtered_box() const {
+    DetectionBox det_box;
+    if (!has_filtered_box()) {
+        return det_box;
+    }
+    // 筛选框保持事件判定阶段给出的原始状态
+    const auto& box = image_data_->filtered_box;
+    det_box.left = box.left;
+    det_box.top = box.top;
+    det_box.right = box.right;
+    det_box.bottom = box.bottom;
+    det_box.confidence = box.confidence;
+    det_box.class_id = box.class_id;
+    det_box.track_id = box.track_id;
+    det_box.status = box.status;
+    return det_box;
+}
+
+cv::Rect ResultView::roi() const {
+    return image_data_ ? image_data_->roi : cv::Rect();
+}
+
+cv::Mat ResultView::source_image() const {
+    return image_data_ ? image_data_->source_bgr() : cv::Mat();
+}
+
+cv::Mat ResultView::mask() const {
+    return image_data_ ? image_data_->mask : cv::Mat();
+}
+
+const ResultDelta* ResultView::delta() const {
+    return image_data_ ? image_data_->result_delta.get() : nullptr;
+}
+
+void ResultView::reset() {
+    image_data_.reset();
+}
+
+ProcessResult ResultView::to_process_result() const {
+    ProcessResult result;
+    result.status = status_;
+    result.frame_id = frame_id_;
+    if (!image_data_) {
+        return result;
+    }
+    result.roi = image_data_->roi;
+    result.detections.assign(begin(), end());
+    result.has_filtered_box = has_filtered_box();
+    if (result.has_filtered_box) {
+        result.filtered_box = filtered_box();
+    }
+    return result;
+}
@@ -0,0 +1,291 @@
+#include "shm_frame_bridge.h"
+#include "logger_manager.h"
+#include "result_record.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kStopResultTimeoutMs = 1000;   // 停止过程中等待单帧结果的上限
+
+} // namespace
+
+ShmFrameBridge::ShmFrameBridge(HighwayEventDetector* detector, const ShmBridgeConfig& config)
+    : detector_(detector), config_(config), frame_ring_(new ShmFrameRing()),
+      listen_fd_(-1), running_(false) {
+}
+
+ShmFrameBridge::~ShmFrameBridge() {
+    stop();
+}
+
+std::string ShmFrameBridge::get_control_socket_path() const {
+    return config_.control_socket_path.empty() ? "/tmp/" + config_.name + ".sock"
+                                               : config_.control_socket_path;
+}
+
+bool ShmFrameBridge::start() {
+    if (running_.load()) {
+        return true;
+    }
+    if (!detector_ || !detector_->is_running()) {
+        LOG_ERROR("❌ 共享内存桥接启动失败：检测器未运行");
+        return false;
+    }
+    if (!frame_ring_) {
+        frame_ring_.reset(new ShmFrameRing());
+    }
+    if (!frame_ring_->create(get_frame_ring_name(), config_.slot_count, config_.slot_bytes)) {
+        return false;
+    }
+    if (!result_ring_.create(get_result_ring_name(), config_.result_ring_bytes)) {
+        frame_ring_->close();
+        return false;
+    }
+
+    // 创建控制通道
+    std::string socket_path = get_control_socket_path();
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        LOG_ERROR_F("❌ 控制通道路径过长: %s", socket_path.c_str());
+        result_ring_.close();
+        frame_ring_->close();
+        return false;
+    }
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(socket_path.c_str());
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0 ||
+        bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd_, 4) != 0) {
+        LOG_ERROR_F("❌ 创建控制通道 %s 失败: %s", socket_path.c_str(), std::strerror(errno));
+        if (listen_fd_ >= 0) {
+            close(listen_fd_);
+            listen_fd_ = -1;
+        }
+        result_ring_.close();
+        frame_ring_->close();
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_frames_.clear();
+        ingest_done_ = false;
+    }
+    running_.store(true);
+    ingest_thread_ = std::thread(&ShmFrameBridge::ingest_thread_func, this);
+    result_thread_ = std::thread(&ShmFrameBridge::result_thread_func, this);
+    control_thread_ = std::thread(&ShmFrameBridge::control_thread_func, this);
+
+    std::cout << "✅ 共享内存桥接已启动，控制通道: " << socket_path << std::endl;
+    return true;
+}
+
+void ShmFrameBridge::stop() {
+    if (!running_.load()) {
+        return;
+    }
+    running_.store(false);
+    pending_cv_.notify_all();
+
+    if (ingest_thread_.joinable()) {
+        ingest_thread_.join();
+    }
+    // 接收线程退出后待处理帧不再增加，结果线程写完剩余记录后退出
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        ingest_done_ = true;
+    }
+    pending_cv_.notify_all();
+    if (result_thread_.joinable()) {
+        result_thread_.join();
+    }
+    if (control_thread_.joinable()) {
+        control_thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+        unlink(get_control_socket_path().c_str());
+    }
+    result_ring_.close();
+
+    // 等待流水线释放所有零拷贝帧
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (frame_ring_->get_slots_in_use() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (frame_ring_->get_slots_in_use() > 0) {
+        // 仍有帧被流水线引用，保留映射避免悬空访问（请先停止检测器再停止桥接）
+        LOG_WARN_F("⚠️ 仍有 %u 个帧槽位被流水线引用，帧环映射将保留到进程退出",
+                   frame_ring_->get_slots_in_use());
+        frame_ring_.release();
+    } else {
+        frame_ring_->close();
+    }
+
+    LOG_INFO("🛑 共享内存桥接已停止");
+}
+
+void ShmFrameBridge::ingest_thread_func() {
+    while (running_.load()) {
+        cv::Mat image;
+        ShmFrameMeta meta;
+        if (!frame_ring_->read_frame(image, meta, 100)) {
+            continue;
+        }
+        frames_received_.fetch_add(1);
+
+        // 零拷贝提交：image 持有槽位引用，随 ImageData 一起在流水线中流转
+        FrameSource source;
+        source.stream_id = meta.stream_id;
+        int64_t frame_id = detector_->add_frame(std::move(image), source);
+
+        PendingFrame pending;
+        pending.frame_id = frame_id >= 0 ? static_cast<uint64_t>(frame_id) : 0;
+        pending.meta = meta;
+        pending.rejected = frame_id < 0;
+        if (pending.rejected) {
+            frames_rejected_.fetch_add(1);
+        }
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            pending_frames_.push_back(pending);
+        }
+        pending_cv_.notify_one();
+    }
+}
+
+void ShmFrameBridge::result_thread_func() {
+    std::vector<uint8_t> buffer;
+    while (true) {
+        PendingFrame pending;
+        {
+            std::unique_lock<std::mutex> lock(pending_mutex_);
+            pending_cv_.wait(lock, [this]() {
+                return !pending_frames_.empty() || ingest_done_;
+            });
+            if (pending_frames_.empty()) {
+                break;
+            }
+            pending = pending_frames_.front();
+            pending_frames_.pop_front();
+        }
+
+        ProcessResult result;
+        if (pending.rejected) {
+            result.status = ResultStatus::ERROR;
+        } else {
+            // 停止过程中缩短等待（检测器已停止时直接返回ERROR），每个已提交的帧都写入一条记录
+            int timeout_ms = config_.result_timeout_ms;
+            if (!running_.load()) {
+                timeout_ms = detector_->is_running() ? std::min(timeout_ms, kStopResultTimeoutMs) : 0;
+            }
+            result = detector_->get_result_with_timeout(pending.frame_id, timeout_ms);
+        }
+
+        result_record::RecordMeta meta;
+        meta.source_frame_id = pending.meta.source_frame_id;
+        meta.timestamp_ms = pending.meta.timestamp_ms;
+        meta.stream_id = pending.meta.stream_id;
+
+        buffer.clear();
+        size_t size = result_record::encode(result, meta, buffer);
+        if (result_ring_.write(buffer.data(), static_cast<uint32_t>(size), config_.result_write_timeout_ms)) {
+            results_written_.fetch_add(1);
+        }
+    }
+}
+
+void ShmFrameBridge::control_thread_func() {
+    while (running_.load()) {
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+        int client = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+
+        // 逐行处理命令，空闲超过5秒或对端关闭时断开
+        std::string pending;
+        char chunk[512];
+        auto idle_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (running_.load() && std::chrono::steady_clock::now() < idle_deadline) {
+            pollfd cfd{client, POLLIN, 0};
+            if (poll(&cfd, 1, 200) <= 0) {
+                continue;
+            }
+            ssize_t n = recv(client, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                break;
+            }
+            pending.append(chunk, static_cast<size_t>(n));
+            size_t pos;
+            while ((pos = pending.find('\n')) != std::string::npos) {
+                std::string command = pending.substr(0, pos);
+                pending.erase(0, pos + 1);
+                if (!command.empty() && command.back() == '\r') {
+                    command.pop_back();
+                }
+                std::string reply = handle_command(command);
+                send(client, reply.data(), reply.size(), MSG_NOSIGNAL);
+            }
+            if (pending.size() > 4096) {
+                break;   // 异常输入
+            }
+            idle_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        }
+        close(client);
+    }
+}
+
+std::string ShmFrameBridge::handle_command(const std::string& command) {
+    std::ostringstream reply;
+    if (command == "PING") {
+        reply << "PONG\n";
+    } else if (command == "INFO") {
+        reply << "frame_ring=" << get_frame_ring_name()
+              << " slot_count=" << frame_ring_->get_slot_count()
+              << " slot_bytes=" << frame_ring_->get_slot_bytes()
+              << " result_ring=" << get_result_ring_name()
+              << " record_version=" << result_record::kVersion << "\n";
+    } else if (command == "STATS") {
+        Statistics stats = get_statistics();
+        reply << "received=" << stats.frames_received
+              << " rejected=" << stats.frames_rejected
+              << " results=" << stats.results_written
+              << " dropped=" << stats.results_dropped
+              << " recovered=" << stats.slots_recovered
+              << " slots_in_use=" << stats.slots_in_use << "\n";
+    } else if (command == "STATUS") {
+        reply << detector_->get_pipeline_status() << "\n";
+    } else {
+        reply << "ERR unknown command: " << command << "\n";
+    }
+    return reply.str();
+}
+
+ShmFrameBridge::Statistics ShmFrameBridge::get_statistics() const {
+    Statistics stats;
+    stats.frames_received = frames_received_.load();
+    stats.frames_rejected = frames_rejected_.load();
+    stats.results_written = results_written_.load();
+    stats.results_dropped = result_ring_.get_records_dropped();
+    if (frame_ring_) {
+        stats.slots_recovered = frame_ring_->get_slots_recovered();
+        stats.slots_in_use = frame_ring_->get_slots_in_use();
+    }
+    return stats;
+}
@@ -0,0 +1,878 @@
+#include "shm_transport.h"
+#include "logger_manager.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t kFrameRingMagic = 0x46455748;   // "HWEF"
+constexpr uint32_t kResultRingMagic = 0x52455748;  // "HWER"
+constexpr uint32_t kRingVersion = 3;
+constexpr size_t kPageSize = 4096;
+constexpr size_t kSlotHeaderBytes = 128;
+constexpr uint32_t kPadMarker = 0xFFFFFFFFu;
+constexpr uint32_t kMaxProducers = 64;              // 生产者表容量（同时登记的生产者进程数）
+constexpr int kHeartbeatIntervalMs = 100;          // 生产者心跳间隔
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "共享内存中的原子变量必须是无锁的");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "共享内存中的原子变量必须是无锁的");
+
+size_t round_up(size_t value, size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+/**
+ * 等待退避：先让出CPU，多次未就绪后短暂休眠
+ */
+void backoff(int& spins) {
+    if (++spins < 64) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+int64_t monotonic_ms() {
+    // 只在本进程内比较（观察方本地计时），不与其他进程的时钟比较
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * 槽位状态字：低32位为 SlotState，高32位为占用者登记号（仅写入中有效）
+ * 占用与登记号在同一次CAS中发布，生产者在任何时刻退出都能据登记号判断并回收
+ */
+uint64_t pack_state(uint32_t state, uint32_t owner) {
+    return (static_cast<uint64_t>(owner) << 32) | state;
+}
+
+uint32_t state_of(uint64_t word) {
+    return static_cast<uint32_t>(word);
+}
+
+uint32_t owner_of(uint64_t word) {
+    return static_cast<uint32_t>(word >> 32);
+}
+
+/**
+ * 登记号：低8位为生产者表下标+1，高24位为该表项的登记代数（表项复用后旧登记号失效）
+ */
+uint32_t make_owner_id(uint32_t index, uint32_t generation) {
+    return ((generation & 0xFFFFFFu) << 8) | (index + 1);
+}
+
+uint32_t owner_index(uint32_t owner) {
+    return (owner & 0xFFu) - 1;
+}
+
+/**
+ * 零拷贝Mat的槽位引用
+ */
+struct SlotRef {
+    ShmFrameRing* ring;
+    uint32_t index;
+};
+
+/**
+ * 共享内存槽位分配器
+ * 槽位数据以用户分配的UMatData挂到cv::Mat上，借助Mat自身的引用计数，
+ * 最后一个引用析构时把槽位归还给帧环。重新分配（如create）委托给标准分配器。
+ */
+class ShmSlotAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usage_flags) const override {
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage_flags);
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag access_flags, cv::UMatUsageFlags usage_flags) const override {
+        return cv::Mat::getStdAllocator()->allocate(data, access_flags, usage_flags);
+    }
+
+    void deallocate(cv::UMatData* data) const override {
+        if (!data) {
+            return;
+        }
+        SlotRef* ref = static_cast<SlotRef*>(data->userdata);
+        if (ref) {
+            ref->ring->release_slot(ref->index);
+            delete ref;
+        }
+        delete data;
+    }
+};
+
+ShmSlotAllocator& slot_allocator() {
+    static ShmSlotAllocator allocator;
+    return allocator;
+}
+
+} // namespace
+
+// ==================== ShmFrameRing ====================
+
+/**
+ * 生产者表项：owner 为当前登记号（0表示空闲），beat 由登记的生产者定期递增
+ */
+struct ShmFrameRing::ProducerEntry {
+    std::atomic<uint32_t> owner;
+    std::atomic<uint32_t> generation;
+    std::atomic<uint64_t> beat;
+};
+
+struct ShmFrameRing::RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t reserved;
+    uint64_t slot_bytes;       // 每个槽位的数据容量
+    uint64_t slot_stride;      // 槽位间距（含槽位头，页对齐）
+    uint64_t slots_offset;     // 第一个槽位相对映射起始的偏移
+
+    alignas(64) std::atomic<uint64_t> write_ticket;   // 生产者下一个票号
+    alignas(64) std::atomic<uint64_t> read_ticket;    // 消费者下一个票号
+    alignas(64) std::atomic<uint64_t> frames_written;
+    std::atomic<uint64_t> frames_read;
+    std::atomic<uint64_t> slots_recovered;
+
+    alignas(64) ProducerEntry producers[kMaxProducers];
+};
+
+struct ShmFrameRing::SlotHeader {
+    std::atomic<uint64_t> state;      // 状态字（SlotState + 占用者登记号，见 pack_state）
+    std::atomic<uint32_t> seq;        // seqlock序号，奇数表示写入中
+    uint32_t reserved;
+    std::atomic<uint64_t> ticket;     // 当前占用票号，先于推进 write_ticket 发布
+    ShmFrameMeta meta;
+};
+
+static_assert(sizeof(ShmFrameMeta) + 32 <= kSlotHeaderBytes, "槽位头超出预留空间");
+
+ShmFrameRing::ShmFrameRing()
+    : owner_(false), region_(nullptr), region_size_(0), header_(nullptr) {
+}
+
+ShmFrameRing::~ShmFrameRing() {
+    close();
+}
+
+bool ShmFrameRing::map_region(int fd, size_t size) {
+    void* region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (region == MAP_FAILED) {
+        LOG_ERROR_F("❌ 共享内存映射失败: %s", std::strerror(errno));
+        return false;
+    }
+    region_ = region;
+    region_size_ = size;
+    return true;
+}
+
+bool ShmFrameRing::create(const std::string& name, uint32_t slot_count, uint64_t slot_bytes) {
+    close();
+    if (slot_count == 0 || slot_bytes == 0) {
+        LOG_ERROR("❌ 帧环槽位数量和大小必须大于0");
+        return false;
+    }
+
+    size_t header_size = round_up(sizeof(RingHeader), kPageSize);
+    size_t slot_stride = round_up(kSlotHeaderBytes + slot_bytes, kPageSize);
+    size_t total = header_size + slot_stride * slot_count;
+
+    // 清理上次异常退出遗留的同名对象
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd < 0) {
+        LOG_ERROR_F("❌ 创建共享内存 %s 失败: %s", name.c_str(), std::strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        LOG_ERROR_F("❌ 设置共享内存 %s 大小失败: %s", name.c_str(), std::strerror(errno));
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    bool mapped = map_region(fd, total);
+    ::close(fd);
+    if (!mapped) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    header_ = new (region_) RingHeader();
+    header_->slot_count = slot_count;
+    header_->slot_bytes = slot_bytes;
+    header_->slot_stride = slot_stride;
+    header_->slots_offset = header_size;
+    header_->write_ticket.store(0);
+    header_->read_ticket.store(0);
+    header_->frames_written.store(0);
+    header_->frames_read.store(0);
+    header_->slots_recovered.store(0);
+    for (uint32_t i = 0; i < kMaxProducers; ++i) {
+        header_->producers[i].owner.store(0);
+        header_->producers[i].generation.store(0);
+        header_->producers[i].beat.store(0);
+    }
+    for (uint32_t i = 0; i < slot_count; ++i) {
+        SlotHeader* slot = new (slot_at(i)) SlotHeader();
+        slot->state.store(SLOT_FREE);
+        slot->seq.store(0);
+        slot->ticket.store(UINT64_MAX);
+    }
+    header_->version = kRingVersion;
+    // magic最后写入，打开方据此判断初始化完成
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = kFrameRingMagic;
+
+    name_ = name;
+    owner_ = true;
+    observed_.assign(kMaxProducers, BeatObservation());
+    std::cout << "✅ 共享内存帧环已创建: " << name << "，槽位 " << slot_count
+              << " × " << slot_bytes / 1024 << " KB" << std::endl;
+    return true;
+}
+
+bool ShmFrameRing::open(const std::string& name) {
+    close();
+    int fd = shm_open(name.c_str(), O_RDWR, 0666);
+    if (fd < 0) {
+        LOG_ERROR_F("❌ 打开共享内存 %s 失败: %s", name.c_str(), std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(RingHeader)) {
+        LOG_ERROR_F("❌ 共享内存 %s 大小无效", name.c_str());
+        ::close(fd);
+        return false;
+    }
+    bool mapped = map_region(fd, static_cast<size_t>(st.st_size));
+    ::close(fd);
+    if (!mapped) {
+        return false;
+    }
+
+    RingHeader* header = static_cast<RingHeader*>(region_);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->magic != kFrameRingMagic || header->version != kRingVersion ||
+        header->slots_offset + header->slot_stride * header->slot_count > region_size_) {
+        LOG_ERROR_F("❌ 共享内存 %s 不是有效的帧环", name.c_str());
+        munmap(region_, region_size_);
+        region_ = nullptr;
+        region_size_ = 0;
+        return false;
+    }
+    header_ = header;
+    name_ = name;
+    owner_ = false;
+    observed_.assign(kMaxProducers, BeatObservation());
+    return true;
+}
+
+void ShmFrameRing::close() {
+    unregister_producer();
+    if (region_) {
+        munmap(region_, region_size_);
+    }
+    if (owner_ && !name_.empty()) {
+        shm_unlink(name_.c_str());
+    }
+    region_ = nullptr;
+    region_size_ = 0;
+    header_ = nullptr;
+    owner_ = false;
+    name_.clear();
+}
+
+uint32_t ShmFrameRing::get_slot_count() const {
+    return header_ ? header_->slot_count : 0;
+}
+
+uint64_t ShmFrameRing::get_slot_bytes() const {
+    return header_ ? header_->slot_bytes : 0;
+}
+
+ShmFrameRing::SlotHeader* ShmFrameRing::slot_at(uint32_t index) const {
+    uint8_t* base = static_cast<uint8_t*>(region_);
+    return reinterpret_cast<SlotHeader*>(base + header_->slots_offset + header_->slot_stride * index);
+}
+
+uint8_t* ShmFrameRing::slot_data(uint32_t index) const {
+    return reinterpret_cast<uint8_t*>(slot_at(index)) + kSlotHeaderBytes;
+}
+
+ShmFrameRing::ProducerEntry* ShmFrameRing::producer_at(uint32_t index) const {
+    return &header_->producers[index];
+}
+
+uint32_t ShmFrameRing::register_producer() {
+    std::lock_guard<std::mutex> lock(producer_mutex_);
+    uint32_t id = producer_id_.load();
+    if (id != 0 && producer_at(owner_index(id))->owner.load(std::memory_order_acquire) == id) {
+        return id;
+    }
+
+    // 登记失效（close 后重新写入，或被观察方判定超时后表项已被释放）时重新登记
+    uint32_t registered = 0;
+    for (int pass = 0; pass < 2 && registered == 0; ++pass) {
+        for (uint32_t i = 0; i < kMaxProducers; ++i) {
+            ProducerEntry* entry = producer_at(i);
+            uint32_t expected = 0;
+            if (entry->owner.load(std::memory_order_relaxed) != 0) {
+                // 第二轮：释放心跳已停止的表项（其占用的槽位随之可被回收）
+                expected = entry->owner.load(std::memory_order_acquire);
+                if (pass == 0 || expected == 0 || !owner_exited(pack_state(SLOT_WRITING, expected))) {
+                    continue;
+                }
+                expected = 0;
+            }
+            uint32_t candidate = make_owner_id(i, entry->generation.fetch_add(1) + 1);
+            if (entry->owner.compare_exchange_strong(expected, candidate, std::memory_order_acq_rel)) {
+                entry->beat.fetch_add(1, std::memory_order_release);
+                registered = candidate;
+                break;
+            }
+        }
+    }
+    if (registered == 0) {
+        LOG_ERROR_F("❌ 帧环 %s 的生产者表已满（%u），无法登记", name_.c_str(), kMaxProducers);
+        return 0;
+    }
+    producer_id_.store(registered);
+
+    if (!heartbeat_thread_.joinable()) {
+        heartbeat_stop_ = false;
+        heartbeat_thread_ = std::thread(&ShmFrameRing::heartbeat_thread_func, this);
+    }
+    return registered;
+}
+
+void ShmFrameRing::unregister_producer() {
+    {
+        std::lock_guard<std::mutex> lock(producer_mutex_);
+        heartbeat_stop_ = true;
+    }
+    heartbeat_cv_.notify_all();
+    if (heartbeat_thread_.joinable()) {
+        heartbeat_thread_.join();
+    }
+    uint32_t id = producer_id_.exchange(0);
+    if (id != 0 && header_) {
+        // 注销后本进程仍占用的槽位立即可被回收
+        uint32_t expected = id;
+        producer_at(owner_index(id))->owner.compare_exchange_strong(expected, 0, std::memory_order_acq_rel);
+    }
+}
+
+void ShmFrameRing::heartbeat_thread_func() {
+    std::unique_lock<std::mutex> lock(producer_mutex_);
+    while (!heartbeat_stop_) {
+        heartbeat_cv_.wait_for(lock, std::chrono::milliseconds(kHeartbeatIntervalMs),
+                               [this]() { return heartbeat_stop_; });
+        uint32_t id = producer_id_.load();
+        if (heartbeat_stop_ || id == 0) {
+            continue;
+        }
+        ProducerEntry* entry = producer_at(owner_index(id));
+        if (entry->owner.load(std::memory_order_acquire) != id) {
+            // 本进程曾被判定为已退出（如长时间暂停），下次写入时重新登记
+            LOG_WARN_F("⚠️ 帧环 %s 的生产者登记已失效，将重新登记", name_.c_str());
+            producer_id_.store(0);
+            continue;
+        }
+        entry->beat.fetch_add(1, std::memory_order_release);
+    }
+}
+
+bool ShmFrameRing::acquire_write_slot(SlotHandle& handle, int timeout_ms) {
+    if (!header_) {
+        return false;
+    }
+    uint32_t producer = register_producer();
+    if (producer == 0) {
+        return false;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, timeout_ms));
+    int spins = 0;
+    const uint64_t claimed = pack_state(SLOT_WRITING, producer);
+
+    while (true) {
+        uint64_t ticket = header_->write_ticket.load(std::memory_order_acquire);
+        uint32_t index = static_cast<uint32_t>(ticket % header_->slot_count);
+        SlotHeader* slot = slot_at(index);
+
+        // 先锁定槽位（同时发布登记号）再推进票号，保证同一槽位不会被两个生产者同时占用
+        uint64_t expected = SLOT_FREE;
+        if (slot->state.compare_exchange_strong(expected, claimed, std::memory_order_acq_rel)) {
+            slot->seq.fetch_add(1, std::memory_order_acq_rel);   // 进入写入（奇数）
+            // 票号在推进 write_ticket 之前发布：消费者看到票号推进时一定能按票号匹配并回收
+            slot->ticket.store(ticket, std::memory_order_release);
+            uint64_t expected_ticket = ticket;
+            if (header_->write_ticket.compare_exchange_strong(expected_ticket, ticket + 1,
+                                                              std::memory_order_acq_rel)) {
+                handle.index = index;
+                handle.ticket = ticket;
+                handle.data = slot_data(index);
+                handle.capacity = header_->slot_bytes;
+                handle.claimed_state = claimed;
+                return true;
+            }
+            // 票号已被其他生产者推进，释放槽位后重试
+            slot->seq.fetch_add(1, std::memory_order_release);
+            slot->state.store(SLOT_FREE, std::memory_order_release);
+            continue;
+        }
+
+        // 占用槽位后、推进票号前退出的生产者：票号未推进，消费者不会处理，由生产者回收
+        if (state_of(expected) == SLOT_WRITING && try_recover_claim(slot, ticket, expected)) {
+            continue;
+        }
+
+        // 环满（下一个槽位仍被流水线引用）
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        backoff(spins);
+    }
+}
+
+bool ShmFrameRing::commit_write_slot(const SlotHandle& handle, const ShmFrameMeta& meta) {
+    SlotHeader* slot = slot_at(handle.index);
+    if (slot->state.load(std::memory_order_acquire) != handle.claimed_state ||
+        slot->ticket.load(std::memory_order_acquire) != handle.ticket) {
+        LOG_WARN_F("⚠️ 帧环槽位 %u 已被回收（心跳超时），丢弃该帧，票号: %llu",
+                   handle.index, static_cast<unsigned long long>(handle.ticket));
+        return false;
+    }
+    slot->meta = meta;
+    slot->seq.fetch_add(1, std::memory_order_release);   // 写入完成（偶数）
+    uint64_t expected = handle.claimed_state;
+    if (!slot->state.compare_exchange_strong(expected, SLOT_READY, std::memory_order_acq_rel)) {
+        LOG_WARN_F("⚠️ 帧环槽位 %u 提交前被回收，丢弃该帧，票号: %llu",
+                   handle.index, static_cast<unsigned long long>(handle.ticket));
+        return false;
+    }
+    header_->frames_written.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ShmFrameRing::write_frame(const cv::Mat& image, uint64_t source_frame_id, uint64_t timestamp_ms,
+                               int32_t stream_id, int timeout_ms) {
+    if (image.empty() || !header_) {
+        return false;
+    }
+    uint64_t row_bytes = static_cast<uint64_t>(image.cols) * image.elemSize();
+    uint64_t total = row_bytes * image.rows;
+    if (total > header_->slot_bytes) {
+        LOG_ERROR_F("❌ 图像大小 %llu 超出帧环槽位容量 %llu",
+                    static_cast<unsigned long long>(total),
+                    static_cast<unsigned long long>(header_->slot_bytes));
+        return false;
+    }
+
+    SlotHandle handle;
+    if (!acquire_write_slot(handle, timeout_ms)) {
+        return false;
+    }
+
+    if (image.isContinuous()) {
+        std::memcpy(handle.data, image.data, total);
+    } else {
+        for (int r = 0; r < image.rows; ++r) {
+            std::memcpy(handle.data + r * row_bytes, image.ptr(r), row_bytes);
+        }
+    }
+
+    ShmFrameMeta meta;
+    meta.source_frame_id = source_frame_id;
+    meta.timestamp_ms = timestamp_ms;
+    meta.stream_id = stream_id;
+    meta.width = image.cols;
+    meta.height = image.rows;
+    meta.type = image.type();
+    meta.step = row_bytes;
+    meta.data_bytes = total;
+    return commit_write_slot(handle, meta);
+}
+
+bool ShmFrameRing::read_meta(const SlotHeader* slot, ShmFrameMeta& meta) const {
+    uint32_t before = slot->seq.load(std::memory_order_acquire);
+    if (before & 1u) {
+        return false;
+    }
+    std::memcpy(&meta, &slot->meta, sizeof(meta));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t after = slot->seq.load(std::memory_order_relaxed);
+    return before == after;
+}
+
+bool ShmFrameRing::owner_exited(uint64_t state) {
+    uint32_t owner = owner_of(state);
+    uint32_t index = owner_index(owner);
+    if (owner == 0 || index >= kMaxProducers) {
+        return true;
+    }
+    ProducerEntry* entry = producer_at(index);
+    if (entry->owner.load(std::memory_order_acquire) != owner) {
+        return true;   // 已注销，或表项已被其他生产者复用
+    }
+
+    uint64_t beat = entry->beat.load(std::memory_order_acquire);
+    int64_t now = monotonic_ms();
+    std::lock_guard<std::mutex> lock(observe_mutex_);
+    BeatObservation& seen = observed_[index];
+    if (seen.owner != owner || seen.beat != beat) {
+        seen.owner = owner;
+        seen.beat = beat;
+        seen.since_ms = now;
+        return false;
+    }
+    if (now - seen.since_ms <= owner_timeout_ms_.load()) {
+        return false;
+    }
+    // 心跳停止：释放表项，该生产者其余占用的槽位随后无需再等待超时
+    uint32_t expected = owner;
+    entry->owner.compare_exchange_strong(expected, 0, std::memory_order_acq_rel);
+    return true;
+}
+
+bool ShmFrameRing::try_recover_slot(SlotHeader* slot, uint64_t ticket) {
+    if (slot->ticket.load(std::memory_order_acquire) != ticket) {
+        return false;
+    }
+    uint64_t state = slot->state.load(std::memory_order_acquire);
+    if (state_of(state) != SLOT_WRITING || !owner_exited(state)) {
+        return false;
+    }
+    if (!slot->state.compare_exchange_strong(state, SLOT_FREE, std::memory_order_acq_rel)) {
+        return false;
+    }
+    // 写入中的seqlock序号恢复为偶数
+    if (slot->seq.load(std::memory_order_relaxed) & 1u) {
+        slot->seq.fetch_add(1, std::memory_order_release);
+    }
+    header_->read_ticket.store(ticket + 1, std::memory_order_release);
+    header_->slots_recovered.fetch_add(1, std::memory_order_relaxed);
+    LOG_WARN_F("⚠️ 生产者（登记号 %u）写入帧时退出，已回收槽位，票号: %llu",
+               owner_of(state), static_cast<unsigned long long>(ticket));
+    return true;
+}
+
+bool ShmFrameRing::try_recover_claim(SlotHeader* slot, uint64_t ticket, uint64_t state) {
+    // 槽位票号位于 [read_ticket, ticket) 内：票号已推进的写入（环满），由消费者按票号回收
+    uint64_t slot_ticket = slot->ticket.load(std::memory_order_acquire);
+    uint64_t read_ticket = header_->read_ticket.load(std::memory_order_acquire);
+    if (slot_ticket >= read_ticket && slot_ticket < ticket) {
+        return false;
+    }
+    // 其余情况为未推进票号的占用：槽位票号仍是上一次已消费的票号，或等于当前 write_ticket
+    if (!owner_exited(state)) {
+        return false;
+    }
+    if (!slot->state.compare_exchange_strong(state, SLOT_FREE, std::memory_order_acq_rel)) {
+        return false;
+    }
+    if (slot->seq.load(std::memory_order_relaxed) & 1u) {
+        slot->seq.fetch_add(1, std::memory_order_release);
+    }
+    header_->slots_recovered.fetch_add(1, std::memory_order_relaxed);
+    LOG_WARN_F("⚠️ 生产者（登记号 %u）占用槽位后退出（票号未推进），已回收槽位，票号: %llu",
+               owner_of(state), static_cast<unsigned long long>(ticket));
+    return true;
+}
+
+bool ShmFrameRing::read_frame(cv::Mat& image, ShmFrameMeta& meta, int timeout_ms) {
+    if (!header_) {
+        return false;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, timeout_ms));
+    int spins = 0;
+
+    while (true) {
+        uint64_t ticket = header_->read_ticket.load(std::memory_order_relaxed);
+        if (ticket < header_->write_ticket.load(std::memory_order_acquire)) {
+            uint32_t index = static_cast<uint32_t>(ticket % header_->slot_count);
+            SlotHeader* slot = slot_at(index);
+            uint32_t state = state_of(slot->state.load(std::memory_order_acquire));
+
+            if (state == SLOT_READY && slot->ticket.load(std::memory_order_acquire) == ticket &&
+                read_meta(slot, meta)) {
+                slot->state.store(SLOT_CONSUMING, std::memory_order_release);
+                header_->read_ticket.store(ticket + 1, std::memory_order_release);
+
+                bool valid = meta.width > 0 && meta.height > 0 &&
+                             meta.data_bytes <= header_->slot_bytes &&
+                             meta.step * static_cast<uint64_t>(meta.height) <= meta.data_bytes;
+                if (!valid) {
+                    LOG_ERROR_F("❌ 槽位 %u 元数据无效，丢弃该帧", index);
+                    release_slot(index);
+                    continue;
+                }
+
+                // 零拷贝包装：Mat引用计数归零时由分配器归还槽位
+                uint8_t* data = slot_data(index);
+                cv::Mat wrapped(meta.height, meta.width, meta.type, data, static_cast<size_t>(meta.step));
+                cv::UMatData* u = new cv::UMatData(&slot_allocator());
+                u->data = u->origdata = data;
+                u->size = static_cast<size_t>(meta.data_bytes);
+                u->userdata = new SlotRef{this, index};
+                u->refcount = 1;
+                wrapped.u = u;
+                wrapped.allocator = &slot_allocator();
+                image = wrapped;
+
+                header_->frames_read.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            if (state == SLOT_WRITING && try_recover_slot(slot, ticket)) {
+                continue;
+            }
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        backoff(spins);
+    }
+}
+
+void ShmFrameRing::release_slot(uint32_t index) {
+    if (!header_ || index >= header_->slot_count) {
+        return;
+    }
+    slot_at(index)->state.store(SLOT_FREE, std::memory_order_release);
+}
+
+uint64_t ShmFrameRing::get_frames_written() const {
+    return header_ ? header_->frames_written.load() : 0;
+}
+
+uint64_t ShmFrameRing::get_frames_read() const {
+    return header_ ? header_->frames_read.load() : 0;
+}
+
+uint64_t ShmFrameRing::get_slots_recovered() const {
+    return header_ ? header_->slots_recovered.load() : 0;
+}
+
+uint32_t ShmFrameRing::get_slots_in_use() const {
+    if (!header_) {
+        return 0;
+    }
+    // 按槽位状态统计，生产者在任何时刻退出都不会使计数失准
+    uint32_t in_use = 0;
+    for (uint32_t i = 0; i < header_->slot_count; ++i) {
+        if (state_of(slot_at(i)->state.load(std::memory_order_acquire)) != SLOT_FREE) {
+            ++in_use;
+        }
+    }
+    return in_use;
+}
+
+// ==================== ShmResultRing ====================
+
+struct ShmResultRing::RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;                          // 数据区字节数（8字节对齐）
+    alignas(64) std::atomic<uint64_t> head;     // 已写入总字节数（生产者）
+    alignas(64) std::atomic<uint64_t> tail;     // 已读取总字节数（消费者）
+    alignas(64) std::atomic<uint64_t> records_dropped;
+};
+
+ShmResultRing::ShmResultRing()
+    : owner_(false), region_(nullptr), region_size_(0), header_(nullptr), data_(nullptr) {
+}
+
+ShmResultRing::~ShmResultRing() {
+    close();
+}
+
+bool ShmResultRing::create(const std::string& name, uint64_t capacity_bytes) {
+    close();
+    uint64_t capacity = round_up(std::max<uint64_t>(capacity_bytes, kPageSize), 8);
+    size_t header_size = round_up(sizeof(RingHeader), kPageSize);
+    size_t total = header_size + capacity;
+
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd < 0) {
+        LOG_ERROR_F("❌ 创建共享内存 %s 失败: %s", name.c_str(), std::strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        LOG_ERROR_F("❌ 设置共享内存 %s 大小失败: %s", name.c_str(), std::strerror(errno));
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void* region = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (region == MAP_FAILED) {
+        LOG_ERROR_F("❌ 共享内存映射失败: %s", std::strerror(errno));
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    region_ = region;
+    region_size_ = total;
+    header_ = new (region_) RingHeader();
+    header_->version = kRingVersion;
+    header_->capacity = capacity;
+    header_->head.store(0);
+    header_->tail.store(0);
+    header_->records_dropped.store(0);
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = kResultRingMagic;
+    data_ = static_cast<uint8_t*>(region_) + header_size;
+
+    name_ = name;
+    owner_ = true;
+    std::cout << "✅ 共享内存结果环已创建: " << name << "，容量 " << capacity / 1024 << " KB" << std::endl;
+    return true;
+}
+
+bool ShmResultRing::open(const std::string& name) {
+    close();
+    int fd = shm_open(name.c_str(), O_RDWR, 0666);
+    if (fd < 0) {
+        LOG_ERROR_F("❌ 打开共享内存 %s 失败: %s", name.c_str(), std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(RingHeader)) {
+        ::close(fd);
+        return false;
+    }
+    size_t total = static_cast<size_t>(st.st_size);
+    void* region = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (region == MAP_FAILED) {
+        return false;
+    }
+
+    RingHeader* header = static_cast<RingHeader*>(region);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    size_t header_size = round_up(sizeof(RingHeader), kPageSize);
+    if (header->magic != kResultRingMagic || header->version != kRingVersion ||
+        header_size + header->capacity > total) {
+        LOG_ERROR_F("❌ 共享内存 %s 不是有效的结果环", name.c_str());
+        munmap(region, total);
+        return false;
+    }
+
+    region_ = region;
+    region_size_ = total;
+    header_ = header;
+    data_ = static_cast<uint8_t*>(region_) + header_size;
+    name_ = name;
+    owner_ = false;
+    return true;
+}
+
+void ShmResultRing::close() {
+    if (region_) {
+        munmap(region_, region_size_);
+    }
+    if (owner_ && !name_.empty()) {
+        shm_unlink(name_.c_str());
+    }
+    region_ = nullptr;
+    region_size_ = 0;
+    header_ = nullptr;
+    data_ = nullptr;
+    owner_ = false;
+    name_.clear();
+}
+
+bool ShmResultRing::try_write(const uint8_t* record, uint32_t size) {
+    const uint64_t capacity = header_->capacity;
+    const uint64_t entry = round_up(sizeof(uint32_t) + size, 8);
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    uint64_t tail = header_->tail.load(std::memory_order_acquire);
+    uint64_t offset = head % capacity;
+    uint64_t contiguous = capacity - offset;
+    uint64_t needed = entry <= contiguous ? entry : contiguous + entry;
+    if (capacity - (head - tail) < needed) {
+        return false;
+    }
+
+    if (entry > contiguous) {
+        // 环尾剩余空间不足，写入填充标记后从头开始
+        std::memcpy(data_ + offset, &kPadMarker, sizeof(kPadMarker));
+        head += contiguous;
+        offset = 0;
+    }
+    std::memcpy(data_ + offset, &size, sizeof(size));
+    std::memcpy(data_ + offset + sizeof(size), record, size);
+    header_->head.store(head + entry, std::memory_order_release);
+    return true;
+}
+
+bool ShmResultRing::write(const uint8_t* record, uint32_t size, int timeout_ms) {
+    if (!header_ || !record || size == 0) {
+        return false;
+    }
+    if (round_up(sizeof(uint32_t) + size, 8) > header_->capacity / 2) {
+        // 单条记录不允许超过半个环，等待也不会有足够空间
+        LOG_ERROR_F("❌ 结果记录 %u 字节超过结果环容量的一半，丢弃", size);
+        header_->records_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, timeout_ms));
+    int spins = 0;
+    while (!try_write(record, size)) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            header_->records_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        backoff(spins);
+    }
+    return true;
+}
+
+bool ShmResultRing::try_read(std::vector<uint8_t>& record) {
+    const uint64_t capacity = header_->capacity;
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    uint64_t head = header_->head.load(std::memory_order_acquire);
+    while (tail < head) {
+        uint64_t offset = tail % capacity;
+        uint32_t size = 0;
+        std::memcpy(&size, data_ + offset, sizeof(size));
+        if (size == kPadMarker) {
+            tail += capacity - offset;
+            continue;
+        }
+        record.assign(data_ + offset + sizeof(size), data_ + offset + sizeof(size) + size);
+        header_->tail.store(tail + round_up(sizeof(uint32_t) + size, 8), std::memory_order_release);
+        return true;
+    }
+    header_->tail.store(tail, std::memory_order_release);
+    return false;
+}
+
+bool ShmResultRing::read(std::vector<uint8_t>& record, int timeout_ms) {
+    if (!header_) {
+        return false;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, timeout_ms));
+    int spins = 0;
+    while (!try_read(record)) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        backoff(spins);
+    }
+    return true;
+}
+
+uint64_t ShmResultRing::get_records_dropped() const {
+    return header_ ? header_->records_dropped.load() : 0;
+}
@@ -0,0 +1,141 @@
+#include "stage_profiler.h"
+#include <cstdio>
+#include <time.h>
+
+namespace {
+thread_local StageProfiler* t_current_profiler = nullptr;
+thread_local bool t_pool_task = false;
+}
+
+uint64_t StageProfiler::thread_cpu_ns() {
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+StageProfiler* StageProfiler::current() {
+    return t_current_profiler;
+}
+
+void StageProfiler::record_input_wait(uint64_t ns) {
+    if (t_current_profiler) {
+        t_current_profiler->add_input_wait(ns);
+    }
+}
+
+void StageProfiler::record_output_wait(uint64_t ns) {
+    if (t_current_profiler) {
+        t_current_profiler->add_output_wait(ns);
+    }
+}
+
+void StageProfiler::record_lock_wait(uint64_t ns) {
+    if (!t_current_profiler) {
+        return;
+    }
+    if (t_pool_task) {
+        t_current_profiler->add_pool_lock_wait(ns);
+    } else {
+        t_current_profiler->add_lock_wait(ns);
+    }
+}
+
+StageProfiler::ThreadBinding::ThreadBinding(StageProfiler* profiler, bool pool_task)
+    : previous_(t_current_profiler), previous_pool_task_(t_pool_task) {
+    t_current_profiler = profiler;
+    t_pool_task = pool_task;
+}
+
+StageProfiler::ThreadBinding::~ThreadBinding() {
+    t_current_profiler = previous_;
+    t_pool_task = previous_pool_task_;
+}
+
+StageProfileSnapshot StageProfiler::snapshot() const {
+    StageProfileSnapshot profile;
+    profile.batches = batches_.load(std::memory_order_relaxed);
+    profile.images = images_.load(std::memory_order_relaxed);
+    profile.busy_cpu_ns = busy_cpu_ns_.load(std::memory_order_relaxed);
+    profile.busy_wall_ns = busy_wall_ns_.load(std::memory_order_relaxed);
+    profile.input_wait_ns = input_wait_ns_.load(std::memory_order_relaxed);
+    profile.output_wait_ns = output_wait_ns_.load(std::memory_order_relaxed);
+    profile.lock_wait_ns = lock_wait_ns_.load(std::memory_order_relaxed);
+    profile.pool_tasks = pool_tasks_.load(std::memory_order_relaxed);
+    profile.pool_cpu_ns = pool_cpu_ns_.load(std::memory_order_relaxed);
+    profile.pool_lock_wait_ns = pool_lock_wait_ns_.load(std::memory_order_relaxed);
+    profile.hw_intervals = hw_intervals_.load(std::memory_order_relaxed);
+    profile.hw_cycles = hw_cycles_.load(std::memory_order_relaxed);
+    profile.hw_instructions = hw_instructions_.load(std::memory_order_relaxed);
+    profile.hw_cache_misses = hw_cache_misses_.load(std::memory_order_relaxed);
+    profile.hw_branch_misses = hw_branch_misses_.load(std::memory_order_relaxed);
+    return profile;
+}
+
+void StageProfiler::add_service_sample(size_t batch_size, uint64_t wall_ns) {
+    ServiceSample sample;
+    sample.batch_size = static_cast<uint32_t>(batch_size);
+    sample.wall_ns = wall_ns;
+    std::lock_guard<std::mutex> lock(samples_mutex_);
+    if (service_samples_.size() < SERVICE_SAMPLE_CAPACITY) {
+        service_samples_.push_back(sample);
+    } else {
+        service_samples_[next_sample_] = sample;
+        next_sample_ = (next_sample_ + 1) % SERVICE_SAMPLE_CAPACITY;
+    }
+}
+
+std::vector<ServiceSample> StageProfiler::service_samples() const {
+    std::lock_guard<std::mutex> lock(samples_mutex_);
+    return service_samples_;
+}
+
+std::string StageProfiler::format(const StageProfileSnapshot& profile) {
+    uint64_t total = profile.total_ns();
+    if (total == 0) {
+        return "无数据";
+    }
+    // 锁等待发生在 process_batch 内，计算时间取CPU时间（可能因CPU计时粒度略超墙钟）
+    uint64_t busy_cpu = profile.busy_cpu_ns < profile.busy_wall_ns ? profile.busy_cpu_ns : profile.busy_wall_ns;
+    auto pct = [total](uint64_t ns) { return 100.0 * static_cast<double>(ns) / static_cast<double>(total); };
+
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "计算 %.1f%% | 非CPU %.1f%% | 等输入 %.1f%% | 等输出 %.1f%% | 锁等待 %.1f%%",
+                  pct(busy_cpu), pct(profile.offcpu_ns()), pct(profile.input_wait_ns),
+                  pct(profile.output_wait_ns), pct(profile.lock_wait_ns));
+    std::string result(line);
+    if (profile.pool_tasks > 0) {
+        // 线程池任务不在工作线程时间内，以绝对值报告
+        std::snprintf(line, sizeof(line), " | 线程池CPU %.1f ms (%llu 任务, 锁等待 %.1f ms)",
+                      profile.pool_cpu_ns / 1e6, static_cast<unsigned long long>(profile.pool_tasks),
+                      profile.pool_lock_wait_ns / 1e6);
+        result += line;
+    }
+    if (profile.hw_instructions > 0) {
+        std::snprintf(line, sizeof(line), " | IPC %.2f, 缓存未命中 %.2f/千指令, 分支未命中 %.2f/千指令",
+                      profile.ipc(), profile.cache_mpki(), profile.branch_mpki());
+        result += line;
+    }
+    return result;
+}
+
+void InstrumentedMutex::record_wait(uint64_t ns) {
+    contended_.fetch_add(1, std::memory_order_relaxed);
+    wait_ns_.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t prev = max_wait_ns_.load(std::memory_order_relaxed);
+    while (ns > prev && !max_wait_ns_.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {
+    }
+    StageProfiler::record_lock_wait(ns);
+}
+
+LockContentionSnapshot InstrumentedMutex::snapshot() const {
+    LockContentionSnapshot stats;
+    stats.name = name_;
+    stats.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+    stats.contended = contended_.load(std::memory_order_relaxed);
+    stats.wait_ns = wait_ns_.load(std::memory_order_relaxed);
+    stats.max_wait_ns = max_wait_ns_.load(std::memory_order_relaxed);
+    return stats;
+}
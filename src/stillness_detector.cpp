@@ -0,0 +1,167 @@
+#include "stillness_detector.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+float median_of(std::vector<float>& values) {
+    if (values.empty()) {
+        return 0.0f;
+    }
+    auto mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    if (values.size() % 2 != 0) {
+        return *mid;
+    }
+    float lower = *std::max_element(values.begin(), mid);
+    return (lower + *mid) * 0.5f;
+}
+
+// 参考位置取最近几帧的中位数，降低检测框抖动对单帧步长的影响
+constexpr size_t kReferenceFrames = 5;
+
+}  // namespace
+
+TrackStillnessDetector::TrackStillnessDetector(const StillnessConfig& config)
+    : config_(config) {
+}
+
+void TrackStillnessDetector::set_config(const StillnessConfig& config) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    config_ = config;
+}
+
+void TrackStillnessDetector::reset() {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    streams_.clear();
+}
+
+void TrackStillnessDetector::reset_stream(int stream_id) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    streams_.erase(stream_id);
+}
+
+float TrackStillnessDetector::displacement_ratio(const std::deque<Sample>& samples) {
+    size_t k = std::max<size_t>(1, samples.size() / 3);
+    std::vector<float> xs, ys, heights;
+    xs.reserve(k);
+    ys.reserve(k);
+    heights.reserve(samples.size());
+    for (const auto& sample : samples) {
+        heights.push_back(sample.height);
+    }
+
+    auto window_center = [&](size_t begin) {
+        xs.clear();
+        ys.clear();
+        for (size_t i = begin; i < begin + k; ++i) {
+            xs.push_back(samples[i].x);
+            ys.push_back(samples[i].y);
+        }
+        return std::make_pair(median_of(xs), median_of(ys));
+    };
+    auto head = window_center(0);
+    auto tail = window_center(samples.size() - k);
+
+    float height = std::max(1.0f, median_of(heights));
+    return std::hypot(tail.first - head.first, tail.second - head.second) / height;
+}
+
+bool TrackStillnessDetector::detect_camera_motion(const StreamState& state, const std::vector<TrackBox>& boxes,
+                                                  const StillnessConfig& config) const {
+    std::vector<float> dxs, dys, log_scales;
+    std::vector<float> xs, ys, heights;
+    size_t moved = 0;
+    for (const auto& box : boxes) {
+        auto it = state.tracks.find(box.track_id);
+        if (it == state.tracks.end() || !it->second.still || it->second.samples.empty() || box.box.height <= 0) {
+            continue;
+        }
+        const auto& samples = it->second.samples;
+        if (samples.back().seq + 1 != state.frames_seen) {
+            continue;
+        }
+        xs.clear();
+        ys.clear();
+        heights.clear();
+        for (size_t i = samples.size() - std::min(samples.size(), kReferenceFrames); i < samples.size(); ++i) {
+            xs.push_back(samples[i].x);
+            ys.push_back(samples[i].y);
+            heights.push_back(samples[i].height);
+        }
+        float ref_height = std::max(1.0f, median_of(heights));
+        float x = box.box.x + box.box.width * 0.5f;
+        float y = static_cast<float>(box.box.y + box.box.height);
+        float dx = (x - median_of(xs)) / ref_height;
+        float dy = (y - median_of(ys)) / ref_height;
+        if (std::hypot(dx, dy) > config.camera_step_ratio) {
+            ++moved;
+        }
+        dxs.push_back(dx);
+        dys.push_back(dy);
+        log_scales.push_back(std::log(box.box.height / ref_height));
+    }
+
+    if (static_cast<int>(dxs.size()) < std::max(1, config.min_reference_tracks)) {
+        return false;
+    }
+
+    // 平移：多数静止目标超过步长阈值，且中位步长向量同样超过阈值（随机抖动的中位数趋近于0）
+    bool shifted = moved >= config.camera_motion_track_ratio * dxs.size() &&
+                   std::hypot(median_of(dxs), median_of(dys)) > config.camera_step_ratio;
+    bool zoomed = std::fabs(median_of(log_scales)) > std::log1p(config.camera_zoom_ratio);
+    return shifted || zoomed;
+}
+
+bool TrackStillnessDetector::update(int stream_id, std::vector<TrackBox>& boxes, bool camera_moving) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    const StillnessConfig& config = config_;
+    StreamState& state = streams_[stream_id];
+    // 各帧数阈值按本流自己的帧计数（检测器的 frame_idx 由所有流共用）
+    const uint64_t seq = state.frames_seen;
+
+    // 连续多帧都出现整体偏移才判定为相机运动，单帧检测抖动不触发回退
+    bool suspected = seq > 0 && detect_camera_motion(state, boxes, config);
+    state.suspect_frames = suspected ? state.suspect_frames + 1 : 0;
+    if (camera_moving || state.suspect_frames >= std::max(1, config.camera_confirm_frames)) {
+        // 相机运动：旧位置不再可比，清空历史并交给特征点路径
+        state.suspect_frames = 0;
+        for (auto& entry : state.tracks) {
+            entry.second.samples.clear();
+            entry.second.still = false;
+        }
+        state.hold_until = seq + std::max(1, config.camera_motion_hold_frames);
+        camera_motion_events_.fetch_add(1);
+    }
+    state.frames_seen = seq + 1;
+
+    size_t history = static_cast<size_t>(std::max(3, config.history_frames));
+    size_t min_history = static_cast<size_t>(std::max(3, std::min(config.min_history_frames, config.history_frames)));
+    for (auto& box : boxes) {
+        TrackHistory& track = state.tracks[box.track_id];
+        track.samples.push_back({seq, box.box.x + box.box.width * 0.5f,
+                                 static_cast<float>(box.box.y + box.box.height),
+                                 static_cast<float>(box.box.height)});
+        while (track.samples.size() > history) {
+            track.samples.pop_front();
+        }
+        track.still = track.samples.size() >= min_history &&
+                      displacement_ratio(track.samples) < config.still_displacement_ratio;
+        box.is_still = track.still;
+    }
+
+    // 清除长时间未出现的轨迹
+    for (auto it = state.tracks.begin(); it != state.tracks.end();) {
+        const auto& samples = it->second.samples;
+        bool expired = samples.empty() ||
+                       seq > samples.back().seq + static_cast<uint64_t>(std::max(1, config.max_missing_frames));
+        it = expired ? state.tracks.erase(it) : std::next(it);
+    }
+
+    if (seq < state.hold_until) {
+        feature_frames_.fetch_add(1);
+        return true;
+    }
+    history_frames_.fetch_add(1);
+    return false;
+}
@@ -2,7 +2,7 @@
 #include "logger_manager.h"
 #include <iostream>
 
-ThreadPool::ThreadPool(size_t threads) : running_(true) {
+ThreadPool::ThreadPool(size_t threads, StageProfiler* profiler) : running_(true), profiler_(profiler) {
     if (threads == 0) {
         threads = std::thread::hardware_concurrency();
         if (threads == 0) threads = 4; // 默认4个线程
@@ -12,6 +12,7 @@ ThreadPool::ThreadPool(size_t threads) : running_(true) {
     
     for (size_t i = 0; i < threads; ++i) {
         workers_.emplace_back([this] {
+            StageProfiler::ThreadBinding binding(profiler_, true);
             for (;;) {
                 std::function<void()> task;
 
@@ -33,6 +34,9 @@ ThreadPool::ThreadPool(size_t threads) : running_(true) {
                     }
                 }
 
+                uint64_t cpu_start = profiler_ ? StageProfiler::thread_cpu_ns() : 0;
+                HwCounterValues hw_start;
+                bool hw_valid = profiler_ && HwPerfCounters::read(hw_start);
                 try {
                     task();
                 } catch (const std::exception& e) {
@@ -40,6 +44,13 @@ ThreadPool::ThreadPool(size_t threads) : running_(true) {
                 } catch (...) {
                     LOG_ERROR("ThreadPool任务执行未知异常");
                 }
+                if (profiler_) {
+                    profiler_->add_pool_task(StageProfiler::thread_cpu_ns() - cpu_start);
+                    HwCounterValues hw_end;
+                    if (hw_valid && HwPerfCounters::read(hw_end)) {
+                        profiler_->add_hw(hw_end - hw_start);
+                    }
+                }
             }
         });
     }
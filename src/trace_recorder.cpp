@@ -0,0 +1,230 @@
+#include "trace_recorder.h"
+#include "logger_manager.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+std::atomic<bool> TraceRecorder::enabled_{false};
+
+namespace {
+
+struct TraceEvent {
+    uint64_t start_ns;
+    uint64_t dur_ns;
+    const char* category;
+    const char* name;
+    int64_t batch_id;
+    int64_t frame_idx;
+    char phase;          // 'X' 区间事件，'i' 瞬时事件
+};
+
+/**
+ * 线程私有事件缓冲区，只有所属线程写入，导出时按 count 读取已提交的事件
+ */
+struct ThreadBuffer {
+    explicit ThreadBuffer(size_t capacity, uint64_t gen)
+        : events(capacity), generation(gen),
+          tid(static_cast<uint32_t>(syscall(SYS_gettid))) {}
+
+    std::vector<TraceEvent> events;
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+    uint64_t generation;
+    uint32_t tid;
+    std::string thread_name;
+};
+
+std::mutex g_registry_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> g_registry;
+std::atomic<uint64_t> g_generation{0};
+size_t g_events_per_thread = TraceRecorder::DEFAULT_EVENTS_PER_THREAD;
+uint64_t g_capture_start_ns = 0;
+
+thread_local std::shared_ptr<ThreadBuffer> t_buffer;
+thread_local std::string t_thread_name;
+
+// 获取当前线程本次抓取的缓冲区，首次调用时注册
+ThreadBuffer* current_buffer() {
+    uint64_t generation = g_generation.load(std::memory_order_acquire);
+    if (t_buffer && t_buffer->generation == generation) {
+        return t_buffer.get();
+    }
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    generation = g_generation.load(std::memory_order_acquire);
+    t_buffer = std::make_shared<ThreadBuffer>(g_events_per_thread, generation);
+    t_buffer->thread_name = t_thread_name;
+    g_registry.push_back(t_buffer);
+    return t_buffer.get();
+}
+
+void append_event(const TraceEvent& event) {
+    // 抓取已停止（如区间在 stop() 之前开始、之后结束）：丢弃，不为未记录过的线程分配缓冲区
+    if (!TraceRecorder::is_enabled()) {
+        return;
+    }
+    ThreadBuffer* buffer = current_buffer();
+    size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= buffer->events.size()) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[index] = event;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void append_json_string(std::ostringstream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+bool TraceRecorder::start(size_t events_per_thread) {
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    if (enabled_.load()) {
+        return false;
+    }
+    g_registry.clear();
+    g_events_per_thread = events_per_thread > 0 ? events_per_thread : DEFAULT_EVENTS_PER_THREAD;
+    g_capture_start_ns = now_ns();
+    // 代数递增使各线程在下次记录时重新注册缓冲区
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+    enabled_.store(true, std::memory_order_release);
+    LOG_INFO_F("🎬 开始追踪抓取，每线程缓冲 %zu 个事件", g_events_per_thread);
+    return true;
+}
+
+void TraceRecorder::stop() {
+    if (!enabled_.exchange(false)) {
+        return;
+    }
+    CaptureStats stats = get_stats();
+    LOG_INFO_F("🎬 追踪抓取结束: %llu 个事件, %zu 个线程, 丢弃 %llu 个",
+               static_cast<unsigned long long>(stats.events), stats.threads,
+               static_cast<unsigned long long>(stats.dropped));
+}
+
+void TraceRecorder::complete(const char* category, const char* name, uint64_t start_ns, uint64_t end_ns,
+                             int64_t batch_id, int64_t frame_idx) {
+    TraceEvent event;
+    event.start_ns = start_ns;
+    event.dur_ns = end_ns > start_ns ? end_ns - start_ns : 0;
+    event.category = category;
+    event.name = name;
+    event.batch_id = batch_id;
+    event.frame_idx = frame_idx;
+    event.phase = 'X';
+    append_event(event);
+}
+
+void TraceRecorder::instant(const char* category, const char* name, int64_t batch_id, int64_t frame_idx) {
+    TraceEvent event;
+    event.start_ns = now_ns();
+    event.dur_ns = 0;
+    event.category = category;
+    event.name = name;
+    event.batch_id = batch_id;
+    event.frame_idx = frame_idx;
+    event.phase = 'i';
+    append_event(event);
+}
+
+void TraceRecorder::set_thread_name(const std::string& name) {
+    t_thread_name = name;
+}
+
+TraceRecorder::CaptureStats TraceRecorder::get_stats() {
+    CaptureStats stats;
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    stats.threads = g_registry.size();
+    for (const auto& buffer : g_registry) {
+        stats.events += buffer->count.load(std::memory_order_acquire);
+        stats.dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+std::string TraceRecorder::to_chrome_json() {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    uint64_t base_ns;
+    {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        buffers = g_registry;
+        base_ns = g_capture_start_ns;
+    }
+
+    const int pid = static_cast<int>(getpid());
+    std::ostringstream out;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char line[512];
+    for (const auto& buffer : buffers) {
+        if (!buffer->thread_name.empty()) {
+            out << (first ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid
+                << ",\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+            append_json_string(out, buffer->thread_name);
+            out << "}}";
+            first = false;
+        }
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            const TraceEvent& event = buffer->events[i];
+            double ts_us = event.start_ns >= base_ns ? (event.start_ns - base_ns) / 1000.0 : 0.0;
+            int n;
+            if (event.phase == 'X') {
+                n = std::snprintf(line, sizeof(line),
+                                  "%s\n{\"ph\":\"X\",\"cat\":\"%s\",\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f,"
+                                  "\"pid\":%d,\"tid\":%u,\"args\":{\"batch_id\":%" PRId64 ",\"frame_idx\":%" PRId64 "}}",
+                                  first ? "" : ",", event.category, event.name, ts_us, event.dur_ns / 1000.0,
+                                  pid, buffer->tid, event.batch_id, event.frame_idx);
+            } else {
+                n = std::snprintf(line, sizeof(line),
+                                  "%s\n{\"ph\":\"i\",\"s\":\"t\",\"cat\":\"%s\",\"name\":\"%s\",\"ts\":%.3f,"
+                                  "\"pid\":%d,\"tid\":%u,\"args\":{\"batch_id\":%" PRId64 ",\"frame_idx\":%" PRId64 "}}",
+                                  first ? "" : ",", event.category, event.name, ts_us,
+                                  pid, buffer->tid, event.batch_id, event.frame_idx);
+            }
+            if (n > 0) {
+                out.write(line, std::min<size_t>(static_cast<size_t>(n), sizeof(line) - 1));
+                first = false;
+            }
+        }
+    }
+    out << "\n]}\n";
+    return out.str();
+}
+
+bool TraceRecorder::dump_chrome_json(const std::string& path) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file) {
+        LOG_ERROR_F("❌ 无法写入追踪文件: %s", path.c_str());
+        return false;
+    }
+    file << to_chrome_json();
+    file.close();
+    if (!file) {
+        LOG_ERROR_F("❌ 写入追踪文件失败: %s", path.c_str());
+        return false;
+    }
+    std::cout << "✅ 追踪数据已导出: " << path << std::endl;
+    return true;
+}
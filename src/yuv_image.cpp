@@ -0,0 +1,334 @@
+#include "yuv_image.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// BT.601 有限范围 YUV -> RGB 的 20 位定点系数（与 OpenCV cvtColor 一致）
+constexpr int kShift = 20;
+constexpr int kRound = 1 << (kShift - 1);
+constexpr int kCY = 1220542;
+constexpr int kCUB = 2116026;
+constexpr int kCUG = -409993;
+constexpr int kCVG = -852492;
+constexpr int kCVR = 1673527;
+
+std::atomic<uint64_t> g_fused_pixels{0};
+std::atomic<uint64_t> g_full_frame_pixels{0};
+
+struct Planes {
+    const uchar* y;
+    size_t y_step;
+    const uchar* u;
+    const uchar* v;
+    size_t uv_step;   // 色度行字节数
+    int uv_pixel;     // 同一行相邻色度样本的字节间距（交织为2，平面为1）
+};
+
+Planes planes_of(const YuvImage& src) {
+    const int height = src.height();
+    const uchar* chroma = src.data.ptr(height);
+    Planes planes;
+    planes.y = src.data.data;
+    planes.y_step = src.data.step;
+    switch (src.layout) {
+    case YuvLayout::NV21:
+        planes.v = chroma;
+        planes.u = chroma + 1;
+        planes.uv_step = src.data.step;
+        planes.uv_pixel = 2;
+        break;
+    case YuvLayout::I420:
+        planes.uv_step = src.width() / 2;
+        planes.u = chroma;
+        planes.v = chroma + planes.uv_step * (height / 2);
+        planes.uv_pixel = 1;
+        break;
+    case YuvLayout::NV12:
+    default:
+        planes.u = chroma;
+        planes.v = chroma + 1;
+        planes.uv_step = src.data.step;
+        planes.uv_pixel = 2;
+        break;
+    }
+    return planes;
+}
+
+inline uchar clamp_u8(int value) {
+    return static_cast<uchar>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// 标量实现：转换 [begin, width) 的像素
+template <int UvPixel, bool Rgb>
+void convert_row_scalar(const uchar* y, const uchar* u, const uchar* v, int begin, int width, uchar* dst) {
+    constexpr int b_index = Rgb ? 2 : 0;
+    constexpr int r_index = Rgb ? 0 : 2;
+    for (int x = begin; x < width; ++x) {
+        int luma = std::max(y[x] - 16, 0) * kCY;
+        int cu = u[x * UvPixel] - 128;
+        int cv = v[x * UvPixel] - 128;
+        int r = (luma + kCVR * cv + kRound) >> kShift;
+        int g = (luma + kCVG * cv + kCUG * cu + kRound) >> kShift;
+        int b = (luma + kCUB * cu + kRound) >> kShift;
+        dst[3 * x + b_index] = clamp_u8(b);
+        dst[3 * x + 1] = clamp_u8(g);
+        dst[3 * x + r_index] = clamp_u8(r);
+    }
+}
+
+#if CV_SIMD
+// 4 组 32 位定点结果饱和打包为 8 位（先饱和到 int16，再无符号饱和到 uint8，即 clamp_u8）
+inline cv::v_uint8 pack_channel(const cv::v_int32& a, const cv::v_int32& b, const cv::v_int32& c,
+                                const cv::v_int32& d) {
+    return cv::v_pack_u(cv::v_pack(a, b), cv::v_pack(c, d));
+}
+
+// v_int16::nlanes 个像素的亮度（已减16）与色度（已减128）扩展到 32 位后计算 B/G/R
+inline void yuv_to_bgr_s32(const cv::v_int16& y, const cv::v_int16& du, const cv::v_int16& dv,
+                           cv::v_int32 b[2], cv::v_int32 g[2], cv::v_int32 r[2]) {
+    const cv::v_int32 coef_y = cv::vx_setall_s32(kCY);
+    const cv::v_int32 coef_ub = cv::vx_setall_s32(kCUB);
+    const cv::v_int32 coef_ug = cv::vx_setall_s32(kCUG);
+    const cv::v_int32 coef_vg = cv::vx_setall_s32(kCVG);
+    const cv::v_int32 coef_vr = cv::vx_setall_s32(kCVR);
+    const cv::v_int32 round = cv::vx_setall_s32(kRound);
+    cv::v_int32 y32[2], u32[2], v32[2];
+    cv::v_expand(y, y32[0], y32[1]);
+    cv::v_expand(du, u32[0], u32[1]);
+    cv::v_expand(dv, v32[0], v32[1]);
+    for (int i = 0; i < 2; ++i) {
+        cv::v_int32 luma = y32[i] * coef_y + round;
+        r[i] = cv::v_shr<kShift>(luma + v32[i] * coef_vr);
+        g[i] = cv::v_shr<kShift>(luma + v32[i] * coef_vg + u32[i] * coef_ug);
+        b[i] = cv::v_shr<kShift>(luma + u32[i] * coef_ub);
+    }
+}
+#endif
+
+// 一行 Y/U/V 转为 BGR（Rgb 为 true 时 RGB）写出，UvPixel 为同一行相邻色度样本的字节间距；
+// 色度与亮度一一对应（已按目标尺寸采样）。交织色度（UvPixel 为2）时 u/v 指向同一行的相邻字节。
+// 有 OpenCV 通用向量指令（CV_SIMD）时整向量处理，结果与标量实现逐位一致，剩余像素走标量实现
+template <int UvPixel, bool Rgb>
+void convert_row(const uchar* y, const uchar* u, const uchar* v, int width, uchar* dst) {
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::v_uint8::nlanes;
+    const cv::v_uint16 y_offset = cv::vx_setall_u16(16);
+    const cv::v_int16 uv_offset = cv::vx_setall_s16(128);
+    for (; x <= width - lanes; x += lanes) {
+        cv::v_uint8 y8 = cv::vx_load(y + x);
+        cv::v_uint8 u8, v8;
+        if (UvPixel == 2) {
+            if (u < v) {
+                cv::v_load_deinterleave(u + 2 * x, u8, v8);
+            } else {
+                cv::v_load_deinterleave(v + 2 * x, v8, u8);
+            }
+        } else {
+            u8 = cv::vx_load(u + x);
+            v8 = cv::vx_load(v + x);
+        }
+        cv::v_uint16 y16[2], u16[2], v16[2];
+        cv::v_expand(y8, y16[0], y16[1]);
+        cv::v_expand(u8, u16[0], u16[1]);
+        cv::v_expand(v8, v16[0], v16[1]);
+        cv::v_int32 b[4], g[4], r[4];
+        for (int half = 0; half < 2; ++half) {
+            // max(y - 16, 0)：先取 max 再减，不会回绕
+            cv::v_int16 luma = cv::v_reinterpret_as_s16(cv::v_max(y16[half], y_offset) - y_offset);
+            cv::v_int16 du = cv::v_reinterpret_as_s16(u16[half]) - uv_offset;
+            cv::v_int16 dv = cv::v_reinterpret_as_s16(v16[half]) - uv_offset;
+            yuv_to_bgr_s32(luma, du, dv, b + 2 * half, g + 2 * half, r + 2 * half);
+        }
+        cv::v_uint8 b8 = pack_channel(b[0], b[1], b[2], b[3]);
+        cv::v_uint8 g8 = pack_channel(g[0], g[1], g[2], g[3]);
+        cv::v_uint8 r8 = pack_channel(r[0], r[1], r[2], r[3]);
+        if (Rgb) {
+            cv::v_store_interleave(dst + 3 * x, r8, g8, b8);
+        } else {
+            cv::v_store_interleave(dst + 3 * x, b8, g8, r8);
+        }
+    }
+    cv::vx_cleanup();
+#endif
+    convert_row_scalar<UvPixel, Rgb>(y, u, v, x, width, dst);
+}
+
+template <int UvPixel>
+void convert_row(const uchar* y, const uchar* u, const uchar* v, int width, uchar* dst, bool rgb) {
+    if (rgb) {
+        convert_row<UvPixel, true>(y, u, v, width, dst);
+    } else {
+        convert_row<UvPixel, false>(y, u, v, width, dst);
+    }
+}
+
+void prepare_dst(cv::Mat& dst, cv::Size size, int type) {
+    if (dst.size() != size || dst.type() != type) {
+        dst.create(size, type);
+    }
+}
+
+// 按行条带并行（与 cv::resize/cvtColor 相同的并行粒度）
+double stripes_for(const cv::Size& size) {
+    return std::max(1.0, static_cast<double>(size.area()) / (1 << 16));
+}
+
+}  // namespace
+
+bool YuvImage::valid() const {
+    if (data.empty() || data.type() != CV_8UC1 || data.rows % 3 != 0) {
+        return false;
+    }
+    if (width() % 2 != 0 || height() % 2 != 0) {
+        return false;
+    }
+    return layout != YuvLayout::I420 || data.isContinuous();
+}
+
+namespace yuv {
+
+int bgr_conversion_code(YuvLayout layout) {
+    switch (layout) {
+    case YuvLayout::NV21:
+        return cv::COLOR_YUV2BGR_NV21;
+    case YuvLayout::I420:
+        return cv::COLOR_YUV2BGR_I420;
+    case YuvLayout::NV12:
+    default:
+        return cv::COLOR_YUV2BGR_NV12;
+    }
+}
+
+void to_bgr(const YuvImage& src, cv::Mat& dst) {
+    if (!src.valid()) {
+        dst.release();
+        return;
+    }
+    cv::cvtColor(src.data, dst, bgr_conversion_code(src.layout));
+    g_full_frame_pixels.fetch_add(static_cast<uint64_t>(src.size().area()));
+}
+
+void convert_crop(const YuvImage& src, const cv::Rect& crop, cv::Mat& dst, bool rgb) {
+    cv::Rect region = crop & cv::Rect(cv::Point(0, 0), src.size());
+    if (!src.valid() || region.empty()) {
+        dst.release();
+        return;
+    }
+    const bool aligned = (region.x | region.y | region.width | region.height) % 2 == 0;
+    if (aligned && src.layout != YuvLayout::I420) {
+        // 偶数对齐的半平面区域直接交给 OpenCV 的 SIMD 实现（支持带步长的子矩阵）
+        const int height = src.height();
+        cv::Mat y_region = src.data(region);
+        cv::Mat uv_plane(height / 2, src.width() / 2, CV_8UC2, src.data.data + height * src.data.step, src.data.step);
+        cv::Mat uv_region = uv_plane(cv::Rect(region.x / 2, region.y / 2, region.width / 2, region.height / 2));
+        int code = src.layout == YuvLayout::NV21 ? (rgb ? cv::COLOR_YUV2RGB_NV21 : cv::COLOR_YUV2BGR_NV21)
+                                                 : (rgb ? cv::COLOR_YUV2RGB_NV12 : cv::COLOR_YUV2BGR_NV12);
+        prepare_dst(dst, region.size(), CV_8UC3);
+        cv::cvtColorTwoPlane(y_region, uv_region, dst, code);
+        g_fused_pixels.fetch_add(static_cast<uint64_t>(region.area()));
+        return;
+    }
+    prepare_dst(dst, region.size(), CV_8UC3);
+    const Planes planes = planes_of(src);
+
+    // 色度按最近邻复制（每个色度样本覆盖 2x2 亮度），与整帧 cvtColor 后再裁剪的结果一致
+    std::vector<int> chroma_offset(region.width);
+    for (int x = 0; x < region.width; ++x) {
+        chroma_offset[x] = ((region.x + x) >> 1) * planes.uv_pixel;
+    }
+
+    cv::parallel_for_(cv::Range(0, region.height), [&](const cv::Range& rows) {
+        std::vector<uchar> row_u(region.width), row_v(region.width);
+        for (int r = rows.start; r < rows.end; ++r) {
+            const int sy = region.y + r;
+            const uchar* y_row = planes.y + sy * planes.y_step + region.x;
+            const uchar* u_row = planes.u + (sy >> 1) * planes.uv_step;
+            const uchar* v_row = planes.v + (sy >> 1) * planes.uv_step;
+            for (int x = 0; x < region.width; ++x) {
+                row_u[x] = u_row[chroma_offset[x]];
+                row_v[x] = v_row[chroma_offset[x]];
+            }
+            convert_row<1>(y_row, row_u.data(), row_v.data(), region.width, dst.ptr<uchar>(r), rgb);
+        }
+    }, stripes_for(region.size()));
+    g_fused_pixels.fetch_add(static_cast<uint64_t>(region.area()));
+}
+
+void convert_resize(const YuvImage& src, const cv::Rect& crop, cv::Size dst_size, cv::Mat& dst, bool rgb) {
+    cv::Rect region = crop & cv::Rect(cv::Point(0, 0), src.size());
+    if (!src.valid() || region.empty() || dst_size.width <= 0 || dst_size.height <= 0) {
+        dst.release();
+        return;
+    }
+    if (dst_size == region.size()) {
+        convert_crop(src, region, dst, rgb);
+        return;
+    }
+
+    // 先在平面数据上缩放（OpenCV SIMD 实现，只读取区域内的 Y 与 UV），再以目标尺寸做一次色彩转换。
+    // 色度平面按同一区域缩放到目标尺寸：cv::resize 的像素中心对齐映射下，目标像素对应的色度坐标
+    // 恰为其亮度坐标所在的色度样本位置；区域边界为奇数时色度偏差不超过半个色度样本
+    const int height = src.height();
+    const uchar* chroma = src.data.ptr(height);
+    cv::Rect chroma_region(region.x / 2, region.y / 2, (region.x + region.width + 1) / 2 - region.x / 2,
+                           (region.y + region.height + 1) / 2 - region.y / 2);
+    cv::Mat y_scaled;
+    cv::resize(src.luma()(region), y_scaled, dst_size, 0, 0, cv::INTER_LINEAR);
+    cv::Mat u_scaled;
+    cv::Mat v_scaled;
+    cv::Mat uv_scaled;
+    if (src.layout == YuvLayout::I420) {
+        const size_t uv_step = src.width() / 2;
+        cv::Mat u_plane(height / 2, src.width() / 2, CV_8UC1, const_cast<uchar*>(chroma), uv_step);
+        cv::Mat v_plane(height / 2, src.width() / 2, CV_8UC1, const_cast<uchar*>(chroma) + uv_step * (height / 2),
+                        uv_step);
+        cv::resize(u_plane(chroma_region), u_scaled, dst_size, 0, 0, cv::INTER_LINEAR);
+        cv::resize(v_plane(chroma_region), v_scaled, dst_size, 0, 0, cv::INTER_LINEAR);
+    } else {
+        cv::Mat uv_plane(height / 2, src.width() / 2, CV_8UC2, const_cast<uchar*>(chroma), src.data.step);
+        cv::resize(uv_plane(chroma_region), uv_scaled, dst_size, 0, 0, cv::INTER_LINEAR);
+    }
+
+    prepare_dst(dst, dst_size, CV_8UC3);
+    const int u_index = src.layout == YuvLayout::NV21 ? 1 : 0;
+    cv::parallel_for_(cv::Range(0, dst_size.height), [&](const cv::Range& rows) {
+        for (int r = rows.start; r < rows.end; ++r) {
+            const uchar* y_row = y_scaled.ptr<uchar>(r);
+            uchar* out = dst.ptr<uchar>(r);
+            if (src.layout == YuvLayout::I420) {
+                convert_row<1>(y_row, u_scaled.ptr<uchar>(r), v_scaled.ptr<uchar>(r), dst_size.width, out, rgb);
+            } else {
+                const uchar* uv_row = uv_scaled.ptr<uchar>(r);
+                convert_row<2>(y_row, uv_row + u_index, uv_row + (1 - u_index), dst_size.width, out, rgb);
+            }
+        }
+    }, stripes_for(dst_size));
+    g_fused_pixels.fetch_add(static_cast<uint64_t>(dst_size.area()));
+}
+
+void luma_resize(const YuvImage& src, const cv::Rect& crop, cv::Size dst_size, cv::Mat& dst, int interpolation) {
+    cv::Rect region = crop & cv::Rect(cv::Point(0, 0), src.size());
+    if (!src.valid() || region.empty() || dst_size.width <= 0 || dst_size.height <= 0) {
+        dst.release();
+        return;
+    }
+    cv::Mat luma = src.luma()(region);
+    if (dst_size == region.size()) {
+        luma.copyTo(dst);
+    } else {
+        cv::resize(luma, dst, dst_size, 0, 0, interpolation);
+    }
+}
+
+uint64_t get_fused_pixels() {
+    return g_fused_pixels.load();
+}
+
+uint64_t get_full_frame_pixels() {
+    return g_full_frame_pixels.load();
+}
+
+}  // namespace yuv
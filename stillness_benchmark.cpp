@@ -0,0 +1,316 @@
+#include "stillness_detector.h"
+#include "stage_profiler.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * 静止判定CPU开销对比工具
+ *
+ * 回放 track_record_path 记录的跟踪框，逐帧比较两种静止判定方式的线程CPU时间：
+ *   - 特征点路径：VehicleParkingDetect::detect（特征点提取 + RANSAC 自运动估计，每帧执行）
+ *   - 轨迹历史路径：TrackStillnessDetector，仅在检测到相机运动时调用特征点路径
+ * 特征点路径需要原始画面，通过 --video 提供录制时的视频（按记录的违停检测图尺寸缩放）；
+ * 未提供视频时只统计轨迹历史路径，并与记录中特征点路径给出的 is_still 对比一致率。
+ *
+ * 用法：
+ *   StillnessBenchmark <tracks.csv> [--video FILE] [--frame-offset N] [--stream N] [--repeat N]
+ *     --video FILE       录制时输入的视频，第 frame_idx - offset 帧对应记录中的 frame_idx
+ *     --frame-offset N   视频首帧对应的 frame_idx（默认0）
+ *     --stream N         只回放指定视频流（默认记录中的第一路）
+ *     --repeat N         轨迹历史路径重复回放次数，用于稳定计时（默认1）
+ */
+
+namespace {
+
+struct RecordedFrame {
+    uint64_t frame_idx = 0;
+    cv::Size parking_size;
+    bool recorded_feature = false;          // 记录时该帧由特征点路径判定
+    std::vector<TrackBox> boxes;
+};
+
+struct CpuStats {
+    std::vector<double> per_frame_us;
+
+    void add(uint64_t ns) { per_frame_us.push_back(ns / 1000.0); }
+
+    double mean() const {
+        if (per_frame_us.empty()) return 0.0;
+        double sum = 0.0;
+        for (double v : per_frame_us) sum += v;
+        return sum / per_frame_us.size();
+    }
+
+    double percentile(double p) const {
+        if (per_frame_us.empty()) return 0.0;
+        std::vector<double> sorted = per_frame_us;
+        std::sort(sorted.begin(), sorted.end());
+        size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5));
+        return sorted[index];
+    }
+
+    std::string to_string() const {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(1) << "平均 " << mean() << " us/帧, p50 " << percentile(0.5)
+            << " us, p99 " << percentile(0.99) << " us";
+        return oss.str();
+    }
+};
+
+bool load_tracks(const std::string& path, int& stream_id, std::vector<RecordedFrame>& frames) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::map<uint64_t, RecordedFrame> by_frame;
+    std::string line;
+    bool stream_selected = stream_id >= 0;
+    while (std::getline(file, line)) {
+        if (line.empty() || line.compare(0, 9, "frame_idx") == 0) {
+            continue;
+        }
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() < 13) {
+            continue;
+        }
+        int stream = std::atoi(fields[1].c_str());
+        if (!stream_selected) {
+            stream_id = stream;
+            stream_selected = true;
+        }
+        if (stream != stream_id) {
+            continue;
+        }
+        uint64_t frame_idx = std::strtoull(fields[0].c_str(), nullptr, 10);
+        RecordedFrame& frame = by_frame[frame_idx];
+        frame.frame_idx = frame_idx;
+        frame.parking_size = cv::Size(std::atoi(fields[2].c_str()), std::atoi(fields[3].c_str()));
+        frame.recorded_feature = fields[4] == "feature";
+        frame.boxes.push_back(TrackBox(std::atoi(fields[5].c_str()),
+                                       cv::Rect(std::atoi(fields[8].c_str()), std::atoi(fields[9].c_str()),
+                                                std::atoi(fields[10].c_str()), std::atoi(fields[11].c_str())),
+                                       std::atoi(fields[6].c_str()),
+                                       static_cast<float>(std::atof(fields[7].c_str())),
+                                       fields[12] == "1", 0.0));
+    }
+    frames.clear();
+    for (auto& entry : by_frame) {
+        frames.push_back(std::move(entry.second));
+    }
+    return true;
+}
+
+// 与 BatchObjectTracking 构造函数中的参数一致
+VehicleParkingDetect* create_feature_detector() {
+    VehicleParkingDetect* detector = createVehicleParkingDetectOptimized();
+    VehicleParkingInitParams params;
+    params.K = 4;
+    params.EPS_WORLD = 2.0;
+    params.MIN_SPEED_FRAMES = 3;
+    params.RESET_EVERY = 200;
+    params.MAX_FEATURES = 800;
+    params.FEATURE_QUALITY = 0.02;
+    params.MIN_DISTANCE = 10;
+    params.MIN_TRACK_POINTS = 80;
+    params.RANSAC_THRESHOLD = 3.0;
+    params.MIN_INLIERS = 80;
+    detector->init(params);
+    return detector;
+}
+
+// 按顺序读取视频帧并缩放到违停检测图尺寸
+class FrameSource {
+public:
+    FrameSource(const std::string& path, uint64_t frame_offset) : frame_offset_(frame_offset) {
+        if (!path.empty()) {
+            capture_.open(path);
+        }
+    }
+
+    bool is_open() const { return capture_.isOpened(); }
+
+    bool read(uint64_t frame_idx, const cv::Size& size, cv::Mat& out) {
+        if (frame_idx < frame_offset_) {
+            return false;
+        }
+        uint64_t target = frame_idx - frame_offset_;
+        while (next_index_ <= target) {
+            if (!capture_.read(current_)) {
+                return false;
+            }
+            ++next_index_;
+        }
+        if (current_.empty()) {
+            return false;
+        }
+        cv::resize(current_, out, size);
+        return true;
+    }
+
+private:
+    cv::VideoCapture capture_;
+    uint64_t frame_offset_;
+    uint64_t next_index_ = 0;
+    cv::Mat current_;
+};
+
+void print_usage(const char* program) {
+    std::cout << "用法: " << program
+              << " <tracks.csv> [--video FILE] [--frame-offset N] [--stream N] [--repeat N]" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string tracks_path;
+    std::string video_path;
+    uint64_t frame_offset = 0;
+    int stream_id = -1;
+    int repeat = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--video") == 0 && i + 1 < argc) {
+            video_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--frame-offset") == 0 && i + 1 < argc) {
+            frame_offset = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+            stream_id = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            tracks_path = argv[i];
+        }
+    }
+
+    std::vector<RecordedFrame> frames;
+    if (tracks_path.empty() || !load_tracks(tracks_path, stream_id, frames)) {
+        print_usage(argv[0]);
+        std::cerr << "❌ 无法读取跟踪框记录: " << tracks_path << std::endl;
+        return 1;
+    }
+    if (frames.empty()) {
+        std::cerr << "❌ 记录中没有视频流 " << stream_id << " 的跟踪框" << std::endl;
+        return 1;
+    }
+    size_t total_boxes = 0;
+    for (const auto& frame : frames) {
+        total_boxes += frame.boxes.size();
+    }
+    std::cout << "📂 " << tracks_path << ": 视频流 " << stream_id << ", " << frames.size() << " 帧, "
+              << total_boxes << " 个跟踪框" << std::endl;
+
+    // 轨迹历史路径（不含相机运动时的特征点回退）
+    CpuStats history_cpu;
+    std::vector<std::vector<bool>> history_still(frames.size());
+    std::vector<bool> needs_feature(frames.size(), false);
+    uint64_t camera_motion_events = 0;
+    for (int round = 0; round < repeat; ++round) {
+        TrackStillnessDetector detector;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            std::vector<TrackBox> boxes = frames[i].boxes;
+            uint64_t cpu_start = StageProfiler::thread_cpu_ns();
+            bool fallback = detector.update(stream_id, boxes);
+            history_cpu.add(StageProfiler::thread_cpu_ns() - cpu_start);
+            if (round == 0) {
+                needs_feature[i] = fallback;
+                for (const auto& box : boxes) {
+                    history_still[i].push_back(box.is_still);
+                }
+            }
+        }
+        if (round == 0) {
+            camera_motion_events = detector.get_camera_motion_events();
+        }
+    }
+    size_t fallback_frames = std::count(needs_feature.begin(), needs_feature.end(), true);
+    std::cout << "\n🧭 轨迹历史判定: " << history_cpu.to_string() << std::endl;
+    std::cout << "  相机运动 " << camera_motion_events << " 次, 需要特征点回退 " << fallback_frames << "/"
+              << frames.size() << " 帧" << std::endl;
+
+    FrameSource source(video_path, frame_offset);
+    if (!source.is_open()) {
+        // 没有画面时与记录中的特征点判定结果对比
+        size_t compared = 0, agreed = 0;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            if (!frames[i].recorded_feature || needs_feature[i]) {
+                continue;
+            }
+            for (size_t j = 0; j < frames[i].boxes.size(); ++j) {
+                ++compared;
+                agreed += frames[i].boxes[j].is_still == history_still[i][j] ? 1 : 0;
+            }
+        }
+        if (!video_path.empty()) {
+            std::cerr << "⚠️ 无法打开视频: " << video_path << "，跳过特征点路径计时" << std::endl;
+        }
+        if (compared > 0) {
+            std::cout << "  与记录的特征点判定一致率: " << std::fixed << std::setprecision(2)
+                      << 100.0 * agreed / compared << "% (" << compared << " 个跟踪框)" << std::endl;
+        }
+        return 0;
+    }
+
+    // 特征点路径逐帧执行，同时在另一个实例上只对回退帧执行，得到轨迹历史路径的完整开销
+    VehicleParkingDetect* every_frame = create_feature_detector();
+    VehicleParkingDetect* on_fallback = create_feature_detector();
+    CpuStats feature_cpu;
+    CpuStats combined_cpu;
+    size_t compared = 0, agreed = 0, missing_frames = 0;
+    cv::Mat parking_image;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (!source.read(frames[i].frame_idx, frames[i].parking_size, parking_image)) {
+            ++missing_frames;
+            continue;
+        }
+
+        std::vector<TrackBox> boxes = frames[i].boxes;
+        uint64_t cpu_start = StageProfiler::thread_cpu_ns();
+        every_frame->detect(parking_image, boxes);
+        feature_cpu.add(StageProfiler::thread_cpu_ns() - cpu_start);
+
+        uint64_t fallback_ns = 0;
+        if (needs_feature[i]) {
+            std::vector<TrackBox> fallback_boxes = frames[i].boxes;
+            cpu_start = StageProfiler::thread_cpu_ns();
+            on_fallback->detect(parking_image, fallback_boxes);
+            fallback_ns = StageProfiler::thread_cpu_ns() - cpu_start;
+        } else {
+            for (size_t j = 0; j < boxes.size(); ++j) {
+                ++compared;
+                agreed += boxes[j].is_still == history_still[i][j] ? 1 : 0;
+            }
+        }
+        combined_cpu.add(static_cast<uint64_t>(history_cpu.per_frame_us[i] * 1000.0) + fallback_ns);
+    }
+    if (missing_frames > 0) {
+        std::cerr << "⚠️ " << missing_frames << " 帧在视频中不存在，未计入对比（检查 --frame-offset）" << std::endl;
+    }
+
+    std::cout << "\n📸 特征点/RANSAC判定（每帧）: " << feature_cpu.to_string() << std::endl;
+    std::cout << "🧭 轨迹历史判定（含回退）: " << combined_cpu.to_string() << std::endl;
+    if (combined_cpu.mean() > 0.0) {
+        std::cout << "  CPU 降低 " << std::fixed << std::setprecision(1)
+                  << feature_cpu.mean() / combined_cpu.mean() << " 倍" << std::endl;
+    }
+    if (compared > 0) {
+        std::cout << "  非回退帧判定一致率: " << std::fixed << std::setprecision(2)
+                  << 100.0 * agreed / compared << "% (" << compared << " 个跟踪框)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,283 @@
+#include "multi_object_tracker.h"
+#include "byte_track.h"
+#include "stage_profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+/**
+ * 多目标跟踪器基准测试
+ *
+ * 在合成场景（匀速运动目标 + 检测噪声 + 漏检 + 低分误检）上，按每帧目标数
+ * 比较内置跟踪器（网格哈希 / 两两计算）与外部 xtkj 跟踪器的单帧线程CPU时间，
+ * 并统计内置跟踪器的ID切换与输出覆盖率。目标数越多框越小（画面占用率不变），
+ * 每帧位移相对框尺寸越大，ID切换按每千个轨迹帧归一化，并区分丢失后新建与错配到其他轨迹。
+ *
+ * 用法：
+ *   TrackerBenchmark [--boxes 50,200,1000] [--frames N] [--seed N] [--no-external]
+ */
+
+namespace {
+
+constexpr float kSceneWidth = 1920.0f;
+constexpr float kSceneHeight = 1080.0f;
+
+struct SceneObject {
+    float cx, cy, w, h, vx, vy;
+    int cls_id;
+};
+
+struct Detection {
+    TrackedObject box;
+    int truth;                              // 对应的真值目标，-1 为误检
+};
+
+/**
+ * 合成场景：目标在画面内匀速运动、碰边反弹
+ */
+class SyntheticScene {
+public:
+    SyntheticScene(int count, uint32_t seed) : rng_(seed) {
+        // 目标越多框越小，保持画面占用率大致相当
+        float scale = std::sqrt(50.0f / std::max(1, count));
+        std::uniform_real_distribution<float> x(0.0f, kSceneWidth), y(0.0f, kSceneHeight);
+        std::uniform_real_distribution<float> size(40.0f * scale, 160.0f * scale);
+        std::uniform_real_distribution<float> speed(-6.0f, 6.0f);
+        std::uniform_int_distribution<int> cls(0, 2);
+        for (int i = 0; i < count; ++i) {
+            float w = size(rng_);
+            objects_.push_back({x(rng_), y(rng_), w, w * 0.8f, speed(rng_), speed(rng_) * 0.5f, cls(rng_)});
+        }
+    }
+
+    void step(std::vector<Detection>& detections) {
+        std::normal_distribution<float> noise(0.0f, 1.5f);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        detections.clear();
+        for (size_t i = 0; i < objects_.size(); ++i) {
+            SceneObject& object = objects_[i];
+            object.cx += object.vx;
+            object.cy += object.vy;
+            if (object.cx < 0 || object.cx > kSceneWidth) object.vx = -object.vx;
+            if (object.cy < 0 || object.cy > kSceneHeight) object.vy = -object.vy;
+            if (unit(rng_) < 0.05f) {
+                continue;                   // 漏检
+            }
+            Detection detection;
+            detection.truth = static_cast<int>(i);
+            detection.box.left = object.cx - object.w * 0.5f + noise(rng_);
+            detection.box.top = object.cy - object.h * 0.5f + noise(rng_);
+            detection.box.right = object.cx + object.w * 0.5f + noise(rng_);
+            detection.box.bottom = object.cy + object.h * 0.5f + noise(rng_);
+            // 约15%的检测为低分（遮挡、模糊），需要第二轮关联找回
+            detection.box.score = unit(rng_) < 0.15f ? 0.2f + 0.25f * unit(rng_) : 0.6f + 0.4f * unit(rng_);
+            detection.box.cls_id = object.cls_id;
+            detections.push_back(detection);
+        }
+        // 约2%的低分误检
+        size_t false_positives = objects_.size() / 50;
+        for (size_t i = 0; i < false_positives; ++i) {
+            Detection detection;
+            detection.truth = -1;
+            detection.box.left = unit(rng_) * kSceneWidth;
+            detection.box.top = unit(rng_) * kSceneHeight;
+            detection.box.right = detection.box.left + 30.0f;
+            detection.box.bottom = detection.box.top + 30.0f;
+            detection.box.score = 0.1f + 0.3f * unit(rng_);
+            detection.box.cls_id = 0;
+            detections.push_back(detection);
+        }
+        std::shuffle(detections.begin(), detections.end(), rng_);
+    }
+
+private:
+    std::mt19937 rng_;
+    std::vector<SceneObject> objects_;
+};
+
+struct CpuStats {
+    std::vector<double> per_frame_us;
+
+    double mean() const {
+        if (per_frame_us.empty()) return 0.0;
+        double sum = 0.0;
+        for (double v : per_frame_us) sum += v;
+        return sum / per_frame_us.size();
+    }
+
+    double percentile(double p) const {
+        if (per_frame_us.empty()) return 0.0;
+        std::vector<double> sorted = per_frame_us;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5))];
+    }
+};
+
+struct BuiltinResult {
+    CpuStats cpu;
+    uint64_t id_switches = 0;
+    uint64_t new_id_switches = 0;           // 切换到新建轨迹（原轨迹丢失后重建）
+    uint64_t truth_detections = 0;
+    uint64_t truth_output = 0;
+    double pairs_per_frame = 0.0;
+};
+
+BuiltinResult run_builtin(int boxes, int frames, uint32_t seed, bool spatial_hash) {
+    TrackerConfig config;
+    config.use_spatial_hash = spatial_hash;
+    MultiObjectTracker tracker(config);
+    SyntheticScene scene(boxes, seed);
+
+    BuiltinResult result;
+    std::vector<int> last_id(boxes, -1);
+    std::vector<char> id_seen;
+    std::vector<Detection> detections;
+    std::vector<TrackedObject> objects;
+    for (int frame = 0; frame < frames; ++frame) {
+        scene.step(detections);
+        objects.clear();
+        for (size_t i = 0; i < detections.size(); ++i) {
+            objects.push_back(detections[i].box);
+            objects.back().index = static_cast<int>(i);
+            result.truth_detections += detections[i].truth >= 0 ? 1 : 0;
+        }
+
+        uint64_t cpu_start = StageProfiler::thread_cpu_ns();
+        tracker.update(0, objects);
+        result.cpu.per_frame_us.push_back((StageProfiler::thread_cpu_ns() - cpu_start) / 1000.0);
+
+        for (const auto& object : objects) {
+            int truth = detections[object.index].truth;
+            if (truth < 0) {
+                continue;
+            }
+            result.truth_output++;
+            if (static_cast<size_t>(object.track_id) >= id_seen.size()) {
+                id_seen.resize(object.track_id + 1, 0);
+            }
+            if (last_id[truth] >= 0 && last_id[truth] != object.track_id) {
+                result.id_switches++;
+                result.new_id_switches += id_seen[object.track_id] ? 0 : 1;
+            }
+            id_seen[object.track_id] = 1;
+            last_id[truth] = object.track_id;
+        }
+    }
+    result.pairs_per_frame = static_cast<double>(tracker.get_candidate_pairs()) / frames;
+    return result;
+}
+
+CpuStats run_external(int boxes, int frames, uint32_t seed, size_t& capacity) {
+    // 外部跟踪器的结果组容量固定，超出部分截断
+    capacity = std::extent<decltype(detect_result_group_t::results)>::value;
+    std::unique_ptr<xtkj::ITracker> tracker(xtkj::createTracker(30, 30, 0.5, 0.6, 0.8));
+    tracker->init(30, 30, 0.5, 0.6, 0.8);
+    SyntheticScene scene(boxes, seed);
+
+    CpuStats cpu;
+    std::vector<Detection> detections;
+    auto group = std::make_unique<detect_result_group_t>();
+    for (int frame = 0; frame < frames; ++frame) {
+        scene.step(detections);
+        std::memset(group.get(), 0, sizeof(detect_result_group_t));
+        for (const auto& detection : detections) {
+            if (static_cast<size_t>(group->count) >= capacity) {
+                break;
+            }
+            detect_result_t& result = group->results[group->count++];
+            result.cls_id = detection.box.cls_id;
+            result.box.left = static_cast<int>(detection.box.left);
+            result.box.top = static_cast<int>(detection.box.top);
+            result.box.right = static_cast<int>(detection.box.right);
+            result.box.bottom = static_cast<int>(detection.box.bottom);
+            result.prop = detection.box.score;
+            result.track_id = -1;
+        }
+        uint64_t cpu_start = StageProfiler::thread_cpu_ns();
+        tracker->track(group.get(), static_cast<int>(kSceneWidth), static_cast<int>(kSceneHeight));
+        cpu.per_frame_us.push_back((StageProfiler::thread_cpu_ns() - cpu_start) / 1000.0);
+    }
+    return cpu;
+}
+
+std::string format_cpu(const CpuStats& cpu) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1) << std::setw(9) << cpu.mean() << std::setw(9) << cpu.percentile(0.5)
+        << std::setw(9) << cpu.percentile(0.99);
+    return oss.str();
+}
+
+std::vector<int> parse_list(const char* text) {
+    std::vector<int> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        int value = std::atoi(item.c_str());
+        if (value > 0) {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<int> box_counts = {50, 200, 1000};
+    int frames = 300;
+    uint32_t seed = 1;
+    bool external = true;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--boxes") == 0 && i + 1 < argc) {
+            box_counts = parse_list(argv[++i]);
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = std::max(10, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--no-external") == 0) {
+            external = false;
+        } else {
+            std::cout << "用法: " << argv[0] << " [--boxes 50,200,1000] [--frames N] [--seed N] [--no-external]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "单帧线程CPU时间（us）: 平均 / p50 / p99，" << frames << " 帧" << std::endl;
+    for (int boxes : box_counts) {
+        BuiltinResult hashed = run_builtin(boxes, frames, seed, true);
+        BuiltinResult brute = run_builtin(boxes, frames, seed, false);
+
+        std::cout << "\n📦 每帧 " << boxes << " 个目标" << std::endl;
+        std::cout << "  内置(网格哈希) " << format_cpu(hashed.cpu) << "   候选对 " << std::fixed
+                  << std::setprecision(0) << hashed.pairs_per_frame << "/帧" << std::endl;
+        std::cout << "  内置(两两计算) " << format_cpu(brute.cpu) << "   候选对 " << brute.pairs_per_frame << "/帧"
+                  << std::endl;
+        if (external) {
+            size_t capacity = 0;
+            CpuStats external_cpu = run_external(boxes, frames, seed, capacity);
+            std::cout << "  外部xtkj       " << format_cpu(external_cpu);
+            if (static_cast<size_t>(boxes) > capacity) {
+                std::cout << "   (结果组容量 " << capacity << "，已截断)";
+            }
+            std::cout << std::endl;
+        }
+        double coverage = hashed.truth_detections > 0
+            ? 100.0 * hashed.truth_output / hashed.truth_detections : 0.0;
+        // 目标越多、框越小，每帧位移相对框尺寸越大，按轨迹帧归一化后再比较
+        double switches_per_k = hashed.truth_output > 0 ? 1000.0 * hashed.id_switches / hashed.truth_output : 0.0;
+        std::cout << "  内置跟踪: 输出覆盖 " << std::setprecision(1) << coverage << "%, ID切换 "
+                  << hashed.id_switches << " 次（" << std::setprecision(2) << switches_per_k
+                  << " 次/千轨迹帧，其中 " << hashed.new_id_switches << " 次为丢失后新建）" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include "yuv_image.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * YUV 输入转换开销对比工具
+ *
+ * 用合成的 NV12 帧（默认 4K）对比两种生成各阶段输入的方式：
+ *   - 整帧转换：cvtColor 整帧转 BGR，再分别缩放/裁剪出分割输入、违停缩放图、检测ROI与亮度缩略图
+ *   - 按需转换：融合内核直接从 YUV 生成上述派生图，亮度缩略图取自 Y 平面
+ * 输出实测的每帧耗时（墙钟中位数，含 OpenCV 并行）及各派生图的分项耗时、写出字节数，
+ * 以及按需转换相对整帧转换的像素误差。缩放类派生图的色彩转换走 convert_row 的向量实现。
+ *
+ * 用法：
+ *   YuvConvertBenchmark [--width N] [--height N] [--layout nv12|nv21|i420] [--roi-ratio R] [--repeat N]
+ *     --width/--height  帧尺寸（默认 3840x2160）
+ *     --layout          色度排列（默认 nv12；i420 的检测ROI也走 convert_row）
+ *     --roi-ratio R     检测ROI占画面下方的高度比例（默认0.6，1表示整帧）
+ *     --repeat N        重复次数（默认50）
+ */
+
+namespace {
+
+struct Variants {
+    cv::Mat seg;       // 分割输入 1024x1024
+    cv::Mat parking;   // 违停缩放图，长边640
+    cv::Mat roi;       // 检测ROI
+    cv::Mat luma;      // 亮度金字塔底层，宽480
+};
+
+struct Timing {
+    std::vector<double> ms;
+
+    void add(double value) { ms.push_back(value); }
+
+    double median() const {
+        if (ms.empty()) return 0.0;
+        std::vector<double> sorted = ms;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[sorted.size() / 2];
+    }
+};
+
+// 各派生图的分项耗时
+struct StepTimings {
+    Timing seg;
+    Timing parking;
+    Timing roi;
+    Timing luma;
+};
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+YuvImage make_frame(int width, int height, YuvLayout layout) {
+    // 亮度为带噪声的渐变，色度为低频随机，接近真实画面的取值分布
+    YuvImage frame(cv::Mat(height * 3 / 2, width, CV_8UC1), layout);
+    cv::Mat luma = frame.luma();
+    for (int y = 0; y < height; ++y) {
+        uchar* row = luma.ptr<uchar>(y);
+        for (int x = 0; x < width; ++x) {
+            row[x] = static_cast<uchar>(16 + (x * 219 / width + y * 37 / height) % 220);
+        }
+    }
+    cv::Mat noise(height, width, CV_8UC1);
+    cv::randu(noise, 0, 16);
+    luma += noise;
+    cv::Mat chroma_small(height / 16, width / 16, CV_8UC2);
+    cv::randu(chroma_small, 64, 192);
+    cv::Mat chroma(height / 2, width / 2, CV_8UC2);
+    cv::resize(chroma_small, chroma, chroma.size(), 0, 0, cv::INTER_LINEAR);
+    if (layout == YuvLayout::I420) {
+        // U 平面与 V 平面依次紧密排列
+        cv::Mat planes[2] = {
+            cv::Mat(height / 2, width / 2, CV_8UC1, frame.data.ptr(height), width / 2),
+            cv::Mat(height / 2, width / 2, CV_8UC1, frame.data.ptr(height) + (width / 2) * (height / 2), width / 2)};
+        cv::split(chroma, planes);
+    } else {
+        chroma.copyTo(cv::Mat(height / 2, width / 2, CV_8UC2, frame.data.ptr(height), frame.data.step));
+    }
+    return frame;
+}
+
+cv::Size parking_size(int width, int height) {
+    // 与 BatchObjectTracking::parking_image_size 一致：长边640
+    double scale = 640.0 / std::max(width, height);
+    return cv::Size(std::max(1, static_cast<int>(width * scale)), std::max(1, static_cast<int>(height * scale)));
+}
+
+size_t mat_bytes(const cv::Mat& mat) {
+    return mat.total() * mat.elemSize();
+}
+
+double mean_abs_diff(const cv::Mat& a, const cv::Mat& b) {
+    if (a.size() != b.size() || a.type() != b.type()) {
+        return -1.0;
+    }
+    return cv::norm(a, b, cv::NORM_L1) / static_cast<double>(a.total() * a.channels());
+}
+
+void print_usage(const char* program) {
+    std::cerr << "用法: " << program << " [--width N] [--height N] [--layout nv12|nv21|i420] [--roi-ratio R] [--repeat N]"
+              << std::endl;
+}
+
+void print_steps(const StepTimings& steps) {
+    std::cout << "    分项: 分割输入 " << std::setprecision(2) << steps.seg.median() << " ms, 违停缩放图 "
+              << steps.parking.median() << " ms, 检测ROI " << steps.roi.median() << " ms, 亮度缩略图 "
+              << steps.luma.median() << " ms" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int width = 3840;
+    int height = 2160;
+    double roi_ratio = 0.6;
+    int repeat = 50;
+    YuvLayout layout = YuvLayout::NV12;
+    const char* layout_name = "NV12";
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--layout") == 0 && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "nv12") {
+                layout = YuvLayout::NV12;
+                layout_name = "NV12";
+            } else if (value == "nv21") {
+                layout = YuvLayout::NV21;
+                layout_name = "NV21";
+            } else if (value == "i420") {
+                layout = YuvLayout::I420;
+                layout_name = "I420";
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            width = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            height = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--roi-ratio") == 0 && i + 1 < argc) {
+            roi_ratio = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    width &= ~1;
+    height &= ~1;
+    roi_ratio = std::min(1.0, std::max(0.05, roi_ratio));
+    if (width < 16 || height < 16) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    YuvImage frame = make_frame(width, height, layout);
+    const cv::Rect full(0, 0, width, height);
+    const int roi_height = std::max(2, static_cast<int>(height * roi_ratio)) & ~1;
+    const cv::Rect roi(0, height - roi_height, width, roi_height);
+    const cv::Size seg_size(1024, 1024);
+    const cv::Size park_size = parking_size(width, height);
+    const cv::Size luma_size(std::min(480, width), std::max(1, height * std::min(480, width) / width));
+
+    std::cout << "🎞️ " << layout_name << " " << width << "x" << height << " (" << std::fixed << std::setprecision(1)
+              << frame.bytes() / 1e6 << " MB), 检测ROI " << roi.width << "x" << roi.height << ", 重复 "
+              << repeat << " 次" << std::endl;
+
+    // 整帧转换：先生成整帧BGR，再由各阶段缩放/裁剪
+    Timing full_timing;
+    Timing full_convert;
+    StepTimings full_steps;
+    Variants full_out;
+    cv::Mat bgr;
+    for (int round = 0; round < repeat; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        yuv::to_bgr(frame, bgr);
+        full_convert.add(elapsed_ms(start));
+        auto step = std::chrono::steady_clock::now();
+        cv::resize(bgr, full_out.seg, seg_size);
+        full_steps.seg.add(elapsed_ms(step));
+        step = std::chrono::steady_clock::now();
+        cv::resize(bgr, full_out.parking, park_size);
+        full_steps.parking.add(elapsed_ms(step));
+        step = std::chrono::steady_clock::now();
+        full_out.roi = bgr(roi);  // 检测阶段直接引用整帧BGR的ROI视图
+        full_steps.roi.add(elapsed_ms(step));
+        step = std::chrono::steady_clock::now();
+        cv::Mat small;
+        cv::resize(bgr, small, luma_size, 0, 0, cv::INTER_NEAREST);
+        cv::cvtColor(small, full_out.luma, cv::COLOR_BGR2GRAY);
+        full_steps.luma.add(elapsed_ms(step));
+        full_timing.add(elapsed_ms(start));
+    }
+
+    // 按需转换：融合内核只生成各阶段需要的派生图
+    Timing fused_timing;
+    StepTimings fused_steps;
+    Variants fused_out;
+    for (int round = 0; round < repeat; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        yuv::convert_resize(frame, full, seg_size, fused_out.seg);
+        fused_steps.seg.add(elapsed_ms(start));
+        auto step = std::chrono::steady_clock::now();
+        yuv::convert_resize(frame, full, park_size, fused_out.parking);
+        fused_steps.parking.add(elapsed_ms(step));
+        step = std::chrono::steady_clock::now();
+        yuv::convert_crop(frame, roi, fused_out.roi);
+        fused_steps.roi.add(elapsed_ms(step));
+        step = std::chrono::steady_clock::now();
+        yuv::luma_resize(frame, full, luma_size, fused_out.luma, cv::INTER_NEAREST);
+        fused_steps.luma.add(elapsed_ms(step));
+        fused_timing.add(elapsed_ms(start));
+    }
+
+    // 写出字节：整帧转换的ROI为零拷贝视图，按需转换则需写出ROI区域
+    size_t full_bytes = mat_bytes(bgr) + mat_bytes(full_out.seg) + mat_bytes(full_out.parking) +
+                        mat_bytes(full_out.luma);
+    size_t variant_bytes = mat_bytes(fused_out.seg) + mat_bytes(fused_out.parking) + mat_bytes(fused_out.roi) +
+                           mat_bytes(fused_out.luma);
+
+    std::cout << "\n🐢 整帧转换: " << std::setprecision(2) << full_timing.median() << " ms/帧（实测中位数，其中整帧转BGR "
+              << full_convert.median() << " ms）, 写出 " << std::setprecision(1) << full_bytes / 1e6 << " MB（整帧BGR "
+              << mat_bytes(bgr) / 1e6 << " MB）" << std::endl;
+    print_steps(full_steps);
+    std::cout << "⚡ 按需转换: " << std::setprecision(2) << fused_timing.median() << " ms/帧（实测中位数）, 写出 "
+              << std::setprecision(1) << variant_bytes / 1e6 << " MB" << std::endl;
+    print_steps(fused_steps);
+    if (fused_timing.median() > 0.0) {
+        std::cout << "  耗时降低 " << std::setprecision(2) << full_timing.median() / fused_timing.median()
+                  << " 倍, 每帧少写 " << std::setprecision(1)
+                  << (static_cast<double>(full_bytes) - static_cast<double>(variant_bytes)) / 1e6
+                  << " MB, 且各阶段不再从整帧BGR读取" << std::endl;
+    }
+
+    // ROI 裁剪与整帧转换结果逐像素一致；缩放图的色度采样位置不同，仅有插值误差
+    std::cout << "\n🔍 平均绝对误差（相对整帧转换）: 分割输入 " << std::setprecision(3)
+              << mean_abs_diff(fused_out.seg, full_out.seg) << ", 违停缩放图 "
+              << mean_abs_diff(fused_out.parking, full_out.parking) << ", 检测ROI "
+              << mean_abs_diff(fused_out.roi, full_out.roi) << std::endl;
+    return 0;
+}